@@ -0,0 +1,488 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2011 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include "StdDefines.h"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+#if defined(__linux__) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <sys/uio.h>
+#  ifdef __NR_io_uring_setup
+#   define TUVOK_HAVE_URING 1
+#  endif
+# endif
+#endif
+#include "LargeFileURing.h"
+#include "Threads.h"
+
+namespace {
+  // O_DIRECT wants offsets, sizes and buffers aligned to this.
+  const size_t Alignment = 4096;
+
+  std::shared_ptr<uint8_t> aligned_buffer(size_t len) {
+    void* mem = NULL;
+    if(posix_memalign(&mem, Alignment, std::max<size_t>(len, 1)) != 0) {
+      throw std::bad_alloc();
+    }
+    return std::shared_ptr<uint8_t>(static_cast<uint8_t*>(mem), ::free);
+  }
+
+  /// The buffers registered with the kernel.  A read takes a buffer and
+  /// gives it back when the last user of the data drops it, which may well
+  /// happen after the file was closed.
+  struct BufferPool {
+    std::shared_ptr<uint8_t> memory;
+    std::vector<int> unused;
+    tuvok::CriticalSection guard;
+
+    /// @returns an unused buffer and sets 'index', or NULL if all are taken.
+    static std::shared_ptr<uint8_t> take(const std::shared_ptr<BufferPool>& pool,
+                                         int& index) {
+      {
+        SCOPEDLOCK(pool->guard);
+        if(pool->unused.empty()) { return std::shared_ptr<uint8_t>(); }
+        index = pool->unused.back();
+        pool->unused.pop_back();
+      }
+      const int i = index;
+      std::shared_ptr<BufferPool> p = pool;
+      return std::shared_ptr<uint8_t>(
+        pool->memory.get() + size_t(i)*LargeFileURing::BufferSize,
+        [p, i](uint8_t*) {
+          SCOPEDLOCK(p->guard);
+          p->unused.push_back(i);
+        }
+      );
+    }
+  };
+}
+
+struct LargeFileURing::Request {
+  std::shared_ptr<uint8_t> buffer; ///< what the kernel reads into
+  int index;       ///< of the registered buffer, or -1
+  uint64_t start;  ///< file offset the read starts at
+  size_t length;   ///< bytes read from 'start'
+  size_t skip;     ///< the data we want starts this far into 'buffer'
+  size_t wanted;
+  int result;      ///< bytes read or -errno, once done
+  bool done;
+#ifdef TUVOK_HAVE_URING
+  struct iovec iov;
+#endif
+};
+
+#ifdef TUVOK_HAVE_URING
+struct LargeFileURing::Ring {
+  int fd;
+  void* sq_map; size_t sq_size;
+  void* cq_map; size_t cq_size;
+  struct io_uring_sqe* sqes; size_t sqes_size;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array, sq_entries;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_cqe* cqes;
+  std::shared_ptr<BufferPool> buffers; ///< NULL if registration failed
+  unsigned queued;    ///< in the submission queue, not yet submitted
+  unsigned in_flight; ///< submitted, not yet completed
+
+  Ring(int rfd) : fd(rfd), sq_map(NULL), sq_size(0), cq_map(NULL),
+                  cq_size(0), sqes(NULL), sqes_size(0), queued(0),
+                  in_flight(0) {}
+  ~Ring() {
+    if(sqes) { munmap(sqes, sqes_size); }
+    if(cq_map && cq_map != sq_map) { munmap(cq_map, cq_size); }
+    if(sq_map) { munmap(sq_map, sq_size); }
+    ::close(fd); // also drops the registered buffers
+  }
+
+  static void* map(int fd, size_t len, off_t what) {
+    void* m = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, what);
+    return m == MAP_FAILED ? NULL : m;
+  }
+
+  /// @returns a new ring, or NULL if the kernel won't give us one.
+  static std::shared_ptr<Ring> create() {
+    struct io_uring_params p;
+    ::memset(&p, 0, sizeof(p));
+    const int rfd = int(syscall(__NR_io_uring_setup, Depth, &p));
+    // no io_uring (old kernel, or forbidden by a sandbox): we use pread.
+    if(rfd < 0) { return std::shared_ptr<Ring>(); }
+    std::shared_ptr<Ring> r(new Ring(rfd));
+    r->sq_size = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+    r->cq_size = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+    bool single = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    if(p.features & IORING_FEAT_SINGLE_MMAP) {
+      single = true;
+      r->sq_size = r->cq_size = std::max(r->sq_size, r->cq_size);
+    }
+#endif
+    r->sq_map = map(rfd, r->sq_size, IORING_OFF_SQ_RING);
+    if(!r->sq_map) { return std::shared_ptr<Ring>(); }
+    r->cq_map = single ? r->sq_map : map(rfd, r->cq_size, IORING_OFF_CQ_RING);
+    r->sqes_size = p.sq_entries*sizeof(struct io_uring_sqe);
+    r->sqes = static_cast<struct io_uring_sqe*>(map(rfd, r->sqes_size,
+                                                    IORING_OFF_SQES));
+    if(!r->cq_map || !r->sqes) { return std::shared_ptr<Ring>(); }
+
+    uint8_t* sq = static_cast<uint8_t*>(r->sq_map);
+    r->sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    r->sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    r->sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    r->sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    r->sq_entries = p.sq_entries;
+    uint8_t* cq = static_cast<uint8_t*>(r->cq_map);
+    r->cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    r->cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    r->cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    r->cqes = reinterpret_cast<struct io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    // registering fails if we may not lock that much memory; the reads then
+    // simply use buffers of their own.
+    std::shared_ptr<BufferPool> pool(new BufferPool);
+    pool->memory = aligned_buffer(Buffers*BufferSize);
+    std::vector<struct iovec> iov(Buffers);
+    for(size_t i=0; i < Buffers; ++i) {
+      iov[i].iov_base = pool->memory.get() + i*BufferSize;
+      iov[i].iov_len = BufferSize;
+      pool->unused.push_back(int(Buffers-1-i));
+    }
+    if(syscall(__NR_io_uring_register, rfd, IORING_REGISTER_BUFFERS,
+               iov.data(), unsigned(Buffers)) == 0) {
+      r->buffers = pool;
+    }
+    return r;
+  }
+
+  /// @returns the next free submission entry, or NULL if the queue is full.
+  struct io_uring_sqe* next() {
+    const unsigned tail = *sq_tail;
+    if(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+      return NULL;
+    }
+    const unsigned idx = tail & *sq_mask;
+    ::memset(&sqes[idx], 0, sizeof(struct io_uring_sqe));
+    sq_array[idx] = idx;
+    return &sqes[idx];
+  }
+  /// makes the entry 'next' gave out visible to the kernel
+  void push() {
+    __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+    ++queued;
+  }
+
+  int enter(unsigned submit, unsigned wait) {
+    int rv;
+    do {
+      rv = int(syscall(__NR_io_uring_enter, fd, submit, wait,
+                       wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0));
+    } while(rv < 0 && errno == EINTR);
+    return rv;
+  }
+};
+#else
+struct LargeFileURing::Ring {
+  unsigned queued;
+  unsigned in_flight;
+  static std::shared_ptr<Ring> create() { return std::shared_ptr<Ring>(); }
+};
+#endif
+
+LargeFileURing::LargeFileURing(const std::string fn,
+                               std::ios_base::openmode mode,
+                               uint64_t header_size,
+                               uint64_t /* length */) :
+  LargeFileFD(fn, mode, header_size), want_direct(false), is_direct(false)
+{
+  this->open(mode);
+}
+LargeFileURing::LargeFileURing(const std::wstring fn,
+                               std::ios_base::openmode mode,
+                               uint64_t header_size,
+                               uint64_t /* length */) :
+  LargeFileFD(fn, mode, header_size), want_direct(false), is_direct(false)
+{
+  this->open(mode);
+}
+
+LargeFileURing::~LargeFileURing()
+{
+  this->close();
+}
+
+void LargeFileURing::open(std::ios_base::openmode mode)
+{
+  this->close();
+  LargeFileFD::open(mode);
+
+  this->is_direct = false;
+  this->ring = Ring::create();
+#ifdef O_DIRECT
+  // only the ring reads into aligned buffers; without it, reads go through
+  // LargeFileFD into arbitrary memory, which O_DIRECT would refuse.
+  if(this->ring && this->want_direct && !(mode & std::ios_base::out)) {
+    // not every file system can do this; then we just keep the normal fd.
+    const int dfd = ::open(this->m_filename.c_str(), O_RDONLY | O_DIRECT);
+    if(dfd != -1) {
+      ::close(this->fd);
+      this->fd = dfd;
+      this->is_direct = true;
+    }
+  }
+#endif
+}
+
+LargeFileURing::Requests::iterator
+LargeFileURing::add_request(uint64_t offset, size_t len)
+{
+#ifdef TUVOK_HAVE_URING
+  // the completion queue must never overflow: bound what's outstanding.
+  if(this->ring->queued + this->ring->in_flight >= Depth) {
+    this->submit();
+    while(this->ring->in_flight >= Depth) { this->reap(1); }
+  }
+  struct io_uring_sqe* sqe = this->ring->next();
+  if(sqe == NULL) {
+    this->submit();
+    sqe = this->ring->next();
+    assert(sqe != NULL);
+  }
+
+  Request req;
+  req.start = offset;
+  req.length = len;
+  if(this->is_direct) {
+    req.start = offset & ~uint64_t(Alignment-1);
+    req.length = size_t((offset + len + Alignment-1) & ~uint64_t(Alignment-1))
+               - size_t(req.start);
+  }
+  req.skip = size_t(offset - req.start);
+  req.wanted = len;
+  req.result = 0;
+  req.done = false;
+  req.index = -1;
+  if(this->ring->buffers && req.length <= BufferSize) {
+    req.buffer = BufferPool::take(this->ring->buffers, req.index);
+  }
+  if(!req.buffer) {
+    req.index = -1;
+    req.buffer = aligned_buffer(req.length);
+  }
+
+  Requests::iterator r = this->requests.insert(
+    std::make_pair(std::make_pair(offset, len), req)
+  ).first;
+  Request& rq = r->second;
+  sqe->fd = this->fd;
+  sqe->off = rq.start;
+  sqe->user_data = reinterpret_cast<uintptr_t>(&rq);
+  if(rq.index >= 0) {
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->addr = reinterpret_cast<uintptr_t>(rq.buffer.get());
+    sqe->len = unsigned(rq.length);
+    sqe->buf_index = uint16_t(rq.index);
+  } else {
+    rq.iov.iov_base = rq.buffer.get();
+    rq.iov.iov_len = rq.length;
+    sqe->opcode = IORING_OP_READV;
+    sqe->addr = reinterpret_cast<uintptr_t>(&rq.iov);
+    sqe->len = 1;
+  }
+  this->ring->push();
+  return r;
+#else
+  (void) offset; (void) len;
+  assert(false); // no ring, no requests.
+  return this->requests.end();
+#endif
+}
+
+void LargeFileURing::submit()
+{
+#ifdef TUVOK_HAVE_URING
+  if(!this->ring) { return; }
+  while(this->ring->queued > 0) {
+    const int rv = this->ring->enter(this->ring->queued, 0);
+    if(rv < 0) {
+      if((errno == EAGAIN || errno == EBUSY) && this->ring->in_flight > 0) {
+        this->reap(1); // make room, then try again
+        continue;
+      }
+      throw std::ios_base::failure("could not submit reads.");
+    }
+    this->ring->queued -= unsigned(rv);
+    this->ring->in_flight += unsigned(rv);
+  }
+#endif
+}
+
+size_t LargeFileURing::poll()
+{
+  if(!this->ring) { return 0; }
+  return this->reap(0);
+}
+
+size_t LargeFileURing::reap(unsigned wait)
+{
+#ifdef TUVOK_HAVE_URING
+  if(wait > 0 && this->ring->enter(0, wait) < 0) {
+    throw std::ios_base::failure("waiting for reads failed.");
+  }
+  size_t n = 0;
+  unsigned head = *this->ring->cq_head;
+  const unsigned tail = __atomic_load_n(this->ring->cq_tail, __ATOMIC_ACQUIRE);
+  for(; head != tail; ++head, ++n) {
+    const struct io_uring_cqe& cqe =
+      this->ring->cqes[head & *this->ring->cq_mask];
+    Request* req = reinterpret_cast<Request*>(uintptr_t(cqe.user_data));
+    req->result = cqe.res;
+    req->done = true;
+    --this->ring->in_flight;
+  }
+  __atomic_store_n(this->ring->cq_head, head, __ATOMIC_RELEASE);
+  return n;
+#else
+  (void) wait;
+  return 0;
+#endif
+}
+
+void LargeFileURing::finish(Request& req)
+{
+  this->submit();
+  while(!req.done) { this->reap(1); }
+}
+
+std::shared_ptr<const void> LargeFileURing::rd(uint64_t offset,
+                                                    size_t len)
+{
+  if(!this->ring || len == 0) {
+    return LargeFileFD::rd(offset, len);
+  }
+  if(!this->is_open()) {
+    throw std::ios_base::failure("file is not open!!");
+  }
+
+  const uint64_t real_offset = offset + this->header_size;
+  Requests::iterator r = this->requests.find(std::make_pair(real_offset, len));
+  if(r == this->requests.end()) {
+    r = this->add_request(real_offset, len);
+  }
+  // also sends off everything enqueued since the last read.
+  Request& req = r->second;
+  this->finish(req);
+
+  if(req.result < 0) {
+    this->requests.erase(r);
+    throw std::ios_base::failure("read failure.");
+  }
+  size_t got = size_t(req.result) > req.skip
+             ? std::min(size_t(req.result) - req.skip, req.wanted) : 0;
+  // short reads are rare but allowed; finish those ourselves.  With O_DIRECT
+  // they only happen at the end of the file.
+  while(got < req.wanted && !this->is_direct) {
+    const ssize_t bytes = ::pread(this->fd,
+                                  req.buffer.get() + req.skip + got,
+                                  req.wanted - got, off_t(real_offset + got));
+    if(bytes < 0 && errno == EINTR) { continue; }
+    if(bytes < 0) {
+      this->requests.erase(r);
+      throw std::ios_base::failure("read failure.");
+    }
+    if(bytes == 0) { break; }
+    got += size_t(bytes);
+  }
+  this->bytes_read = got;
+
+  // share ownership of the whole buffer, but point to the data we want.
+  std::shared_ptr<const void> mem(req.buffer, req.buffer.get() + req.skip);
+  this->requests.erase(r);
+  return mem;
+}
+
+void LargeFileURing::enqueue(uint64_t offset, size_t len)
+{
+  if(len == 0) { return; }
+  if(!this->ring) {
+    LargeFileFD::enqueue(offset, len);
+    return;
+  }
+  const uint64_t real_offset = offset + this->header_size;
+  // already requested; once is enough.
+  if(this->requests.find(std::make_pair(real_offset, len)) !=
+     this->requests.end()) {
+    return;
+  }
+  this->add_request(real_offset, len);
+}
+
+void LargeFileURing::wr(const std::shared_ptr<const void>& data,
+                        uint64_t offset,
+                        size_t len)
+{
+  // a pending read of that range would return the old data: drop it.
+  const uint64_t real_offset = offset + this->header_size;
+  for(Requests::iterator r = this->requests.begin();
+      r != this->requests.end(); ) {
+    const uint64_t start = r->first.first;
+    const uint64_t end = start + r->first.second;
+    if(start < real_offset + len && real_offset < end) {
+      this->finish(r->second);
+      r = this->requests.erase(r);
+    } else {
+      ++r;
+    }
+  }
+  LargeFileFD::wr(data, offset, len);
+}
+
+void LargeFileURing::close()
+{
+  if(this->ring) {
+    // the kernel still writes into the buffers of outstanding reads.
+    this->submit();
+    while(this->ring->in_flight > 0) { this->reap(1); }
+  }
+  this->requests.clear();
+  this->ring.reset();
+  LargeFileFD::close();
+}
+
+void LargeFileURing::direct(bool d) { this->want_direct = d; }
+
+bool LargeFileURing::uring() const { return this->ring.get() != NULL; }
@@ -0,0 +1,120 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2011 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#ifndef BASICS_LARGEFILE_URING_H
+#define BASICS_LARGEFILE_URING_H
+
+#include <map>
+#include <memory>
+#include <utility>
+#include "LargeFileFD.h"
+
+/** Reads data through Linux' io_uring.  Reads which were announced with
+ * 'enqueue' are collected and handed to the kernel together on the next 'rd'
+ * (or 'submit'), so a burst of hints costs a single system call.  Small reads
+ * go into a set of buffers registered with the kernel up front.
+ * Writes are synchronous, as in LargeFileFD.
+ * If io_uring is not available (old kernel, not Linux, forbidden by the
+ * sandbox), this behaves exactly like LargeFileFD. */
+class LargeFileURing : public LargeFileFD {
+  public:
+    /// @argument header_size is maintained as a "base" offset.  Seeking to
+    /// byte 0 actually seeks to 'header_size'.
+    LargeFileURing(const std::string fn,
+                   std::ios_base::openmode mode = std::ios_base::in,
+                   uint64_t header_size=0,
+                   uint64_t length=0);
+    /// @argument header_size is maintained as a "base" offset.  Seeking to
+    /// byte 0 actually seeks to 'header_size'.
+    LargeFileURing(const std::wstring fn,
+                   std::ios_base::openmode mode = std::ios_base::in,
+                   uint64_t header_size=0,
+                   uint64_t length=0);
+    virtual ~LargeFileURing();
+
+    virtual void open(std::ios_base::openmode mode = std::ios_base::in);
+
+    /// reads a block of data, returns a pointer to it.  User must cast it to
+    /// the type that makes sense for them.
+    virtual std::shared_ptr<const void> rd(uint64_t offset,
+                                                size_t len);
+    using LargeFile::read;
+    using LargeFile::rd;
+
+    /// notifies the object that we're going to need the following data soon.
+    /// The read is queued; it starts with the next 'submit' or 'rd'.
+    virtual void enqueue(uint64_t offset, size_t len);
+
+    /// writes a block of data.  Waits for pending reads of the same range.
+    virtual void wr(const std::shared_ptr<const void>& data,
+                    uint64_t offset,
+                    size_t len);
+    using LargeFile::write;
+
+    virtual void close();
+
+    /// starts all queued reads with a single system call.
+    void submit();
+    /// collects reads which have finished, without waiting.
+    /// @returns the number of reads which finished.
+    size_t poll();
+    /// Reads bypass the page cache (O_DIRECT) when set.  Only applies to
+    /// read-only files and takes effect on the next 'open'.  Ignored if the
+    /// file system does not support it, or if io_uring is not available.
+    void direct(bool);
+    /// @returns true if reads really go through io_uring.
+    bool uring() const;
+
+    /// number of reads that can be in flight at once
+    static const unsigned Depth = 64;
+    /// registered buffers: how many, and how large each one is.  Larger
+    /// reads get a buffer of their own.
+    static const size_t Buffers = 16;
+    static const size_t BufferSize = 1024*1024;
+
+    struct Ring;
+    struct Request;
+    typedef std::map<std::pair<uint64_t, size_t>, Request> Requests;
+
+  private:
+    LargeFileURing(const LargeFileURing&);
+    LargeFileURing& operator=(const LargeFileURing&);
+
+    Requests::iterator add_request(uint64_t offset, size_t len);
+    /// processes completions; waits for at least 'wait' of them.
+    size_t reap(unsigned wait);
+    /// waits until 'req' has finished.
+    void finish(Request& req);
+
+  private:
+    std::shared_ptr<Ring> ring; ///< NULL if io_uring is not available
+    Requests requests;
+    bool want_direct;
+    bool is_direct;
+};
+
+#endif /* BASICS_LARGEFILE_URING_H */
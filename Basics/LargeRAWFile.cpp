@@ -1,6 +1,10 @@
 #include <memory>
 #include <sstream>
 #include <algorithm> // for std::max, std::min
+#ifndef _WIN32
+# include <cerrno>
+# include <unistd.h>
+#endif
 #include "LargeRAWFile.h"
 #include "nonstd.h"
 
@@ -190,6 +194,53 @@ size_t LargeRAWFile::ReadRAW(unsigned char* pData, uint64_t iCount) {
   #endif
 }
 
+size_t LargeRAWFile::ReadRAWAt(unsigned char* pData, uint64_t iCount,
+                               uint64_t iPos) const {
+  uint64_t iTotalRead = 0;
+  uint64_t iOffset = iPos+m_iHeaderSize;
+  #ifdef _WIN32
+  // ReadFile with an explicit offset.  On our synchronous handle that still
+  // moves the file pointer to the end of the data read, so remember where
+  // it was and put it back afterwards.  Windows serializes I/O on such a
+  // handle anyway, so holding the lock throughout costs no parallelism.
+  std::lock_guard<std::mutex> lock(m_ReadAtGuard);
+  LARGE_INTEGER liZero, liPrevPos;
+  liZero.QuadPart = 0;
+  SetFilePointerEx(m_StreamFile, liZero, &liPrevPos, FILE_CURRENT);
+  while (iCount > 0) {
+    const DWORD dwChunk = DWORD(std::min<uint64_t>(iCount,
+                                std::numeric_limits<DWORD>::max()));
+    OVERLAPPED ov = {0};
+    ov.Offset = DWORD(iOffset & 0xFFFFFFFF);
+    ov.OffsetHigh = DWORD(iOffset >> 32);
+    DWORD dwReadBytes = 0;
+    if (!ReadFile(m_StreamFile, pData, dwChunk, &dwReadBytes, &ov) ||
+        dwReadBytes == 0) {
+      break;
+    }
+    iCount -= dwReadBytes;
+    iTotalRead += dwReadBytes;
+    iOffset += dwReadBytes;
+    pData += dwReadBytes;
+  }
+  SetFilePointerEx(m_StreamFile, liPrevPos, NULL, FILE_BEGIN);
+  #else
+  // anything still sitting in stdio's buffer would be invisible to pread.
+  if (m_bWritable) fflush(m_StreamFile);
+  const int fd = fileno(m_StreamFile);
+  while (iCount > 0) {
+    const ssize_t rd = pread(fd, pData, size_t(iCount), off_t(iOffset));
+    if (rd < 0 && errno == EINTR) continue;
+    if (rd <= 0) break;
+    iCount -= uint64_t(rd);
+    iTotalRead += uint64_t(rd);
+    iOffset += uint64_t(rd);
+    pData += rd;
+  }
+  #endif
+  return size_t(iTotalRead);
+}
+
 size_t LargeRAWFile::WriteRAW(const unsigned char* pData, uint64_t iCount) {
   #ifdef _WIN32
   uint64_t iTotalWritten = 0;
@@ -9,6 +9,9 @@
 
 #include <string>
 #include <vector>
+#ifdef _WIN32
+# include <mutex>
+#endif
 #include "EndianConvert.h"
 
 #ifdef _WIN32
@@ -59,6 +62,11 @@ public:
   virtual uint64_t GetPos();
   virtual void SeekPos(uint64_t iPos);
   virtual size_t ReadRAW(unsigned char* pData, uint64_t iCount);
+  /// Reads from the given position without moving the file pointer.  This
+  /// may be called from multiple threads at once, concurrently with each
+  /// other (but not with SeekPos/ReadRAW/WriteRAW).
+  virtual size_t ReadRAWAt(unsigned char* pData, uint64_t iCount,
+                           uint64_t iPos) const;
   virtual size_t WriteRAW(const unsigned char* pData, uint64_t iCount);
   virtual bool CopyRAW(uint64_t iCount, uint64_t iSourcePos, uint64_t iTargetPos,
                        unsigned char* pBuffer, uint64_t iBufferSize);
@@ -157,6 +165,11 @@ protected:
   bool          m_bIsOpen;
   bool          m_bWritable;
   uint64_t      m_iHeaderSize;
+#ifdef _WIN32
+  /// ReadFile moves the file pointer even when given an offset; ReadRAWAt
+  /// puts it back, one reader at a time.
+  mutable std::mutex m_ReadAtGuard;
+#endif
 };
 
 #include <memory>
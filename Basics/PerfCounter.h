@@ -3,7 +3,9 @@
 
 /// Valid performance counters the system should track.
 /// When adding a new counter, please add a (units) clause so we know how to
-/// interpret the value!
+/// interpret the value, and give it a name in PerfRegistry.cpp!
+/// Counters which are only interesting locally can instead be added at
+/// runtime via PerfRegistry::Register.
 enum PerfCounter {
 
   // structured timers, indention signals timer hierarchy
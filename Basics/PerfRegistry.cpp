@@ -0,0 +1,423 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "PerfRegistry.h"
+
+// not every compiler we support knows 'thread_local', but all of them can
+// keep PODs in thread local storage.
+#ifdef _MSC_VER
+# define TUVOK_TLS __declspec(thread)
+#else
+# define TUVOK_TLS __thread
+#endif
+
+namespace tuvok {
+
+namespace {
+  // histogram buckets: bucket 0 takes everything <= 0, then each power of
+  // two in [2^EMin, 2^EMax) is split into 'SubBuckets' linear buckets.
+  const int EMin = -20;       // ~1e-6
+  const int EMax = 44;        // ~1.7e13
+  const int SubBuckets = 8;
+  const size_t NumBuckets = size_t(1 + (EMax-EMin+1)*SubBuckets);
+
+  size_t bucket(double v) {
+    if(!(v > 0)) { return 0; } // also NaNs
+    int e;
+    const double m = std::frexp(v, &e); // v = m * 2^e, m in [0.5, 1)
+    if(e < EMin) { return 1; }
+    if(e > EMax) { return NumBuckets-1; }
+    const int sub = std::min(SubBuckets-1, int((m-0.5) * 2*SubBuckets));
+    return size_t(1 + (e-EMin)*SubBuckets + sub);
+  }
+  // lower edge of bucket 'b'; the upper edge is that of 'b+1'.
+  double bucket_start(size_t b) {
+    if(b == 0) { return 0.0; }
+    const int e = int((b-1) / SubBuckets) + EMin;
+    const int sub = int((b-1) % SubBuckets);
+    return std::ldexp(0.5 + sub / (2.0*SubBuckets), e);
+  }
+  double bucket_mid(size_t b) {
+    if(b == 0) { return 0.0; }
+    return 0.5*(bucket_start(b) + bucket_start(b+1));
+  }
+
+  // only the owning thread ever writes a slot, so a plain load and store is
+  // enough; the atomics just make concurrent readers well defined.
+  template<typename T> void add(std::atomic<T>& a, T v) {
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+  }
+
+  struct Builtin { const char* name; const char* units; };
+  const Builtin builtins[] = {
+    { "PERF_SUBFRAMES", "counter" },
+    { "PERF_RENDER", "milliseconds" },
+    { "PERF_RAYCAST", "milliseconds" },
+    { "PERF_READ_HTABLE", "milliseconds" },
+    { "PERF_CONDENSE_HTABLE", "milliseconds" },
+    { "PERF_SORT_HTABLE", "milliseconds" },
+    { "PERF_UPLOAD_BRICKS", "milliseconds" },
+    { "PERF_POOL_SORT", "milliseconds" },
+    { "PERF_POOL_UPLOADED_MEM", "bytes" },
+    { "PERF_POOL_GET_BRICK", "milliseconds" },
+    { "PERF_DY_GET_BRICK", "milliseconds" },
+    { "PERF_DY_CACHE_LOOKUPS", "counter" },
+    { "PERF_DY_CACHE_LOOKUP", "milliseconds" },
+    { "PERF_DY_RESERVE_BRICK", "milliseconds" },
+    { "PERF_DY_LOAD_BRICK", "milliseconds" },
+    { "PERF_DY_CACHE_ADDS", "counter" },
+    { "PERF_DY_CACHE_ADD", "milliseconds" },
+    { "PERF_DY_BRICK_COPIED", "counter" },
+    { "PERF_DY_BRICK_COPY", "milliseconds" },
+    { "PERF_POOL_UPLOAD_BRICK", "milliseconds" },
+    { "PERF_POOL_UPLOAD_TEXEL", "milliseconds" },
+    { "PERF_POOL_UPLOAD_METADATA", "milliseconds" },
+    { "PERF_EO_BRICKS", "counter" },
+    { "PERF_EO_DISK_READ", "milliseconds" },
+    { "PERF_EO_DECOMPRESSION", "milliseconds" },
+    { "PERF_MM_PRECOMPUTE", "milliseconds" },
+    { "PERF_SOMETHING", "milliseconds" },
+  };
+  static_assert(sizeof(builtins)/sizeof(builtins[0]) == PERF_END,
+                "every PerfCounter needs a name");
+
+  std::atomic<uint64_t> instances(0);
+
+  // the calling thread's shard in the registry with the given instance id.
+  TUVOK_TLS uint64_t tlsInstance = 0;
+  TUVOK_TLS PerfRegistry::Shard* tlsShard = NULL;
+
+  // registries which are alive, so that exiting threads can hand back their
+  // shards.  There are few registries, and threads rarely exit.
+  std::mutex liveGuard;
+  std::vector<PerfRegistry*> live;
+}
+
+void ReleaseThreadShards() {
+  {
+    std::lock_guard<std::mutex> lock(liveGuard);
+    for(size_t i=0; i < live.size(); ++i) { live[i]->ReleaseShard(); }
+  }
+  tlsInstance = 0;
+  tlsShard = NULL;
+}
+
+namespace {
+  // TLS destructors are not available for PODs, so we ask the OS to call us
+  // back when a thread which has a shard exits.
+  std::once_flag exitOnce;
+#ifdef DETECTED_OS_WINDOWS
+  DWORD exitKey = FLS_OUT_OF_INDEXES;
+  VOID WINAPI thread_exit(PVOID) { ReleaseThreadShards(); }
+#else
+  pthread_key_t exitKey;
+  void thread_exit(void*) { ReleaseThreadShards(); }
+#endif
+
+  void watch_thread() {
+    std::call_once(exitOnce, []() {
+#ifdef DETECTED_OS_WINDOWS
+      exitKey = FlsAlloc(thread_exit);
+#else
+      pthread_key_create(&exitKey, thread_exit);
+#endif
+    });
+    // the callback only happens for a non-NULL value.
+#ifdef DETECTED_OS_WINDOWS
+    FlsSetValue(exitKey, &exitKey);
+#else
+    pthread_setspecific(exitKey, &exitKey);
+#endif
+  }
+}
+
+struct PerfRegistry::Slot {
+  std::atomic<double> sum;
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> buckets[NumBuckets];
+  std::atomic<double> frameMax;    ///< largest sample of frame 'frame'
+  std::atomic<uint64_t> frame;
+  Slot() : sum(0.0), count(0), frameMax(0.0), frame(0) {
+    for(size_t b=0; b < NumBuckets; ++b) { buckets[b].store(0); }
+  }
+};
+
+struct PerfRegistry::Shard {
+  std::thread::id owner;
+  std::atomic<Slot*> slots[MaxCounters];
+  explicit Shard(std::thread::id o) : owner(o) {
+    for(size_t i=0; i < MaxCounters; ++i) { slots[i].store(NULL); }
+  }
+  ~Shard() {
+    for(size_t i=0; i < MaxCounters; ++i) { delete slots[i].load(); }
+  }
+  /// adds the samples of 'other' to ours; 'frame' is the current frame.
+  void Absorb(const Shard& other, uint64_t frame) {
+    for(size_t i=0; i < MaxCounters; ++i) {
+      const Slot* from = other.slots[i].load(std::memory_order_acquire);
+      if(!from) { continue; }
+      Slot* to = slots[i].load(std::memory_order_relaxed);
+      if(!to) {
+        to = new Slot();
+        slots[i].store(to, std::memory_order_release);
+      }
+      add(to->sum, from->sum.load(std::memory_order_relaxed));
+      add(to->count, from->count.load(std::memory_order_relaxed));
+      for(size_t b=0; b < NumBuckets; ++b) {
+        add(to->buckets[b], from->buckets[b].load(std::memory_order_relaxed));
+      }
+      if(from->frame.load(std::memory_order_acquire) != frame) { continue; }
+      const double fmax = from->frameMax.load(std::memory_order_relaxed);
+      if(to->frame.load(std::memory_order_relaxed) != frame ||
+         fmax > to->frameMax.load(std::memory_order_relaxed)) {
+        to->frameMax.store(fmax, std::memory_order_relaxed);
+        to->frame.store(frame, std::memory_order_release);
+      }
+    }
+  }
+};
+
+struct PerfRegistry::Totals {
+  double sum;
+  uint64_t count;
+  double frameMax; ///< largest sample of the current frame; -1 if unknown
+  std::vector<uint64_t> buckets;
+  Totals() : sum(0.0), count(0), frameMax(-1.0), buckets(NumBuckets, 0) {}
+};
+
+PerfRegistry::PerfRegistry() :
+  m_iInstance(++instances),
+  m_iCount(0),
+  m_iFrame(1),
+  m_Retired(new Shard(std::thread::id()))
+{
+  for(size_t i=0; i < size_t(PERF_END); ++i) {
+    Register(builtins[i].name, builtins[i].units);
+  }
+  std::lock_guard<std::mutex> lock(liveGuard);
+  live.push_back(this);
+}
+
+PerfRegistry::~PerfRegistry() {
+  std::lock_guard<std::mutex> lock(liveGuard);
+  live.erase(std::remove(live.begin(), live.end(), this), live.end());
+}
+
+PerfRegistry::ID PerfRegistry::Register(const std::string& name,
+                                        const std::string& units) {
+  SCOPEDLOCK(m_Guard);
+  std::vector<std::string>::const_iterator i =
+    std::find(m_vNames.begin(), m_vNames.end(), name);
+  if(i != m_vNames.end()) { return ID(i - m_vNames.begin()); }
+  if(m_vNames.size() >= MaxCounters) { return Invalid; }
+
+  m_vNames.push_back(name);
+  m_vUnits.push_back(units);
+  m_vQueried.push_back(0.0);
+  m_vFrameStart.push_back(std::unique_ptr<Totals>(new Totals()));
+  // publish only after the bookkeeping is in place
+  m_iCount.store(m_vNames.size());
+  return ID(m_vNames.size()-1);
+}
+
+PerfRegistry::ID PerfRegistry::Find(const std::string& name) const {
+  SCOPEDLOCK(m_Guard);
+  std::vector<std::string>::const_iterator i =
+    std::find(m_vNames.begin(), m_vNames.end(), name);
+  return i == m_vNames.end() ? Invalid : ID(i - m_vNames.begin());
+}
+
+size_t PerfRegistry::Count() const { return m_iCount.load(); }
+
+std::string PerfRegistry::Name(ID id) const {
+  SCOPEDLOCK(m_Guard);
+  return id < m_vNames.size() ? m_vNames[id] : std::string();
+}
+std::string PerfRegistry::Units(ID id) const {
+  SCOPEDLOCK(m_Guard);
+  return id < m_vUnits.size() ? m_vUnits[id] : std::string();
+}
+
+PerfRegistry::Shard* PerfRegistry::LocalShard() {
+  if(tlsInstance == m_iInstance) { return tlsShard; }
+
+  // first use from this thread, or it used a different registry last time
+  SCOPEDLOCK(m_Guard);
+  const std::thread::id self = std::this_thread::get_id();
+  Shard* shard = NULL;
+  for(size_t i=0; i < m_vShards.size() && !shard; ++i) {
+    if(m_vShards[i]->owner == self) { shard = m_vShards[i].get(); }
+  }
+  if(!shard) {
+    m_vShards.push_back(std::unique_ptr<Shard>(new Shard(self)));
+    shard = m_vShards.back().get();
+    watch_thread();
+  }
+  tlsInstance = m_iInstance;
+  tlsShard = shard;
+  return shard;
+}
+
+void PerfRegistry::ReleaseShard() {
+  SCOPEDLOCK(m_Guard);
+  const std::thread::id self = std::this_thread::get_id();
+  for(size_t i=0; i < m_vShards.size(); ++i) {
+    if(m_vShards[i]->owner != self) { continue; }
+    m_Retired->Absorb(*m_vShards[i], m_iFrame.load());
+    m_vShards.erase(m_vShards.begin() + std::ptrdiff_t(i));
+    return;
+  }
+}
+
+PerfRegistry::Slot* PerfRegistry::LocalSlot(ID id) {
+  Shard* shard = LocalShard();
+  Slot* slot = shard->slots[id].load(std::memory_order_acquire);
+  if(!slot) {
+    slot = new Slot();
+    shard->slots[id].store(slot, std::memory_order_release);
+  }
+  return slot;
+}
+
+void PerfRegistry::Add(ID id, double amount) {
+  assert(id < m_iCount.load(std::memory_order_relaxed));
+  if(id >= m_iCount.load(std::memory_order_relaxed)) { return; }
+
+  Slot* slot = LocalSlot(id);
+  add(slot->sum, amount);
+  add(slot->count, uint64_t(1));
+  add(slot->buckets[bucket(amount)], uint64_t(1));
+
+  // the first sample of a new frame replaces the old maximum
+  const uint64_t frame = m_iFrame.load(std::memory_order_relaxed);
+  if(slot->frame.load(std::memory_order_relaxed) != frame) {
+    slot->frameMax.store(amount, std::memory_order_relaxed);
+    slot->frame.store(frame, std::memory_order_release);
+  } else if(amount > slot->frameMax.load(std::memory_order_relaxed)) {
+    slot->frameMax.store(amount, std::memory_order_relaxed);
+  }
+}
+
+void PerfRegistry::Gather(ID id, Totals& t) const {
+  t = Totals();
+  for(size_t i=0; i <= m_vShards.size(); ++i) {
+    const Shard& shard = i < m_vShards.size() ? *m_vShards[i] : *m_Retired;
+    const Slot* slot = shard.slots[id].load(std::memory_order_acquire);
+    if(!slot) { continue; }
+    t.sum += slot->sum.load(std::memory_order_relaxed);
+    t.count += slot->count.load(std::memory_order_relaxed);
+    if(slot->frame.load(std::memory_order_acquire) == m_iFrame.load()) {
+      t.frameMax = std::max(t.frameMax,
+                            slot->frameMax.load(std::memory_order_relaxed));
+    }
+    for(size_t b=0; b < NumBuckets; ++b) {
+      t.buckets[b] += slot->buckets[b].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+double PerfRegistry::Query(ID id) {
+  SCOPEDLOCK(m_Guard);
+  assert(id < m_vNames.size());
+  if(id >= m_vNames.size()) { return 0.0; }
+  Totals t;
+  Gather(id, t);
+  const double sum = t.sum - m_vQueried[id];
+  m_vQueried[id] = t.sum;
+  return sum;
+}
+
+namespace {
+  // value below which a fraction 'p' of the samples in 'buckets' lie.
+  double percentile(const std::vector<uint64_t>& buckets, uint64_t count,
+                    double p) {
+    const uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(p*count)));
+    uint64_t seen = 0;
+    for(size_t b=0; b < buckets.size(); ++b) {
+      seen += buckets[b];
+      if(seen >= rank) { return bucket_mid(b); }
+    }
+    return bucket_mid(buckets.size()-1);
+  }
+}
+
+std::vector<PerfRegistry::Stats> PerfRegistry::Snapshot(bool bNewFrame) {
+  SCOPEDLOCK(m_Guard);
+  std::vector<Stats> stats;
+  Totals now;
+  std::vector<uint64_t> frame(NumBuckets);
+  for(ID id=0; id < ID(m_vNames.size()); ++id) {
+    Gather(id, now);
+    const Totals& start = *m_vFrameStart[id];
+    const uint64_t count = now.count - start.count;
+    if(count == 0) { continue; }
+
+    size_t top = 0;
+    for(size_t b=0; b < NumBuckets; ++b) {
+      frame[b] = now.buckets[b] - start.buckets[b];
+      if(frame[b]) { top = b; }
+    }
+    Stats s;
+    s.name = m_vNames[id];
+    s.units = m_vUnits[id];
+    s.count = count;
+    s.sum = now.sum - start.sum;
+    s.mean = s.sum / double(count);
+    // a sample racing with the start of the frame might not have made it
+    // into frameMax; the histogram bounds it anyway.
+    s.max = now.frameMax >= 0 ? now.frameMax
+                              : (top == 0 ? 0.0 : bucket_start(top+1));
+    s.p50 = std::min(s.max, percentile(frame, count, 0.50));
+    s.p99 = std::min(s.max, percentile(frame, count, 0.99));
+    stats.push_back(s);
+
+    if(bNewFrame) { *m_vFrameStart[id] = now; }
+  }
+  if(bNewFrame) { ++m_iFrame; }
+  return stats;
+}
+
+namespace {
+  std::string quoted(const std::string& str) {
+    std::string q("\"");
+    for(std::string::const_iterator c = str.begin(); c != str.end(); ++c) {
+      if(*c == '"' || *c == '\\') { q += '\\'; }
+      q += *c;
+    }
+    return q + "\"";
+  }
+}
+
+std::string PerfRegistry::JSON(bool bNewFrame) {
+  const std::vector<Stats> stats = Snapshot(bNewFrame);
+  std::ostringstream json;
+  json << std::setprecision(10) << "{";
+  for(size_t i=0; i < stats.size(); ++i) {
+    const Stats& s = stats[i];
+    json << (i ? ",\n " : "\n ") << quoted(s.name) << ": {"
+         << "\"units\": " << quoted(s.units)
+         << ", \"count\": " << s.count << ", \"sum\": " << s.sum
+         << ", \"mean\": " << s.mean << ", \"p50\": " << s.p50
+         << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+  }
+  json << "\n}\n";
+  return json.str();
+}
+
+std::string PerfRegistry::CSV(bool bNewFrame) {
+  const std::vector<Stats> stats = Snapshot(bNewFrame);
+  std::ostringstream csv;
+  csv << std::setprecision(10) << "name,units,count,sum,mean,p50,p99,max\n";
+  for(size_t i=0; i < stats.size(); ++i) {
+    const Stats& s = stats[i];
+    csv << s.name << "," << s.units << "," << s.count << "," << s.sum << ","
+        << s.mean << "," << s.p50 << "," << s.p99 << "," << s.max << "\n";
+  }
+  return csv.str();
+}
+
+}
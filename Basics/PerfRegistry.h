@@ -0,0 +1,99 @@
+#ifndef TUVOK_PERF_REGISTRY_H
+#define TUVOK_PERF_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PerfCounter.h"
+#include "Threads.h"
+
+namespace tuvok {
+
+/// Collects performance measurements.  Counters are identified by an id;
+/// the builtin PerfCounter values are preregistered with their enum value
+/// as id, anything else can be added at runtime via Register.
+///
+/// Every thread accumulates into its own set of slots, so Add never takes a
+/// lock and never contends with other threads.  When a thread exits, its
+/// slots are folded into the registry's totals and freed.  Besides the sum, each slot
+/// keeps a log-scale histogram of the individual samples, which is what the
+/// percentiles in a Snapshot are computed from (accurate to ~6%).
+///
+/// Nothing is ever reset: PerfQuery and Snapshot remember what they
+/// reported last time and return the difference.
+class PerfRegistry {
+public:
+  typedef uint32_t ID;
+  static const size_t MaxCounters = 256;
+  static const ID Invalid = ID(-1);
+
+  PerfRegistry();
+  ~PerfRegistry();
+
+  /// @returns the id of the counter 'name', adding it if needed.  'units'
+  /// should say how to interpret the values (milliseconds, bytes, ...).
+  /// Returns Invalid if there is no room for another counter.
+  ID Register(const std::string& name, const std::string& units);
+  /// @returns the id of counter 'name', or Invalid if there is none.
+  ID Find(const std::string& name) const;
+  size_t Count() const;
+  std::string Name(ID id) const;
+  std::string Units(ID id) const;
+
+  /// records one sample of 'amount' for counter 'id'.  Lock-free.
+  void Add(ID id, double amount);
+
+  /// @returns the sum of all samples since the last Query for 'id'.
+  double Query(ID id);
+
+  struct Stats {
+    std::string name;
+    std::string units;
+    uint64_t count;  ///< number of samples
+    double sum;
+    double mean;
+    double p50;
+    double p99;
+    double max;
+  };
+  /// statistics of all counters which saw samples since the last frame
+  /// started.  Starts a new frame if 'bNewFrame' is set.
+  std::vector<Stats> Snapshot(bool bNewFrame);
+  /// the Snapshot as JSON (an object keyed by counter name) or CSV (one
+  /// line per counter with a header line).
+  std::string JSON(bool bNewFrame);
+  std::string CSV(bool bNewFrame);
+
+  struct Slot;
+  struct Shard;
+  struct Totals;
+
+private:
+  friend void ReleaseThreadShards();
+  /// folds the calling thread's shard into m_Retired and drops it.
+  void ReleaseShard();
+  Shard* LocalShard();
+  Slot* LocalSlot(ID id);
+  /// sums up all threads' slots of counter 'id'
+  void Gather(ID id, Totals& t) const;
+
+  const uint64_t m_iInstance; ///< distinguishes registries in the TLS cache
+  mutable CriticalSection m_Guard;
+  std::vector<std::string> m_vNames;
+  std::vector<std::string> m_vUnits;
+  std::atomic<size_t> m_iCount;
+  std::atomic<uint64_t> m_iFrame;
+  std::vector<std::unique_ptr<Shard>> m_vShards;
+  std::unique_ptr<Shard> m_Retired;   ///< samples of threads which exited
+  std::vector<double> m_vQueried;     ///< sums at the last Query
+  std::vector<std::unique_ptr<Totals>> m_vFrameStart; ///< at frame start
+
+  PerfRegistry(const PerfRegistry&);
+  PerfRegistry& operator=(const PerfRegistry&);
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_VALUEOCCUPANCY_H
+#define TUVOK_VALUEOCCUPANCY_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace tuvok {
+
+/// Sorted, disjoint [first, second] ranges of scalar values, e.g. the ones a
+/// transfer function maps to a non-zero opacity.
+typedef std::vector<std::pair<double, double>> ValueRanges;
+
+/// Which values a brick actually holds.  Its scalar range [fMin, fMax] is
+/// cut into 64 equally wide bins, and bit i of iBins is set if some value of
+/// the brick falls into bin i.  Min/max alone cannot tell that a brick of
+/// air and a few voxels of bone holds nothing a soft-tissue TF shows.
+class ValueOccupancy {
+public:
+  enum { Bins = 64 };
+  /// every bin occupied: all we know is the brick's min/max.
+  enum : uint64_t { All = ~uint64_t(0) };
+
+  /// maps the values of [fMin, fMax] to their bins.  Building the bitmap and
+  /// testing against it must both go through this, so that a value inside a
+  /// range always lands in one of the range's bins.
+  class Binning {
+  public:
+    Binning(double fMin, double fMax) : m_fMin(fMin),
+      m_fScale(fMax > fMin ? double(Bins) / (fMax - fMin) : 0.0) {}
+    unsigned operator()(double v) const {
+      const double b = (v - m_fMin) * m_fScale;
+      return b > 0.0 ? (b < double(Bins-1) ? unsigned(b) : unsigned(Bins-1))
+                     : 0u;
+    }
+  private:
+    double m_fMin;
+    double m_fScale;
+  };
+
+  ValueOccupancy() : fMin(DBL_MAX), fMax(-DBL_MAX), iBins(All) {}
+  ValueOccupancy(double _fMin, double _fMax, uint64_t _iBins=All) :
+    fMin(_fMin), fMax(_fMax), iBins(_iBins) {}
+
+  /// @returns the bins which overlap [lo, hi]; 0 if it misses the brick.
+  uint64_t Mask(double lo, double hi) const {
+    if(hi < fMin || lo > fMax || lo > hi) { return 0; }
+    const Binning bin(fMin, fMax);
+    const unsigned a = bin(lo), b = bin(hi);
+    const uint64_t upto = b+1 < unsigned(Bins) ? (uint64_t(1) << (b+1)) - 1
+                                               : All;
+    return upto & ~((uint64_t(1) << a) - 1);
+  }
+
+  /// @returns true if some value of the brick may lie in one of 'ranges'.
+  bool Intersects(const ValueRanges& ranges) const {
+    ValueRanges::const_iterator r = std::lower_bound(
+      ranges.begin(), ranges.end(), fMin,
+      [](const std::pair<double,double>& a, double v) { return a.second < v; }
+    );
+    uint64_t mask = 0;
+    for(; r != ranges.end() && r->first <= fMax; ++r) {
+      mask |= Mask(r->first, r->second);
+    }
+    return (mask & iBins) != 0;
+  }
+
+  double fMin;
+  double fMax;
+  uint64_t iBins;
+};
+
+}
+#endif // TUVOK_VALUEOCCUPANCY_H
@@ -288,10 +288,10 @@ public:
     }
   }
 
-  VECTOR3<T> abs() const FUNC_CONST {return VECTOR3<T>(fabs(x),fabs(y),fabs(z));}
-  T maxVal() const FUNC_CONST {return MAX(x,MAX(y,z));}
-  T minVal() const FUNC_CONST {return MIN(x,MIN(y,z));}
-  T volume() const FUNC_CONST {return x*y*z;}
+  VECTOR3<T> abs() const FUNC_PURE {return VECTOR3<T>(fabs(x),fabs(y),fabs(z));}
+  T maxVal() const FUNC_PURE {return MAX(x,MAX(y,z));}
+  T minVal() const FUNC_PURE {return MIN(x,MIN(y,z));}
+  T volume() const FUNC_PURE {return x*y*z;}
   T length() const { return sqrt(
     T(this->x*this->x + this->y*this->y + this->z*this->z));
   }
@@ -308,7 +308,7 @@ public:
       z = replacement.z;
     }
   }
-  VECTOR3<T> normalized() const FUNC_CONST {
+  VECTOR3<T> normalized() const FUNC_PURE {
     T len = length(); 
     return VECTOR3<T>(x/len,y/len,z/len);
   }
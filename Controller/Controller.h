@@ -66,21 +66,28 @@ namespace Controller {
   };
 }}
 
-#define T_ERROR(...)                                              \
+/// Channels after this one are compiled out of the macros below; e.g.
+/// -DTUVOK_DEBUG_CHANNELS=AbstrDebugOut::CHANNEL_WARNING keeps only errors
+/// and warnings.  Whether compiled in or not, the arguments of a message are
+/// not evaluated when its channel is off.
+#ifndef TUVOK_DEBUG_CHANNELS
+# define TUVOK_DEBUG_CHANNELS AbstrDebugOut::CHANNEL_OTHER
+#endif
+#define TUVOK_DEBUG_(channel, show, method, ...)                  \
   do {                                                            \
-    tuvok::Controller::Debug::Out().Error(_func_, __VA_ARGS__);   \
-  } while(0)
-#define WARNING(...)                                              \
-  do {                                                            \
-    tuvok::Controller::Debug::Out().Warning(_func_, __VA_ARGS__); \
-  } while(0)
-#define MESSAGE(...)                                              \
-  do {                                                            \
-    tuvok::Controller::Debug::Out().Message(_func_, __VA_ARGS__); \
-  } while(0)
-#define OTHER(...)                                                \
-  do {                                                            \
-    tuvok::Controller::Debug::Out().Other(_func_, __VA_ARGS__);   \
+    if(AbstrDebugOut::channel <= TUVOK_DEBUG_CHANNELS) {          \
+      AbstrDebugOut& dbgOut_ = tuvok::Controller::Debug::Out();   \
+      if(dbgOut_.show()) { dbgOut_.method(_func_, __VA_ARGS__); } \
+    }                                                             \
   } while(0)
 
+#define T_ERROR(...) \
+  TUVOK_DEBUG_(CHANNEL_ERROR, ShowErrors, Error, __VA_ARGS__)
+#define WARNING(...) \
+  TUVOK_DEBUG_(CHANNEL_WARNING, ShowWarnings, Warning, __VA_ARGS__)
+#define MESSAGE(...) \
+  TUVOK_DEBUG_(CHANNEL_MESSAGE, ShowMessages, Message, __VA_ARGS__)
+#define OTHER(...) \
+  TUVOK_DEBUG_(CHANNEL_OTHER, ShowOther, Other, __VA_ARGS__)
+
 #endif // TUVOK_CONTROLLER_H
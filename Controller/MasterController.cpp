@@ -87,7 +87,6 @@ MasterController::MasterController() :
   LuaScript()->cexec("provenance.enable", false);
 
   RState.BStrategy = RendererState::BS_SkipTwoLevels;
-  std::fill(m_Perf, m_Perf+PERF_END, 0.0);
 }
 
 
@@ -303,15 +302,11 @@ unsigned MasterController::GetHTSize() const {
 
 
 double MasterController::PerfQuery(enum PerfCounter pc) {
-  assert(pc < PERF_END);
-  double tmp = m_Perf[pc];
-  m_Perf[pc] = 0.0;
-  return tmp;
+  return m_Perf.Query(pc);
 }
 void MasterController::IncrementPerfCounter(enum PerfCounter pc,
                                             double amount) {
-  assert(pc < PERF_END);
-  m_Perf[pc] += amount;
+  m_Perf.Add(pc, amount);
 }
 
 void MasterController::SetMaxGPUMem(uint64_t megs) {
@@ -341,36 +336,12 @@ void register_unsigned(lua_State* lua, const char* name, unsigned value) {
   lua_setglobal(lua, name);
 }
 
-void register_perf_enum(std::shared_ptr<LuaScripting>& ss) {
+void register_perf_enum(std::shared_ptr<LuaScripting>& ss,
+                        const PerfRegistry& perf) {
   lua_State* lua = ss->getLuaState();
-  register_unsigned(lua, "PERF_SUBFRAMES", PERF_SUBFRAMES);
-  register_unsigned(lua, "PERF_RENDER", PERF_RENDER);
-  register_unsigned(lua, "PERF_RAYCAST", PERF_RAYCAST);
-  register_unsigned(lua, "PERF_READ_HTABLE", PERF_READ_HTABLE);
-  register_unsigned(lua, "PERF_CONDENSE_HTABLE", PERF_CONDENSE_HTABLE);
-  register_unsigned(lua, "PERF_SORT_HTABLE", PERF_SORT_HTABLE);
-  register_unsigned(lua, "PERF_UPLOAD_BRICKS", PERF_UPLOAD_BRICKS);
-  register_unsigned(lua, "PERF_POOL_SORT", PERF_POOL_SORT);
-  register_unsigned(lua, "PERF_POOL_UPLOADED_MEM", PERF_POOL_UPLOADED_MEM);
-  register_unsigned(lua, "PERF_POOL_GET_BRICK", PERF_POOL_GET_BRICK);
-  register_unsigned(lua, "PERF_DY_GET_BRICK", PERF_DY_GET_BRICK);
-  register_unsigned(lua, "PERF_DY_CACHE_LOOKUPS", PERF_DY_CACHE_LOOKUPS);
-  register_unsigned(lua, "PERF_DY_CACHE_LOOKUP", PERF_DY_CACHE_LOOKUP);
-  register_unsigned(lua, "PERF_DY_RESERVE_BRICK", PERF_DY_RESERVE_BRICK);
-  register_unsigned(lua, "PERF_DY_LOAD_BRICK", PERF_DY_LOAD_BRICK);
-  register_unsigned(lua, "PERF_DY_CACHE_ADDS", PERF_DY_CACHE_ADDS);
-  register_unsigned(lua, "PERF_DY_CACHE_ADD", PERF_DY_CACHE_ADD);
-  register_unsigned(lua, "PERF_DY_BRICK_COPIED", PERF_DY_BRICK_COPIED);
-  register_unsigned(lua, "PERF_DY_BRICK_COPY", PERF_DY_BRICK_COPY);
-  register_unsigned(lua, "PERF_POOL_UPLOAD_BRICK", PERF_POOL_UPLOAD_BRICK);
-  register_unsigned(lua, "PERF_POOL_UPLOAD_TEXEL", PERF_POOL_UPLOAD_TEXEL);
-  register_unsigned(lua, "PERF_POOL_UPLOAD_METADATA", PERF_POOL_UPLOAD_METADATA);
-  register_unsigned(lua, "PERF_EO_BRICKS", PERF_EO_BRICKS);
-  register_unsigned(lua, "PERF_EO_DISK_READ", PERF_EO_DISK_READ);
-  register_unsigned(lua, "PERF_EO_DECOMPRESSION", PERF_EO_DECOMPRESSION);
-
-  register_unsigned(lua, "PERF_MM_PRECOMPUTE", PERF_MM_PRECOMPUTE);
-  register_unsigned(lua, "PERF_SOMETHING", PERF_SOMETHING);
+  for(unsigned pc = 0; pc < unsigned(PERF_END); ++pc) {
+    register_unsigned(lua, perf.Name(pc).c_str(), pc);
+  }
 }
 
 void MasterController::RegisterLuaCommands() {
@@ -502,11 +473,20 @@ void MasterController::RegisterLuaCommands() {
     &MasterController::PerfQuery, "tuvok.perf",
     "queries performance information.  meaning is query-specific.", false
   );
+  m_pMemReg->registerFunction(&m_Perf, &PerfRegistry::Find,
+    "tuvok.perfCounter", "looks up the id of the named performance counter, "
+    "for use with tuvok.perf.", false);
+  m_pMemReg->registerFunction(&m_Perf, &PerfRegistry::JSON, "tuvok.perfJSON",
+    "sum, mean, p50, p99 and max of every performance counter since the "
+    "frame started, as JSON.  Starts a new frame if the argument is true.",
+    false);
+  m_pMemReg->registerFunction(&m_Perf, &PerfRegistry::CSV, "tuvok.perfCSV",
+    "same as tuvok.perfJSON, but as CSV.", false);
   ss->registerFunction(&SysTools::basename, "basename",
                        "basename for the given filename", false);
   ss->registerFunction(&SysTools::dirname, "dirname",
                        "dirname for the given filename", false);
-  register_perf_enum(ss);
+  register_perf_enum(ss, m_Perf);
 
   // Register Tuvok specific math functions...
   LuaMathFunctions::registerMathFunctions(ss);
@@ -38,6 +38,7 @@
 #include <vector>
 
 #include "Basics/PerfCounter.h"
+#include "Basics/PerfRegistry.h"
 #include "Basics/Vectors.h"
 #include "../DebugOut/MultiplexOut.h"
 #include "../DebugOut/ConsoleOut.h"
@@ -184,6 +185,8 @@ public:
   /// @warning Querying a metric resets it!
   double PerfQuery(enum PerfCounter);
   void IncrementPerfCounter(enum PerfCounter, double amount);
+  /// all performance counters, including ones registered at runtime.
+  PerfRegistry& Perf() { return m_Perf; }
 
 private:
   /// Initializer; add all our builtin commands.
@@ -230,7 +233,7 @@ private:
   AbstrRenderer*   m_pActiveRenderer;
 
   /// for PerfCounter tracking.
-  double m_Perf[PERF_END];
+  PerfRegistry m_Perf;
 };
 
 }
@@ -2,6 +2,7 @@
 #define TUVOK_STACK_TIMER_H
 
 #include "Basics/PerfCounter.h"
+#include "Basics/PerfRegistry.h"
 #include "Basics/Timer.h"
 #include "Controller.h"
 
@@ -15,14 +16,20 @@ namespace tuvok {
 ///     StackTimer task_identifier(PERF_DISK_READ);
 ///     this->Function();
 ///   }
+///
+/// Counters registered at runtime work just as well:
+///
+///   static const PerfRegistry::ID id =
+///     Controller::Instance().Perf().Register("my.task", "milliseconds");
+///   StackTimer task_identifier(id);
 struct StackTimer {
-  StackTimer(enum PerfCounter pc) : counter(pc) {
+  StackTimer(PerfRegistry::ID pc) : counter(pc) {
     timer.Start();
   }
   ~StackTimer() {
-    Controller::Instance().IncrementPerfCounter(counter, timer.Elapsed());
+    Controller::Instance().Perf().Add(counter, timer.Elapsed());
   }
-  enum PerfCounter counter;
+  PerfRegistry::ID counter;
   Timer timer;
 };
 
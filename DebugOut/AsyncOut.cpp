@@ -0,0 +1,279 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    AsyncOut.cpp
+  \date    October 2013
+*/
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include "AsyncOut.h"
+#include "Basics/Threads.h"
+
+using tuvok::LambdaThread;
+
+/// A message on its way to the writer.  'seq' tells whose turn the slot is:
+/// it equals the position of the next message to be written into it, and is
+/// one more than that once the message is ready to be passed on.
+struct AsyncOut::Slot {
+  Slot() : seq(0), channel(CHANNEL_NONE), bRaw(false), pLong(NULL) {
+    source[0] = msg[0] = '\0';
+  }
+  std::atomic<size_t> seq;
+  DebugChannel channel;
+  bool bRaw;
+  char* pLong; ///< messages which do not fit into 'msg'
+  char source[64];
+  char msg[432];
+};
+
+namespace {
+  // like vsnprintf: @returns the length of the whole message, even if only
+  // part of it fit.
+  int format(char* buf, size_t iSize, const char* fmt, va_list args) {
+#ifdef DETECTED_OS_WINDOWS
+    va_list copy;
+    va_copy(copy, args);
+    const int iLength = _vscprintf(fmt, copy);
+    va_end(copy);
+    _vsnprintf_s(buf, iSize, _TRUNCATE, fmt, args);
+    return iLength;
+#else
+    return vsnprintf(buf, iSize, fmt, args);
+#endif
+  }
+}
+
+AsyncOut::AsyncOut(AbstrDebugOut* pTarget, size_t iCapacity) :
+  m_pTarget(pTarget),
+  m_iMask(1),
+  m_iHead(0),
+  m_iTail(0),
+  m_iDropped(0),
+  m_iReported(0),
+  m_bIdle(false)
+{
+  while(m_iMask+1 < iCapacity) { m_iMask = m_iMask*2 + 1; }
+  m_pSlots.reset(new Slot[m_iMask+1]);
+  for(size_t i=0; i <= m_iMask; ++i) { m_pSlots[i].seq.store(i); }
+
+  m_bShowMessages = m_pTarget->ShowMessages();
+  m_bShowWarnings = m_pTarget->ShowWarnings();
+  m_bShowErrors = m_pTarget->ShowErrors();
+  m_bShowOther = m_pTarget->ShowOther();
+
+  m_pWriter.reset(new LambdaThread(
+    [this](const bool& bContinue, LambdaThread::Interface& thread) {
+      while(bContinue) {
+        this->Drain();
+        // producers only wake us up when they see m_bIdle.  Setting it
+        // before looking at the buffer again means that either we see their
+        // message or they see that we are going to sleep.
+        this->m_bIdle.store(true);
+        thread.Suspend([this, &bContinue]() {
+          return bContinue && this->Empty();
+        });
+        this->m_bIdle.store(false);
+      }
+      this->Drain();
+    }
+  ));
+  m_pWriter->StartThread();
+}
+
+AsyncOut::~AsyncOut() {
+  m_pWriter->RequestThreadStop();
+  m_pWriter->JoinThread();
+}
+
+void AsyncOut::Push(enum DebugChannel channel, bool bRaw, const char* source,
+                    const char* fmt, va_list args) const
+{
+  size_t pos = m_iHead.load(std::memory_order_relaxed);
+  Slot* slot;
+  for(;;) {
+    slot = &m_pSlots[pos & m_iMask];
+    const size_t seq = slot->seq.load(std::memory_order_acquire);
+    const intptr_t diff = intptr_t(seq) - intptr_t(pos);
+    if(diff == 0) {
+      if(m_iHead.compare_exchange_weak(pos, pos+1,
+                                       std::memory_order_relaxed)) {
+        break;
+      }
+    } else if(diff < 0) { // the writer has not passed it on yet: full.
+      ++m_iDropped;
+      return;
+    } else { // someone else claimed it; try the next one.
+      pos = m_iHead.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->channel = channel;
+  slot->bRaw = bRaw;
+  const size_t iSource = std::min(strlen(source), sizeof(slot->source)-1);
+  memcpy(slot->source, source, iSource);
+  slot->source[iSource] = '\0';
+
+  va_list copy;
+  va_copy(copy, args);
+  const int iLength = format(slot->msg, sizeof(slot->msg), fmt, args);
+  if(iLength >= int(sizeof(slot->msg))) {
+    // if there is no memory for it, the truncated message will do.
+    slot->pLong = new (std::nothrow) char[iLength+1];
+    if(slot->pLong) { format(slot->pLong, iLength+1, fmt, copy); }
+  }
+  va_end(copy);
+
+  slot->seq.store(pos+1);
+  if(m_bIdle.load()) { m_pWriter->Resume(); }
+}
+
+void AsyncOut::PushF(enum DebugChannel channel, bool bRaw,
+                     const char* source, const char* fmt, ...) const
+{
+  va_list args;
+  va_start(args, fmt);
+  Push(channel, bRaw, source, fmt, args);
+  va_end(args);
+}
+
+void AsyncOut::Drain() {
+  size_t tail = m_iTail.load(std::memory_order_relaxed);
+  for(;;) {
+    Slot& slot = m_pSlots[tail & m_iMask];
+    if(slot.seq.load(std::memory_order_acquire) != tail+1) { break; }
+
+    const char* msg = slot.pLong ? slot.pLong : slot.msg;
+    if(slot.bRaw) {
+      m_pTarget->printf(msg);
+    } else if(m_pTarget->Enabled(slot.channel)) {
+      m_pTarget->printf(slot.channel, slot.source, msg);
+    }
+    delete[] slot.pLong;
+    slot.pLong = NULL;
+
+    slot.seq.store(tail + m_iMask+1, std::memory_order_release);
+    m_iTail.store(++tail, std::memory_order_release);
+  }
+
+  const uint64_t iDropped = m_iDropped.load();
+  if(iDropped != m_iReported.load(std::memory_order_relaxed)) {
+    const std::string msg = std::to_string(iDropped - m_iReported.load()) +
+      " message(s) dropped: the log could not keep up.";
+    m_pTarget->printf(CHANNEL_WARNING, _func_, msg.c_str());
+    m_iReported.store(iDropped);
+  }
+}
+
+bool AsyncOut::Empty() const {
+  const size_t tail = m_iTail.load(std::memory_order_relaxed);
+  return m_pSlots[tail & m_iMask].seq.load() != tail+1;
+}
+
+void AsyncOut::Flush() {
+  const size_t head = m_iHead.load();
+  while(intptr_t(m_iTail.load() - head) < 0 ||
+        m_iReported.load() != m_iDropped.load()) {
+    m_pWriter->Resume();
+    std::this_thread::yield();
+  }
+}
+
+void AsyncOut::printf(enum DebugChannel channel, const char* source,
+                      const char* msg)
+{
+  PushF(channel, false, source, "%s", msg);
+}
+
+void AsyncOut::printf(const char *s) const
+{
+  PushF(CHANNEL_NONE, true, "", "%s", s);
+}
+
+void AsyncOut::Other(const char *source, const char* format, ...)
+{
+  if (!m_bShowOther) return;
+  va_list args;
+  va_start(args, format);
+  Push(CHANNEL_OTHER, false, source, format, args);
+  va_end(args);
+}
+
+void AsyncOut::Message(const char* source, const char* format, ...)
+{
+  if (!m_bShowMessages) return;
+  va_list args;
+  va_start(args, format);
+  Push(CHANNEL_MESSAGE, false, source, format, args);
+  va_end(args);
+}
+
+void AsyncOut::Warning(const char* source, const char* format, ...)
+{
+  if (!m_bShowWarnings) return;
+  va_list args;
+  va_start(args, format);
+  Push(CHANNEL_WARNING, false, source, format, args);
+  va_end(args);
+}
+
+void AsyncOut::Error(const char* source, const char* format, ...)
+{
+  if (!m_bShowErrors) return;
+  va_list args;
+  va_start(args, format);
+  Push(CHANNEL_ERROR, false, source, format, args);
+  va_end(args);
+}
+
+void AsyncOut::SetShowMessages(bool bShowMessages) {
+  AbstrDebugOut::SetShowMessages(bShowMessages);
+  m_pTarget->SetShowMessages(bShowMessages);
+}
+
+void AsyncOut::SetShowWarnings(bool bShowWarnings) {
+  AbstrDebugOut::SetShowWarnings(bShowWarnings);
+  m_pTarget->SetShowWarnings(bShowWarnings);
+}
+
+void AsyncOut::SetShowErrors(bool bShowErrors) {
+  AbstrDebugOut::SetShowErrors(bShowErrors);
+  m_pTarget->SetShowErrors(bShowErrors);
+}
+
+void AsyncOut::SetShowOther(bool bShowOther) {
+  AbstrDebugOut::SetShowOther(bShowOther);
+  m_pTarget->SetShowOther(bShowOther);
+}
@@ -0,0 +1,102 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    AsyncOut.h
+  \date    October 2013
+*/
+
+#pragma once
+
+#ifndef TUVOK_ASYNCOUT_H
+#define TUVOK_ASYNCOUT_H
+
+#include <atomic>
+#include <memory>
+#include "AbstrDebugOut.h"
+
+namespace tuvok { class LambdaThread; }
+
+/// Passes messages on to another debug out from a background thread.  The
+/// calling thread only formats the message into a slot of a bounded,
+/// lock-free ring buffer; time stamps, the target's own formatting and all
+/// I/O happen on the writer thread.  When the buffer is full the message is
+/// dropped (and counted) instead of blocking the caller.
+class AsyncOut : public AbstrDebugOut {
+  public:
+    /// takes ownership of 'pTarget'.  'iCapacity' is the number of messages
+    /// which can be in flight; it is rounded up to a power of two.
+    AsyncOut(AbstrDebugOut* pTarget, size_t iCapacity=1024);
+    ~AsyncOut();
+
+    virtual void printf(enum DebugChannel, const char* source,
+                        const char* msg);
+    virtual void printf(const char *s) const;
+    virtual void Other(const char *source, const char* format, ...);
+    virtual void Message(const char* source, const char* format, ...);
+    virtual void Warning(const char* source, const char* format, ...);
+    virtual void Error(const char* source, const char* format, ...);
+
+    virtual void SetShowMessages(bool bShowMessages);
+    virtual void SetShowWarnings(bool bShowWarnings);
+    virtual void SetShowErrors(bool bShowErrors);
+    virtual void SetShowOther(bool bShowOther);
+
+    /// blocks until everything queued so far was passed on.
+    void Flush();
+    /// @returns the number of messages dropped because the buffer was full.
+    uint64_t Dropped() const { return m_iDropped.load(); }
+
+    struct Slot;
+
+  private:
+    AsyncOut(const AsyncOut&); ///< unimplemented.
+    AsyncOut& operator=(const AsyncOut&); ///< unimplemented.
+
+    /// formats the message into a free slot and hands it to the writer.
+    /// 'bRaw' messages go to the target's printf(const char*).
+    void Push(enum DebugChannel, bool bRaw, const char* source,
+              const char* format, va_list args) const;
+    void PushF(enum DebugChannel, bool bRaw, const char* source,
+               const char* format, ...) const;
+    /// writer thread: passes on everything published so far.
+    void Drain();
+    bool Empty() const;
+
+    std::unique_ptr<AbstrDebugOut> m_pTarget;
+    size_t m_iMask;
+    std::unique_ptr<Slot[]> m_pSlots;
+    mutable std::atomic<size_t> m_iHead; ///< next slot to be claimed
+    std::atomic<size_t> m_iTail;         ///< next slot to be passed on
+    mutable std::atomic<uint64_t> m_iDropped;
+    std::atomic<uint64_t> m_iReported;   ///< drops the writer reported
+    mutable std::atomic<bool> m_bIdle;   ///< writer is (about to be) asleep
+    std::unique_ptr<tuvok::LambdaThread> m_pWriter;
+};
+
+#endif // TUVOK_ASYNCOUT_H
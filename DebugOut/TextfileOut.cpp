@@ -45,7 +45,8 @@
 using namespace std;
 
 TextfileOut::TextfileOut(std::string strFilename) :
-  m_strFilename(strFilename)
+  m_strFilename(strFilename),
+  m_file(strFilename.c_str(), ios_base::app)
 {
   this->Message(_func_, "Starting up");
 }
@@ -57,6 +58,8 @@ TextfileOut::~TextfileOut() {
 void TextfileOut::printf(enum DebugChannel channel, const char* source,
                          const char* buff)
 {
+  // guards the stream and localtime's static buffer
+  SCOPEDLOCK(m_Guard);
   time_t epoch_time;
   time(&epoch_time);
 
@@ -72,21 +75,19 @@ void TextfileOut::printf(enum DebugChannel channel, const char* source,
 #endif
   char datetime[64];
 
-  ofstream fs;
-  fs.open(m_strFilename.c_str(), ios_base::app);
-  if (fs.fail()) return;
+  if (!m_file.is_open() || m_file.fail()) return;
 
   if(strftime(datetime, 64, "(%d.%m.%Y %H:%M:%S)", ADDR_NOW) > 0) {
-    fs << datetime << " ";
+    m_file << datetime << " ";
   }
-  fs << ChannelToString(channel) << " (" << source << ") " << buff << std::endl;
-
-  fs.flush();
-  fs.close();
+  m_file << ChannelToString(channel) << " (" << source << ") " << buff
+         << std::endl;
 }
 
 void TextfileOut::printf(const char *s) const
 {
+  // guards the stream and localtime's static buffer
+  SCOPEDLOCK(m_Guard);
   time_t epoch_time;
   time(&epoch_time);
 
@@ -102,16 +103,11 @@ void TextfileOut::printf(const char *s) const
 #endif
   char datetime[64];
 
-  ofstream fs;
-  fs.open(m_strFilename.c_str(), ios_base::app);
-  if (fs.fail()) return;
+  if (!m_file.is_open() || m_file.fail()) return;
 
   if(strftime(datetime, 64, "(%d.%m.%Y %H:%M:%S)", ADDR_NOW) > 0) {
-    fs << datetime << " " << s << std::endl;
+    m_file << datetime << " " << s << std::endl;
   } else {
-    fs << s << std::endl;
+    m_file << s << std::endl;
   }
-
-  fs.flush();
-  fs.close();
 }
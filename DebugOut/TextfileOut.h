@@ -41,8 +41,10 @@
 #ifndef TUVOK_TEXTFILEOUT_H
 #define TUVOK_TEXTFILEOUT_H
 
+#include <fstream>
 #include <string>
 #include "AbstrDebugOut.h"
+#include "Basics/Threads.h"
 
 class TextfileOut : public AbstrDebugOut {
   public:
@@ -59,6 +61,9 @@ class TextfileOut : public AbstrDebugOut {
 
   private:
     std::string m_strFilename;
+    /// opened once; reopening the file for every message is very slow.
+    mutable std::ofstream m_file;
+    mutable tuvok::CriticalSection m_Guard;
 
     /// same as printf above but does regard m_bShowOther
     void _printf(const char* format, ...) const;
@@ -36,6 +36,7 @@
 #include <cctype>
 #include <vector>
 #include "AbstrGeoConverter.h"
+#include "Mesh.h"
 #include "SysTools.h"
 
 using namespace tuvok;
@@ -50,6 +51,50 @@ bool AbstrGeoConverter::ConvertToNative(const Mesh&,
   return false;
 }
 
+namespace {
+  // Collects the whole mesh and hands it to the converter at the end.
+  class BufferingMeshSink : public MeshSink {
+  public:
+    BufferingMeshSink(AbstrGeoConverter& conv, const std::string& filename,
+                      const std::string& desc, const FLOATVECTOR4& color) :
+      m_conv(conv), m_strFilename(filename), m_strDesc(desc),
+      m_vColor(color) {}
+
+    virtual bool Append(const VertVec& vertices, const NormVec& normals,
+                        const IndexVec& triangles) {
+      m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+      m_normals.insert(m_normals.end(), normals.begin(), normals.end());
+      m_indices.insert(m_indices.end(), triangles.begin(), triangles.end());
+      return true;
+    }
+
+    virtual bool Close() {
+      Mesh m(m_vertices, m_normals, TexCoordVec(), ColorVec(),
+             m_indices, m_indices, IndexVec(), IndexVec(),
+             false, false, m_strDesc, Mesh::MT_TRIANGLES);
+      m.SetDefaultColor(m_vColor);
+      return m_conv.ConvertToNative(m, m_strFilename);
+    }
+
+  private:
+    AbstrGeoConverter& m_conv;
+    std::string m_strFilename;
+    std::string m_strDesc;
+    FLOATVECTOR4 m_vColor;
+    VertVec m_vertices;
+    NormVec m_normals;
+    IndexVec m_indices;
+  };
+}
+
+std::shared_ptr<MeshSink>
+AbstrGeoConverter::CreateSink(const std::string& strTargetFilename,
+                              const std::string& strDesc,
+                              const FLOATVECTOR4& vDefaultColor) {
+  return std::make_shared<BufferingMeshSink>(*this, strTargetFilename,
+                                             strDesc, vDefaultColor);
+}
+
 bool AbstrGeoConverter::CanRead(const std::string& fn) const
 {
   return SupportedExtension(SysTools::ToUpperCase(SysTools::GetExt(fn)));
@@ -182,6 +227,144 @@ void AbstrGeoConverter::AddToMesh(const VertVec& vertices,
   }
 }
 
+namespace {
+  enum {
+    PL_NORMALS   = 1,
+    PL_TEXCOORDS = 2,
+    PL_COLORS    = 4
+  };
+
+  // one polygon of a PolygonList
+  struct Polygon {
+    explicit Polygon(const uint32_t* p) :
+      k(p[0]), flags(p[1]), v(p+2),
+      n(v + k),
+      t(n + ((flags & PL_NORMALS)   ? k : 0)),
+      c(t + ((flags & PL_TEXCOORDS) ? k : 0)),
+      next(c + ((flags & PL_COLORS) ? k : 0)) {}
+    uint32_t k, flags;
+    const uint32_t *v, *n, *t, *c, *next;
+  };
+
+  // indices AddToMesh adds for a polygon with k vertices
+  size_t Triangulated(size_t k) { return k > 3 ? 3*(k-2) : k; }
+
+  bool Passes(size_t k, bool bLinesOnly, bool bNoLines) {
+    return bLinesOnly ? k == 2 : (!bNoLines || k != 2);
+  }
+
+  struct IndexCounts {
+    IndexCounts() : v(0), n(0), t(0), c(0), iSkipped(0) {}
+    size_t v, n, t, c, iSkipped;
+  };
+}
+
+void PolygonList::Add(const IndexVec& v, const IndexVec& n,
+                      const IndexVec& t, const IndexVec& c) {
+  const size_t k = v.size();
+  if (m_iCount == 0) m_iFirstVertexCount = k;
+  const uint32_t flags = (n.size() == k ? PL_NORMALS : 0) |
+                         (t.size() == k ? PL_TEXCOORDS : 0) |
+                         (c.size() == k ? PL_COLORS : 0);
+  m_vData.push_back(uint32_t(k));
+  m_vData.push_back(flags);
+  m_vData.insert(m_vData.end(), v.begin(), v.end());
+  if (flags & PL_NORMALS) m_vData.insert(m_vData.end(), n.begin(), n.end());
+  if (flags & PL_TEXCOORDS) m_vData.insert(m_vData.end(), t.begin(), t.end());
+  if (flags & PL_COLORS) m_vData.insert(m_vData.end(), c.begin(), c.end());
+  m_iCount++;
+}
+
+size_t AbstrGeoConverter::AddToMesh(const VertVec& vertices,
+                                    const std::vector<PolygonList>& pieces,
+                                    PolygonFilter eFilter,
+                                    IndexVec& VertIndices,
+                                    IndexVec& NormalIndices,
+                                    IndexVec& TCIndices,
+                                    IndexVec& COLIndices) {
+  const bool bLinesOnly = eFilter == PF_LINES;
+  const bool bNoLines = eFilter == PF_NO_LINES;
+  // where each piece's indices go
+  std::vector<IndexCounts> offsets(pieces.size()+1);
+  const int64_t iPieces = int64_t(pieces.size());
+#pragma omp parallel for schedule(dynamic)
+  for (int64_t i = 0;i<iPieces;i++) {
+    const IndexVec& data = pieces[size_t(i)].Data();
+    IndexCounts& counts = offsets[size_t(i)+1];
+    for (const uint32_t* p = data.data();p != data.data()+data.size();) {
+      const Polygon poly(p);
+      p = poly.next;
+      if (!Passes(poly.k, bLinesOnly, bNoLines)) {
+        counts.iSkipped++;
+        continue;
+      }
+      const size_t iIndices = Triangulated(poly.k);
+      counts.v += iIndices;
+      if (poly.flags & PL_NORMALS) counts.n += iIndices;
+      if (poly.flags & PL_TEXCOORDS) counts.t += iIndices;
+      if (poly.flags & PL_COLORS) counts.c += iIndices;
+    }
+  }
+  offsets[0].v = VertIndices.size();
+  offsets[0].n = NormalIndices.size();
+  offsets[0].t = TCIndices.size();
+  offsets[0].c = COLIndices.size();
+  for (size_t i = 1;i<offsets.size();i++) {
+    offsets[i].v += offsets[i-1].v;
+    offsets[i].n += offsets[i-1].n;
+    offsets[i].t += offsets[i-1].t;
+    offsets[i].c += offsets[i-1].c;
+    offsets[i].iSkipped += offsets[i-1].iSkipped;
+  }
+  VertIndices.resize(offsets.back().v);
+  NormalIndices.resize(offsets.back().n);
+  TCIndices.resize(offsets.back().t);
+  COLIndices.resize(offsets.back().c);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int64_t i = 0;i<iPieces;i++) {
+    const IndexVec& data = pieces[size_t(i)].Data();
+    uint32_t* pv = VertIndices.data() + offsets[size_t(i)].v;
+    uint32_t* pn = NormalIndices.data() + offsets[size_t(i)].n;
+    uint32_t* pt = TCIndices.data() + offsets[size_t(i)].t;
+    uint32_t* pc = COLIndices.data() + offsets[size_t(i)].c;
+    IndexVec v, n, t, c;
+    for (const uint32_t* p = data.data();p != data.data()+data.size();) {
+      const Polygon poly(p);
+      p = poly.next;
+      if (!Passes(poly.k, bLinesOnly, bNoLines)) continue;
+      const bool bN = (poly.flags & PL_NORMALS) != 0;
+      const bool bT = (poly.flags & PL_TEXCOORDS) != 0;
+      const bool bC = (poly.flags & PL_COLORS) != 0;
+
+      if (poly.k <= 3) {
+        pv = std::copy(poly.v, poly.v+poly.k, pv);
+        if (bN) pn = std::copy(poly.n, poly.n+poly.k, pn);
+        if (bT) pt = std::copy(poly.t, poly.t+poly.k, pt);
+        if (bC) pc = std::copy(poly.c, poly.c+poly.k, pc);
+        continue;
+      }
+
+      v.assign(poly.v, poly.v+poly.k);
+      n.assign(poly.n, poly.n+(bN ? poly.k : 0));
+      t.assign(poly.t, poly.t+(bT ? poly.k : 0));
+      c.assign(poly.c, poly.c+(bC ? poly.k : 0));
+      // indices past the vertices would have AddToMesh read garbage
+      if (*std::max_element(v.begin(), v.end()) < vertices.size())
+        SortByGradient(vertices,v,n,t,c);
+
+      // the fan AddToMesh builds, normals, texcoords and colors included
+      for (size_t j = 0;j<v.size()-2;j++) {
+        *pv++ = v[0]; *pv++ = v[j+1]; *pv++ = v[j+2];
+        if (bN) {*pn++ = n[j]; *pn++ = n[j+1]; *pn++ = n[j+2];}
+        if (bT) {*pt++ = t[j]; *pt++ = t[j+1]; *pt++ = t[j+2];}
+        if (bC) {*pc++ = c[j]; *pc++ = c[j+1]; *pc++ = c[j+2];}
+      }
+    }
+  }
+  return offsets.back().iSkipped;
+}
+
 // *******************************************
 // code to parse text files
 // *******************************************
@@ -46,9 +46,46 @@
 namespace tuvok {
 
 typedef std::vector<FLOATVECTOR3> VertVec;
+typedef std::vector<FLOATVECTOR3> NormVec;
 typedef std::vector<uint32_t> IndexVec;
 class Mesh;
 
+/// Receives a triangle mesh piece by piece, for meshes which are too large
+/// to be held in memory as a whole.
+class MeshSink {
+public:
+  virtual ~MeshSink() {}
+  /// appends vertices (with one normal each) and triangles.  Indices refer
+  /// to all vertices appended so far, not just to those of this piece.
+  virtual bool Append(const VertVec& vertices, const NormVec& normals,
+                      const IndexVec& triangles) = 0;
+  /// finishes the file; nothing may be appended afterwards.
+  virtual bool Close() = 0;
+};
+
+/// Polygons as a parser reads them, before AddToMesh triangulates them:
+/// per polygon, its vertex count, which of its normal, texcoord and color
+/// index lists have an index per vertex, and those lists.  Once grown,
+/// adding to one does not allocate.
+class PolygonList {
+public:
+  PolygonList() : m_iCount(0), m_iFirstVertexCount(0) {}
+
+  void Add(const IndexVec& v, const IndexVec& n,
+           const IndexVec& t, const IndexVec& c);
+  void Reserve(size_t iPolygons) { m_vData.reserve(iPolygons*5); }
+
+  size_t Count() const { return m_iCount; }
+  /// vertices of the first polygon added
+  size_t FirstVertexCount() const { return m_iFirstVertexCount; }
+  const IndexVec& Data() const { return m_vData; }
+
+private:
+  IndexVec m_vData;
+  size_t   m_iCount;
+  size_t   m_iFirstVertexCount;
+};
+
 class AbstrGeoConverter {
 public:
   virtual ~AbstrGeoConverter() {}
@@ -60,6 +97,14 @@ public:
   virtual bool ConvertToNative(const Mesh& m,
                                const std::string& strTargetFilename);
 
+  /// @returns a sink which writes a triangle mesh to the given file.  The
+  /// default collects the whole mesh and calls ConvertToNative on Close;
+  /// formats which can be written incrementally override this.
+  virtual std::shared_ptr<MeshSink> CreateSink(
+    const std::string& strTargetFilename, const std::string& strDesc,
+    const FLOATVECTOR4& vDefaultColor
+  );
+
   /// @param filename the file in question
   /// @return SupportedExtension() for the file's extension
   virtual bool CanRead(const std::string& fn) const;
@@ -90,6 +135,20 @@ protected:
                  IndexVec&  VertIndices, IndexVec& NormalIndices, 
                  IndexVec&  TCIndices, IndexVec& COLIndices);
 
+  enum PolygonFilter {
+    PF_ALL,       ///< add every polygon
+    PF_LINES,     ///< add only polygons with 2 vertices
+    PF_NO_LINES   ///< add all but polygons with 2 vertices
+  };
+  /// Adds the polygons of all 'pieces' which pass 'eFilter' as AddToMesh
+  /// would, one after the other, but on all cores.
+  /// @returns how many polygons were filtered out.
+  size_t AddToMesh(const VertVec& vertices,
+                   const std::vector<PolygonList>& pieces,
+                   PolygonFilter eFilter,
+                   IndexVec& VertIndices, IndexVec& NormalIndices,
+                   IndexVec& TCIndices, IndexVec& COLIndices);
+
   // parser helper
   std::string TrimToken(const std::string& Src, 
                         const std::string& delim = " \r\n\t",
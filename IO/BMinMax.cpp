@@ -1,22 +1,172 @@
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
 #include "BMinMax.h"
 #include "Basics/MinMaxBlock.h"
 #include "BrickedDataset.h"
 #include "Controller/Controller.h"
+#include "QuantizeSIMD.h"
+
+namespace tuvok {
+
+struct MinMaxScratch::Buffers {
+  std::vector<uint8_t> u8;
+  std::vector<uint16_t> u16;
+  std::vector<uint32_t> u32;
+  std::vector<int8_t> i8;
+  std::vector<int16_t> i16;
+  std::vector<int32_t> i32;
+  std::vector<float> f32;
+  std::vector<double> f64;
+  /// squared gradient magnitudes of one row of voxels
+  std::vector<float> rowf;
+  std::vector<double> rowd;
+};
+
+MinMaxScratch::MinMaxScratch() : buffers(new Buffers) {}
+MinMaxScratch::~MinMaxScratch() {}
+
+}
 
 namespace {
-  template<typename T> tuvok::MinMaxBlock mm(const tuvok::BrickKey& bk,
-                                             const tuvok::BrickedDataset& ds) {
-    std::vector<T> data(ds.GetMaxBrickSize().volume());
-    ds.GetBrick(bk, data);
-    auto mmax = std::minmax_element(data.begin(), data.end());
-    return tuvok::MinMaxBlock(*mmax.first, *mmax.second, DBL_MAX, -FLT_MAX);
+  using tuvok::MinMaxScratch;
+
+  // picks the buffer for a type; the second argument only selects.
+  std::vector<uint8_t>& data(MinMaxScratch::Buffers& b, uint8_t) {
+    return b.u8;
+  }
+  std::vector<uint16_t>& data(MinMaxScratch::Buffers& b, uint16_t) {
+    return b.u16;
+  }
+  std::vector<uint32_t>& data(MinMaxScratch::Buffers& b, uint32_t) {
+    return b.u32;
+  }
+  std::vector<int8_t>& data(MinMaxScratch::Buffers& b, int8_t) {
+    return b.i8;
+  }
+  std::vector<int16_t>& data(MinMaxScratch::Buffers& b, int16_t) {
+    return b.i16;
+  }
+  std::vector<int32_t>& data(MinMaxScratch::Buffers& b, int32_t) {
+    return b.i32;
+  }
+  std::vector<float>& data(MinMaxScratch::Buffers& b, float) { return b.f32; }
+  std::vector<double>& data(MinMaxScratch::Buffers& b, double) {
+    return b.f64;
+  }
+  std::vector<float>& row(MinMaxScratch::Buffers& b, float) { return b.rowf; }
+  std::vector<double>& row(MinMaxScratch::Buffers& b, double) {
+    return b.rowd;
+  }
+
+  /// gradients are computed in float where that holds every difference of
+  /// two values exactly (or the data are float anyway), else in double.
+  template<typename T> struct Precision {
+    typedef typename std::conditional<
+      sizeof(T) <= 2 || std::is_same<T, float>::value, float, double
+    >::type type;
+  };
+
+  template<typename T> double normalization() {
+    return std::numeric_limits<T>::is_integer ?
+           double(std::numeric_limits<T>::max()) : 1.0;
+  }
+
+  // squared gradient magnitudes of row 'y' of slice 'z', into 'g'.  The
+  // neighbours along y and z are whole rows, so the inner loop is a plain
+  // element-wise one which the compiler vectorizes.
+  template<typename T, typename F>
+  void gradient_row(const T* pData, const UINT64VECTOR3& n, uint64_t y,
+                    uint64_t z, F fNorm, F* g) {
+    const size_t nx = size_t(n.x);
+    const size_t sy = nx;
+    const size_t sz = size_t(n.x * n.y);
+    const T* c = pData + size_t(z)*sz + size_t(y)*sy;
+    const T* ym = y > 0 ? c - sy : c;
+    const T* yp = y+1 < n.y ? c + sy : c;
+    const T* zm = z > 0 ? c - sz : c;
+    const T* zp = z+1 < n.z ? c + sz : c;
+    // central differences are halved, one-sided ones are not.
+    const F fx = F(0.5) / fNorm;
+    const F fy = (ym != c && yp != c ? F(0.5) : F(1)) / fNorm;
+    const F fz = (zm != c && zp != c ? F(0.5) : F(1)) / fNorm;
+
+    for(size_t x=1; x+1 < nx; ++x) {
+      const F dx = (F(c[x+1]) - F(c[x-1])) * fx;
+      const F dy = (F(yp[x]) - F(ym[x])) * fy;
+      const F dz = (F(zp[x]) - F(zm[x])) * fz;
+      g[x] = dx*dx + dy*dy + dz*dz;
+    }
+    const size_t ends[2] = { 0, nx-1 };
+    for(size_t e=0; e < (nx > 1 ? 2U : 1U); ++e) {
+      const size_t x = ends[e];
+      const F dx = nx > 1 ? (F(c[x+1 < nx ? x+1 : x]) - F(c[x > 0 ? x-1 : x]))
+                            / fNorm : F(0);
+      const F dy = (F(yp[x]) - F(ym[x])) * fy;
+      const F dz = (F(zp[x]) - F(zm[x])) * fz;
+      g[x] = dx*dx + dy*dy + dz*dz;
+    }
+  }
+
+  template<typename T>
+  tuvok::MinMaxBlock mm(const tuvok::BrickKey& bk,
+                        const tuvok::BrickedDataset& ds,
+                        MinMaxScratch& scratch) {
+    std::vector<T>& d = data(*scratch.buffers, T());
+    ds.GetBrick(bk, d);
+    const UINTVECTOR3 vSize = ds.GetBrickVoxelCounts(bk);
+    assert(d.size() >= vSize.volume());
+    if(d.size() < vSize.volume()) {
+      T_ERROR("brick holds %u voxels, not %u",
+              static_cast<unsigned>(d.size()),
+              static_cast<unsigned>(vSize.volume()));
+      return tuvok::MinMaxBlock();
+    }
+    return tuvok::minmax_voxels(d.data(),
+                                UINT64VECTOR3(vSize.x, vSize.y, vSize.z),
+                                scratch);
   }
 }
 
 namespace tuvok {
 
+template<typename T>
+MinMaxBlock minmax_voxels(const T* pData, const UINT64VECTOR3& vSize,
+                          MinMaxScratch& scratch) {
+  typedef typename Precision<T>::type F;
+  if(vSize.volume() == 0) { return MinMaxBlock(); }
+
+  std::vector<F>& g = row(*scratch.buffers, F());
+  g.resize(size_t(vSize.x));
+  const F fNorm = F(normalization<T>());
+  T lo = std::numeric_limits<T>::max();
+  T hi = std::numeric_limits<T>::lowest();
+  F glo = std::numeric_limits<F>::max();
+  F ghi = F(0);
+
+  // Slice by slice: a slice's values are scanned while it and its two
+  // neighbours, which its gradients need, are still in cache.
+  const size_t iSlice = size_t(vSize.x * vSize.y);
+  for(uint64_t z=0; z < vSize.z; ++z) {
+    simd::MinMax(pData + size_t(z)*iSlice, iSlice, lo, hi);
+    for(uint64_t y=0; y < vSize.y; ++y) {
+      gradient_row(pData, vSize, y, z, fNorm, &g[0]);
+      simd::MinMax(&g[0], g.size(), glo, ghi);
+    }
+  }
+  return MinMaxBlock(double(lo), double(hi),
+                     std::sqrt(double(glo)), std::sqrt(double(ghi)));
+}
+
 MinMaxBlock minmax_brick(const BrickKey& bk, const BrickedDataset& ds) {
+  MinMaxScratch scratch;
+  return minmax_brick(bk, ds, scratch);
+}
+
+MinMaxBlock minmax_brick(const BrickKey& bk, const BrickedDataset& ds,
+                         MinMaxScratch& scratch) {
   // identify type (float, etc)
   const unsigned size = ds.GetBitWidth() / 8;
   assert(ds.GetComponentCount() == 1);
@@ -26,19 +176,21 @@ MinMaxBlock minmax_brick(const BrickKey& bk, const BrickedDataset& ds) {
   // giant if-block to simply call the right compile-time function w/ knowledge
   // we only know at run-time.
   if(!sign && !fp && size == 1) {
-    return mm<uint8_t>(bk, ds);
+    return mm<uint8_t>(bk, ds, scratch);
   } else if(!sign && !fp && size == 2) {
-    return mm<uint16_t>(bk, ds);
+    return mm<uint16_t>(bk, ds, scratch);
   } else if(!sign && !fp && size == 4) {
-    return mm<uint32_t>(bk, ds);
+    return mm<uint32_t>(bk, ds, scratch);
   } else if(sign && !fp && size == 1) {
-    return mm<int8_t>(bk, ds);
+    return mm<int8_t>(bk, ds, scratch);
   } else if(sign && !fp && size == 2) {
-    return mm<int16_t>(bk, ds);
+    return mm<int16_t>(bk, ds, scratch);
   } else if(sign && !fp && size == 4) {
-    return mm<int32_t>(bk, ds);
+    return mm<int32_t>(bk, ds, scratch);
   } else if(sign && fp && size == 4) {
-    return mm<float>(bk, ds);
+    return mm<float>(bk, ds, scratch);
+  } else if(sign && fp && size == 8) {
+    return mm<double>(bk, ds, scratch);
   } else {
     T_ERROR("unsupported type.");
     assert(false);
@@ -46,4 +198,12 @@ MinMaxBlock minmax_brick(const BrickKey& bk, const BrickedDataset& ds) {
   return MinMaxBlock();
 }
 
+#define MINMAX_VOXELS(T) \
+  template MinMaxBlock minmax_voxels<T>(const T*, const UINT64VECTOR3&, \
+                                        MinMaxScratch&);
+MINMAX_VOXELS(uint8_t) MINMAX_VOXELS(uint16_t) MINMAX_VOXELS(uint32_t)
+MINMAX_VOXELS(int8_t) MINMAX_VOXELS(int16_t) MINMAX_VOXELS(int32_t)
+MINMAX_VOXELS(float) MINMAX_VOXELS(double)
+#undef MINMAX_VOXELS
+
 }
@@ -1,13 +1,38 @@
 #ifndef TUVOK_BMINMAX_H
 #define TUVOK_BMINMAX_H
 
+#include <memory>
 #include "Basics/MinMaxBlock.h"
+#include "Basics/Vectors.h"
 #include "Brick.h"
 
 namespace tuvok {
 class BrickedDataset;
 
+/// Buffers minmax_brick reuses from one brick to the next, so that scanning
+/// many bricks does not allocate for each.  Use one per thread.
+class MinMaxScratch {
+public:
+  MinMaxScratch();
+  ~MinMaxScratch();
+  struct Buffers;
+  std::unique_ptr<Buffers> buffers;
+};
+
+/// @returns the scalar range and the range of central-difference gradient
+/// magnitudes of the brick.
 MinMaxBlock minmax_brick(const BrickKey& bk, const BrickedDataset& ds);
+MinMaxBlock minmax_brick(const BrickKey& bk, const BrickedDataset& ds,
+                         MinMaxScratch& scratch);
+
+/// The kernel of minmax_brick, over the 'vSize' voxels at 'pData' (x
+/// fastest).  Gradients are in the units the 2D histogram and the shaders
+/// use: differences of values normalized by the type's maximum (1 for
+/// floating point), halved for central differences.  Across the brick's
+/// faces they are one-sided.
+template<typename T>
+MinMaxBlock minmax_voxels(const T* pData, const UINT64VECTOR3& vSize,
+                          MinMaxScratch& scratch);
 
 }
 
@@ -1,8 +1,9 @@
-#include <algorithm>
-#include <ctime>
+#include <cassert>
 #include <functional>
-#include <map>
+#include <limits>
+#include <list>
 #include <memory>
+#include <unordered_map>
 #include "BrickCache.h"
 #include "Controller/StackTimer.h"
 
@@ -78,20 +79,17 @@ struct TypeErase {
 
 struct BrickInfo {
   BrickKey key;
-  uint64_t access_time;
-  BrickInfo(const BrickKey& k, time_t t) : key(k),
-                                           access_time(uint64_t(t)) {}
-};
-
-struct CacheLRU {
-  typedef std::pair<BrickInfo, TypeErase> CacheElem;
-  bool operator()(const CacheElem& a, const CacheElem& b) const {
-    return a.first.access_time > b.first.access_time;
-  }
+  uint64_t access_time; ///< value of the cache's access counter at last use
+  BrickInfo(const BrickKey& k, uint64_t t) : key(k), access_time(t) {}
 };
 
+// The cache is a hash table from key to an entry in a recency list.  The list
+// is kept in most-recently-used order: a hit just splices the entry to the
+// front, and eviction always takes the back.  Thus lookup, add and remove are
+// all constant time, independent of how many bricks we are holding.
 struct BrickCache::bcinfo {
-    bcinfo(): bytes(0) {}
+    bcinfo(): bytes(0), budget(std::numeric_limits<size_t>::max()),
+              counter(0) {}
     // this is wordy but they all just forward to a real implementation below.
     const void* lookup(const BrickKey& k, uint8_t) {
       return this->typed_lookup<uint8_t>(k);
@@ -123,6 +121,34 @@ struct BrickCache::bcinfo {
       return this->typed_lookup<float>(k);
     }
 
+    std::shared_ptr<const void> share(const BrickKey& k, uint8_t) {
+      return this->typed_share<uint8_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, uint16_t) {
+      return this->typed_share<uint16_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, uint32_t) {
+      return this->typed_share<uint32_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, uint64_t) {
+      return this->typed_share<uint64_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, int8_t) {
+      return this->typed_share<int8_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, int16_t) {
+      return this->typed_share<int16_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, int32_t) {
+      return this->typed_share<int32_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, int64_t) {
+      return this->typed_share<int64_t>(k);
+    }
+    std::shared_ptr<const void> share(const BrickKey& k, float) {
+      return this->typed_share<float>(k);
+    }
+
     // the erasure means we can just do the insert with the thing we already
     // have: it'll make a shared_ptr out of it and insert it into the
     // container.
@@ -156,80 +182,99 @@ struct BrickCache::bcinfo {
     }
     ///@}
     void remove() {
-      if(!cache.empty()) {
-        // libstdc++ complains it's not a heap otherwise.. somehow.  bug?
-        std::make_heap(this->cache.begin(), this->cache.end(), CacheLRU());
-        const CacheElem& entry = this->cache.front();
-        TypeErase::GenericType& gt = *(entry.second.gt);
-        assert((entry.second.width * gt.elems()) <= this->bytes);
-        this->bytes -= entry.second.width * gt.elems();
-
-        std::pop_heap(this->cache.begin(), this->cache.end(), CacheLRU());
-        this->cache.pop_back();
+      if(!this->recency.empty()) {
+        // the back of the list is the least recently used element.
+        const CacheElem& entry = this->recency.back();
+        assert(nbytes(entry) <= this->bytes);
+        this->bytes -= nbytes(entry);
+        this->index.erase(entry.first.key);
+        this->recency.pop_back();
+      }
+      assert(this->index.size() == this->recency.size());
+    }
+    void reserve(size_t nb) {
+      // if nothing is cached we allow any single brick, even if it is larger
+      // than the whole budget; otherwise one could never load it.
+      while(!this->recency.empty() &&
+            (nb > this->budget || this->bytes > this->budget - nb)) {
+        this->remove();
       }
-      assert(this->size() == this->bytes);
     }
+    void capacity(size_t nb) {
+      this->budget = nb;
+      while(!this->recency.empty() && this->bytes > this->budget) {
+        this->remove();
+      }
+    }
+    size_t capacity() const { return this->budget; }
     void clear() {
-      this->cache.clear();
+      this->index.clear();
+      this->recency.clear();
       this->bytes = 0;
     }
     size_t size() const { return this->bytes; }
 
   private:
     template<typename T> const void* typed_lookup(const BrickKey& k);
+    template<typename T> std::shared_ptr<const void>
+      typed_share(const BrickKey& k);
     template<typename T> const void* typed_add(const BrickKey&,
                                                std::vector<T>&);
 
   private:
     typedef std::pair<BrickInfo, TypeErase> CacheElem;
-    std::vector<CacheElem> cache;
-    size_t bytes; ///< how much memory we're currently using for data.
-};
+    typedef std::list<CacheElem> RecencyList;
+    static size_t nbytes(const CacheElem& e) {
+      return e.second.width * e.second.gt->elems();
+    }
 
-struct KeyMatches {
-  bool operator()(const BrickKey& key,
-                  const std::pair<BrickInfo,TypeErase>& a) const {
-    return key == a.first.key;
-  }
+    RecencyList recency; ///< most recently used element is at the front.
+    std::unordered_map<BrickKey, RecencyList::iterator, BKeyHash> index;
+    size_t bytes; ///< how much memory we're currently using for data.
+    size_t budget; ///< how much memory we may use, in bytes.
+    uint64_t counter; ///< monotonic; bumped on every access.
 };
 
-// if the key doesn't exist, you get an empty vector.
+// if the key doesn't exist, you get NULL.
 template<typename T>
 const void* BrickCache::bcinfo::typed_lookup(const BrickKey& k) {
-  using namespace std::placeholders;
-  KeyMatches km;
-  auto func = std::bind(&KeyMatches::operator(), km, k, _1);
-
-  // gcc can't seem to deduce this with 'auto'.
-  typedef std::vector<CacheElem> maptype;
-  maptype::iterator i = std::find_if(this->cache.begin(), this->cache.end(),
-                                     func);
-  if(i == this->cache.end()) { return NULL; }
-
-  i->first.access_time = time(NULL);
-  TypeErase::GenericType& gt = *(i->second.gt);
-  assert(this->size() == this->bytes);
+  auto i = this->index.find(k);
+  if(i == this->index.end()) { return NULL; }
+
+  RecencyList::iterator elem = i->second;
+  elem->first.access_time = ++this->counter;
+  // move it to the front; splice does not invalidate the iterator.
+  this->recency.splice(this->recency.begin(), this->recency, elem);
+  assert(this->recency.front().first.access_time == this->counter);
+
+  TypeErase::GenericType& gt = *(elem->second.gt);
   return dynamic_cast<TypeErase::TypeEraser<std::vector<T>>&>(gt).get().data();
 }
 
+// like typed_lookup, but the pointer we give out keeps the element alive.
+template<typename T>
+std::shared_ptr<const void> BrickCache::bcinfo::typed_share(const BrickKey& k) {
+  const void* data = this->typed_lookup<T>(k);
+  if(NULL == data) { return std::shared_ptr<const void>(); }
+  // aliasing constructor: owns the erased vector, points at its data.
+  return std::shared_ptr<const void>(this->index.find(k)->second->second.gt,
+                                     data);
+}
+
 template<typename T>
 const void* BrickCache::bcinfo::typed_add(const BrickKey& k,
                                           std::vector<T>& data) {
   // maybe the case of a general cache allows duplicate insert, but for our uses
   // there should never be a duplicate entry.
-#ifndef NDEBUG
-  KeyMatches km;
-  using namespace std::placeholders;
-  auto func = std::bind(&KeyMatches::operator(), km, k, _1);
-  assert(std::find_if(this->cache.begin(), this->cache.end(), func) ==
-         this->cache.end());
-#endif
+  assert(this->index.find(k) == this->index.end());
+
   this->bytes += sizeof(T) * data.size();
-  this->cache.push_back(std::make_pair(BrickInfo(k, time(NULL)),
-                        std::move(data)));
+  this->recency.push_front(std::make_pair(BrickInfo(k, ++this->counter),
+                                          TypeErase(std::move(data))));
+  this->index.insert(std::make_pair(k, this->recency.begin()));
 
-  assert(this->size() == this->bytes);
-  TypeErase::GenericType& gt = *this->cache.back().second.gt;
+  assert(this->index.size() == this->recency.size());
+  TypeErase::GenericType& gt = *this->recency.front().second.gt;
   return dynamic_cast<TypeErase::TypeEraser<std::vector<T>>&>(gt).get().data();
 }
 
@@ -266,6 +311,33 @@ const void* BrickCache::lookup(const BrickKey& k, float value) {
   return this->ci->lookup(k, value);
 }
 
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, uint8_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, uint16_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, uint32_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, uint64_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, int8_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, int16_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, int32_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, int64_t v) {
+  return this->ci->share(k, v);
+}
+std::shared_ptr<const void> BrickCache::share(const BrickKey& k, float v) {
+  return this->ci->share(k, v);
+}
 
 const void* BrickCache::add(const BrickKey& k,
                             std::vector<uint8_t>& data) {
@@ -305,6 +377,9 @@ const void* BrickCache::add(const BrickKey& k,
 }
 
 void BrickCache::remove() { this->ci->remove(); }
+void BrickCache::reserve(size_t bytes) { this->ci->reserve(bytes); }
+void BrickCache::capacity(size_t bytes) { this->ci->capacity(bytes); }
+size_t BrickCache::capacity() const { return this->ci->capacity(); }
 void BrickCache::clear() { return this->ci->clear(); }
 size_t BrickCache::size() const { return this->ci->size(); }
 
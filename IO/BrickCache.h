@@ -8,7 +8,7 @@
 namespace tuvok {
 
 // Implements a simple brick cache: associates a chunk of data with the given
-// brick key.
+// brick key.  Entries are evicted in least-recently-used order.
 // Lookup of a nonexistent key results in an empty vector: there is no way to
 // tell whether a key doesn't exist, or whether the data it stores is actually
 // empty.
@@ -31,6 +31,20 @@ class BrickCache {
     const void* lookup(const BrickKey&, float);
     ///@}
 
+    /// like lookup, but the returned pointer shares ownership of the data:
+    /// it remains valid even if the element is evicted afterwards.
+    ///@{
+    std::shared_ptr<const void> share(const BrickKey&, uint8_t);
+    std::shared_ptr<const void> share(const BrickKey&, uint16_t);
+    std::shared_ptr<const void> share(const BrickKey&, uint32_t);
+    std::shared_ptr<const void> share(const BrickKey&, uint64_t);
+    std::shared_ptr<const void> share(const BrickKey&, int8_t);
+    std::shared_ptr<const void> share(const BrickKey&, int16_t);
+    std::shared_ptr<const void> share(const BrickKey&, int32_t);
+    std::shared_ptr<const void> share(const BrickKey&, int64_t);
+    std::shared_ptr<const void> share(const BrickKey&, float);
+    ///@}
+
     /// These return their argument for ease of use.
     ///@{
     const void* add(const BrickKey&, std::vector<uint8_t>&);
@@ -44,9 +58,20 @@ class BrickCache {
     const void* add(const BrickKey&, std::vector<float>&);
     ///@}
 
-    /// removes the most appropriate element.
+    /// removes the most appropriate (least recently used) element.
     void remove();
 
+    /// evicts elements until an additional 'bytes' bytes fit within the
+    /// capacity.  An empty cache accepts anything, so a single brick larger
+    /// than the capacity can still be added.
+    void reserve(size_t bytes);
+
+    /// sets the byte budget, evicting elements if we are currently above it.
+    /// The default is unlimited.
+    void capacity(size_t bytes);
+    /// @returns the byte budget.
+    size_t capacity() const;
+
     /// @returns cache size currently in use (in bytes)
     size_t size() const;
 
@@ -0,0 +1,65 @@
+#ifndef TUVOK_BRICK_VIEW_H
+#define TUVOK_BRICK_VIEW_H
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace tuvok {
+
+/// Describes a brick which lives somewhere inside a larger block of memory,
+/// such as a cached source brick.  Component 'c' of the voxel at (x,y,z) is
+///   data.get()[((z*imageHeight + y)*rowLength + x)*components + c]
+/// 'rowLength' and 'imageHeight' are in voxels, i.e. exactly what OpenGL
+/// wants for GL_UNPACK_ROW_LENGTH and GL_UNPACK_IMAGE_HEIGHT.
+/// 'data' shares ownership of the memory it points into: the view stays
+/// valid even if the brick gets evicted from whatever cache it came from.
+template<typename T> struct BrickView {
+  std::shared_ptr<const T> data; ///< first voxel of the brick
+  std::array<size_t,3> size;     ///< voxels per dimension
+  size_t rowLength;
+  size_t imageHeight;
+  size_t components;
+
+  BrickView() : rowLength(0), imageHeight(0), components(1) {
+    size[0] = size[1] = size[2] = 0;
+  }
+
+  /// @returns true if the voxels are contiguous in memory.
+  bool dense() const {
+    return (size[0] == rowLength || (size[1] <= 1 && size[2] <= 1)) &&
+           (size[1] == imageHeight || size[2] <= 1);
+  }
+  size_t elems() const { return size[0]*size[1]*size[2]*components; }
+
+  /// copies the brick into 'dest', which ends up 'elems()' long.  Rows which
+  /// are contiguous in the source get copied together.
+  void copy(std::vector<T>& dest) const {
+    dest.resize(this->elems());
+    if(dest.empty()) { return; }
+    const T* src = this->data.get();
+    const size_t row = size[0] * components;
+    const size_t srow = rowLength * components;
+    const size_t slice = imageHeight * srow;
+    if(this->dense()) {
+      std::memcpy(dest.data(), src, dest.size() * sizeof(T));
+    } else if(size[0] == rowLength) { // each slice is one contiguous block
+      for(size_t z=0; z < size[2]; ++z) {
+        std::memcpy(&dest[z*size[1]*row], src + z*slice,
+                    size[1]*row*sizeof(T));
+      }
+    } else {
+      T* tgt = dest.data();
+      for(size_t z=0; z < size[2]; ++z) {
+        for(size_t y=0; y < size[1]; ++y, tgt += row) {
+          std::memcpy(tgt, src + z*slice + y*srow, row*sizeof(T));
+        }
+      }
+    }
+  }
+};
+
+}
+
+#endif
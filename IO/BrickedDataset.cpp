@@ -38,7 +38,7 @@
 
 namespace tuvok {
 
-BrickedDataset::BrickedDataset() { }
+BrickedDataset::BrickedDataset() : m_bGrouped(false) { }
 BrickedDataset::~BrickedDataset() { }
 
 void BrickedDataset::NBricksHint(size_t n) {
@@ -64,6 +64,7 @@ void BrickedDataset::AddBrick(const BrickKey& bk,
           static_cast<unsigned>(brick.n_voxels[2]));
 #endif
   this->bricks.insert(std::make_pair(bk, brick));
+  this->InvalidateIndices();
 }
 
 /// Looks up the spatial range of a brick.
@@ -101,15 +102,52 @@ BrickTable::const_iterator BrickedDataset::BricksEnd() const
 /// @return the number of bricks at the given LOD.
 BrickTable::size_type BrickedDataset::GetBrickCount(size_t lod, size_t ts) const
 {
-  BrickTable::size_type count = 0;
-  BrickTable::const_iterator iter = this->bricks.begin();
-  for(; iter != this->bricks.end(); ++iter) {
-    if(std::get<0>(iter->first) == ts &&
-       std::get<1>(iter->first) == lod) {
-      ++count;
-    }
+  SCOPEDLOCK(m_IndexGuard);
+  const TsLOD key(ts, lod);
+  auto idx = m_indices.find(key);
+  if(idx != m_indices.end()) { return idx->second->size(); }
+  this->GroupBricks();
+  auto g = m_groups.find(key);
+  return g != m_groups.end() ? g->second.size() : 0;
+}
+
+std::shared_ptr<const SpatialBrickIndex>
+BrickedDataset::GetBrickIndex(size_t ts, size_t lod) const
+{
+  SCOPEDLOCK(m_IndexGuard);
+  const TsLOD key(ts, lod);
+  auto idx = m_indices.find(key);
+  if(idx != m_indices.end()) { return idx->second; }
+
+  this->GroupBricks();
+  std::vector<BrickTable::const_iterator> group;
+  auto g = m_groups.find(key);
+  if(g != m_groups.end()) {
+    group.swap(g->second);
+    m_groups.erase(g);
   }
-  return count;
+  std::shared_ptr<const SpatialBrickIndex> index(
+    new SpatialBrickIndex(std::move(group)));
+  m_indices.insert(std::make_pair(key, index));
+  return index;
+}
+
+void BrickedDataset::GroupBricks() const {
+  // sort all bricks into their timestep + LOD in one pass, so that
+  // indexing them one timestep/LOD at a time stays linear.
+  if(m_bGrouped) { return; }
+  for(auto b=this->bricks.cbegin(); b != this->bricks.cend(); ++b) {
+    m_groups[TsLOD(std::get<0>(b->first), std::get<1>(b->first))]
+      .push_back(b);
+  }
+  m_bGrouped = true;
+}
+
+void BrickedDataset::InvalidateIndices() {
+  SCOPEDLOCK(m_IndexGuard);
+  m_groups.clear();
+  m_indices.clear();
+  m_bGrouped = false;
 }
 
 size_t BrickedDataset::GetLargestSingleBrickLOD(size_t ts) const {
@@ -172,9 +210,15 @@ BrickedDataset::BrickIsLastInDimension(size_t dim, const BrickKey& k) const
   return true;
 }
 
+ValueOccupancy BrickedDataset::OccupancyForKey(const BrickKey& k) const {
+  const MinMaxBlock mm = MaxMinForKey(k);
+  return ValueOccupancy(mm.minScalar, mm.maxScalar);
+}
+
 void BrickedDataset::Clear() {
   MESSAGE("Clearing brick metadata.");
   bricks.clear();
+  this->InvalidateIndices();
 }
 
 } // namespace tuvok
@@ -35,7 +35,13 @@
 #ifndef TUVOK_BRICKED_DATASET_H
 #define TUVOK_BRICKED_DATASET_H
 
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 #include "Basics/MinMaxBlock.h"
+#include "Basics/Threads.h"
+#include "SpatialBrickIndex.h"
 #include "Dataset.h"
 
 namespace tuvok {
@@ -60,6 +66,10 @@ public:
   virtual BrickTable::size_type GetBrickCount(size_t lod, size_t ts) const;
   virtual size_t GetLargestSingleBrickLOD(size_t ts) const;
   virtual uint64_t GetTotalBrickCount() const;
+  /// @returns the bricks of the given timestep + LOD, indexed spatially.  The
+  /// index is built on first use; adding bricks invalidates it.
+  std::shared_ptr<const SpatialBrickIndex> GetBrickIndex(size_t ts,
+                                                         size_t lod) const;
 
   virtual const BrickMD& GetBrickMetadata(const BrickKey&) const;
 
@@ -71,6 +81,9 @@ public:
   virtual UINTVECTOR3 GetMaxUsedBrickSizes() const;
   /// @returns the min/max scalar and gradient values for the given brick.
   virtual tuvok::MinMaxBlock MaxMinForKey(const BrickKey&) const=0;
+  /// @returns which parts of the brick's scalar range (as MaxMinForKey gives
+  /// it) hold values.  By default, that is all of it.
+  virtual tuvok::ValueOccupancy OccupancyForKey(const BrickKey&) const;
 
   virtual void Clear();
 
@@ -93,6 +106,20 @@ protected:
 
 protected:
   BrickTable bricks;
+
+private:
+  /// fills m_groups, unless that was done since the last invalidation.
+  /// Callers hold m_IndexGuard.
+  void GroupBricks() const;
+  /// forgets the indices, as bricks were added or removed.
+  void InvalidateIndices();
+
+  typedef std::pair<size_t, size_t> TsLOD;
+  mutable CriticalSection m_IndexGuard;
+  /// the bricks of each timestep + LOD, until their index gets built.
+  mutable std::map<TsLOD, std::vector<BrickTable::const_iterator>> m_groups;
+  mutable bool m_bGrouped;
+  mutable std::map<TsLOD, std::shared_ptr<const SpatialBrickIndex>> m_indices;
 };
 
 } // namespace tuvok
@@ -36,12 +36,21 @@
 */
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <memory>
+#include <sstream>
+#include <streambuf>
 #include <sys/stat.h>
+#include <unordered_map>
 #include <vector>
 #include "DICOMParser.h"
 
 #include <Controller/Controller.h>
+#include <Basics/Checksums/crc32.h>
+#include <Basics/LargeFileC.h>
 #include <Basics/SysTools.h>
 
 #ifdef DEBUG_DICOM
@@ -90,6 +99,314 @@ std::string DICOM_TypeStrings[28] = {
 
 using namespace std;
 
+namespace {
+  /// A read-only stream buffer over a file which fetches the bytes the
+  /// parser asks for a block at a time, with positional reads.  A DICOM
+  /// header usually fits into the first block, so the pixel data are never
+  /// read.
+  class BlockReadBuf : public std::streambuf {
+  public:
+    BlockReadBuf(LargeFile& file, uint64_t iSize) :
+      m_file(file), m_iSize(iSize), m_iBlockStart(0) {}
+
+  protected:
+    virtual int_type underflow() {
+      if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+      if (!Fill(m_iBlockStart + uint64_t(egptr() - eback()))) {
+        return traits_type::eof();
+      }
+      return traits_type::to_int_type(*gptr());
+    }
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which) {
+      int64_t iBase = 0;
+      if (dir == std::ios_base::cur) {
+        iBase = int64_t(m_iBlockStart) + int64_t(gptr() - eback());
+      } else if (dir == std::ios_base::end) {
+        iBase = int64_t(m_iSize);
+      }
+      return seekpos(pos_type(off_type(iBase + int64_t(off))), which);
+    }
+
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode) {
+      const int64_t iPos = int64_t(off_type(pos));
+      if (iPos < 0 || uint64_t(iPos) > m_iSize) return pos_type(off_type(-1));
+      const uint64_t iTarget = uint64_t(iPos);
+      const uint64_t iBlock = uint64_t(egptr() - eback());
+      if (iTarget >= m_iBlockStart && iTarget <= m_iBlockStart + iBlock) {
+        setg(eback(), eback() + size_t(iTarget - m_iBlockStart), egptr());
+      } else {
+        // the next underflow reads the block starting here.
+        m_iBlockStart = iTarget;
+        setg(NULL, NULL, NULL);
+      }
+      return pos;
+    }
+
+  private:
+    bool Fill(uint64_t iOffset) {
+      static const size_t iBlockSize = 64 * 1024;
+      if (iOffset >= m_iSize) return false;
+      const size_t iLength = size_t(std::min<uint64_t>(iBlockSize,
+                                                       m_iSize - iOffset));
+      try {
+        m_block = m_file.rd(iOffset, iLength);
+      } catch (const std::ios_base::failure&) {
+        return false;
+      }
+      const size_t iRead = size_t(m_file.gcount());
+      if (iRead == 0) return false;
+      char* p = const_cast<char*>(static_cast<const char*>(m_block.get()));
+      m_iBlockStart = iOffset;
+      setg(p, p, p + iRead);
+      return true;
+    }
+
+    LargeFile& m_file;
+    const uint64_t m_iSize;
+    uint64_t m_iBlockStart; ///< file offset of eback()
+    std::shared_ptr<const void> m_block;
+  };
+
+  /// What a scan found out about one file.
+  struct ScanEntry {
+    ScanEntry() : iSize(0), iMTime(0), bDICOM(false) {}
+    uint64_t iSize;
+    int64_t iMTime;
+    bool bDICOM;
+    DICOMFileInfo info; ///< only meaningful for DICOMs
+  };
+  typedef std::unordered_map<std::string, ScanEntry> ScanIndex;
+
+  /// Layout of the scan index file.  The header is followed by 'entries'
+  /// records of the file's path, size, modification time and, for DICOMs,
+  /// the header fields we parsed.  Everything is native-endian; an index
+  /// from a machine with the other byte order fails the version check and
+  /// gets rebuilt.
+  struct ScanIndexHeader {
+    char magic[8];      ///< "TVKDCMIX"
+    uint32_t version;
+    uint32_t checksum;  ///< CRC32 of all records
+    uint64_t entries;
+    uint64_t bytes;     ///< size of all records
+  };
+  const char scanMagic[8] = {'T','V','K','D','C','M','I','X'};
+  const uint32_t scanVersion = 1;
+
+  template<typename T> void put(vector<char>& out, T v) {
+    const char* p = reinterpret_cast<const char*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+  }
+  void put(vector<char>& out, const string& s) {
+    put(out, uint32_t(s.size()));
+    out.insert(out.end(), s.begin(), s.end());
+  }
+  void put(vector<char>& out, bool b) { put(out, uint8_t(b ? 1 : 0)); }
+
+  template<typename T> bool get(const char*& p, const char* end, T& v) {
+    if (size_t(end - p) < sizeof(T)) return false;
+    memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+  }
+  bool get(const char*& p, const char* end, string& s) {
+    uint32_t iLength;
+    if (!get(p, end, iLength) || size_t(end - p) < iLength) return false;
+    s.assign(p, iLength);
+    p += iLength;
+    return true;
+  }
+  bool get(const char*& p, const char* end, bool& b) {
+    uint8_t v;
+    if (!get(p, end, v)) return false;
+    b = v != 0;
+    return true;
+  }
+
+  void Pack(vector<char>& out, const string& path, const ScanEntry& e) {
+    put(out, path);
+    put(out, e.iSize);
+    put(out, e.iMTime);
+    put(out, e.bDICOM);
+    if (!e.bDICOM) return;
+    const DICOMFileInfo& i = e.info;
+    put(out, i.m_iImageIndex);
+    put(out, i.GetOffsetToData());
+    put(out, i.m_fvPatientPosition.x); put(out, i.m_fvPatientPosition.y);
+    put(out, i.m_fvPatientPosition.z);
+    put(out, i.m_iComponentCount);
+    put(out, i.m_fScale); put(out, i.m_fBias);
+    put(out, i.m_fWindowWidth); put(out, i.m_fWindowCenter);
+    put(out, i.m_bSigned);
+    put(out, i.m_iSeries);
+    put(out, i.m_ivSize.x); put(out, i.m_ivSize.y); put(out, i.m_ivSize.z);
+    put(out, i.m_fvfAspect.x); put(out, i.m_fvfAspect.y);
+    put(out, i.m_fvfAspect.z);
+    put(out, i.m_iAllocated); put(out, i.m_iStored);
+    put(out, i.m_bIsBigEndian); put(out, i.m_bIsJPEGEncoded);
+    put(out, i.m_strAcquDate); put(out, i.m_strAcquTime);
+    put(out, i.m_strModality); put(out, i.m_strDesc);
+  }
+
+  bool Unpack(const char*& p, const char* end, string& path, ScanEntry& e) {
+    if (!get(p, end, path) || !get(p, end, e.iSize) ||
+        !get(p, end, e.iMTime) || !get(p, end, e.bDICOM)) return false;
+    if (!e.bDICOM) return true;
+    DICOMFileInfo& i = e.info;
+    i = DICOMFileInfo(path);
+    uint32_t iOffset = 0;
+    const bool bOK =
+      get(p, end, i.m_iImageIndex) && get(p, end, iOffset) &&
+      get(p, end, i.m_fvPatientPosition.x) &&
+      get(p, end, i.m_fvPatientPosition.y) &&
+      get(p, end, i.m_fvPatientPosition.z) &&
+      get(p, end, i.m_iComponentCount) &&
+      get(p, end, i.m_fScale) && get(p, end, i.m_fBias) &&
+      get(p, end, i.m_fWindowWidth) && get(p, end, i.m_fWindowCenter) &&
+      get(p, end, i.m_bSigned) &&
+      get(p, end, i.m_iSeries) &&
+      get(p, end, i.m_ivSize.x) && get(p, end, i.m_ivSize.y) &&
+      get(p, end, i.m_ivSize.z) &&
+      get(p, end, i.m_fvfAspect.x) && get(p, end, i.m_fvfAspect.y) &&
+      get(p, end, i.m_fvfAspect.z) &&
+      get(p, end, i.m_iAllocated) && get(p, end, i.m_iStored) &&
+      get(p, end, i.m_bIsBigEndian) && get(p, end, i.m_bIsJPEGEncoded) &&
+      get(p, end, i.m_strAcquDate) && get(p, end, i.m_strAcquTime) &&
+      get(p, end, i.m_strModality) && get(p, end, i.m_strDesc);
+    // also derives the data size from the fields above.
+    i.SetOffsetToData(iOffset);
+    return bOK;
+  }
+
+  uint32_t Checksum(const char* p, size_t iLength) {
+    CRC32 crc;
+    return static_cast<uint32_t>(
+      crc.get(reinterpret_cast<const unsigned char*>(p), iLength));
+  }
+
+  bool LoadScanIndex(const string& fname, ScanIndex& index) {
+    ifstream is(fname.c_str(), ios::binary);
+    if (!is) return false; // no index yet
+    ScanIndexHeader hdr;
+    if (!is.read(reinterpret_cast<char*>(&hdr), sizeof(ScanIndexHeader)) ||
+        memcmp(hdr.magic, scanMagic, sizeof(scanMagic)) != 0 ||
+        hdr.version != scanVersion) {
+      WARNING("%s is not a (current) DICOM scan index; ignoring it.",
+              fname.c_str());
+      return false;
+    }
+    vector<char> records(size_t(hdr.bytes));
+    if (!records.empty() && !is.read(&records[0], records.size())) {
+      WARNING("DICOM scan index %s is truncated; ignoring it.",
+              fname.c_str());
+      return false;
+    }
+    const char* p = records.empty() ? NULL : &records[0];
+    const char* end = p + records.size();
+    if (Checksum(p, records.size()) != hdr.checksum) {
+      WARNING("DICOM scan index %s is corrupt; ignoring it.", fname.c_str());
+      return false;
+    }
+    for (uint64_t i = 0; i < hdr.entries; ++i) {
+      string path;
+      ScanEntry e;
+      if (!Unpack(p, end, path, e)) {
+        WARNING("DICOM scan index %s is corrupt; ignoring it.",
+                fname.c_str());
+        index.clear();
+        return false;
+      }
+      index[path] = e;
+    }
+    return true;
+  }
+
+  void SaveScanIndex(const string& fname, const ScanIndex& index) {
+    vector<char> records;
+    for (ScanIndex::const_iterator e = index.begin(); e != index.end(); ++e) {
+      Pack(records, e->first, e->second);
+    }
+    ScanIndexHeader hdr;
+    memcpy(hdr.magic, scanMagic, sizeof(scanMagic));
+    hdr.version = scanVersion;
+    hdr.checksum = Checksum(records.empty() ? NULL : &records[0],
+                            records.size());
+    hdr.entries = index.size();
+    hdr.bytes = records.size();
+
+    // write to the side and then move it into place, so that a concurrent
+    // scan never reads a half-written index.
+    const string tmpname = fname + ".tmp";
+    {
+      ofstream os(tmpname.c_str(), ios::binary);
+      os.write(reinterpret_cast<const char*>(&hdr), sizeof(ScanIndexHeader));
+      if (!records.empty()) os.write(&records[0], records.size());
+      if (!os) {
+        WARNING("writing DICOM scan index %s failed.", tmpname.c_str());
+        os.close();
+        remove(tmpname.c_str());
+        return;
+      }
+    }
+    if (rename(tmpname.c_str(), fname.c_str()) != 0) {
+      // some platforms won't rename over an existing file.
+      remove(fname.c_str());
+      if (rename(tmpname.c_str(), fname.c_str()) != 0) {
+        WARNING("could not move DICOM scan index into place (%s).",
+                fname.c_str());
+        remove(tmpname.c_str());
+      }
+    }
+  }
+
+  /// Groups files the way DICOMStackInfo::Match does: two files belong to
+  /// the same stack iff they agree in all of these fields.
+  struct StackKey {
+    explicit StackKey(const DICOMFileInfo& i) : info(&i) {}
+    bool operator==(const StackKey& other) const {
+      const DICOMFileInfo& a = *info;
+      const DICOMFileInfo& b = *other.info;
+      return a.m_iSeries        == b.m_iSeries &&
+             a.m_ivSize          == b.m_ivSize &&
+             a.m_iAllocated      == b.m_iAllocated &&
+             a.m_iStored         == b.m_iStored &&
+             a.m_iComponentCount == b.m_iComponentCount &&
+             a.m_bSigned         == b.m_bSigned &&
+             a.m_fvfAspect       == b.m_fvfAspect &&
+             a.m_bIsBigEndian    == b.m_bIsBigEndian &&
+             a.m_bIsJPEGEncoded  == b.m_bIsJPEGEncoded &&
+             a.m_strAcquDate     == b.m_strAcquDate &&
+             a.m_strModality     == b.m_strModality &&
+             a.m_strDesc         == b.m_strDesc;
+    }
+    const DICOMFileInfo* info;
+  };
+  struct StackKeyHash {
+    size_t operator()(const StackKey& k) const {
+      const DICOMFileInfo& i = *k.info;
+      size_t h = std::hash<uint32_t>()(i.m_iSeries);
+      combine(h, std::hash<uint32_t>()(i.m_ivSize.x));
+      combine(h, std::hash<uint32_t>()(i.m_ivSize.y));
+      combine(h, std::hash<uint32_t>()(i.m_ivSize.z));
+      combine(h, std::hash<uint32_t>()(i.m_iAllocated));
+      combine(h, std::hash<float>()(i.m_fvfAspect.x));
+      combine(h, std::hash<float>()(i.m_fvfAspect.y));
+      combine(h, std::hash<float>()(i.m_fvfAspect.z));
+      combine(h, std::hash<string>()(i.m_strAcquDate));
+      combine(h, std::hash<string>()(i.m_strDesc));
+      return h;
+    }
+    static void combine(size_t& h, size_t v) {
+      h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+  };
+
+  bool ImageIndexSmaller(const SimpleFileInfo* a, const SimpleFileInfo* b) {
+    return a->m_iImageIndex < b->m_iImageIndex;
+  }
+}
+
 DICOMParser::DICOMParser(void)
 {
 }
@@ -109,39 +426,78 @@ bool StacksSmaller ( FileStackInfo* pElem1, FileStackInfo* pElem2 )
 
 void DICOMParser::GetDirInfo(string  strDirectory) {
   vector<string> files = SysTools::GetDirContents(strDirectory);
-  vector<DICOMFileInfo> fileInfos;
-
-  // query directory for DICOM files
-  for (size_t i = 0;i<files.size();i++) {
-    MESSAGE("Looking for DICOM data in file %s", files[i].c_str());
-    DICOMFileInfo info;
-    if (GetDICOMFileInfo(files[i], info)) {
-      fileInfos.push_back(info);
+  vector<ScanEntry> scans(files.size());
+  vector<char> bStatted(files.size(), 0);
+
+  ScanIndex index;
+  if (!m_strScanIndex.empty()) LoadScanIndex(m_strScanIndex, index);
+
+  // query directory for DICOM files.  The files are independent, so we read
+  // their headers in parallel; files the index knows as they are now are
+  // not read at all.
+  const int64_t iFiles = static_cast<int64_t>(files.size());
+  int64_t iRead = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:iRead)
+  for (int64_t i = 0; i < iFiles; i++) {
+    ScanEntry& e = scans[size_t(i)];
+    LARGE_STAT_BUFFER stat_buf;
+    if (!SysTools::GetFileStats(files[size_t(i)], stat_buf)) continue;
+    bStatted[size_t(i)] = 1;
+    e.iSize = static_cast<uint64_t>(stat_buf.st_size);
+    e.iMTime = static_cast<int64_t>(stat_buf.st_mtime);
+
+    ScanIndex::const_iterator known = index.find(files[size_t(i)]);
+    if (known != index.end() && known->second.iSize == e.iSize &&
+        known->second.iMTime == e.iMTime) {
+      e.bDICOM = known->second.bDICOM;
+      e.info = known->second.info;
+    } else {
+      e.bDICOM = GetDICOMFileInfo(files[size_t(i)], e.info);
+      iRead++;
+    }
+  }
+  MESSAGE("Read the headers of %lld of %u files in %s.",
+          static_cast<long long>(iRead), static_cast<unsigned>(files.size()),
+          strDirectory.c_str());
+
+  if (!m_strScanIndex.empty() && iRead > 0) {
+    for (size_t i = 0; i<files.size(); i++) {
+      if (bStatted[i]) index[files[i]] = scans[i];
     }
+    SaveScanIndex(m_strScanIndex, index);
   }
 
   // sort results into stacks
   for (size_t i = 0; i<m_FileStacks.size(); i++) delete m_FileStacks[i];
   m_FileStacks.clear();
 
-  MESSAGE("%d files in candidate list.", fileInfos.size());
-  // Ignore duplicate DICOMs.
-  for (size_t i = 0; i<fileInfos.size(); i++) {
-    bool bFoundMatch = false;
-    for (size_t j = 0; j<m_FileStacks.size(); j++) {
-      if (((DICOMStackInfo*)m_FileStacks[j])->Match(&fileInfos[i])) {
-        MESSAGE("found match at %u(%s), dropping %u(%s) out.",
-                static_cast<unsigned>(j), m_FileStacks[j]->m_strDesc.c_str(),
-                static_cast<unsigned>(i), fileInfos[i].m_strDesc.c_str());
-        bFoundMatch = true;
-        break;
-      }
-    }
-    if (!bFoundMatch) {
-      DICOMStackInfo* newStack = new DICOMStackInfo(&fileInfos[i]);
-      m_FileStacks.push_back(newStack);
+  // Hashing finds a file's stack without trying every stack in turn.
+  std::unordered_map<StackKey, size_t, StackKeyHash> stacks;
+  size_t iCandidates = 0;
+  for (size_t i = 0; i<scans.size(); i++) {
+    if (!scans[i].bDICOM) continue;
+    iCandidates++;
+    const DICOMFileInfo& info = scans[i].info;
+    std::unordered_map<StackKey, size_t, StackKeyHash>::const_iterator s =
+      stacks.find(StackKey(info));
+    if (s == stacks.end()) {
+      stacks.insert(std::make_pair(StackKey(info), m_FileStacks.size()));
+      m_FileStacks.push_back(new DICOMStackInfo(&info));
+    } else {
+      m_FileStacks[s->second]->m_Elements.push_back(
+        new SimpleDICOMFileInfo(&info));
     }
   }
+  MESSAGE("%u files in candidate list, %u stacks.",
+          static_cast<unsigned>(iCandidates),
+          static_cast<unsigned>(m_FileStacks.size()));
+
+  // order each stack by image number; files with the same number keep the
+  // order they were found in, as DICOMStackInfo::Match would have it.
+  for (size_t i = 0; i<m_FileStacks.size(); i++) {
+    std::stable_sort(m_FileStacks[i]->m_Elements.begin(),
+                     m_FileStacks[i]->m_Elements.end(), ImageIndexSmaller);
+  }
 
   // sort stacks by sequence number
   sort( m_FileStacks.begin( ), m_FileStacks.end( ), StacksSmaller );
@@ -155,12 +511,23 @@ void DICOMParser::GetDirInfo(string  strDirectory) {
   }
 }
 
+string DICOMParser::ScanIndexFor(const string& strDirectory) {
+  string strTemp;
+  if (!SysTools::GetTempDirectory(strTemp) || strTemp.empty()) return "";
+  // one index per directory: scans of different directories don't rewrite
+  // each other's entries, and an index holds no more than its directory.
+  std::ostringstream name;
+  name << strTemp << "tuvok-dicomscan-" << std::hex
+       << std::hash<string>()(strDirectory) << ".idx";
+  return name.str();
+}
+
 void DICOMParser::GetDirInfo(wstring wstrDirectory) {
   string strDirectory(wstrDirectory.begin(), wstrDirectory.end());
   GetDirInfo(strDirectory);
 }
 
-void DICOMParser::ReadHeaderElemStart(ifstream& fileDICOM, short& iGroupID, short& iElementID, DICOM_eType& eElementType, uint32_t& iElemLength, bool bImplicit, bool bNeedsEndianConversion) {
+void DICOMParser::ReadHeaderElemStart(istream& fileDICOM, short& iGroupID, short& iElementID, DICOM_eType& eElementType, uint32_t& iElemLength, bool bImplicit, bool bNeedsEndianConversion) {
   string typeString = "  ";
 
   fileDICOM.read((char*)&iGroupID,2);
@@ -210,7 +577,7 @@ void DICOMParser::ReadHeaderElemStart(ifstream& fileDICOM, short& iGroupID, shor
 }
 
 
-uint32_t DICOMParser::GetUInt(ifstream& fileDICOM, const DICOM_eType eElementType, const uint32_t iElemLength, const bool bNeedsEndianConversion) {
+uint32_t DICOMParser::GetUInt(istream& fileDICOM, const DICOM_eType eElementType, const uint32_t iElemLength, const bool bNeedsEndianConversion) {
   string value;
   uint32_t result;
   switch (eElementType) {
@@ -239,11 +606,11 @@ uint32_t DICOMParser::GetUInt(ifstream& fileDICOM, const DICOM_eType eElementTyp
 
 
 #ifdef DEBUG_DICOM
-void DICOMParser::ParseUndefLengthSequence(ifstream& fileDICOM, short& iSeqGroupID, short& iSeqElementID, DICOMFileInfo& info, const bool bImplicit, const bool bNeedsEndianConversion, uint32_t iDepth) {
+void DICOMParser::ParseUndefLengthSequence(istream& fileDICOM, short& iSeqGroupID, short& iSeqElementID, DICOMFileInfo& info, const bool bImplicit, const bool bNeedsEndianConversion, uint32_t iDepth) {
   for (int i = 0;i<int(iDepth)-1;i++) Console::printf("  ");
   Console::printf("iGroupID=%x iElementID=%x elementType=SEQUENCE (undef length)\n", iSeqGroupID, iSeqElementID);
 #else
-void DICOMParser::ParseUndefLengthSequence(ifstream& fileDICOM, short& , short& , DICOMFileInfo& info, const bool bImplicit, const bool bNeedsEndianConversion) {
+void DICOMParser::ParseUndefLengthSequence(istream& fileDICOM, short& , short& , DICOMFileInfo& info, const bool bImplicit, const bool bNeedsEndianConversion) {
 #endif
   int iItemCount = 0;
   uint32_t iData;
@@ -323,14 +690,14 @@ void DICOMParser::ParseUndefLengthSequence(ifstream& fileDICOM, short& , short&
 
 }
 
-void DICOMParser::ReadSizedElement(ifstream& fileDICOM, string& value, const uint32_t iElemLength) {
+void DICOMParser::ReadSizedElement(istream& fileDICOM, string& value, const uint32_t iElemLength) {
   value.resize(iElemLength);
   if (iElemLength) {
     fileDICOM.read(&value[0],iElemLength);
   }
 }
 
-void DICOMParser::SkipUnusedElement(ifstream& fileDICOM, string& value, const uint32_t iElemLength) {
+void DICOMParser::SkipUnusedElement(istream& fileDICOM, string& value, const uint32_t iElemLength) {
   ReadSizedElement(fileDICOM, value, iElemLength);
 }
 
@@ -360,7 +727,14 @@ bool DICOMParser::GetDICOMFileInfo(const string& strFilename,
   }
 
   // open file
-  ifstream fileDICOM(strFilename.c_str(), ios::in | ios::binary);
+  LargeFileC file(strFilename);
+  if (!file.is_open()) {
+    MESSAGE("File '%s' can't be a DICOM -- can't open it.",
+            strFilename.c_str());
+    return false;
+  }
+  BlockReadBuf buffer(file, static_cast<uint64_t>(stat_buf.st_size));
+  istream fileDICOM(&buffer);
   fileDICOM.seekg(128);  // skip first 128 bytes
 
   string value;
@@ -881,9 +1255,6 @@ bool DICOMParser::GetDICOMFileInfo(const string& strFilename,
     }
   }
 
-
-  fileDICOM.close();
-
   return info.m_ivSize.volume() != 0;
 }
 
@@ -908,6 +1279,8 @@ SimpleDICOMFileInfo::SimpleDICOMFileInfo(const std::wstring& wstrFileName) :
   m_iComponentCount(1),
   m_fScale(1.0f),
   m_fBias(0.0f),
+  m_fWindowWidth(0),
+  m_fWindowCenter(0),
   m_bSigned(false),
   m_iOffsetToData(0)
 {
@@ -919,6 +1292,8 @@ SimpleDICOMFileInfo::SimpleDICOMFileInfo() :
   m_iComponentCount(1),
   m_fScale(1.0f),
   m_fBias(0.0f),
+  m_fWindowWidth(0),
+  m_fWindowCenter(0),
   m_bSigned(false),
   m_iOffsetToData(0)
 {
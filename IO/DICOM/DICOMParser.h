@@ -39,7 +39,7 @@
 #ifndef DICOMPARSER_H
 #define DICOMPARSER_H
 
-#include <fstream>
+#include <istream>
 #include <string>
 
 // if the following define is set, the DICOM parser outputs detailed parsing
@@ -159,26 +159,39 @@ public:
   DICOMParser(void);
   ~DICOMParser(void);
 
+  /// Scans the files' headers in parallel and groups them into stacks.
   virtual void GetDirInfo(std::string  strDirectory);
   virtual void GetDirInfo(std::wstring wstrDirectory);
 
+  /// Remembers what scanning found in 'strIndexFile', keyed by each file's
+  /// path, size and modification time, so that files which did not change
+  /// are not read again.  Empty (the default) disables the index.
+  void SetScanIndex(const std::string& strIndexFile) {
+    m_strScanIndex = strIndexFile;
+  }
+  /// @returns the scan index for 'strDirectory' in the temp directory, or
+  /// an empty string if there is no temp directory.
+  static std::string ScanIndexFor(const std::string& strDirectory);
+
+  /// Reads the header of one file; only the blocks of the file the header
+  /// covers are read, never the pixel data.
   static bool GetDICOMFileInfo(const std::string& fileName, DICOMFileInfo& info);
 protected:
-  static void ReadSizedElement(std::ifstream& fileDICOM, std::string& value, 
+  static void ReadSizedElement(std::istream& fileDICOM, std::string& value, 
                                 const uint32_t iElemLength);
-  static void SkipUnusedElement(std::ifstream& fileDICOM, std::string& value,
+  static void SkipUnusedElement(std::istream& fileDICOM, std::string& value,
                                 const uint32_t iElemLength);
-  static void ReadHeaderElemStart(std::ifstream& fileDICOM, short& iGroupID,
+  static void ReadHeaderElemStart(std::istream& fileDICOM, short& iGroupID,
                                   short& iElementID, DICOM_eType& eElementType,
                                   uint32_t& iElemLength, bool bImplicit,
                                   bool bNeedsEndianConversion);
-  static uint32_t GetUInt(std::ifstream& fileDICOM,
+  static uint32_t GetUInt(std::istream& fileDICOM,
                         const DICOM_eType eElementType,
                         const uint32_t iElemLength,
                         const bool bNeedsEndianConversion);
 
   #ifdef DEBUG_DICOM
-  static void ParseUndefLengthSequence(std::ifstream& fileDICOM,
+  static void ParseUndefLengthSequence(std::istream& fileDICOM,
                                        short& iSeqGroupID,
                                        short& iSeqElementID,
                                        DICOMFileInfo& info,
@@ -186,13 +199,16 @@ protected:
                                        const bool bNeedsEndianConversion,
                                        uint32_t iDepth);
   #else
-  static void ParseUndefLengthSequence(std::ifstream& fileDICOM,
+  static void ParseUndefLengthSequence(std::istream& fileDICOM,
                                        short& iSeqGroupID,
                                        short& iSeqElementID,
                                        DICOMFileInfo& info,
                                        const bool bImplicit,
                                        const bool bNeedsEndianConversion);
   #endif
+
+private:
+  std::string m_strScanIndex;
 };
 
 #endif // DICOMPARSER_H
@@ -44,8 +44,10 @@
 #include <utility>
 #include <boost/noncopyable.hpp>
 #include "Basics/Grids.h"
+#include "Basics/ValueOccupancy.h"
 #include "Basics/Vectors.h"
 #include "Brick.h"
+#include "BrickView.h"
 
 #define MAX_TRANSFERFUNCTION_SIZE 4096
 
@@ -99,6 +101,35 @@ public:
   virtual bool GetBrick(const BrickKey&, std::vector<float>&) const=0;
   virtual bool GetBrick(const BrickKey&, std::vector<double>&) const=0;
   ///@}
+  /// Zero-copy data access: describes where the brick's voxels already live
+  /// in memory.  Datasets which cannot do that return false; callers should
+  /// then fall back to GetBrick.
+  ///@{
+  virtual bool GetBrickView(const BrickKey&, BrickView<uint8_t>&) const {
+    return false;
+  }
+  virtual bool GetBrickView(const BrickKey&, BrickView<int8_t>&) const {
+    return false;
+  }
+  virtual bool GetBrickView(const BrickKey&, BrickView<uint16_t>&) const {
+    return false;
+  }
+  virtual bool GetBrickView(const BrickKey&, BrickView<int16_t>&) const {
+    return false;
+  }
+  virtual bool GetBrickView(const BrickKey&, BrickView<uint32_t>&) const {
+    return false;
+  }
+  virtual bool GetBrickView(const BrickKey&, BrickView<int32_t>&) const {
+    return false;
+  }
+  virtual bool GetBrickView(const BrickKey&, BrickView<float>&) const {
+    return false;
+  }
+  virtual bool GetBrickView(const BrickKey&, BrickView<double>&) const {
+    return false;
+  }
+  ///@}
   virtual BrickTable::const_iterator BricksBegin() const = 0;
   virtual BrickTable::const_iterator BricksEnd() const = 0;
   /// @return the number of bricks in a given LoD + timestep.
@@ -149,6 +180,11 @@ public:
   virtual bool ContainsData(const BrickKey&, double /*isoval*/) const {return true;}
   virtual bool ContainsData(const BrickKey&, double /*fMin*/, double /*fMax*/) const {return true;}
   virtual bool ContainsData(const BrickKey&, double /*fMin*/, double /*fMax*/, double /*fMinGradient*/, double /*fMaxGradient*/) const {return true;}
+  /// @param ranges value ranges of interest, e.g. a 1D TF's non-zero ones
+  virtual bool ContainsData(const BrickKey& k, const ValueRanges& ranges) const {
+    return !ranges.empty() &&
+           ContainsData(k, ranges.front().first, ranges.back().second);
+  }
 
   /// unimplemented!  Override these if you want tools built on this IO layer
   /// to be able to create data in your format.
@@ -0,0 +1,479 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include "StdTuvokDefines.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "3rdParty/bzip2/bzlib.h"
+#include "3rdParty/zlib/zlib.h"
+#include "Controller/Controller.h"
+#include "DecompressingRAWFile.h"
+
+namespace tuvok {
+
+namespace {
+  // data are handed to the reader in blocks of (about) this size, and this
+  // many may be waiting for it.
+  const size_t iBlockSize = 4*1024*1024;
+  const size_t iQueueDepth = 4;
+  // compressed data are read this much at a time.
+  const size_t iInSize = 1024*1024;
+  // BGZF blocks never hold more than this.
+  const size_t iMaxBGZFData = 65536;
+
+  uint16_t le16(const uint8_t* p) { return uint16_t(p[0] | (p[1] << 8)); }
+  uint32_t le32(const uint8_t* p) {
+    return uint32_t(le16(p)) | (uint32_t(le16(p+2)) << 16);
+  }
+
+  bool gzip_magic(const uint8_t* p, size_t n) {
+    return n >= 2 && p[0] == 0x1f && p[1] == 0x8b;
+  }
+
+  /// @returns the size of the BGZF block starting at 'p', or 0 if there is
+  /// none (or none whose header is complete in the 'n' bytes given).
+  /// @param iHeader is set to the size of the block's gzip header.
+  size_t bgzf_block(const uint8_t* p, size_t n, size_t& iHeader) {
+    // BGZF blocks have an 'extra' field and no other optional fields.
+    if(n < 18 || !gzip_magic(p, n) || p[2] != Z_DEFLATED || p[3] != 4) {
+      return 0;
+    }
+    const size_t iExtraEnd = 12 + le16(p+10);
+    if(iExtraEnd > n) { return 0; }
+    for(size_t i=12; i+4 <= iExtraEnd; i += 4 + le16(p+i+2)) {
+      if(p[i] == 'B' && p[i+1] == 'C' && le16(p+i+2) == 2 &&
+         i+6 <= iExtraEnd) {
+        iHeader = iExtraEnd;
+        return size_t(le16(p+i+4)) + 1;
+      }
+    }
+    return 0;
+  }
+}
+
+/// The decompressing thread and the blocks it queued for the reader.
+struct DecompressingRAWFile::Stream {
+  Stream(const LargeRAWFile& file, RAWEncoding e, bool bBGZF,
+         std::atomic<bool>& bFailed) :
+    m_File(file), m_Encoding(e), m_bBGZF(bBGZF), m_bFailed(bFailed),
+    m_bDone(false), m_bStop(false), m_iCurrent(0), m_bStarted(false)
+  {}
+  ~Stream() { Stop(); }
+
+  size_t Read(unsigned char* pData, uint64_t iCount, uint64_t iPos) {
+    std::lock_guard<std::mutex> lock(m_ReadMutex);
+    if(!m_bStarted || iPos < m_iCurrent) {
+      if(m_bStarted) {
+        MESSAGE("Reading '%s' from %llu again; restarting decompression.",
+                m_File.GetFilename().c_str(), iPos);
+      }
+      Stop();
+      Start();
+    }
+    size_t iRead = 0;
+    while(iCount > 0) {
+      const uint64_t iEnd = m_iCurrent + m_Current.size();
+      if(iPos < iEnd) {
+        const size_t n = size_t(std::min(iCount, iEnd - iPos));
+        memcpy(pData, &m_Current[size_t(iPos - m_iCurrent)], n);
+        pData += n;
+        iCount -= n;
+        iPos += n;
+        iRead += n;
+      } else {
+        m_iCurrent = iEnd;
+        m_Current.clear();
+        if(!Pop(m_Current)) { break; }
+      }
+    }
+    return iRead;
+  }
+
+  /// waits until the thread got past the data read so far: done, or with a
+  /// block queued which nobody asked for yet.
+  void Settle() {
+    std::lock_guard<std::mutex> rlock(m_ReadMutex);
+    if(!m_bStarted) { return; }
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Changed.wait(lock, [this]() { return !m_Blocks.empty() || m_bDone; });
+  }
+
+private:
+  void Start() {
+    m_Blocks.clear();
+    m_bDone = m_bStop = false;
+    m_strError.clear();
+    m_Current.clear();
+    m_iCurrent = 0;
+    m_bStarted = true;
+    m_Thread = std::thread(&Stream::Run, this);
+  }
+
+  void Stop() {
+    if(!m_Thread.joinable()) { return; }
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_bStop = true;
+    }
+    m_Changed.notify_all();
+    m_Thread.join();
+    m_Blocks.clear();
+  }
+
+  void Run() {
+    switch(m_Encoding) {
+      case RE_GZIP: if(m_bBGZF) { InflateBGZF(); } else { Inflate(0); } break;
+      case RE_BZIP2: Bunzip(); break;
+      default: Fail("is not compressed"); break;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_bDone = true;
+    }
+    m_Changed.notify_all();
+  }
+
+  /// queues 'block' for the reader, once there is room for it.
+  /// @returns false if the reader wants us to stop.
+  bool Push(std::vector<uint8_t>& block) {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Changed.wait(lock, [this]() {
+      return m_Blocks.size() < iQueueDepth || m_bStop;
+    });
+    if(m_bStop) { return false; }
+    m_Blocks.push_back(std::vector<uint8_t>());
+    m_Blocks.back().swap(block);
+    lock.unlock();
+    m_Changed.notify_all();
+    return true;
+  }
+
+  /// @returns false if there are no more blocks, and why, if that is early.
+  bool Pop(std::vector<uint8_t>& block) {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Changed.wait(lock, [this]() { return !m_Blocks.empty() || m_bDone; });
+    if(m_Blocks.empty()) {
+      if(!m_strError.empty()) {
+        T_ERROR("'%s' %s", m_File.GetFilename().c_str(), m_strError.c_str());
+        m_strError.clear();
+      }
+      return false;
+    }
+    block.swap(m_Blocks.front());
+    m_Blocks.pop_front();
+    lock.unlock();
+    m_Changed.notify_all();
+    return true;
+  }
+
+  void Fail(const std::string& strError) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_strError = strError;
+    m_bFailed = true;
+  }
+
+  /// reads compressed data.  Bypasses our own ReadRAWAt, of course.
+  size_t ReadIn(uint8_t* pData, size_t iCount, uint64_t iPos) const {
+    return m_File.LargeRAWFile::ReadRAWAt(pData, iCount, iPos);
+  }
+
+  /// inflates gzip members (or zlib streams) one after the other, starting
+  /// at compressed offset 'iIn'.
+  bool Inflate(uint64_t iIn) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // +32: detect gzip or zlib headers.
+    if(inflateInit2(&z, 32 + MAX_WBITS) != Z_OK) {
+      Fail("could not be decompressed: zlib initialization failed.");
+      return false;
+    }
+    std::vector<uint8_t> in(iInSize), out(iBlockSize);
+    size_t iOut = 0;
+    bool bOK = true;
+    for(;;) {
+      if(z.avail_in == 0) {
+        z.next_in = &in[0];
+        z.avail_in = uInt(ReadIn(&in[0], in.size(), iIn));
+        iIn += z.avail_in;
+        if(z.avail_in == 0) {
+          Fail("ends in the middle of its gzip data.");
+          bOK = false;
+          break;
+        }
+      }
+      z.next_out = &out[iOut];
+      z.avail_out = uInt(out.size() - iOut);
+      const int ret = inflate(&z, Z_NO_FLUSH);
+      iOut = out.size() - z.avail_out;
+      if(ret != Z_OK && ret != Z_STREAM_END) {
+        std::ostringstream err;
+        err << "has corrupt gzip data (" << (z.msg ? z.msg : "unknown error")
+            << ").";
+        Fail(err.str());
+        bOK = false;
+        break;
+      }
+      if(iOut == out.size()) {
+        if(!Push(out)) { bOK = false; break; }
+        out.resize(iBlockSize);
+        iOut = 0;
+      }
+      if(ret == Z_STREAM_END) {
+        // another member may follow; anything else is trailing garbage.
+        uint8_t magic[2];
+        if(!gzip_magic(magic, ReadIn(magic, 2, iIn - z.avail_in))) { break; }
+        inflateReset(&z);
+      }
+    }
+    inflateEnd(&z);
+    if(bOK && iOut > 0) {
+      out.resize(iOut);
+      bOK = Push(out);
+    }
+    return bOK;
+  }
+
+  /// inflates BGZF blocks, a block's worth of them in parallel at a time.
+  bool InflateBGZF() {
+    struct Member {
+      size_t iIn, iInSize;   ///< where the deflate data are in 'in'
+      size_t iOut, iOutSize; ///< where they go in 'out'
+      uint32_t iCRC;
+    };
+    std::vector<uint8_t> in; // compressed data, starting at offset iIn
+    uint64_t iIn = 0;
+    bool bEOF = false;
+    for(;;) {
+      if(!bEOF && in.size() < iBlockSize) {
+        const size_t iHave = in.size();
+        in.resize(iBlockSize);
+        const size_t iGot = ReadIn(&in[iHave], iBlockSize - iHave,
+                                   iIn + iHave);
+        in.resize(iHave + iGot);
+        bEOF = iGot < iBlockSize - iHave;
+      }
+      if(in.empty()) { return true; }
+
+      std::vector<Member> members;
+      size_t iUsed = 0, iOutSize = 0;
+      while(iOutSize < iBlockSize) {
+        size_t iHeader = 0;
+        const size_t iSize = bgzf_block(&in[0] + iUsed, in.size() - iUsed,
+                                        iHeader);
+        if(iSize < iHeader + 8 || iUsed + iSize > in.size()) { break; }
+        const uint8_t* pTrailer = &in[iUsed + iSize - 8];
+        const Member m = { iUsed + iHeader, iSize - iHeader - 8, iOutSize,
+                           le32(pTrailer + 4), le32(pTrailer) };
+        if(m.iOutSize > iMaxBGZFData) { break; }
+        members.push_back(m);
+        iOutSize += m.iOutSize;
+        iUsed += iSize;
+      }
+      if(members.empty()) {
+        // no more BGZF blocks; inflate any other members the usual way.
+        if(!gzip_magic(&in[0], in.size())) { return true; }
+        return Inflate(iIn);
+      }
+
+      std::vector<uint8_t> out(iOutSize);
+      std::atomic<bool> bOK(true);
+      const int64_t iMembers = int64_t(members.size());
+#pragma omp parallel for schedule(dynamic)
+      for(int64_t i=0; i < iMembers; ++i) {
+        const Member& m = members[size_t(i)];
+        uint8_t dummy; // zlib wants somewhere to write, even if it will not.
+        uint8_t* pOut = m.iOutSize > 0 ? &out[m.iOut] : &dummy;
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        if(inflateInit2(&z, -MAX_WBITS) != Z_OK) { bOK = false; continue; }
+        z.next_in = &in[m.iIn];
+        z.avail_in = uInt(m.iInSize);
+        z.next_out = pOut;
+        z.avail_out = uInt(m.iOutSize);
+        if(inflate(&z, Z_FINISH) != Z_STREAM_END || z.avail_out != 0 ||
+           crc32(crc32(0L, Z_NULL, 0), pOut, uInt(m.iOutSize)) != m.iCRC) {
+          bOK = false;
+        }
+        inflateEnd(&z);
+      }
+      if(!bOK) {
+        Fail("has a corrupt BGZF block.");
+        return false;
+      }
+      if(!out.empty() && !Push(out)) { return false; }
+      in.erase(in.begin(), in.begin() + iUsed);
+      iIn += iUsed;
+    }
+  }
+
+  /// decompresses bzip2 streams one after the other.
+  bool Bunzip() {
+#ifdef TUVOK_NO_IO
+    Fail("cannot be decompressed: bzip2 library not available!");
+    return false;
+#else
+    bz_stream bz;
+    memset(&bz, 0, sizeof(bz));
+    if(BZ2_bzDecompressInit(&bz, 0, 0) != BZ_OK) {
+      Fail("could not be decompressed: bzip2 initialization failed.");
+      return false;
+    }
+    std::vector<uint8_t> in(iInSize), out(iBlockSize);
+    uint64_t iIn = 0;
+    size_t iOut = 0;
+    bool bOK = true;
+    for(;;) {
+      if(bz.avail_in == 0) {
+        bz.next_in = reinterpret_cast<char*>(&in[0]);
+        bz.avail_in = unsigned(ReadIn(&in[0], in.size(), iIn));
+        iIn += bz.avail_in;
+        if(bz.avail_in == 0) {
+          Fail("ends in the middle of its bzip2 data.");
+          bOK = false;
+          break;
+        }
+      }
+      bz.next_out = reinterpret_cast<char*>(&out[iOut]);
+      bz.avail_out = unsigned(out.size() - iOut);
+      const int ret = BZ2_bzDecompress(&bz);
+      iOut = out.size() - bz.avail_out;
+      if(ret != BZ_OK && ret != BZ_STREAM_END) {
+        std::ostringstream err;
+        err << "has corrupt bzip2 data (error " << ret << ").";
+        Fail(err.str());
+        bOK = false;
+        break;
+      }
+      if(iOut == out.size()) {
+        if(!Push(out)) { bOK = false; break; }
+        out.resize(iBlockSize);
+        iOut = 0;
+      }
+      if(ret == BZ_STREAM_END) {
+        // pbzip2 and friends write several streams.
+        uint8_t magic[3];
+        if(ReadIn(magic, 3, iIn - bz.avail_in) < 3 ||
+           memcmp(magic, "BZh", 3) != 0) { break; }
+        char* pNext = bz.next_in;
+        const unsigned iAvail = bz.avail_in;
+        BZ2_bzDecompressEnd(&bz);
+        memset(&bz, 0, sizeof(bz));
+        if(BZ2_bzDecompressInit(&bz, 0, 0) != BZ_OK) {
+          Fail("could not be decompressed: bzip2 initialization failed.");
+          return false;
+        }
+        bz.next_in = pNext;
+        bz.avail_in = iAvail;
+      }
+    }
+    BZ2_bzDecompressEnd(&bz);
+    if(bOK && iOut > 0) {
+      out.resize(iOut);
+      bOK = Push(out);
+    }
+    return bOK;
+#endif
+  }
+
+  const LargeRAWFile& m_File;
+  const RAWEncoding m_Encoding;
+  const bool m_bBGZF;
+  std::atomic<bool>& m_bFailed; ///< set for good by Fail
+
+  std::thread m_Thread;
+  std::mutex m_Mutex; ///< guards everything the thread and reader share
+  std::condition_variable m_Changed;
+  std::deque<std::vector<uint8_t>> m_Blocks;
+  bool m_bDone;           ///< the thread will not queue any more blocks
+  bool m_bStop;           ///< the thread should finish
+  std::string m_strError; ///< why the thread finished early, if it did
+
+  std::mutex m_ReadMutex; ///< readers are served one at a time
+  std::vector<uint8_t> m_Current; ///< the block being read
+  uint64_t m_iCurrent;    ///< offset of m_Current in the data
+  bool m_bStarted;
+};
+
+DecompressingRAWFile::DecompressingRAWFile(const std::string& strFilename,
+                                           uint64_t iHeaderSkip,
+                                           RAWEncoding e, uint64_t iSize) :
+  LargeRAWFile(strFilename, iHeaderSkip),
+  m_Encoding(e),
+  m_iSize(iSize),
+  m_iPos(0),
+  m_bBGZF(false),
+  m_bFailed(false)
+{}
+
+DecompressingRAWFile::~DecompressingRAWFile() { Close(); }
+
+bool DecompressingRAWFile::Open(bool bReadWrite) {
+  if(bReadWrite || !LargeRAWFile::Open(false)) { return false; }
+  m_bBGZF = false;
+  if(m_Encoding == RE_GZIP) {
+    uint8_t header[64];
+    size_t iHeader = 0;
+    m_bBGZF = bgzf_block(header, LargeRAWFile::ReadRAWAt(header,
+                                                         sizeof(header), 0),
+                         iHeader) > 0;
+  }
+  // decompression starts with the first read.
+  m_pStream.reset(new Stream(*this, m_Encoding, m_bBGZF, m_bFailed));
+  m_iPos = 0;
+  return true;
+}
+
+void DecompressingRAWFile::Close() {
+  m_pStream.reset();
+  LargeRAWFile::Close();
+}
+
+size_t DecompressingRAWFile::ReadRAW(unsigned char* pData, uint64_t iCount) {
+  const size_t iRead = ReadRAWAt(pData, iCount, m_iPos);
+  m_iPos += iRead;
+  return iRead;
+}
+
+size_t DecompressingRAWFile::ReadRAWAt(unsigned char* pData, uint64_t iCount,
+                                       uint64_t iPos) const {
+  if(!m_pStream || iPos >= m_iSize) { return 0; }
+  return m_pStream->Read(pData, std::min(iCount, m_iSize - iPos), iPos);
+}
+
+bool DecompressingRAWFile::Failed() const {
+  if(m_pStream) { m_pStream->Settle(); }
+  return m_bFailed;
+}
+
+}
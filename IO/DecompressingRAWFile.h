@@ -0,0 +1,114 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_DECOMPRESSINGRAWFILE_H
+#define TUVOK_DECOMPRESSINGRAWFILE_H
+
+#include "StdTuvokDefines.h"
+#include <atomic>
+#include <memory>
+#include "Basics/LargeRAWFile.h"
+
+namespace tuvok {
+
+/// how the payload of a data file is stored.
+enum RAWEncoding {
+  RE_RAW,   ///< as it is
+  RE_GZIP,  ///< gzip (or zlib) compressed
+  RE_BZIP2  ///< bzip2 compressed
+};
+
+/// A read-only view of the compressed data 'iHeaderSkip' bytes into a file,
+/// as if they were stored uncompressed.  A thread decompresses a few blocks
+/// ahead of the reader, so decompression overlaps with whatever the reader
+/// does with the data.  Reading from the current or any later position is
+/// cheap; going back restarts decompression at the beginning.  This is made
+/// for passes over the data: put a BufferedRAWFile in front of it for
+/// anything which seeks around.
+///
+/// A gzip file of several members is inflated member after member.  If the
+/// members are BGZF blocks, which record their compressed size in the
+/// header, a batch of them is inflated in parallel instead.  Concatenated
+/// bzip2 streams are read as one.
+class DecompressingRAWFile : public LargeRAWFile {
+public:
+  /// @param e RE_GZIP or RE_BZIP2
+  /// @param iSize the size of the uncompressed data, in bytes
+  DecompressingRAWFile(const std::string& strFilename, uint64_t iHeaderSkip,
+                       RAWEncoding e, uint64_t iSize);
+  virtual ~DecompressingRAWFile();
+
+  virtual bool Open(bool bReadWrite=false);
+  virtual void Close();
+  virtual bool Create(uint64_t) { return false; }
+  virtual bool Append() { return false; }
+  virtual bool Truncate() { return false; }
+  virtual bool Truncate(uint64_t) { return false; }
+  virtual uint64_t GetCurrentSize() { return m_iSize; }
+
+  virtual void SeekStart() { m_iPos = 0; }
+  virtual uint64_t SeekEnd() { m_iPos = m_iSize; return m_iPos; }
+  virtual uint64_t GetPos() { return m_iPos; }
+  virtual void SeekPos(uint64_t iPos) { m_iPos = iPos; }
+
+  virtual size_t ReadRAW(unsigned char* pData, uint64_t iCount);
+  /// Readers are served one at a time; see the class comment for what a
+  /// position before the last one read costs.
+  virtual size_t ReadRAWAt(unsigned char* pData, uint64_t iCount,
+                           uint64_t iPos) const;
+
+  virtual size_t WriteRAW(const unsigned char*, uint64_t) { return 0; }
+  virtual bool CopyRAW(uint64_t, uint64_t, uint64_t, unsigned char*,
+                       uint64_t) { return false; }
+  // the offsets given to us would mean nothing to the file underneath.
+  virtual void Hint(IOHint, uint64_t, uint64_t) const {}
+
+  /// @returns true if the data are BGZF blocks, which are inflated in
+  /// parallel.  Only known once the file is open.
+  bool IsBGZF() const { return m_bBGZF; }
+
+  /// @returns true if decompression stopped early because the data are
+  /// corrupt or truncated, in this or any earlier pass.  Checksums come at
+  /// the end, so after the last byte was read this waits for them.
+  bool Failed() const;
+
+private:
+  struct Stream;
+
+  const RAWEncoding m_Encoding;
+  const uint64_t m_iSize;
+  uint64_t m_iPos;
+  bool m_bBGZF;
+  std::atomic<bool> m_bFailed;
+  std::unique_ptr<Stream> m_pStream;
+};
+
+}
+
+#endif // TUVOK_DECOMPRESSINGRAWFILE_H
@@ -5,12 +5,22 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <typeinfo>
 #include <unordered_map>
+#include <unordered_set>
+#include "Basics/Checksums/crc32.h"
+#include "Basics/MemMappedFile.h"
 #include "Basics/SysTools.h"
+#include "Basics/Threads.h"
 #include "BMinMax.h"
 #include "Controller/Controller.h"
 #include "Controller/StackTimer.h"
@@ -40,17 +50,86 @@ struct GBPrelim {
   VoxelIndex src_offset;
 };
 
+/// Layout of the precomputed min/max sidecar file.  The header is followed by
+/// 'records' MinMaxRecords, sorted by key, which we map and search in place.
+/// Everything is native-endian; a file written on a machine with the other
+/// byte order fails the version check and just gets rebuilt.
+struct MinMaxHeader {
+  char magic[8];         ///< "TVKMMIDX"
+  uint32_t version;
+  uint32_t checksum;     ///< CRC32 of all records
+  uint64_t srcSize;      ///< size and modification time of the source file
+  int64_t srcMTime;      ///<   when the min/maxes were computed
+  uint64_t brickSize[3];
+  uint64_t records;
+};
+struct MinMaxRecord {
+  uint64_t ts, lod, brick;
+  double minScalar, maxScalar;
+  double minGradient, maxGradient;
+};
+static const char mmMagic[8] = {'T','V','K','M','M','I','D','X'};
+// 2: real gradient magnitude ranges instead of placeholders.
+static const uint32_t mmVersion = 2;
+
 struct DynamicBrickingDS::dbinfo {
   std::shared_ptr<LinearIndexDataset> ds;
   const BrickSize brickSize;
   BrickCache cache;
-  size_t cacheBytes;
-  std::unordered_map<BrickKey, MinMaxBlock, BKeyHash> minmax;
   enum MinMaxMode mmMode;
 
+  /// Precomputed min/maxes, sorted by key.  These point into the mapped
+  /// sidecar file, or into 'mmLocal' if we had to compute them ourselves.
+  ///@{
+  std::unique_ptr<MemMappedFile> mmFile;
+  std::vector<MinMaxRecord> mmLocal;
+  const MinMaxRecord* mmRecords;
+  uint64_t mmCount;
+  ///@}
+
+  /// Prefetching: a few background threads read source bricks into the
+  /// cache.  'guard' protects the cache and all of the prefetch state, but is
+  /// never held while reading from the source; only readers of the very same
+  /// source brick wait for each other.
+  ///@{
+  CriticalSection guard;
+  WaitCondition work; ///< signalled when bricks are queued
+  std::deque<BrickKey> queue; ///< source bricks to prefetch, in order
+  std::unordered_set<BrickKey, BKeyHash> queued; ///< keys in 'queue'
+  /// being read right now; signalled when that read finishes.
+  std::unordered_map<BrickKey, std::shared_ptr<WaitCondition>,
+                     BKeyHash> inflight;
+  /// reads a source brick into the cache, using the same type GetBrick uses.
+  std::function<void (const BrickKey&)> prefetch;
+  const std::type_info* prefetchType;
+  std::vector<std::unique_ptr<LambdaThread>> loaders;
+  ///@}
+
+  /// Takes a source brick out of 'inflight' (and wakes whoever waits for it)
+  /// when it goes out of scope, however the read ended.
+  struct Landing {
+    Landing(dbinfo& d, const BrickKey& k) : db(d), skey(k) {}
+    ~Landing() {
+      SCOPEDLOCK(this->db.guard);
+      auto busy = this->db.inflight.find(this->skey);
+      if(busy == this->db.inflight.end()) { return; }
+      busy->second->WakeAll();
+      this->db.inflight.erase(busy);
+    }
+    dbinfo& db;
+    const BrickKey skey;
+  private:
+    Landing(const Landing&);
+    Landing& operator=(const Landing&);
+  };
+
   dbinfo(std::shared_ptr<LinearIndexDataset> d,
          BrickSize bs, size_t bytes, enum MinMaxMode mm) :
-    ds(d), brickSize(bs), cacheBytes(bytes), mmMode(mm) {}
+    ds(d), brickSize(bs), mmMode(mm), mmRecords(NULL), mmCount(0),
+    prefetchType(NULL) {
+    cache.capacity(bytes);
+  }
+  ~dbinfo();
 
   // early, non-type-specific parts of GetBrick.
   GBPrelim BrickSetup(const BrickKey&, const DynamicBrickingDS& tgt) const;
@@ -59,40 +138,56 @@ struct DynamicBrickingDS::dbinfo {
   template<typename T> bool Brick(const DynamicBrickingDS& ds,
                                   const BrickKey& key,
                                   std::vector<T>& data);
+  // finds the brick within its (cached) source brick
+  template<typename T> bool View(const DynamicBrickingDS& ds,
+                                 const BrickKey& key,
+                                 BrickView<T>& view);
+  // marks a source brick as being read.  guard must be held.
+  void TakeOff(const BrickKey& skey);
+  // reads a source brick and caches it.  'skey' must be in 'inflight'.
+  template<typename T> std::shared_ptr<const void> Read(const BrickKey& skey);
 
   // given the brick key in the dynamic DS, return the corresponding BrickKey
   // in the source data.
   BrickKey SourceBrickKey(const BrickKey&) const;
 
+  // queues the source bricks of the given (target) bricks for loading.
+  void Prefetch(const std::vector<BrickKey>&);
+  // body of the loader threads: work off the queue until we are destroyed.
+  void LoadQueued(const bool& bContinue);
+  // reads a source brick into the cache, unless it is already there.
+  template<typename T> void Load(const BrickKey& skey);
+  // makes prefetches read bricks as 'T'.  guard must be held.
+  template<typename T> void PrefetchAs();
+  // makes prefetches read bricks in the source's type.  guard must be held.
+  void PrefetchNative();
+  // empties the cache and drops any queued prefetches.
+  void ClearCache();
+
   BrickLayout TargetBrickLayout(size_t lod, size_t ts) const;
 
   /// since ComputeMinMaxes is soooo absurdly slow, we try to cache the
-  /// results.  These load/save all our min/maxes to a stream.
+  /// results in a sidecar file.  LoadMinMax maps the file and validates it
+  /// against the given dataset; SaveMinMax writes out 'mmLocal'.
   ///@{
-  void LoadMinMax(std::istream&);
-  void SaveMinMax(std::ostream&) const;
+  bool LoadMinMax(const std::string& fname, const BrickedDataset&);
+  void SaveMinMax(const std::string& fname, const BrickedDataset&) const;
   ///@}
 
   /// run through all of the bricks and compute min/max info.
   void ComputeMinMaxes(BrickedDataset&);
+  /// @returns the precomputed min/max for the brick, or NULL
+  const MinMaxRecord* FindMinMax(const BrickKey&) const;
 
   // sets the cache size (bytes)
   void SetCacheSize(size_t bytes);
   // get the cache size (bytes)
   size_t GetCacheSize() const;
 
-  /// @returns true if 'bytes' bytes will fit into the current cache
-  bool FitsInCache(size_t bytes) const;
-
   void VerifyBrick(const std::pair<BrickKey, BrickMD>& brk) const;
 
   /// @returns the size of the brick, minus any ghost voxels.
   BrickSize BrickSansGhost() const;
-
-  template<typename T, typename Iter>
-  bool CopyBrick(std::vector<T>& dest, Iter src, size_t components,
-                 const BrickSize tgt_bs, const BrickSize src_bs,
-                 VoxelIndex src_offset);
 };
 
 static BrickSize SourceMaxBrickSize(const BrickedDataset&);
@@ -169,7 +264,7 @@ size_t DynamicBrickingDS::GetCacheSize() const {
 // Removes all the cache information we've made so far.
 void DynamicBrickingDS::Clear() {
   di->ds->Clear();
-  while(this->di->cache.size() > 0) { this->di->cache.remove(); }
+  this->di->ClearCache();
   BrickedDataset::Clear();
   this->Rebrick();
 }
@@ -490,53 +585,6 @@ DynamicBrickingDS::dbinfo::TargetBrickLayout(size_t lod, size_t ts) const {
   return tgt_blayout;
 }
 
-// This is the type-dependent part of ::GetBrick.  Basically, the copying of
-// the source data into the target brick.
-template<typename T, typename Iter>
-bool DynamicBrickingDS::dbinfo::CopyBrick(
-  std::vector<T>& dest, const Iter srcdata, size_t components,
-  const BrickSize tgt_bs, const BrickSize src_bs,
-  VoxelIndex src_offset
-) {
-  assert(tgt_bs[0] <= src_bs[0] && "target can't be larger than source");
-  assert(tgt_bs[1] <= src_bs[1] && "target can't be larger than source");
-  assert(tgt_bs[2] <= src_bs[2] && "target can't be larger than source");
-
-  // make sure the vector is big enough.
-  //assert(dest.size() >= (tgt_bs[0]*tgt_bs[1]*tgt_bs[2])); // be sure!
-  dest.resize(tgt_bs[0]*tgt_bs[1]*tgt_bs[2]*components);
-
-  const VoxelIndex orig_offset = src_offset;
-
-  // our copy size/scanline size is the width of our target brick.
-  const size_t scanline = tgt_bs[0] * components;
-
-  for(uint64_t z=0; z < tgt_bs[2]; ++z) {
-    for(uint64_t y=0; y < tgt_bs[1]; ++y) {
-      const uint64_t x = 0;
-      const uint64_t tgt_offset = (z*tgt_bs[0]*tgt_bs[1] + y*tgt_bs[0] + x) *
-                                   components;
-
-      const uint64_t src_o = (src_offset[2]*src_bs[0]*src_bs[1] +
-                              src_offset[1]*src_bs[0] + src_offset[0]) *
-                              components;
-#if 0
-      // memcpy-based: works fast even in debug.
-      std::copy(srcdata.data()+src_o, srcdata.data()+src_o+scanline,
-                dest.data()+tgt_offset);
-#else
-      // iterators: gives nice error messages in debug.
-      std::copy(srcdata+src_o, srcdata+src_o+scanline,
-                dest.begin()+tgt_offset);
-#endif
-      src_offset[1]++; // should follow 'y' increment.
-    }
-    src_offset[1] = orig_offset[1];
-    src_offset[2]++; // .. and increment z
-  }
-  return true;
-}
-
 // early, non-type-specific parts of GetBrick.
 // Note that because of how we do the re-bricking, we know that all the target
 // bricks will fit nicely inside a (single) source brick.  This is important,
@@ -563,60 +611,253 @@ DynamicBrickingDS::dbinfo::BrickSetup(const BrickKey& k,
   return rv;
 }
 
-// Looks for the brick in the cache; if so, uses it.  Otherwise, grab the brick
+// Looks for the source brick in the cache; if it's not there, reads it.
+// Either way, the view ends up pointing at the target brick within it.
 template<typename T>
-bool DynamicBrickingDS::dbinfo::Brick(const DynamicBrickingDS& ds,
-                                      const BrickKey& key,
-                                      std::vector<T>& data) {
+bool DynamicBrickingDS::dbinfo::View(const DynamicBrickingDS& ds,
+                                     const BrickKey& key,
+                                     BrickView<T>& view) {
   StackTimer gbrick(PERF_DY_GET_BRICK);
   GBPrelim pre = this->BrickSetup(key, ds);
+  const size_t components = this->ds->GetComponentCount();
 
-  const void* lookup;
+  std::shared_ptr<const void> src;
   {
-    tuvok::Controller::Instance().IncrementPerfCounter(PERF_DY_CACHE_LOOKUPS, 1.0);
-    StackTimer cc(PERF_DY_CACHE_LOOKUP);
-    lookup = this->cache.lookup(pre.skey, T(42));
-  }
-  // first: check the cache and see if we can get the data easy.
-  if(NULL != lookup) {
-    MESSAGE("found <%u,%u,%u> in the cache!",
-            static_cast<unsigned>(std::get<0>(pre.skey)),
-            static_cast<unsigned>(std::get<1>(pre.skey)),
-            static_cast<unsigned>(std::get<2>(pre.skey)));
-    tuvok::Controller::Instance().IncrementPerfCounter(PERF_DY_BRICK_COPIED, 1.0);
-    StackTimer copies(PERF_DY_BRICK_COPY);
-    const T* srcdata = static_cast<const T*>(lookup);
-    const size_t components = this->ds->GetComponentCount();
-    return this->CopyBrick<T>(data, srcdata, components, pre.tgt_bs, pre.src_bs,
-                              pre.src_offset);
+    SCOPEDLOCK(this->guard);
+    this->PrefetchAs<T>();
+    for(;;) {
+      {
+        tuvok::Controller::Instance().IncrementPerfCounter(PERF_DY_CACHE_LOOKUPS, 1.0);
+        StackTimer cc(PERF_DY_CACHE_LOOKUP);
+        src = this->cache.share(pre.skey, T(42));
+      }
+      // first: check the cache and see if we can get the data easy.
+      if(src) {
+        MESSAGE("found <%u,%u,%u> in the cache!",
+                static_cast<unsigned>(std::get<0>(pre.skey)),
+                static_cast<unsigned>(std::get<1>(pre.skey)),
+                static_cast<unsigned>(std::get<2>(pre.skey)));
+        break;
+      }
+      // somebody is reading it right now; no sense in doing it twice.
+      auto busy = this->inflight.find(pre.skey);
+      if(busy == this->inflight.end()) { break; }
+      // keep the condition alive; the reader drops it from 'inflight'.
+      const std::shared_ptr<WaitCondition> landed = busy->second;
+      landed->Wait(this->guard);
+    }
+    if(!src) {
+      // we'll read it ourselves; the prefetcher need not bother anymore, and
+      // anybody else who wants it waits for us.
+      this->queued.erase(pre.skey);
+      this->TakeOff(pre.skey);
+    }
   }
   // nope?  oh well.  read it.
-  std::vector<T> srcdata;
+  if(!src && !(src = this->Read<T>(pre.skey))) { return false; }
+
+  // Unless this (target) brick sits at the bottom corner of the source brick,
+  // it starts at an offset.
+  const VoxelIndex& o = pre.src_offset;
+  const uint64_t offset = ((o[2]*pre.src_bs[1] + o[1])*pre.src_bs[0] + o[0]) *
+                          components;
+  view.data = std::shared_ptr<const T>(
+    src, static_cast<const T*>(src.get()) + offset
+  );
+  view.size = pre.tgt_bs;
+  view.rowLength = pre.src_bs[0];
+  view.imageHeight = pre.src_bs[1];
+  view.components = components;
+  return true;
+}
+
+void DynamicBrickingDS::dbinfo::TakeOff(const BrickKey& skey) {
+  this->inflight[skey] = std::make_shared<WaitCondition>();
+}
+
+template<typename T> std::shared_ptr<const void>
+DynamicBrickingDS::dbinfo::Read(const BrickKey& skey) {
+  // declared first, so that it is done last: after the brick is cached.
+  const Landing landing(*this, skey);
+  std::shared_ptr<std::vector<T>> srcdata(new std::vector<T>());
   {
     StackTimer loadBrick(PERF_DY_RESERVE_BRICK);
-    srcdata.resize(this->ds->GetBrickVoxelCounts(pre.skey).volume());
+    srcdata->resize(this->ds->GetBrickVoxelCounts(skey).volume());
   }
+  bool read;
   {
     StackTimer loadBrick(PERF_DY_LOAD_BRICK);
-    if(!this->ds->GetBrick(pre.skey, srcdata)) { return false; }
+    read = this->ds->GetBrick(skey, *srcdata);
   }
+  if(!read) { return std::shared_ptr<const void>(); }
 
-  // add it to the cache.
-  const T* sdata = static_cast<const T*>(srcdata.data());
-  if(this->cacheBytes > 0) {
-    tuvok::Controller::Instance().IncrementPerfCounter(PERF_DY_CACHE_ADDS, 1.0);
-    StackTimer cc(PERF_DY_CACHE_ADD);
-    // is the cache full?  find room.
-    while(!this->FitsInCache(srcdata.size() * sizeof(T))) {
-      this->cache.remove();
-    }
-    sdata = static_cast<const T*>(this->cache.add(pre.skey, srcdata));
+  SCOPEDLOCK(this->guard);
+  if(this->cache.capacity() == 0) {
+    return std::shared_ptr<const void>(srcdata, srcdata->data());
   }
-  const size_t components = this->ds->GetComponentCount();
+  // 'inflight' keeps other readers away, so the brick should not be cached
+  // yet; but adding a key twice would wreck the cache's bookkeeping, so make
+  // sure.
+  std::shared_ptr<const void> cached = this->cache.share(skey, T(42));
+  if(cached) { return cached; }
+  // add it to the cache.
+  tuvok::Controller::Instance().IncrementPerfCounter(PERF_DY_CACHE_ADDS, 1.0);
+  StackTimer cc(PERF_DY_CACHE_ADD);
+  // is the cache full?  find room.
+  this->cache.reserve(srcdata->size() * sizeof(T));
+  this->cache.add(skey, *srcdata);
+  return this->cache.share(skey, T(42));
+}
+
+// GetBrick is just a view plus a (dense) copy of it.
+template<typename T>
+bool DynamicBrickingDS::dbinfo::Brick(const DynamicBrickingDS& ds,
+                                      const BrickKey& key,
+                                      std::vector<T>& data) {
+  BrickView<T> view;
+  if(!this->View<T>(ds, key, view)) { return false; }
   tuvok::Controller::Instance().IncrementPerfCounter(PERF_DY_BRICK_COPIED, 1.0);
   StackTimer copies(PERF_DY_BRICK_COPY);
-  return this->CopyBrick<T>(data, sdata, components, pre.tgt_bs, pre.src_bs,
-                            pre.src_offset);
+  view.copy(data);
+  return true;
+}
+
+DynamicBrickingDS::dbinfo::~dbinfo() {
+  {
+    SCOPEDLOCK(this->guard);
+    for(auto l=this->loaders.begin(); l != this->loaders.end(); ++l) {
+      (*l)->RequestThreadStop();
+    }
+    this->work.WakeAll();
+  }
+  for(auto l=this->loaders.begin(); l != this->loaders.end(); ++l) {
+    (*l)->JoinThread();
+  }
+}
+
+void DynamicBrickingDS::dbinfo::Prefetch(const std::vector<BrickKey>& keys) {
+  // many target bricks come from the same source brick.
+  std::vector<BrickKey> skeys;
+  skeys.reserve(keys.size());
+  for(auto k=keys.cbegin(); k != keys.cend(); ++k) {
+    skeys.push_back(this->SourceBrickKey(*k));
+  }
+
+  SCOPEDLOCK(this->guard);
+  // without a cache there is nowhere to put prefetched bricks.
+  if(this->cache.capacity() == 0) { return; }
+  if(!this->prefetch) { this->PrefetchNative(); }
+  if(!this->prefetch) { return; }
+
+  for(auto sk=skeys.cbegin(); sk != skeys.cend(); ++sk) {
+    if(this->queued.find(*sk) != this->queued.end() ||
+       this->inflight.count(*sk) != 0) {
+      continue;
+    }
+    this->queued.insert(*sk);
+    this->queue.push_back(*sk);
+  }
+  // a few loaders keep the disk and the decompressors busy; more would just
+  // fight the renderer for them.
+  const size_t nLoaders = std::min<size_t>(
+    4, std::max(1u, std::thread::hardware_concurrency())
+  );
+  while(this->loaders.size() < std::min(nLoaders, this->queue.size())) {
+    this->loaders.push_back(std::unique_ptr<LambdaThread>(new LambdaThread(
+      [this](const bool& bContinue, LambdaThread::Interface&) {
+        this->LoadQueued(bContinue);
+      }
+    )));
+    this->loaders.back()->StartThread();
+  }
+  this->work.WakeAll();
+}
+
+// 'bContinue' is only ever touched with the guard held.
+void DynamicBrickingDS::dbinfo::LoadQueued(const bool& bContinue) {
+  for(;;) {
+    BrickKey skey;
+    std::function<void (const BrickKey&)> load;
+    {
+      SCOPEDLOCK(this->guard);
+      while(bContinue && this->queue.empty()) { this->work.Wait(this->guard); }
+      if(!bContinue) { return; }
+      skey = this->queue.front();
+      this->queue.pop_front();
+      // GetBrick might have read it in the meantime.
+      if(this->queued.erase(skey) == 0) { continue; }
+      this->TakeOff(skey);
+      load = this->prefetch;
+    }
+    const Landing landing(*this, skey);
+    try {
+      load(skey);
+    } catch(const std::exception& e) {
+      // a prefetch is only a hint; GetBrick will try again (and complain).
+      WARNING("prefetch of brick <%u,%u,%u> failed: %s",
+              static_cast<unsigned>(std::get<0>(skey)),
+              static_cast<unsigned>(std::get<1>(skey)),
+              static_cast<unsigned>(std::get<2>(skey)), e.what());
+    }
+  }
+}
+
+template<typename T>
+void DynamicBrickingDS::dbinfo::Load(const BrickKey& skey) {
+  {
+    SCOPEDLOCK(this->guard);
+    if(NULL != this->cache.lookup(skey, T(42))) { return; }
+  }
+  std::vector<T> srcdata(this->ds->GetBrickVoxelCounts(skey).volume());
+  if(!this->ds->GetBrick(skey, srcdata)) {
+    WARNING("prefetch of brick <%u,%u,%u> failed",
+            static_cast<unsigned>(std::get<0>(skey)),
+            static_cast<unsigned>(std::get<1>(skey)),
+            static_cast<unsigned>(std::get<2>(skey)));
+    return;
+  }
+  SCOPEDLOCK(this->guard);
+  if(this->cache.capacity() > 0 && NULL == this->cache.lookup(skey, T(42))) {
+    this->cache.reserve(srcdata.size() * sizeof(T));
+    this->cache.add(skey, srcdata);
+  }
+}
+
+template<typename T> void DynamicBrickingDS::dbinfo::PrefetchAs() {
+  if(this->prefetchType != NULL && *this->prefetchType == typeid(T)) {
+    return;
+  }
+  this->prefetchType = &typeid(T);
+  this->prefetch = [this](const BrickKey& skey) { this->Load<T>(skey); };
+}
+
+void DynamicBrickingDS::dbinfo::PrefetchNative() {
+  const bool sign = this->ds->GetIsSigned();
+  switch(this->ds->GetBitWidth()) {
+    case 8:
+      if(sign) { this->PrefetchAs<int8_t>(); }
+      else     { this->PrefetchAs<uint8_t>(); }
+      break;
+    case 16:
+      if(sign) { this->PrefetchAs<int16_t>(); }
+      else     { this->PrefetchAs<uint16_t>(); }
+      break;
+    case 32:
+      if(this->ds->GetIsFloat()) { this->PrefetchAs<float>(); }
+      else if(sign)              { this->PrefetchAs<int32_t>(); }
+      else                       { this->PrefetchAs<uint32_t>(); }
+      break;
+    default:
+      WARNING("no prefetching for %u-bit data.", this->ds->GetBitWidth());
+      break;
+  }
+}
+
+void DynamicBrickingDS::dbinfo::ClearCache() {
+  SCOPEDLOCK(this->guard);
+  this->cache.clear();
+  this->queue.clear();
+  this->queued.clear();
 }
 
 /// we can cache the precomputed brick min/maxes in a file, and then
@@ -638,114 +879,209 @@ static std::string precomputed_filename(const BrickedDataset& ds,
   return "";
 }
 
-void DynamicBrickingDS::dbinfo::LoadMinMax(std::istream& is) {
-  if(!is) { T_ERROR("could not open min/max cache!"); return; }
-
-  uint64_t n_elems;
-  is.read(reinterpret_cast<char*>(&n_elems), sizeof(uint64_t));
-
-  for(uint64_t i=0; i < n_elems; ++i) {
-    uint64_t timestep, lod, brick;
-    is.read(reinterpret_cast<char*>(&timestep), sizeof(uint64_t));
-    is.read(reinterpret_cast<char*>(&lod), sizeof(uint64_t));
-    is.read(reinterpret_cast<char*>(&brick), sizeof(uint64_t));
-    const BrickKey key(timestep, lod, brick);
-    MinMaxBlock mm;
-    is.read(reinterpret_cast<char*>(&mm.minScalar), sizeof(double));
-    is.read(reinterpret_cast<char*>(&mm.maxScalar), sizeof(double));
-    if(!is) {
-      T_ERROR("read failed?  cache is broken.  ignoring it.");
-      this->minmax.clear();
-      return;
-    }
-    this->minmax.insert(std::make_pair(key, mm));
+/// identifies the file the data come from, so we notice when a sidecar file
+/// is stale.
+/// @returns false if the data are not file-backed or we cannot stat them.
+static bool source_identity(const BrickedDataset& ds, uint64_t& size,
+                            int64_t& mtime) {
+  const FileBackedDataset* fbds =
+    dynamic_cast<const FileBackedDataset*>(&ds);
+  if(fbds == NULL) { return false; }
+  LARGE_STAT_BUFFER st;
+  try {
+    // a DynamicBrickingDS is file-backed only if its source is.
+    if(!SysTools::GetFileStats(fbds->Filename(), st)) { return false; }
+  } catch(const std::bad_cast&) {
+    return false;
+  }
+  size = static_cast<uint64_t>(st.st_size);
+  mtime = static_cast<int64_t>(st.st_mtime);
+  return true;
+}
+
+static uint32_t checksum(const MinMaxRecord* recs, uint64_t n) {
+  CRC32 crc;
+  return static_cast<uint32_t>(
+    crc.get(reinterpret_cast<const unsigned char*>(recs),
+            static_cast<size_t>(n * sizeof(MinMaxRecord)))
+  );
+}
+
+bool DynamicBrickingDS::dbinfo::LoadMinMax(const std::string& fname,
+                                           const BrickedDataset& ds) {
+  uint64_t size; int64_t mtime;
+  if(!source_identity(ds, size, mtime)) { return false; }
+
+  std::unique_ptr<MemMappedFile> mmf(new MemMappedFile(fname));
+  if(!mmf->IsOpen()) {
+    WARNING("min/max cache %s is unreadable; ignoring it.", fname.c_str());
+    return false;
+  }
+  const MinMaxHeader* hdr =
+    static_cast<const MinMaxHeader*>(mmf->GetDataPointer());
+  if(mmf->GetFileLength() < sizeof(MinMaxHeader) ||
+     memcmp(hdr->magic, mmMagic, sizeof(mmMagic)) != 0 ||
+     hdr->version != mmVersion) {
+    WARNING("%s is not a (current) min/max cache; ignoring it.",
+            fname.c_str());
+    return false;
+  }
+  if(hdr->srcSize != size || hdr->srcMTime != mtime) {
+    MESSAGE("Data changed since the min/maxes were computed.");
+    return false;
+  }
+  if(hdr->brickSize[0] != this->brickSize[0] ||
+     hdr->brickSize[1] != this->brickSize[1] ||
+     hdr->brickSize[2] != this->brickSize[2] ||
+     hdr->records != ds.GetTotalBrickCount() ||
+     mmf->GetFileLength() !=
+       sizeof(MinMaxHeader) + hdr->records*sizeof(MinMaxRecord)) {
+    WARNING("min/max cache %s does not fit this data; ignoring it.",
+            fname.c_str());
+    return false;
   }
+  const MinMaxRecord* recs = reinterpret_cast<const MinMaxRecord*>(hdr+1);
+  if(checksum(recs, hdr->records) != hdr->checksum) {
+    WARNING("min/max cache %s is corrupt; ignoring it.", fname.c_str());
+    return false;
+  }
+
+  this->mmLocal.clear();
+  this->mmRecords = recs;
+  this->mmCount = hdr->records;
+  this->mmFile = std::move(mmf);
+  return true;
 }
 
-void DynamicBrickingDS::dbinfo::SaveMinMax(std::ostream& os) const {
-  if(!os) { T_ERROR("could not create min/max cache."); return; }
-
-  const uint64_t n_elems = this->minmax.size();
-  MESSAGE("Saving %llu brick min/maxes", n_elems);
-  os.write(reinterpret_cast<const char*>(&n_elems), sizeof(uint64_t));
-
-  for(auto b=this->minmax.cbegin(); b != this->minmax.cend(); ++b) {
-    uint64_t timestep, lod, brick;
-    timestep = std::get<0>(b->first);
-    lod = std::get<1>(b->first);
-    brick = std::get<2>(b->first);
-    os.write(reinterpret_cast<const char*>(&timestep), sizeof(uint64_t));
-    os.write(reinterpret_cast<const char*>(&lod), sizeof(uint64_t));
-    os.write(reinterpret_cast<const char*>(&brick), sizeof(uint64_t));
-    MinMaxBlock mm = b->second;
-    os.write(reinterpret_cast<const char*>(&mm.minScalar), sizeof(double));
-    os.write(reinterpret_cast<const char*>(&mm.maxScalar), sizeof(double));
+void DynamicBrickingDS::dbinfo::SaveMinMax(const std::string& fname,
+                                           const BrickedDataset& ds) const {
+  MinMaxHeader hdr;
+  memcpy(hdr.magic, mmMagic, sizeof(mmMagic));
+  hdr.version = mmVersion;
+  if(!source_identity(ds, hdr.srcSize, hdr.srcMTime)) {
+    WARNING("Can't identify the source file; not saving minmaxes.");
+    return;
+  }
+  for(size_t i=0; i < 3; ++i) { hdr.brickSize[i] = this->brickSize[i]; }
+  hdr.records = this->mmLocal.size();
+  hdr.checksum = checksum(this->mmLocal.data(), hdr.records);
+
+  MESSAGE("Saving %llu brick min/maxes", hdr.records);
+  // write to the side and then move it into place, so that nobody ever maps
+  // a half-written file.
+  const std::string tmpname = fname + ".tmp";
+  {
+    std::ofstream os(tmpname.c_str(), std::ios::binary);
+    if(!os) {
+      WARNING("could not open min/max cache file (%s); ignoring cache.",
+              tmpname.c_str());
+      return;
+    }
+    os.write(reinterpret_cast<const char*>(&hdr), sizeof(MinMaxHeader));
+    os.write(reinterpret_cast<const char*>(this->mmLocal.data()),
+             this->mmLocal.size() * sizeof(MinMaxRecord));
+    if(!os) {
+      WARNING("writing min/max cache %s failed.", tmpname.c_str());
+      os.close();
+      std::remove(tmpname.c_str());
+      return;
+    }
+  }
+  if(std::rename(tmpname.c_str(), fname.c_str()) != 0) {
+    // some platforms won't rename over an existing file.
+    std::remove(fname.c_str());
+    if(std::rename(tmpname.c_str(), fname.c_str()) != 0) {
+      WARNING("could not move min/max cache into place (%s).", fname.c_str());
+      std::remove(tmpname.c_str());
+    }
   }
 }
 
 /// run through all of the bricks and compute min/max info.
 void DynamicBrickingDS::dbinfo::ComputeMinMaxes(BrickedDataset& ds) {
+  this->mmFile.reset();
+  this->mmRecords = NULL;
+  this->mmCount = 0;
+
   // first, check if we have this cached.
   const std::string fname = precomputed_filename(ds, this->brickSize);
-  if(SysTools::FileExists(fname)) {
-    MESSAGE("Brick min/maxes are precomputed.  Reloading from file...");
-    std::ifstream mmfile(fname, std::ios::binary);
-    this->LoadMinMax(mmfile);
-    mmfile.close();
-    return;
+  if(!fname.empty() && SysTools::FileExists(fname)) {
+    if(this->LoadMinMax(fname, ds)) {
+      MESSAGE("Brick min/maxes are precomputed; using %s", fname.c_str());
+      return;
+    }
+  }
+
+  std::vector<BrickKey> keys;
+  keys.reserve(ds.GetTotalBrickCount());
+  for(auto b=ds.BricksBegin(); b != ds.BricksEnd(); ++b) {
+    keys.push_back(b->first);
   }
+  std::sort(keys.begin(), keys.end());
 
   {
     StackTimer precompute(PERF_MM_PRECOMPUTE);
-    unsigned i=0;
-    const unsigned len = static_cast<unsigned>(
-      std::distance(ds.BricksBegin(), ds.BricksEnd())
-    );
-    for(auto b=ds.BricksBegin(); b != ds.BricksEnd(); ++b, ++i) {
-      MESSAGE("precomputing brick %u of %u", i, len);
-      MinMaxBlock mm = minmax_brick(b->first, ds);
-      this->minmax.insert(std::make_pair(b->first, mm));
-
-      // we do want to cache to save decompression time
-      while (this->cache.size() > this->cacheBytes) { this->cache.remove(); }
-
-      // minmax_brick added something to our cache; we don't want to cache
-      // here, though, only when the brick is /actually/ used.
-      //this->cache.clear();
+    MESSAGE("precomputing min/max for %u bricks",
+            static_cast<unsigned>(keys.size()));
+    // GetBrick is safe to call concurrently: a source brick being read is
+    // marked in flight, so threads which need the same one wait for it
+    // rather than reading and caching it twice.
+    this->mmLocal.resize(keys.size());
+    const int64_t n = static_cast<int64_t>(keys.size());
+#pragma omp parallel
+    {
+      MinMaxScratch scratch;
+#pragma omp for schedule(dynamic)
+      for(int64_t i=0; i < n; ++i) {
+        const BrickKey& key = keys[static_cast<size_t>(i)];
+        const MinMaxBlock mm = minmax_brick(key, ds, scratch);
+        MinMaxRecord& rec = this->mmLocal[static_cast<size_t>(i)];
+        rec.ts = std::get<0>(key);
+        rec.lod = std::get<1>(key);
+        rec.brick = std::get<2>(key);
+        rec.minScalar = mm.minScalar;
+        rec.maxScalar = mm.maxScalar;
+        rec.minGradient = mm.minGradient;
+        rec.maxGradient = mm.maxGradient;
+      }
     }
   }
-  // remove all cached bricks
-  while(this->cache.size() > 0) { this->cache.remove(); }
+  this->mmRecords = this->mmLocal.data();
+  this->mmCount = this->mmLocal.size();
+  // minmax_brick filled our cache; we only want bricks in there which are
+  // /actually/ used.
+  this->ClearCache();
 
   // try to cache that data to a file, now.
-  std::ofstream mmcache(fname, std::ios::binary);
-  if(!mmcache) {
-    WARNING("could not open min/max cache file (%s); ignoring cache.",
-            fname.c_str());
-    return;
+  if(!fname.empty()) { this->SaveMinMax(fname, ds); }
+}
+
+const MinMaxRecord*
+DynamicBrickingDS::dbinfo::FindMinMax(const BrickKey& key) const {
+  const MinMaxRecord* end = this->mmRecords + this->mmCount;
+  const MinMaxRecord* rec = std::lower_bound(this->mmRecords, end, key,
+    [](const MinMaxRecord& r, const BrickKey& k) {
+      return BrickKey(r.ts, r.lod, r.brick) < k;
+    }
+  );
+  if(rec == end || BrickKey(rec->ts, rec->lod, rec->brick) != key) {
+    return NULL;
   }
-  this->SaveMinMax(mmcache);
-  mmcache.close();
+  return rec;
 }
 
 void DynamicBrickingDS::dbinfo::SetCacheSize(size_t bytes) {
-  this->cacheBytes = bytes;
-  // shrink the cache to fit.
-  while(this->cache.size() > this->cacheBytes) { this->cache.remove(); }
+  SCOPEDLOCK(this->guard);
+  // shrinks the cache to fit, if needed.
+  this->cache.capacity(bytes);
 }
 
 size_t DynamicBrickingDS::dbinfo::GetCacheSize() const {
-  return this->cacheBytes;
+  return this->cache.capacity();
 }
 
-/// @returns true if 'bytes' bytes will fit into the current cache
-bool DynamicBrickingDS::dbinfo::FitsInCache(size_t bytes) const {
-  // if cache is enabled and nothing is cached we allow to store any given brick
-  // to avoid an endless loop if the total cache size is smaller than the loaded
-  // brick
-  if (cache.size() == 0)
-    return true;
-  return (bytes + cache.size()) < this->cacheBytes;
+void DynamicBrickingDS::Prefetch(const std::vector<BrickKey>& keys) const {
+  this->di->Prefetch(keys);
 }
 
 bool DynamicBrickingDS::GetBrick(const BrickKey& k, std::vector<uint8_t>& data) const
@@ -790,6 +1126,47 @@ bool DynamicBrickingDS::GetBrick(const BrickKey&,
   return false;
 }
 
+bool DynamicBrickingDS::GetBrickView(const BrickKey& k,
+                                     BrickView<uint8_t>& view) const
+{
+  return this->di->View<uint8_t>(*this, k, view);
+}
+bool DynamicBrickingDS::GetBrickView(const BrickKey& k,
+                                     BrickView<int8_t>& view) const
+{
+  return this->di->View<int8_t>(*this, k, view);
+}
+bool DynamicBrickingDS::GetBrickView(const BrickKey& k,
+                                     BrickView<uint16_t>& view) const
+{
+  return this->di->View<uint16_t>(*this, k, view);
+}
+bool DynamicBrickingDS::GetBrickView(const BrickKey& k,
+                                     BrickView<int16_t>& view) const
+{
+  return this->di->View<int16_t>(*this, k, view);
+}
+bool DynamicBrickingDS::GetBrickView(const BrickKey& k,
+                                     BrickView<uint32_t>& view) const
+{
+  return this->di->View<uint32_t>(*this, k, view);
+}
+bool DynamicBrickingDS::GetBrickView(const BrickKey& k,
+                                     BrickView<int32_t>& view) const
+{
+  return this->di->View<int32_t>(*this, k, view);
+}
+bool DynamicBrickingDS::GetBrickView(const BrickKey& k,
+                                     BrickView<float>& view) const
+{
+  return this->di->View<float>(*this, k, view);
+}
+bool DynamicBrickingDS::GetBrickView(const BrickKey&,
+                                     BrickView<double>&) const
+{
+  return false; // no double support, as with GetBrick.
+}
+
 void DynamicBrickingDS::SetRescaleFactors(const DOUBLEVECTOR3& scale) {
   this->di->ds->SetRescaleFactors(scale);
 }
@@ -835,18 +1212,26 @@ std::pair<double,double> DynamicBrickingDS::GetRange() const {
 }
 
 /// Acceleration queries.
-/// Right now, they just forward to the larger data set.  We might consider
-/// recomputing this metadata, to get better performance at the expense of
-/// memory.
+/// With precomputed min/maxes, they use this data set's own bricks' ranges,
+/// which are tighter than the source's and know the gradients.  Otherwise
+/// they forward to the larger data set; computing the min/max dynamically
+/// would mean reading the brick we are trying to skip.
 ///@{
 bool DynamicBrickingDS::ContainsData(const BrickKey& bk, double isoval) const {
   assert(this->bricks.find(bk) != this->bricks.end());
+  if(this->di->mmMode == MM_PRECOMPUTE) {
+    return isoval <= this->MaxMinForKey(bk).maxScalar;
+  }
   BrickKey skey = this->di->SourceBrickKey(bk);
   return di->ds->ContainsData(skey, isoval);
 }
 bool DynamicBrickingDS::ContainsData(const BrickKey& bk, double fmin,
                                      double fmax) const {
   assert(this->bricks.find(bk) != this->bricks.end());
+  if(this->di->mmMode == MM_PRECOMPUTE) {
+    const MinMaxBlock mm = this->MaxMinForKey(bk);
+    return fmax >= mm.minScalar && fmin <= mm.maxScalar;
+  }
   BrickKey skey = this->di->SourceBrickKey(bk);
   return di->ds->ContainsData(skey, fmin, fmax);
 }
@@ -855,9 +1240,24 @@ bool DynamicBrickingDS::ContainsData(const BrickKey& bk,
                                      double fminGradient,
                                      double fmaxGradient) const {
   assert(this->bricks.find(bk) != this->bricks.end());
+  if(this->di->mmMode == MM_PRECOMPUTE) {
+    const MinMaxBlock mm = this->MaxMinForKey(bk);
+    return fmax >= mm.minScalar && fmin <= mm.maxScalar &&
+           fmaxGradient >= mm.minGradient && fminGradient <= mm.maxGradient;
+  }
   BrickKey skey = this->di->SourceBrickKey(bk);
   return di->ds->ContainsData(skey, fmin,fmax, fminGradient, fmaxGradient);
 }
+bool DynamicBrickingDS::ContainsData(const BrickKey& bk,
+                                     const ValueRanges& ranges) const {
+  assert(this->bricks.find(bk) != this->bricks.end());
+  if(this->di->mmMode == MM_PRECOMPUTE && !ranges.empty() &&
+     !this->ContainsData(bk, ranges.front().first, ranges.back().second)) {
+    return false;
+  }
+  BrickKey skey = this->di->SourceBrickKey(bk);
+  return di->ds->ContainsData(skey, ranges);
+}
 
 MinMaxBlock DynamicBrickingDS::MaxMinForKey(const BrickKey& bk) const {
   switch(this->di->mmMode) {
@@ -867,12 +1267,25 @@ MinMaxBlock DynamicBrickingDS::MaxMinForKey(const BrickKey& bk) const {
     } break;
     case MM_DYNAMIC: return minmax_brick(bk, *this); break;
     case MM_PRECOMPUTE: {
-      assert(this->di->minmax.find(bk) != this->di->minmax.end());
-      return this->di->minmax.find(bk)->second;
+      const MinMaxRecord* rec = this->di->FindMinMax(bk);
+      assert(rec != NULL);
+      if(rec == NULL) { return MinMaxBlock(); }
+      return MinMaxBlock(rec->minScalar, rec->maxScalar,
+                         rec->minGradient, rec->maxGradient);
     } break;
   }
   return MinMaxBlock();
 }
+
+ValueOccupancy DynamicBrickingDS::OccupancyForKey(const BrickKey& bk) const {
+  // The source's bins are relative to the source brick's range, so they are
+  // only of use when that is the range we report, too.
+  if(this->di->mmMode == MM_SOURCE) {
+    BrickKey skey = this->di->SourceBrickKey(bk);
+    return di->ds->OccupancyForKey(skey);
+  }
+  return BrickedDataset::OccupancyForKey(bk);
+}
 ///@}
 
 bool DynamicBrickingDS::Export(uint64_t lod, const std::string& to,
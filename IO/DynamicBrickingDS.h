@@ -18,7 +18,8 @@ public:
   /// MM_SOURCE: use the min/max from the source dataset.  this is likely to
   /// have a greater range the actual data, but might still be okay.
   /// MM_PRECOMPUTE: precompute all the new bricks' min/max info when this
-  /// object is created.  Induces huge delays.
+  /// object is created.  Induces huge delays the first time; the results are
+  /// saved to a sidecar file, which later instances just map.
   /// MM_DYNAMIC: compute the exact min/max dynamically when the brick is
   /// requested.
   enum MinMaxMode { MM_SOURCE=0, MM_PRECOMPUTE, MM_DYNAMIC };
@@ -55,6 +56,24 @@ public:
   virtual bool GetBrick(const BrickKey&, std::vector<float>&) const;
   virtual bool GetBrick(const BrickKey&, std::vector<double>&) const;
   ///@}
+  /// Views point straight into the cached source brick.  Holding on to a
+  /// view keeps that source brick in memory, even after eviction.
+  ///@{
+  virtual bool GetBrickView(const BrickKey&, BrickView<uint8_t>&) const;
+  virtual bool GetBrickView(const BrickKey&, BrickView<int8_t>&) const;
+  virtual bool GetBrickView(const BrickKey&, BrickView<uint16_t>&) const;
+  virtual bool GetBrickView(const BrickKey&, BrickView<int16_t>&) const;
+  virtual bool GetBrickView(const BrickKey&, BrickView<uint32_t>&) const;
+  virtual bool GetBrickView(const BrickKey&, BrickView<int32_t>&) const;
+  virtual bool GetBrickView(const BrickKey&, BrickView<float>&) const;
+  virtual bool GetBrickView(const BrickKey&, BrickView<double>&) const;
+  ///@}
+
+  /// Starts reading the source data for the given bricks on a background
+  /// thread, so that a later GetBrick finds it in the cache.  GetBrick only
+  /// waits for a prefetch if it needs a brick which is being read right now.
+  /// Bricks are read with the type GetBrick was last called with.
+  void Prefetch(const std::vector<BrickKey>&) const;
 
   /// User rescaling factors.
   ///@{
@@ -91,7 +110,9 @@ public:
   virtual bool ContainsData(const BrickKey&, double /*fMin*/, double /*fMax*/,
                             double /*fMinGradient*/,
                             double /*fMaxGradient*/) const;
+  virtual bool ContainsData(const BrickKey&, const ValueRanges&) const;
   virtual tuvok::MinMaxBlock MaxMinForKey(const BrickKey& k) const;
+  virtual tuvok::ValueOccupancy OccupancyForKey(const BrickKey& k) const;
 
   /// unimplemented!  Override these if you want tools built on this IO layer
   /// to be able to create data in your format.
@@ -44,6 +44,9 @@
 #include <sstream>
 #include <map>
 #include <memory>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 #include "3rdParty/jpeglib/jconfig.h"
 
 #include "IOManager.h"
@@ -56,12 +59,15 @@
 #include "DynamicBrickingDS.h"
 #include "exception/UnmergeableDatasets.h"
 #include "expressions/parser.h"
+#include "expressions/program.h"
 #include "expressions/syntax.h"
 #include "expressions/treenode.h"
 #include "IO/DICOM/DICOMParser.h"
 #include "IO/Images/ImageParser.h"
 #include "IO/Images/StackExporter.h"
+#include "IsosurfaceExtractor.h"
 #include "Quantize.h"
+#include "SlicePipeline.h"
 #include "TuvokJPEG.h"
 #include "TransferFunction1D.h"
 #include "TuvokSizes.h"
@@ -214,6 +220,7 @@ IOManager::ScanDirectory(string strDirectory) const {
   vector<std::shared_ptr<FileStackInfo>> fileStacks;
 
   DICOMParser parseDICOM;
+  parseDICOM.SetScanIndex(DICOMParser::ScanIndexFor(strDirectory));
   parseDICOM.GetDirInfo(strDirectory);
 
   // Sort out DICOMs with embedded images that we can't read.
@@ -335,140 +342,86 @@ bool IOManager::ConvertDataset(FileStackInfo* pStack,
       return false;
     }
 
-    vector<char> vData;
-    for (size_t j=0; j < pDICOMStack->m_Elements.size(); j++) {
+    const bool bJPEG = pDICOMStack->m_bIsJPEGEncoded;
+    if (bJPEG) pDICOMStack->m_iAllocated = BITS_IN_JSAMPLE;
+    const bool bSwap = pDICOMStack->m_bIsBigEndian != EndianConvert::IsBigEndian();
+    if (bSwap) MESSAGE("Converting Endianess ...");
 
-      SimpleDICOMFileInfo* pDICOMFileInfo = dynamic_cast<SimpleDICOMFileInfo*>(pDICOMStack->m_Elements[j]);
+    // Create temporary file with the DICOM (image) data.  We pretend 3
+    // component data is 4 component data to simplify processing later.
+    /// @todo FIXME: this code assumes 3 component data is always 3*char
+    const bool bRGB = pDICOMStack->m_iComponentCount == 3;
 
+    bool bWindowing = false;
+    for (size_t j=0; j < pDICOMStack->m_Elements.size(); j++) {
+      SimpleDICOMFileInfo* pDICOMFileInfo = dynamic_cast<SimpleDICOMFileInfo*>(pDICOMStack->m_Elements[j]);
       if (!pDICOMFileInfo) continue;
 
-      uint32_t iDataSize = pDICOMStack->m_Elements[j]->GetDataSize();
-      vData.resize(iDataSize);
-
-      if (pDICOMStack->m_bIsJPEGEncoded) {
-        MESSAGE("JPEG is %d bytes, offset %d", iDataSize,
-                pDICOMFileInfo->GetOffsetToData());
-        tuvok::JPEG jpg(pDICOMStack->m_Elements[j]->m_strFileName,
-                        pDICOMFileInfo->GetOffsetToData());
-        if(!jpg.valid()) {
-          T_ERROR("'%s' reports an embedded JPEG, but the JPEG is invalid.",
-                  pDICOMStack->m_Elements[j]->m_strFileName.c_str());
-          return false;
-        }
-        MESSAGE("jpg is: %u bytes (%ux%u, %u components)", uint32_t(jpg.size()),
-                uint32_t(jpg.width()), uint32_t(jpg.height()),
-                uint32_t(jpg.components()));
-
-        const char *jpeg_data = jpg.data();
-        copy(jpeg_data, jpeg_data + jpg.size(), &vData[0]);
-        pDICOMStack->m_iAllocated = BITS_IN_JSAMPLE;
-      } else {
-        pDICOMStack->m_Elements[j]->GetData(vData);
-        MESSAGE("Creating intermediate file %s\n%u%%",
-                strTempMergeFilename.c_str(),
-                static_cast<unsigned>((100*j)/pDICOMStack->m_Elements.size()));
-      }
-
-      if (pDICOMStack->m_bIsBigEndian != EndianConvert::IsBigEndian()) {
-        MESSAGE("Converting Endianess ...");
-        switch (pDICOMStack->m_iAllocated) {
-          case  8 : break;
-          case 16 : {
-                short *pData = reinterpret_cast<short*>(&vData[0]);
-                for (uint32_t k = 0;k<iDataSize/2;k++)
-                  pData[k] = EndianConvert::Swap<short>(pData[k]);
-                } break;
-          case 32 : {
-                int *pData = reinterpret_cast<int*>(&vData[0]);
-                for (uint32_t k = 0;k<iDataSize/4;k++)
-                  pData[k] = EndianConvert::Swap<int>(pData[k]);
-                } break;
-        }
-      }
-
       // HACK: For now we set bias to 0 for unsigned file as we've
       // encountered a number of DICOM files files where the bias
       // parameter would create negative values and so far I don't know
       // how to interpret this correctly
       if (!pDICOMStack->m_bSigned) pDICOMFileInfo->m_fBias = 0.0f;
-
-      if (pDICOMFileInfo->m_fScale != 1.0f || pDICOMFileInfo->m_fBias != 0.0f) {
-        MESSAGE("Applying Scale and Bias  ...");
-        if (pDICOMStack->m_bSigned) {
-          switch (pDICOMStack->m_iAllocated) {
-            case  8 :{
-                  char *pData = reinterpret_cast<char*>(&vData[0]);
-                  for (uint32_t k = 0;k<iDataSize/2;k++){
-                    float sbValue = pData[k] * pDICOMFileInfo->m_fScale + pDICOMFileInfo->m_fBias;
-                    pData[k] = (char)(sbValue);
-                  }} break;
-            case 16 : {
-                  short *pData = reinterpret_cast<short*>(&vData[0]);
-                  for (uint32_t k = 0;k<iDataSize/2;k++){
-                    float sbValue = pData[k] * pDICOMFileInfo->m_fScale + pDICOMFileInfo->m_fBias;
-                    pData[k] = (short)(sbValue);
-                  }} break;
-            case 32 : {
-                  int *pData = reinterpret_cast<int*>(&vData[0]);
-                  for (uint32_t k = 0;k<iDataSize/4;k++){
-                    float sbValue = pData[k] * pDICOMFileInfo->m_fScale + pDICOMFileInfo->m_fBias;
-                    pData[k] = (int)(sbValue);
-                  }} break;
-          }
+      // TODO: implement proper DICOM Windowing
+      if (pDICOMFileInfo->m_fWindowWidth > 0) bWindowing = true;
+    }
+    if (bWindowing) WARNING("DICOM Windowing parameters found!");
+
+    // Slices are decoded, swapped and rescaled on all cores, and written
+    // in order.
+    const bool bWritten = ReadSlicesInOrder(pDICOMStack->m_Elements.size(),
+      [&](size_t j, vector<char>& vData) -> bool {
+        SimpleFileInfo* pFileInfo = pDICOMStack->m_Elements[j];
+        SimpleDICOMFileInfo* pDICOMFileInfo = dynamic_cast<SimpleDICOMFileInfo*>(pFileInfo);
+        vData.clear();
+        if (!pDICOMFileInfo) return true;
+
+        vData.resize(pFileInfo->GetDataSize());
+        if (bJPEG) {
+          tuvok::JPEG jpg(pFileInfo->m_strFileName,
+                          pDICOMFileInfo->GetOffsetToData());
+          if(!jpg.valid()) return false;
+          const char *jpeg_data = jpg.data();
+          if(jpeg_data == NULL) return false;
+          copy(jpeg_data, jpeg_data + min(jpg.size(), vData.size()),
+               vData.begin());
         } else {
-          switch (pDICOMStack->m_iAllocated) {
-            case  8 :{
-                  unsigned char *pData = reinterpret_cast<unsigned char*>(&vData[0]);
-                  for (uint32_t k = 0;k<iDataSize/2;k++){
-                    float sbValue = pData[k] * pDICOMFileInfo->m_fScale + pDICOMFileInfo->m_fBias;
-                    pData[k] = (unsigned char)(sbValue);
-                  }} break;
-            case 16 : {
-                  unsigned short *pData = reinterpret_cast<unsigned short*>(&vData[0]);
-                  for (uint32_t k = 0;k<iDataSize/2;k++){
-                    float sbValue = pData[k] * pDICOMFileInfo->m_fScale + pDICOMFileInfo->m_fBias;
-                    pData[k] = (unsigned short)(sbValue);
-                  }} break;
-            case 32 : {
-                  unsigned int *pData = reinterpret_cast<unsigned int*>(&vData[0]);
-                  for (uint32_t k = 0;k<iDataSize/4;k++) {
-                    float sbValue = pData[k] * pDICOMFileInfo->m_fScale + pDICOMFileInfo->m_fBias;
-                    pData[k] = (unsigned int)(sbValue);
-                  }} break;
-          }
+          if (!pFileInfo->GetData(vData)) return false;
         }
-      }
- 
-      // TODO: implement proper DICOM Windowing
-      if (pDICOMFileInfo->m_fWindowWidth > 0) {
-        WARNING("DICOM Windowing parameters found!");
-      }
 
-      // Create temporary file with the DICOM (image) data.  We pretend 3
-      // component data is 4 component data to simplify processing later.
-      /// @todo FIXME: this code assumes 3 component data is always 3*char
-      if (pDICOMStack->m_iComponentCount == 3) {
-        uint32_t iRGBADataSize = (iDataSize / 3) * 4;
-
-        // Later we'll tell RAWConverter that this dataset has
-        // m_iComponentCount components.  Since we're upping the number of
-        // components here, we update the component count too.
-        pDICOMStack->m_iComponentCount = 4;
-        // Do note that the number of components in the data and the number of
-        // components in our in-memory copy of the data now differ.
-
-        unsigned char *pRGBAData = new unsigned char[iRGBADataSize];
-        for (uint32_t k = 0;k<iDataSize/3;k++) {
-          pRGBAData[k*4+0] = vData[k*3+0];
-          pRGBAData[k*4+1] = vData[k*3+1];
-          pRGBAData[k*4+2] = vData[k*3+2];
-          pRGBAData[k*4+3] = 255;
+        if (bSwap) SwapEndianness(vData, pDICOMStack->m_iAllocated);
+
+        if (pDICOMFileInfo->m_fScale != 1.0f || pDICOMFileInfo->m_fBias != 0.0f)
+          ScaleAndBias(vData, pDICOMStack->m_iAllocated,
+                       pDICOMStack->m_bSigned,
+                       pDICOMFileInfo->m_fScale, pDICOMFileInfo->m_fBias);
+
+        if (bRGB) {
+          vector<char> vRGBA;
+          RGBToRGBA(vData, vRGBA);
+          vData.swap(vRGBA);
         }
-        fs.write((char*)pRGBAData, iRGBADataSize);
-        delete[] pRGBAData;
-      } else {
-        fs.write(&vData[0], iDataSize);
-      }
+        return true;
+      },
+      [&](size_t j, const vector<char>& vData) -> bool {
+        if (!vData.empty()) fs.write(&vData[0], vData.size());
+        MESSAGE("Creating intermediate file %s\n%u%%",
+                strTempMergeFilename.c_str(),
+                static_cast<unsigned>((100*j)/pDICOMStack->m_Elements.size()));
+        return !fs.fail();
+      });
+
+    // Later we'll tell RAWConverter that this dataset has
+    // m_iComponentCount components.  Since we've upped the number of
+    // components, we update the component count too.
+    if (bRGB) pDICOMStack->m_iComponentCount = 4;
+
+    if (!bWritten) {
+      T_ERROR("Could not read the DICOM slices into %s, aborted conversion.",
+              strTempMergeFilename.c_str());
+      fs.close();
+      remove(strTempMergeFilename.c_str());
+      return false;
     }
 
     fs.close();
@@ -530,17 +483,25 @@ bool IOManager::ConvertDataset(FileStackInfo* pStack,
       return false;
     }
 
-    vector<char> vData;
-    for (size_t j = 0;j<pStack->m_Elements.size();j++) {
-      pStack->m_Elements[j]->GetData(vData);
-
-      fs.write(&vData[0], vData.size());
-      MESSAGE("Creating intermediate file %s\n%u%%",
-              strTempMergeFilename.c_str(),
-              static_cast<unsigned>((100*j)/pStack->m_Elements.size()));
-    }
+    const bool bWritten = ReadSlicesInOrder(pStack->m_Elements.size(),
+      [&](size_t j, vector<char>& vData) -> bool {
+        return pStack->m_Elements[j]->GetData(vData);
+      },
+      [&](size_t j, const vector<char>& vData) -> bool {
+        if (!vData.empty()) fs.write(&vData[0], vData.size());
+        MESSAGE("Creating intermediate file %s\n%u%%",
+                strTempMergeFilename.c_str(),
+                static_cast<unsigned>((100*j)/pStack->m_Elements.size()));
+        return !fs.fail();
+      });
 
     fs.close();
+    if (!bWritten) {
+      T_ERROR("Could not read the images into %s, aborted conversion.",
+              strTempMergeFilename.c_str());
+      remove(strTempMergeFilename.c_str());
+      return false;
+    }
     MESSAGE("    done creating intermediate file %s",
             strTempMergeFilename.c_str());
 
@@ -1503,66 +1464,32 @@ bool IOManager::ExtractIsosurface(const tuvok::UVFDataset* pSourceData,
     return false;
   }
 
-  UINT64VECTOR3 vDomainSize = pSourceData->GetDomainSize(size_t(iLODlevel));
-
-  if (bFloatingPoint) {
-    if (bSigned) {
-      switch (iComponentSize) {
-        case 32:
-          pMCData.reset(new MCDataTemplate<float>(strTargetFilename,
-            float(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-        case 64:
-          pMCData.reset(new MCDataTemplate<double>(strTargetFilename,
-            double(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-      }
-    }
-  } else {
-    if (bSigned) {
-      switch (iComponentSize) {
-        case  8:
-          pMCData.reset(new MCDataTemplate<char>(strTargetFilename,
-            char(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-        case 16:
-          pMCData.reset(new MCDataTemplate<short>(strTargetFilename,
-            short(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-        case 32:
-          pMCData.reset(new MCDataTemplate<int>(strTargetFilename,
-            int(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-        case 64:
-          pMCData.reset(new MCDataTemplate<int64_t>(strTargetFilename,
-            int64_t(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-      }
-    } else {
-      switch (iComponentSize) {
-        case  8:
-          pMCData.reset(new MCDataTemplate<unsigned char>(strTargetFilename,
-            (unsigned char)(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-        case 16:
-          pMCData.reset(new MCDataTemplate<unsigned short>(strTargetFilename,
-            (unsigned short)(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-        case 32:
-          pMCData.reset(new MCDataTemplate<uint32_t>(strTargetFilename,
-            uint32_t(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-        case 64:
-          pMCData.reset(new MCDataTemplate<uint64_t>(strTargetFilename,
-            uint64_t(fIsovalue), vScale, vDomainSize, conv, vfColor
-          )); break;
-      }
+  if (bFloatingPoint || iComponentSize != 64) {
+    std::shared_ptr<MeshSink> sink = conv->CreateSink(
+      strTargetFilename, "Marching Cubes mesh by ImageVis3D", vfColor
+    );
+    if (tuvok::ExtractIsosurface(*pSourceData, iLODlevel, fIsovalue, vScale,
+                                 *sink) && sink->Close()) {
+      return true;
     }
+    sink.reset();
+    remove (strTargetFilename.c_str());
+    T_ERROR("Export call failed.");
+    return false;
   }
 
-  if (!pMCData) {
-    T_ERROR("Unsupported data format.");
-    return false;
+  // 64bit integer bricks cannot be read individually; march them one after
+  // the other as they are unbricked.
+  UINT64VECTOR3 vDomainSize = pSourceData->GetDomainSize(size_t(iLODlevel));
+
+  if (bSigned) {
+    pMCData.reset(new MCDataTemplate<int64_t>(strTargetFilename,
+      int64_t(fIsovalue), vScale, vDomainSize, conv, vfColor
+    ));
+  } else {
+    pMCData.reset(new MCDataTemplate<uint64_t>(strTargetFilename,
+      uint64_t(fIsovalue), vScale, vDomainSize, conv, vfColor
+    ));
   }
 
   bool bResult = pSourceData->ApplyFunction(iLODlevel,&MCBrick,
@@ -2368,7 +2295,7 @@ void TypedRead(std::vector<T>& data,
   if(is_float && width == 32) {
     std::vector<float> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<float*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
@@ -2376,49 +2303,49 @@ void TypedRead(std::vector<T>& data,
     // Can this happen?  What would we expand double into?
     std::vector<double> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<double*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
   } else if( is_signed &&  8 == width) {
     std::vector<int8_t> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<int8_t*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
   } else if(!is_signed &&  8 == width) {
     std::vector<uint8_t> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<uint8_t*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
   } else if( is_signed && 16 == width) {
     std::vector<int16_t> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<int16_t*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
   } else if(!is_signed && 16 == width) {
     std::vector<uint16_t> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<uint16_t*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
   } else if( is_signed && 32 == width) {
     std::vector<int32_t> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<int32_t*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
   } else if(!is_signed && 32 == width) {
     std::vector<uint32_t> tmpdata;
     ds.GetBrick(key, tmpdata);
-    data.resize(tmpdata.size() / (width/8));
+    data.resize(tmpdata.size());
     interpolate<uint32_t*, typename std::vector<T>::iterator, T>(
       &tmpdata[0], (&tmpdata[0]) + tmpdata.size(), range, data.begin()
     );
@@ -2429,27 +2356,56 @@ void TypedRead(std::vector<T>& data,
 }
 
 namespace {
+  // Evaluates the program for every brick and writes the results to 'rdb'.
+  // Bricks are read in batches of one per thread; each batch is evaluated in
+  // parallel, while reading and writing stay serial.
   template<typename T>
-  void ReadAndEvalBrick(
-    RasterDataBlock& rdb,
-    const std::vector<std::shared_ptr<UVFDataset>>& uvfs,
-    const std::vector<BrickTable::const_iterator>& iters,
-    tuvok::expression::Node* tree
-  ) {
-    std::vector<std::vector<T>> involumes(uvfs.size());
-    std::vector<T> output;
+  void EvaluateBricks(RasterDataBlock& rdb,
+                      const std::vector<std::shared_ptr<UVFDataset>>& uvfs,
+                      const tuvok::expression::Program& program)
+  {
+#ifdef _OPENMP
+    const size_t batch = static_cast<size_t>(std::max(omp_get_max_threads(),
+                                                      1));
+#else
+    const size_t batch = 1;
+#endif
+    std::vector<BrickTable::const_iterator> iters;
     for(size_t i=0; i < uvfs.size(); ++i) {
-      MESSAGE("Reading brick from volume %u/%u...", static_cast<unsigned>(i+1),
-              static_cast<unsigned>(uvfs.size()));
-      TypedRead<T>(involumes[i], *uvfs[i], iters[i]->first);
+      iters.push_back(uvfs[i]->BricksBegin());
     }
-    MESSAGE("Evaluating expression ...");
-    tuvok::expression::evaluate(*tree, involumes, output);
+    const size_t total = static_cast<size_t>(
+      std::distance(uvfs[0]->BricksBegin(), uvfs[0]->BricksEnd())
+    );
 
-    MESSAGE("Writing ...");
-    NDBrickKey nk = uvfs[0]->IndexToVectorKey(iters[0]->first);
-    if(false == rdb.SetData(&output[0], nk.lod, nk.brick)) {
-      T_ERROR("Write failed!");
+    std::vector<std::vector<std::vector<T>>> involumes;
+    std::vector<std::vector<T>> output;
+    std::vector<BrickKey> keys;
+    size_t done = 0;
+    while(iters[0] != uvfs[0]->BricksEnd()) {
+      involumes.clear();
+      keys.clear();
+      for(size_t b=0; b < batch && iters[0] != uvfs[0]->BricksEnd(); ++b) {
+        involumes.push_back(std::vector<std::vector<T>>(uvfs.size()));
+        keys.push_back(iters[0]->first);
+        for(size_t i=0; i < uvfs.size(); ++i) {
+          TypedRead<T>(involumes.back()[i], *uvfs[i], iters[i]->first);
+          ++iters[i];
+        }
+      }
+      MESSAGE("Evaluating bricks %u-%u of %u...",
+              static_cast<unsigned>(done+1),
+              static_cast<unsigned>(done+keys.size()),
+              static_cast<unsigned>(total));
+      tuvok::expression::evaluate(program, involumes, output);
+
+      for(size_t b=0; b < keys.size(); ++b) {
+        NDBrickKey nk = uvfs[0]->IndexToVectorKey(keys[b]);
+        if(false == rdb.SetData(&output[b][0], nk.lod, nk.brick)) {
+          T_ERROR("Write failed!");
+        }
+      }
+      done += keys.size();
     }
   }
 }
@@ -2495,28 +2451,38 @@ IOManager::EvaluateExpression(const std::string& expr,
   }
 
   tuvok::expression::Node* tree = parser_tree_root();
+  const tuvok::expression::Program program(*tree);
+  if(program.Volumes() > uvf.size()) {
+    throw tuvok::expression::semantic::Error("Volume index out of range",
+                                             __FILE__, __LINE__);
+  }
 
-  // volume iterators
-  std::vector<BrickTable::const_iterator> viters;
-#ifdef DETECTED_OS_APPLE
-  viters.reserve(uvf.size());
-  for(size_t i=0; i < uvf.size(); ++i) {
-    viters.push_back(uvf[i]->BricksBegin());
+  // Figure out which what type our output data should be.
+  size_t bit_width;
+  bool is_float, is_signed;
+  IdentifyType(uvf, bit_width, is_float, is_signed);
+
+  // The output copies its layout from an input of that type, since element
+  // sizes are baked into a raster data block's offsets.
+  size_t layout = uvf.size();
+  for(size_t i=0; i < uvf.size() && layout == uvf.size(); ++i) {
+    if(uvf[i]->GetBitWidth() == bit_width &&
+       uvf[i]->GetIsFloat() == is_float && uvf[i]->GetIsSigned() == is_signed) {
+      layout = i;
+    }
   }
-#else
-  viters.resize(uvf.size());
-  for(size_t i=0; i < viters.size(); ++i) { // initialize
-    viters[i] = uvf[i]->BricksBegin();
+  if(layout == uvf.size()) {
+    throw tuvok::io::UnmergeableDatasets("No input volume has the combined "
+                                         "data type", __FILE__, __LINE__);
   }
-#endif
 
   std::shared_ptr<RasterDataBlock> rdb(new RasterDataBlock());
   rdb->SetBlockSemantic(UVFTables::BS_REG_NDIM_GRID);
   rdb->SetIdentityTransformation();
   rdb->SetTypeToUShort(UVFTables::ES_RED);
 
-  { // Copy the other basic info from the first input volume.
-    std::wstring wide_vol(volumes[0].begin(), volumes[0].end());
+  { // Copy the other basic info from that input volume.
+    std::wstring wide_vol(volumes[layout].begin(), volumes[layout].end());
     UVF firstvol(wide_vol);
     firstvol.Open(false, false, false);
     const std::shared_ptr<const RasterDataBlock> rdb1 = GetFirstRDB(firstvol);
@@ -2525,7 +2491,7 @@ IOManager::EvaluateExpression(const std::string& expr,
     // settings -- see RAWConverter::ConvertRAWDataset(...) ).
     if (rdb1 == NULL) {
       throw tuvok::io::IOException("No raster data blocks present in the "
-                                   "first volume.",
+                                   "input volume.",
                                    __FILE__, __LINE__);
     }
     *rdb = *rdb1;
@@ -2536,69 +2502,30 @@ IOManager::EvaluateExpression(const std::string& expr,
   lout->Create();
   rdb->ResetFile(lout);
 
-  // Figure out which what type our output data should be.
-  size_t bit_width;
-  bool is_float, is_signed;
-  IdentifyType(uvf, bit_width, is_float, is_signed);
-
-  //     foreach brick:
-  //       load brick into 'involumes'
-  //       evaluate(tree, input-bricks-in-a-vector, output)
-  //       write output somewhere
-  /// @todo FIXME: we should query bit_width, is_float, is_signed to create
-  /// different 'involumes' based on the type we need...
-  size_t brick = 0;
-  while(viters[0] != uvf[0]->BricksEnd()) {
-    for(size_t i=0; i < uvf.size(); ++i) {
-      MESSAGE("Brick %u (file %03u/%03u)...", static_cast<unsigned>(brick),
-              static_cast<unsigned>(i+1), static_cast<unsigned>(uvf.size()));
-      // Read in the data we need.
-      if(is_float && bit_width == 32) {
-        ReadAndEvalBrick<float>(*rdb, uvf, viters, tree);
-      } else if(is_float && bit_width == 64) {
-        // Not implemented in UVF...
-        T_ERROR("double format data not supported!");
-        continue;
-      } else if( is_signed && bit_width ==  8) {
-        ReadAndEvalBrick< int8_t>(*rdb, uvf, viters, tree);
-      } else if(!is_signed && bit_width ==  8) {
-        ReadAndEvalBrick<uint8_t>(*rdb, uvf, viters, tree);
-      } else if( is_signed && bit_width == 16) {
-        ReadAndEvalBrick< int16_t>(*rdb, uvf, viters, tree);
-      } else if(!is_signed && bit_width == 16) {
-        ReadAndEvalBrick<uint16_t>(*rdb, uvf, viters, tree);
-      // These types aren't yet implemented in UVF/RasterDataBlock.
-      } else if( is_signed && bit_width == 32) {
-        T_ERROR("32bit signed int data not implemented!");
-        //ReadAndEvalBrick< int32_t>(*rdb, uvf, viters, tree);
-      } else if(!is_signed && bit_width == 32) {
-        T_ERROR("32bit unsigned data not implemented!");
-        //ReadAndEvalBrick<uint32_t>(*rdb, uvf, viters, tree);
-      } else if( is_signed && bit_width == 64) {
-        T_ERROR("64bit signed int data not implemented!");
-        //ReadAndEvalBrick< int64_t>(*rdb, uvf, viters, tree);
-      } else if(!is_signed && bit_width == 64) {
-        T_ERROR("64bit unsigned data not implemented!");
-        //ReadAndEvalBrick<uint64_t>(*rdb, uvf, viters, tree);
-      } else {
-        T_ERROR("Could not figure out destination data type!");
-      }
-    }
-    MESSAGE("Brick %u (evaluation)...", static_cast<unsigned>(brick));
-
-    using namespace std::placeholders;
-    // advance each brick iterator by one.
-#ifndef __APPLE__
-    std::for_each(viters.begin(), viters.end(),
-                  std::bind(std::advance<BrickTable::const_iterator,int>,
-                            _1, 1));
-#else
-    // Clang's libc++ uses iterator_traits<_InputIter>::difference_type to
-    // deduce distance template parameter.
-    std::for_each(viters.begin(), viters.end(),
-                  std::bind(std::advance<BrickTable::const_iterator>,
-                            _1, 1));
-#endif
+  if(is_float && bit_width == 32) {
+    EvaluateBricks<float>(*rdb, uvf, program);
+  } else if(is_float && bit_width == 64) {
+    EvaluateBricks<double>(*rdb, uvf, program);
+  } else if( is_signed && bit_width ==  8) {
+    EvaluateBricks< int8_t>(*rdb, uvf, program);
+  } else if(!is_signed && bit_width ==  8) {
+    EvaluateBricks<uint8_t>(*rdb, uvf, program);
+  } else if( is_signed && bit_width == 16) {
+    EvaluateBricks< int16_t>(*rdb, uvf, program);
+  } else if(!is_signed && bit_width == 16) {
+    EvaluateBricks<uint16_t>(*rdb, uvf, program);
+  } else if( is_signed && bit_width == 32) {
+    EvaluateBricks< int32_t>(*rdb, uvf, program);
+  } else if(!is_signed && bit_width == 32) {
+    EvaluateBricks<uint32_t>(*rdb, uvf, program);
+  } else if(bit_width == 64) {
+    // Datasets cannot hand out 64bit integer bricks (there is no GetBrick
+    // for them), so there is nothing to evaluate on.
+    T_ERROR("64bit integer data not supported!");
+    return;
+  } else {
+    T_ERROR("Could not figure out destination data type!");
+    return;
   }
 
   CreateUVFFromRDB(out_fn, rdb);
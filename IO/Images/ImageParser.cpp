@@ -35,6 +35,7 @@
   \date    September 2008
 */
 
+#include <algorithm>
 #include "ImageParser.h"
 #ifndef TUVOK_NO_QT
 # include <QtGui/QImage>
@@ -87,46 +88,52 @@ bool ImageFileInfo::GetData(std::vector<char>& vData, uint32_t iLength,
 #endif
 {
 #ifndef TUVOK_NO_QT
-  QImage qImage(m_strFileName.c_str());
+  const QImage qImage(m_strFileName.c_str());
   if (qImage.isNull()) return false;
 
+  const size_t w = static_cast<size_t>(qImage.width());
+  const size_t h = static_cast<size_t>(qImage.height());
   if(qImage.depth() == 32) {
     m_iComponentCount = 4;
     ComputeSize();
     vData.resize(GetDataSize());
-    size_t w = static_cast<size_t>(qImage.width());
-    size_t h = static_cast<size_t>(qImage.height());
 
 #if QT_VERSION >= 0x040600
     assert(static_cast<uint64_t>(qImage.byteCount()) ==
            (w*h*m_iComponentCount));
 #endif
     // Qt says we can't use bits() directly as a uchar; the byte order differs
-    // per-platform.  So pull out each component the slow way.
-    const QRgb* bits = reinterpret_cast<const QRgb*>(qImage.bits());
-    for(uint64_t i=0; i < uint64_t(w)*h; ++i) {
-      vData[i*4 + 0] = qRed(*bits);
-      vData[i*4 + 1] = qGreen(*bits);
-      vData[i*4 + 2] = qBlue(*bits);
-      vData[i*4 + 3] = qAlpha(*bits);
-      ++bits;
+    // per-platform.  So pull out each component of the QRgbs.
+    unsigned char* pData = reinterpret_cast<unsigned char*>(&vData[0]);
+    for(size_t y=0; y < h; ++y) {
+      const QRgb* line = reinterpret_cast<const QRgb*>(qImage.scanLine(int(y)));
+      for(size_t x=0; x < w; ++x, pData += 4) {
+        pData[0] = static_cast<unsigned char>(qRed(line[x]));
+        pData[1] = static_cast<unsigned char>(qGreen(line[x]));
+        pData[2] = static_cast<unsigned char>(qBlue(line[x]));
+        pData[3] = static_cast<unsigned char>(qAlpha(line[x]));
+      }
     }
   } else {
-    int iCount = 0;
-    for (int y = 0;y<qImage.height();y++) {
-      for (int x = 0;x<qImage.width();x++) {
-        if (int(iOffset) > iCount) { continue; }
-
-        QColor pixel(qImage.pixel(x,y));
-        unsigned char cValue = (unsigned char)((pixel.red() + pixel.green() +
-pixel.blue()) /
- 3);
-        unsigned char *pData = reinterpret_cast<unsigned char*>(&vData[0]);
-        pData[iCount-iOffset] = cValue;
-
-        if (int(iLength) == iCount-int(iOffset)) break;
-        iCount++;
+    // Pixels [iOffset, iOffset+iLength) as the mean of their RGB components.
+    // Converting the image once beats asking it for every pixel's color.
+    const QImage qRGBImage = qImage.convertToFormat(QImage::Format_RGB32);
+    const size_t iEnd = std::min(w*h, size_t(iOffset) + iLength);
+    if (size_t(iOffset) >= iEnd) return true;
+    if (vData.size() < iEnd - iOffset) vData.resize(iEnd - iOffset);
+
+    unsigned char* pData = reinterpret_cast<unsigned char*>(&vData[0]);
+    for (size_t i = iOffset;i<iEnd;) {
+      const size_t y = i / w;
+      const size_t x0 = i % w;
+      const size_t x1 = std::min(w, x0 + (iEnd - i));
+      const QRgb* line = reinterpret_cast<const QRgb*>(qRGBImage.scanLine(int(y)));
+      for (size_t x = x0;x<x1;x++) {
+        *pData++ = static_cast<unsigned char>((qRed(line[x]) +
+                                               qGreen(line[x]) +
+                                               qBlue(line[x])) / 3);
       }
+      i += x1 - x0;
     }
   }
   return true;
@@ -33,7 +33,11 @@
         University of Utah
 */
 #include "StdTuvokDefines.h"
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <sstream>
+#include <vector>
 
 #ifndef TUVOK_NO_QT
  #include <QtGui/QImage>
@@ -42,10 +46,94 @@
 
 #include "StackExporter.h"
 #include "Basics/SysTools.h"
+#include "Basics/SystemInfo.h"
 #include "Basics/LargeRAWFile.h"
 #include "Basics/nonstd.h"
 #include "Controller/Controller.h"
 
+namespace {
+  /// Names the images of a stack as FindNextSequenceName would, one after
+  /// the other, but looks into the directory only once.
+  class SequenceNames {
+  public:
+    SequenceNames(const std::string& strFilename) :
+      m_strPrefix(SysTools::GetPath(strFilename) +
+                  SysTools::RemoveExt(SysTools::GetFilename(strFilename)) +
+                  "_"),
+      m_strSuffix("." + SysTools::GetExt(strFilename)),
+      m_iFirst(1)
+    {
+      const std::string strFirst = SysTools::FindNextSequenceName(strFilename);
+      SysTools::FromString(m_iFirst,
+        strFirst.substr(m_strPrefix.length(), strFirst.length() -
+                        m_strPrefix.length() - m_strSuffix.length()));
+    }
+
+    std::string operator()(uint64_t i) const {
+      std::ostringstream out;
+      out << m_strPrefix << m_iFirst + i << m_strSuffix;
+      return out.str();
+    }
+
+  private:
+    std::string m_strPrefix;
+    std::string m_strSuffix;
+    uint64_t    m_iFirst;
+  };
+
+  struct RGB8 { unsigned char c[3]; };
+
+  /// Copies a slab of 'nz' Z slices, starting at slice 'z0', into the
+  /// images of X slices [x0,x1) and Y slices [y0,y1).  An X image is Z
+  /// wide and Y high, a Y image is X wide and Z high; each band holds its
+  /// images back to back.
+  template<typename T>
+  void Transpose(const T* pSlab, uint64_t z0, uint64_t nz,
+                 const UINT64VECTOR3& vDomainSize,
+                 uint64_t x0, uint64_t x1, T* pX,
+                 uint64_t y0, uint64_t y1, T* pY) {
+    // Gathering an X image row walks the slab with a stride of a whole
+    // slice.  Doing it in tiles makes each cache line fetched from the
+    // slab serve a tile's worth of X images before it is evicted.
+    const uint64_t iTile = 64;
+    const uint64_t iSlice = vDomainSize.x*vDomainSize.y;
+    const int64_t iRows = int64_t(vDomainSize.y);
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t iy = 0;iy<iRows;++iy) {
+      const uint64_t y = uint64_t(iy);
+      for (uint64_t zt = 0;zt<nz;zt+=iTile) {
+        const uint64_t ze = std::min(zt+iTile, nz);
+        for (uint64_t xt = x0;xt<x1;xt+=iTile) {
+          const uint64_t xe = std::min(xt+iTile, x1);
+          for (uint64_t x = xt;x<xe;++x) {
+            const T* in = pSlab + y*vDomainSize.x + x;
+            T* out = pX + ((x-x0)*vDomainSize.y + y)*vDomainSize.z + z0;
+            for (uint64_t z = zt;z<ze;++z) out[z] = in[z*iSlice];
+          }
+        }
+      }
+      // Y images are made of whole rows
+      if (y >= y0 && y < y1) {
+        for (uint64_t z = 0;z<nz;++z) {
+          const T* in = pSlab + z*iSlice + y*vDomainSize.x;
+          std::copy(in, in+vDomainSize.x,
+                    pY + ((y-y0)*vDomainSize.z + z0+z)*vDomainSize.x);
+        }
+      }
+    }
+  }
+
+  template<typename T>
+  void Transpose(const unsigned char* pSlab, uint64_t z0, uint64_t nz,
+                 const UINT64VECTOR3& vDomainSize,
+                 uint64_t x0, uint64_t x1, unsigned char* pX,
+                 uint64_t y0, uint64_t y1, unsigned char* pY) {
+    Transpose(reinterpret_cast<const T*>(pSlab), z0, nz, vDomainSize,
+              x0, x1, reinterpret_cast<T*>(pX),
+              y0, y1, reinterpret_cast<T*>(pY));
+  }
+}
+
 
 std::vector<std::pair<std::string,std::string>> StackExporter::GetSuportedImageFormats() {
   std::vector<std::pair<std::string,std::string>> formats;
@@ -76,6 +164,7 @@ bool StackExporter::WriteImage(unsigned char* pData,
     if (!out.Create()) return false;
     out.WriteRAW(pData, vSize.area()*iComponentCount);
     out.Close();
+    return true;
   }
 
 #ifndef TUVOK_NO_QT
@@ -116,7 +205,7 @@ bool StackExporter::WriteImage(unsigned char* pData,
 bool StackExporter::WriteSlice(unsigned char* pData,
                                const TransferFunction1D* pTrans,
                                uint64_t iBitWidth,
-                               const std::string& strCurrentDiFilename,
+                               const std::string& strTargetFilename,
                                const UINT64VECTOR2& vSize,
                                float fRescale,
                                uint64_t iComponentCount) {
@@ -138,9 +227,7 @@ bool StackExporter::WriteSlice(unsigned char* pData,
     }
 
     // write data to disk
-    std::string strCurrentTargetFilename = SysTools::FindNextSequenceName(strCurrentDiFilename);
-
-    return WriteImage(pData,strCurrentTargetFilename, vSize, iImageCompCount);
+    return WriteImage(pData, strTargetFilename, vSize, iImageCompCount);
 }
 
 
@@ -155,15 +242,13 @@ void StackExporter::PadInplace(unsigned char* pData,
      size_t sourcePos = (iStepping - iPadcount) * (vSize.area()-(i+1));
      size_t targetPos = iStepping * (vSize.area()-(i+1));
 
-     for (unsigned int j = 0;j<iStepping;++j) {
+     // back to front, as the first pixels' source and target overlap
+     for (unsigned int j = iStepping;j-->0;) {
 
        if ( j < iStepping - iPadcount)
-         pData[targetPos] = pData[sourcePos];
+         pData[targetPos+j] = pData[sourcePos+j];
        else
-         pData[targetPos] = iValue;
-
-       targetPos++;
-       sourcePos++;
+         pData[targetPos+j] = iValue;
      }
      
   }
@@ -179,7 +264,8 @@ bool StackExporter::WriteStacks(const std::string& strRAWFilename,
                                 uint64_t iComponentCount,
                                 float fRescale,
                                 UINT64VECTOR3 vDomainSize,
-                                bool bAllDirs) {
+                                bool bAllDirs,
+                                uint64_t iMaxMem) {
   if (iComponentCount > 4)  {
     T_ERROR("Invalid channel count, no more than four components are accepted by the stack exporter.");
     return false;
@@ -202,79 +288,125 @@ bool StackExporter::WriteStacks(const std::string& strRAWFilename,
 */
   }
 
+  const uint64_t elemSize = iComponentCount*iDataByteWith;
+  if (elemSize == 0 || elemSize > 4) {
+    T_ERROR("Invalid bit depth, only 8, 16 and 32bit data is accepted by the stack exporter.");
+    return false;
+  }
 
   LargeRAWFile dataSource(strRAWFilename);
   if (!dataSource.Open()) return false;
 
-  size_t iMaxPair = size_t((vDomainSize.x <= vDomainSize.y && vDomainSize.x <= vDomainSize.z) ? vDomainSize.z * vDomainSize.y : (
-                           (vDomainSize.y <= vDomainSize.x && vDomainSize.y <= vDomainSize.z) ? vDomainSize.x * vDomainSize.z : vDomainSize.x * vDomainSize.y));
-
-
-  std::shared_ptr<unsigned char> data(
-    new unsigned char[4*iMaxPair*iDataByteWith],
-    nonstd::DeleteArray<unsigned char>()
-  );
+  if (iMaxMem == 0)
+    iMaxMem = tuvok::Controller::ConstInstance().SysInfo().GetMaxUsableCPUMem() / 2;
+
+  // The volume is read in slabs of Z slices, which are written as they
+  // are.  The X and Y images need a whole pass over the volume each, so
+  // every pass fills as many of them as fit next to the slab.
+  const uint64_t iSliceSize = vDomainSize.x*vDomainSize.y*elemSize;
+  const uint64_t iSlab = std::max<uint64_t>(1, std::min(vDomainSize.z,
+                                                 iMaxMem/4/iSliceSize));
+  std::vector<unsigned char> slab(size_t(iSlab*iSliceSize));
+
+  uint64_t iPasses = 1;
+  if (bAllDirs) {
+    const uint64_t iBandMem = iMaxMem - std::min(iMaxMem, iSlab*iSliceSize);
+    const uint64_t iStacks = 2*vDomainSize.volume()*elemSize;
+    iPasses = std::min(std::max(vDomainSize.x, vDomainSize.y),
+                       std::max<uint64_t>(1, iBandMem == 0 ? iStacks :
+                                    (iStacks + iBandMem - 1) / iBandMem));
+  }
+  const uint64_t iBandX = (vDomainSize.x + iPasses - 1) / iPasses;
+  const uint64_t iBandY = (vDomainSize.y + iPasses - 1) / iPasses;
+
+  const SequenceNames xNames(SysTools::AppendFilename(strTargetFilename, "_x"));
+  const SequenceNames yNames(SysTools::AppendFilename(strTargetFilename, "_y"));
+  const SequenceNames zNames(bAllDirs ?
+                             SysTools::AppendFilename(strTargetFilename, "_z") :
+                             strTargetFilename);
+
+  // applies the TF to and writes images [iFirst, iFirst+n) of a stack
+  auto encode = [&](const unsigned char* pData, uint64_t iFirst, uint64_t n,
+                    const UINT64VECTOR2& vSize,
+                    const SequenceNames& names) -> bool {
+    const uint64_t iImageSize = vSize.area()*elemSize;
+    std::atomic<bool> bOK(true);
+#pragma omp parallel
+    {
+      std::vector<unsigned char> image(size_t(4*vSize.area()));
+#pragma omp for schedule(dynamic)
+      for (int64_t i = 0;i<int64_t(n);++i) {
+        const unsigned char* pImage = pData + uint64_t(i)*iImageSize;
+        std::copy(pImage, pImage+iImageSize, image.begin());
+        if (!WriteSlice(image.data(), pTrans, iBitWidth, names(iFirst+i),
+                        vSize, fRescale, iComponentCount))
+          bOK = false;
+      }
+    }
+    if (!bOK) T_ERROR("Unable to write stack images %llu to %llu.",
+                      iFirst, iFirst+n-1);
+    return bOK;
+  };
+
+  for (uint64_t p = 0;p<iPasses;++p) {
+    const uint64_t x0 = std::min(vDomainSize.x, p*iBandX);
+    const uint64_t x1 = std::min(vDomainSize.x, x0+iBandX);
+    const uint64_t y0 = std::min(vDomainSize.y, p*iBandY);
+    const uint64_t y1 = std::min(vDomainSize.y, y0+iBandY);
+    std::vector<unsigned char> xBand, yBand;
+    if (bAllDirs) {
+      xBand.resize(size_t((x1-x0)*vDomainSize.y*vDomainSize.z*elemSize));
+      yBand.resize(size_t((y1-y0)*vDomainSize.x*vDomainSize.z*elemSize));
+    }
 
-  UINT64VECTOR2 vSize(vDomainSize.z, vDomainSize.y);
-  std::string strCurrentDirTargetFilename = SysTools::AppendFilename(strTargetFilename, "_x");
-  size_t elemSize = iComponentCount*iDataByteWith;
+    dataSource.SeekPos(0);
+    for (uint64_t z0 = 0;z0<vDomainSize.z;z0+=iSlab) {
+      const uint64_t nz = std::min(iSlab, vDomainSize.z-z0);
+      MESSAGE("Exporting Stacks (pass %llu of %llu). Processing Slices %llu to %llu of %llu",
+              p+1, iPasses, z0+1, z0+nz, vDomainSize.z);
 
-  if (bAllDirs)  {
-    for (uint64_t x = 0;x<vDomainSize.x;x++) {
-      MESSAGE("Exporting X-Axis Stack. Processing Image %llu of %llu", x+1, vDomainSize.x);
+      if (dataSource.ReadRAW(slab.data(), nz*iSliceSize) != nz*iSliceSize) {
+        T_ERROR("Unable to read slices %llu to %llu.", z0, z0+nz-1);
+        dataSource.Close();
+        return false;
+      }
 
-      uint64_t offset = 0;
-      for (uint64_t v = 0;v<vDomainSize.y;v++) {
-        for (uint64_t u = 0;u<vDomainSize.z;u++) {
-          dataSource.SeekPos(elemSize * (x+u*vDomainSize.x*vDomainSize.y+v*vDomainSize.x) );
-          dataSource.ReadRAW(data.get()+offset, elemSize);
-          offset += elemSize;
+      if (bAllDirs) {
+        switch (elemSize) {
+          case 1 : Transpose<uint8_t>(slab.data(), z0, nz, vDomainSize,
+                                      x0, x1, xBand.data(),
+                                      y0, y1, yBand.data()); break;
+          case 2 : Transpose<uint16_t>(slab.data(), z0, nz, vDomainSize,
+                                       x0, x1, xBand.data(),
+                                       y0, y1, yBand.data()); break;
+          case 3 : Transpose<RGB8>(slab.data(), z0, nz, vDomainSize,
+                                   x0, x1, xBand.data(),
+                                   y0, y1, yBand.data()); break;
+          default : Transpose<uint32_t>(slab.data(), z0, nz, vDomainSize,
+                                        x0, x1, xBand.data(),
+                                        y0, y1, yBand.data()); break;
         }
       }
 
-      if (!WriteSlice(data.get(), pTrans, iBitWidth, strCurrentDirTargetFilename, vSize, fRescale, iComponentCount)) {
-        T_ERROR("Unable to write stack image %llu.",x);
+      if (p == 0 && !encode(slab.data(), z0, nz,
+                            UINT64VECTOR2(vDomainSize.x, vDomainSize.y),
+                            zNames)) {
         dataSource.Close();
         return false;
       }
     }
 
-    vSize = UINT64VECTOR2(vDomainSize.x, vDomainSize.z);
-    strCurrentDirTargetFilename = SysTools::AppendFilename(strTargetFilename, "_y");
-    for (uint64_t y = 0;y<vDomainSize.y;y++) {
-      MESSAGE("Exporting Y-Axis Stack. Processing Image %llu of %llu", y+1, vDomainSize.y);
-
-      uint64_t offset = 0;
-      for (uint64_t u = 0;u<vDomainSize.z;u++) {
-        dataSource.SeekPos(elemSize * (y*vDomainSize.x+u*vDomainSize.x*vDomainSize.y) );
-        dataSource.ReadRAW(data.get()+offset, vDomainSize.x*elemSize);
-        offset += vDomainSize.x*elemSize;
-      }
-
-      if (!WriteSlice(data.get(), pTrans, iBitWidth, strCurrentDirTargetFilename, vSize, fRescale, iComponentCount)) {
-        T_ERROR("Unable to write stack image %llu.",y);
+    if (bAllDirs) {
+      MESSAGE("Exporting Stacks (pass %llu of %llu). Writing X-Axis Images %llu to %llu and Y-Axis Images %llu to %llu",
+              p+1, iPasses, x0+1, x1, y0+1, y1);
+      if (!encode(xBand.data(), x0, x1-x0,
+                  UINT64VECTOR2(vDomainSize.z, vDomainSize.y), xNames) ||
+          !encode(yBand.data(), y0, y1-y0,
+                  UINT64VECTOR2(vDomainSize.x, vDomainSize.z), yNames)) {
         dataSource.Close();
         return false;
       }
     }
-
-    dataSource.SeekPos(0);
-    strCurrentDirTargetFilename = SysTools::AppendFilename(strTargetFilename, "_z");
-  } else {
-    strCurrentDirTargetFilename = strTargetFilename;
-  }
-
-  vSize = UINT64VECTOR2(vDomainSize.x, vDomainSize.y);
-  for (uint64_t z = 0;z<vDomainSize.z;z++) {
-    MESSAGE("Exporting Z-Axis Stack. Processing Image %llu of %llu", z+1, vDomainSize.z);
-
-    dataSource.ReadRAW(data.get(), vDomainSize.x*vDomainSize.y*elemSize);
-
-    if (!WriteSlice(data.get(), pTrans, iBitWidth, strCurrentDirTargetFilename, vSize, fRescale, iComponentCount)) {
-      T_ERROR("Unable to write stack image %llu.",z);
-      dataSource.Close();
-      return false;
-    }
   }
 
   dataSource.Close();
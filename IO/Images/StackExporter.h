@@ -50,6 +50,10 @@ public:
 
   static std::vector<std::pair<std::string,std::string>> GetSuportedImageFormats();
 
+  /// Writes the slices of a raw volume as images, along Z or, with
+  /// bAllDirs, along all three axes.  The volume is streamed; when the X
+  /// and Y images do not fit into iMaxMem bytes (0: half of the usable CPU
+  /// memory), it is read again for every band of them which does.
   static bool WriteStacks(const std::string& strRAWFilename, 
                           const std::string& strTargetFilename,
                           const TransferFunction1D* pTrans,
@@ -57,7 +61,8 @@ public:
                           uint64_t iComponentCount,
                           float fRescale,
                           UINT64VECTOR3 vDomainSize,
-                          bool bAllDirs);
+                          bool bAllDirs,
+                          uint64_t iMaxMem=0);
 
   static bool WriteImage(unsigned char* pData,
                   const std::string& strTargetFilename,
@@ -96,7 +101,7 @@ protected:
   static bool WriteSlice(unsigned char* pData,
                   const TransferFunction1D* pTrans,
                   uint64_t iBitWidth,
-                  const std::string& strCurrentDiFilename,
+                  const std::string& strTargetFilename,
                   const UINT64VECTOR2& vSize,
                   float fRescale,
                   uint64_t iComponentCount);
@@ -0,0 +1,477 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <limits>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+#include "IsosurfaceExtractor.h"
+#include "Basics/MC.h"
+#include "Controller/Controller.h"
+#include "uvfDataset.h"
+
+namespace tuvok { namespace iso {
+
+namespace {
+  // The case tables are protected members of MarchingCubes.
+  struct Tables : public MarchingCubes<float> {
+    using MarchingCubes<float>::ms_edgeTable;
+    using MarchingCubes<float>::ms_triTable;
+  };
+
+  // Corners and edges of a cell, numbered as in MC.inl: the offset of each
+  // corner from the cell's first one, and for each edge the axis it runs
+  // along and the offset of its lower end.
+  const unsigned corner[8][3] = {
+    {0,1,0}, {1,1,0}, {1,0,0}, {0,0,0}, {0,1,1}, {1,1,1}, {1,0,1}, {0,0,1}
+  };
+  const unsigned edgeAxis[12] = { 0,1,0,1, 0,1,0,1, 2,2,2,2 };
+  const unsigned edgeStart[12][3] = {
+    {0,1,0}, {1,0,0}, {0,0,0}, {0,0,0}, {0,1,1}, {1,0,1}, {0,0,1}, {0,0,1},
+    {0,1,0}, {1,1,0}, {1,0,0}, {0,0,0}
+  };
+  const uint32_t NoVertex = std::numeric_limits<uint32_t>::max();
+
+  template<class T> class Marcher {
+  public:
+    Marcher(const T* pData, const BrickExtent& brick,
+            const UINT64VECTOR3& vDomainSize, T isovalue, BrickMesh& mesh) :
+      m_pData(pData), m_brick(brick), m_vDomainSize(vDomainSize),
+      m_isovalue(isovalue), m_mesh(mesh)
+    {
+      m_stride[0] = 1;
+      m_stride[1] = size_t(brick.vVoxels.x);
+      m_stride[2] = size_t(brick.vVoxels.x * brick.vVoxels.y);
+      for(size_t a=0; a < 3; ++a) {
+        // cells are clipped to the volume, and to what the data hold: the
+        // far corner of the last cell must be there, too.
+        const uint64_t iFirst = brick.vFirst[a];
+        const uint64_t iEnd = std::min(iFirst + brick.vOwned[a],
+                                       vDomainSize[a] > 0 ? vDomainSize[a]-1
+                                                          : 0);
+        m_cells[a] = iEnd > iFirst ? iEnd - iFirst : 0;
+        const uint64_t iAvail = brick.vVoxels[a] > brick.vGhost[a] ?
+                                brick.vVoxels[a] - brick.vGhost[a] - 1 : 0;
+        m_cells[a] = std::min(m_cells[a], iAvail);
+        m_bLowSeam[a] = iFirst > 0;
+        m_bHighSeam[a] = iFirst + m_cells[a] + 1 < vDomainSize[a];
+      }
+    }
+
+    void Run() {
+      if(m_cells[0] == 0 || m_cells[1] == 0 || m_cells[2] == 0) return;
+
+      const size_t iPlane = size_t((m_cells[0]+1) * (m_cells[1]+1));
+      for(size_t a=0; a < 3; ++a) {
+        m_cache[a][0].assign(iPlane, NoVertex);
+        m_cache[a][1].assign(iPlane, NoVertex);
+      }
+      size_t cornerOffset[8];
+      for(size_t c=0; c < 8; ++c) {
+        cornerOffset[c] = corner[c][0] * m_stride[0] +
+                          corner[c][1] * m_stride[1] +
+                          corner[c][2] * m_stride[2];
+      }
+
+      for(uint64_t w=0; w < m_cells[2]; ++w) {
+        // plane w+1 takes the place of plane w-1; z edges are per layer.
+        if(w > 0) {
+          std::fill(m_cache[0][(w+1)&1].begin(), m_cache[0][(w+1)&1].end(),
+                    NoVertex);
+          std::fill(m_cache[1][(w+1)&1].begin(), m_cache[1][(w+1)&1].end(),
+                    NoVertex);
+          std::fill(m_cache[2][0].begin(), m_cache[2][0].end(), NoVertex);
+        }
+        for(uint64_t v=0; v < m_cells[1]; ++v) {
+          size_t iIndex = Index(m_brick.vGhost.x, m_brick.vGhost.y + v,
+                                m_brick.vGhost.z + w);
+          for(uint64_t u=0; u < m_cells[0]; ++u, ++iIndex) {
+            unsigned iCase = 0;
+            for(unsigned c=0; c < 8; ++c) {
+              iCase |= unsigned(m_pData[iIndex + cornerOffset[c]] <
+                                m_isovalue) << c;
+            }
+            const int iEdges = Tables::ms_edgeTable[iCase];
+            if(iEdges == 0) continue;
+
+            uint32_t vertex[12];
+            for(unsigned e=0; e < 12; ++e) {
+              if(iEdges & (1 << e)) {
+                vertex[e] = Vertex(edgeAxis[e], u + edgeStart[e][0],
+                                   v + edgeStart[e][1], w, edgeStart[e][2]);
+              }
+            }
+            const int* tri = Tables::ms_triTable[iCase];
+            for(size_t t=0; tri[t] != NO_EDGE; t += 3) {
+              m_mesh.triangles.push_back(vertex[tri[t+0]]);
+              m_mesh.triangles.push_back(vertex[tri[t+1]]);
+              m_mesh.triangles.push_back(vertex[tri[t+2]]);
+            }
+          }
+        }
+      }
+    }
+
+  private:
+    size_t Index(uint64_t x, uint64_t y, uint64_t z) const {
+      return size_t(x + m_brick.vVoxels.x * (y + m_brick.vVoxels.y * z));
+    }
+
+    /// @returns the vertex on the edge along 'axis' starting at the owned
+    /// point (u, v, w+dw), making it if it does not exist yet.
+    uint32_t Vertex(unsigned axis, uint64_t u, uint64_t v, uint64_t w,
+                    unsigned dw) {
+      const size_t iSlot = axis == 2 ? 0 : size_t((w+dw) & 1);
+      uint32_t& cached = m_cache[axis][iSlot][size_t(u + (m_cells[0]+1)*v)];
+      if(cached == NoVertex) {
+        cached = MakeVertex(axis, UINT64VECTOR3(u, v, w+dw));
+      }
+      return cached;
+    }
+
+    /// the same for every brick which has the edge, whichever way the cells
+    /// around it reach it.
+    uint32_t MakeVertex(unsigned axis, const UINT64VECTOR3& vOwned) {
+      const UINT64VECTOR3 vLocal = vOwned + m_brick.vGhost;
+      const size_t iFrom = Index(vLocal.x, vLocal.y, vLocal.z);
+      const size_t iTo = iFrom + m_stride[axis];
+
+      const double fFrom = double(m_pData[iFrom]);
+      const double fTo = double(m_pData[iTo]);
+      double d = (fFrom - double(m_isovalue)) / (fFrom - fTo);
+      if (d < EPSILON) d = 0.0; else if (d > (1.0-EPSILON)) d = 1.0;
+
+      const UINT64VECTOR3 vGlobal = vOwned + m_brick.vFirst;
+      FLOATVECTOR3 vVertex = FLOATVECTOR3(vGlobal);
+      vVertex[axis] += float(d);
+
+      const DOUBLEVECTOR3 vGradFrom = Gradient(vLocal, iFrom);
+      UINT64VECTOR3 vLocalTo = vLocal; vLocalTo[axis] += 1;
+      const DOUBLEVECTOR3 vGradTo = Gradient(vLocalTo, iTo);
+      FLOATVECTOR3 vNormal(vGradFrom + d * (vGradTo - vGradFrom));
+      vNormal.normalize(EPSILON);
+
+      const uint32_t iVertex = uint32_t(m_mesh.vertices.size());
+      m_mesh.vertices.push_back(vVertex);
+      m_mesh.normals.push_back(vNormal);
+
+      bool bSeam = false;
+      for(unsigned a=0; a < 3; ++a) {
+        if(a == axis) continue;
+        bSeam |= (vOwned[a] == 0 && m_bLowSeam[a]) ||
+                 (vOwned[a] == m_cells[a] && m_bHighSeam[a]);
+      }
+      if(bSeam) {
+        const uint64_t iEdge = axis + 3 * (vGlobal.x + m_vDomainSize.x *
+                                          (vGlobal.y + m_vDomainSize.y *
+                                           vGlobal.z));
+        m_mesh.seams.push_back(std::make_pair(iVertex, iEdge));
+      }
+      return iVertex;
+    }
+
+    // central differences; one-sided (three point form) at the data's edge
+    double Derivative(size_t iIndex, uint64_t iPos, uint64_t iSize,
+                      size_t iStride) const {
+      const T* p = m_pData + iIndex;
+      if(iSize < 2) return 0.0;
+      if(iPos == 0) {
+        return iSize < 3 ? double(p[iStride]) - double(p[0])
+                         : 0.5 * (-3.0 * double(p[0]) +
+                                   4.0 * double(p[iStride]) -
+                                   double(p[2*iStride]));
+      }
+      if(iPos == iSize-1) {
+        return iSize < 3 ? double(p[0]) - double(p[-ptrdiff_t(iStride)])
+                         : 0.5 * (3.0 * double(p[0]) -
+                                  4.0 * double(p[-ptrdiff_t(iStride)]) +
+                                  double(p[-2*ptrdiff_t(iStride)]));
+      }
+      return 0.5 * (double(p[iStride]) - double(p[-ptrdiff_t(iStride)]));
+    }
+
+    DOUBLEVECTOR3 Gradient(const UINT64VECTOR3& vLocal, size_t iIndex) const {
+      return DOUBLEVECTOR3(
+        Derivative(iIndex, vLocal.x, m_brick.vVoxels.x, m_stride[0]),
+        Derivative(iIndex, vLocal.y, m_brick.vVoxels.y, m_stride[1]),
+        Derivative(iIndex, vLocal.z, m_brick.vVoxels.z, m_stride[2])
+      );
+    }
+
+    const T* m_pData;
+    const BrickExtent& m_brick;
+    const UINT64VECTOR3 m_vDomainSize;
+    const T m_isovalue;
+    BrickMesh& m_mesh;
+    size_t m_stride[3];
+    uint64_t m_cells[3];
+    bool m_bLowSeam[3];
+    bool m_bHighSeam[3];
+    /// vertices on the edges of the current layer's two planes (x and y
+    /// edges) and between them (z edges, slot 0 only).
+    std::vector<uint32_t> m_cache[3][2];
+  };
+}
+
+template<class T> void March(const T* pData, const BrickExtent& brick,
+                             const UINT64VECTOR3& vDomainSize, T isovalue,
+                             BrickMesh& mesh) {
+  Marcher<T>(pData, brick, vDomainSize, isovalue, mesh).Run();
+}
+
+template void March(const int8_t*, const BrickExtent&, const UINT64VECTOR3&,
+                    int8_t, BrickMesh&);
+template void March(const uint8_t*, const BrickExtent&, const UINT64VECTOR3&,
+                    uint8_t, BrickMesh&);
+template void March(const int16_t*, const BrickExtent&, const UINT64VECTOR3&,
+                    int16_t, BrickMesh&);
+template void March(const uint16_t*, const BrickExtent&, const UINT64VECTOR3&,
+                    uint16_t, BrickMesh&);
+template void March(const int32_t*, const BrickExtent&, const UINT64VECTOR3&,
+                    int32_t, BrickMesh&);
+template void March(const uint32_t*, const BrickExtent&, const UINT64VECTOR3&,
+                    uint32_t, BrickMesh&);
+template void March(const float*, const BrickExtent&, const UINT64VECTOR3&,
+                    float, BrickMesh&);
+template void March(const double*, const BrickExtent&, const UINT64VECTOR3&,
+                    double, BrickMesh&);
+
+Welder::Welder(const UINT64VECTOR3& vDomainSize,
+               const std::vector<uint64_t> vStarts[3], MeshSink& sink,
+               uint32_t iFirstVertex) :
+  m_vDomainSize(vDomainSize),
+  m_sink(sink),
+  m_iVertices(iFirstVertex)
+{
+  for(size_t a=0; a < 3; ++a) { m_vStarts[a] = vStarts[a]; }
+}
+
+uint64_t Welder::LastUser(uint64_t iEdge) const {
+  // the cells around an edge start at its lower end or one before it; the
+  // one at the lower end belongs to the brick with the largest index.
+  uint64_t iPos = iEdge / 3;
+  uint64_t iBrick = 0;
+  uint64_t iScale = 1;
+  for(size_t a=0; a < 3; ++a) {
+    uint64_t p = iPos % m_vDomainSize[a];
+    iPos /= m_vDomainSize[a];
+    if(p + 1 >= m_vDomainSize[a] && p > 0) --p;
+    const uint64_t b = uint64_t(std::upper_bound(m_vStarts[a].begin(),
+                                                 m_vStarts[a].end(), p) -
+                                m_vStarts[a].begin()) - 1;
+    iBrick += b * iScale;
+    iScale *= m_vStarts[a].size();
+  }
+  return iBrick;
+}
+
+bool Welder::Add(uint64_t iBrick, const BrickMesh& mesh) {
+  std::vector<uint32_t> remap(mesh.vertices.size(), NoVertex);
+  for(auto s = mesh.seams.cbegin(); s != mesh.seams.cend(); ++s) {
+    auto known = m_seams.find(s->second);
+    if(known != m_seams.end()) { remap[s->first] = known->second; }
+  }
+
+  VertVec vertices;
+  NormVec normals;
+  vertices.reserve(mesh.vertices.size());
+  normals.reserve(mesh.vertices.size());
+  for(size_t i=0; i < remap.size(); ++i) {
+    if(remap[i] != NoVertex) continue;
+    remap[i] = m_iVertices++;
+    vertices.push_back(mesh.vertices[i]);
+    normals.push_back(mesh.normals[i]);
+  }
+  for(auto s = mesh.seams.cbegin(); s != mesh.seams.cend(); ++s) {
+    if(m_seams.insert(std::make_pair(s->second, remap[s->first])).second) {
+      m_expiry[LastUser(s->second)].push_back(s->second);
+    }
+  }
+
+  IndexVec triangles(mesh.triangles.size());
+  for(size_t i=0; i < triangles.size(); ++i) {
+    triangles[i] = remap[mesh.triangles[i]];
+  }
+  if(!m_sink.Append(vertices, normals, triangles)) { return false; }
+
+  while(!m_expiry.empty() && m_expiry.begin()->first <= iBrick) {
+    const std::vector<uint64_t>& edges = m_expiry.begin()->second;
+    for(auto e = edges.cbegin(); e != edges.cend(); ++e) { m_seams.erase(*e); }
+    m_expiry.erase(m_expiry.begin());
+  }
+  return true;
+}
+
+} // namespace iso
+
+namespace {
+  template<class T>
+  bool Extract(const UVFDataset& ds, uint64_t iLOD, double fIsovalue,
+               const FLOATVECTOR3& vScale, MeshSink& sink) {
+    const T isovalue = T(fIsovalue);
+    const size_t lod = size_t(iLOD);
+#ifdef _OPENMP
+    const size_t iBatch = size_t(omp_get_max_threads());
+#else
+    const size_t iBatch = 1;
+#endif
+    uint32_t iVertices = 0;
+
+    for(size_t ts=0; ts < size_t(ds.GetNumberOfTimesteps()); ++ts) {
+      const UINT64VECTOR3 vDomainSize = ds.GetDomainSize(lod, ts);
+      const UINTVECTOR3 vLayout = ds.GetBrickLayout(lod, ts);
+      const UINTVECTOR3 vOverlap = ds.GetBrickOverlapSize();
+
+      // where each row/column/slice of bricks starts
+      std::vector<uint64_t> vStarts[3];
+      for(size_t a=0; a < 3; ++a) {
+        uint64_t iStart = 0;
+        for(unsigned b=0; b < vLayout[a]; ++b) {
+          UINTVECTOR3 vBrick(0,0,0);
+          vBrick[a] = b;
+          const BrickKey k(ts, lod, vBrick.x + vLayout.x *
+                                    (vBrick.y + vLayout.y * vBrick.z));
+          vStarts[a].push_back(iStart);
+          iStart += ds.GetEffectiveBrickSize(k)[a];
+        }
+      }
+
+      // (min <= iso <= max) is what a brick with a surface cell needs.  The
+      // cells are classified with the isovalue in the data's type, so that
+      // is what the min/max are compared with, too.
+      std::vector<BrickKey> keys;
+      for(size_t b=0; b < vLayout.volume(); ++b) {
+        const BrickKey k(ts, lod, b);
+        if(ds.ContainsData(k, double(isovalue), double(isovalue))) {
+          keys.push_back(k);
+        }
+      }
+      MESSAGE("Extracting isosurface from %u of %u bricks of timestep %u",
+              unsigned(keys.size()), unsigned(vLayout.volume()),
+              unsigned(ts));
+
+      const FLOATVECTOR3 vExtent = FLOATVECTOR3(vDomainSize) * vScale;
+      const float fMaxSize = vExtent.maxVal();
+
+      iso::Welder welder(vDomainSize, vStarts, sink, iVertices);
+      for(size_t iFirst=0; iFirst < keys.size(); iFirst += iBatch) {
+        const std::vector<BrickKey> batch(
+          keys.begin() + iFirst,
+          keys.begin() + std::min(iFirst + iBatch, keys.size())
+        );
+        std::vector<std::vector<T>> data(batch.size());
+        if(!ds.GetBricks(batch, [&](size_t i, std::vector<T>& vData) {
+                               data[i].swap(vData);
+                               return true;
+                             })) {
+          T_ERROR("Reading bricks failed.");
+          return false;
+        }
+
+        std::vector<iso::BrickMesh> meshes(batch.size());
+        bool bOK = true;
+#pragma omp parallel for schedule(dynamic)
+        for(int i=0; i < int(batch.size()); ++i) {
+          const BrickKey& k = batch[i];
+          const size_t iBrick = std::get<2>(k);
+          const UINTVECTOR3 vBrick(
+            unsigned(iBrick % vLayout.x),
+            unsigned((iBrick / vLayout.x) % vLayout.y),
+            unsigned(iBrick / (vLayout.x * vLayout.y))
+          );
+          iso::BrickExtent extent;
+          extent.vVoxels = UINT64VECTOR3(ds.GetBrickVoxelCounts(k));
+          extent.vOwned = ds.GetEffectiveBrickSize(k);
+          for(size_t a=0; a < 3; ++a) {
+            extent.vFirst[a] = vStarts[a][vBrick[a]];
+            // raster data blocks split the overlap between neighbors and
+            // have none at the volume's boundary.
+            extent.vGhost[a] = ds.IsTOCBlock() ? vOverlap[a] :
+                               (vBrick[a] > 0 ? vOverlap[a]/2 : 0);
+          }
+          if(data[i].size() < extent.vVoxels.volume()) {
+            bOK = false;
+            continue;
+          }
+
+          iso::March(&data[i][0], extent, vDomainSize, isovalue, meshes[i]);
+          std::vector<T>().swap(data[i]);
+
+          VertVec& vertices = meshes[i].vertices;
+          for(size_t v=0; v < vertices.size(); ++v) {
+            vertices[v] = (vertices[v] * vScale - vExtent / 2.0f) / fMaxSize;
+          }
+        }
+        if(!bOK) {
+          T_ERROR("Brick data are smaller than the brick.");
+          return false;
+        }
+
+        for(size_t i=0; i < batch.size(); ++i) {
+          if(!welder.Add(std::get<2>(batch[i]), meshes[i])) {
+            T_ERROR("Writing the mesh failed.");
+            return false;
+          }
+        }
+      }
+      iVertices = welder.Vertices();
+    }
+    return true;
+  }
+}
+
+bool ExtractIsosurface(const UVFDataset& ds, uint64_t iLOD, double fIsovalue,
+                       const FLOATVECTOR3& vScale, MeshSink& sink) {
+  if(ds.GetComponentCount() != 1) {
+    T_ERROR("Isosurface extraction only supported for scalar volumes.");
+    return false;
+  }
+
+  if(ds.GetIsFloat()) {
+    switch(ds.GetBitWidth()) {
+      case 32: return Extract<float>(ds, iLOD, fIsovalue, vScale, sink);
+      case 64: return Extract<double>(ds, iLOD, fIsovalue, vScale, sink);
+    }
+  } else if(ds.GetIsSigned()) {
+    switch(ds.GetBitWidth()) {
+      case  8: return Extract<int8_t>(ds, iLOD, fIsovalue, vScale, sink);
+      case 16: return Extract<int16_t>(ds, iLOD, fIsovalue, vScale, sink);
+      case 32: return Extract<int32_t>(ds, iLOD, fIsovalue, vScale, sink);
+    }
+  } else {
+    switch(ds.GetBitWidth()) {
+      case  8: return Extract<uint8_t>(ds, iLOD, fIsovalue, vScale, sink);
+      case 16: return Extract<uint16_t>(ds, iLOD, fIsovalue, vScale, sink);
+      case 32: return Extract<uint32_t>(ds, iLOD, fIsovalue, vScale, sink);
+    }
+  }
+  T_ERROR("Unsupported data format.");
+  return false;
+}
+
+}
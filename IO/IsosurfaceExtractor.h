@@ -0,0 +1,113 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_ISOSURFACEEXTRACTOR_H
+#define TUVOK_ISOSURFACEEXTRACTOR_H
+
+#include "StdTuvokDefines.h"
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Basics/Vectors.h"
+#include "AbstrGeoConverter.h"
+
+namespace tuvok {
+
+class UVFDataset;
+
+/// Extracts the isosurface at 'fIsovalue' from LOD 'iLOD' of every timestep
+/// and writes it to 'sink'.  Bricks whose min/max rule out the isovalue are
+/// never read; the rest are marched in parallel and their meshes are joined
+/// without duplicate vertices along the brick boundaries.  As when
+/// rendering, the mesh is centered at the origin and its largest (scaled)
+/// extent is 1.
+bool ExtractIsosurface(const UVFDataset& ds, uint64_t iLOD, double fIsovalue,
+                       const FLOATVECTOR3& vScale, MeshSink& sink);
+
+namespace iso {
+
+/// Where a brick lies in the volume, in voxels of its LOD.  Each brick owns
+/// the cells whose first corner is one of its (non-ghost) voxels.
+struct BrickExtent {
+  UINT64VECTOR3 vVoxels; ///< size of the brick's data, ghost voxels included
+  UINT64VECTOR3 vGhost;  ///< ghost voxels in front of the first owned one
+  UINT64VECTOR3 vFirst;  ///< position of the first owned voxel in the volume
+  UINT64VECTOR3 vOwned;  ///< number of owned voxels
+};
+
+/// The part of the surface in one brick.  Positions are in voxels of the
+/// volume.
+struct BrickMesh {
+  VertVec vertices;
+  NormVec normals;
+  IndexVec triangles;
+  /// vertices on a face shared with another brick, paired with the id of
+  /// the volume edge they lie on.
+  std::vector<std::pair<uint32_t, uint64_t>> seams;
+};
+
+/// marches the cells the brick owns.
+template<class T> void March(const T* pData, const BrickExtent& brick,
+                             const UINT64VECTOR3& vDomainSize, T isovalue,
+                             BrickMesh& mesh);
+
+/// Joins brick meshes, sharing the vertices on brick boundaries, and passes
+/// them on to a sink.  Only seam vertices are remembered, and only until the
+/// last brick which can use them has been added.
+class Welder {
+public:
+  /// @param vStarts first voxel of each brick along x, y and z
+  /// @param iFirstVertex number of vertices the sink already has
+  Welder(const UINT64VECTOR3& vDomainSize,
+         const std::vector<uint64_t> vStarts[3], MeshSink& sink,
+         uint32_t iFirstVertex=0);
+
+  /// Bricks must be added in the order of their linear index (x fastest).
+  bool Add(uint64_t iBrick, const BrickMesh& mesh);
+
+  /// @returns the number of vertices passed on so far
+  uint32_t Vertices() const { return m_iVertices; }
+
+private:
+  /// @returns the linear index of the last brick which can use the edge
+  uint64_t LastUser(uint64_t iEdge) const;
+
+  UINT64VECTOR3 m_vDomainSize;
+  std::vector<uint64_t> m_vStarts[3];
+  MeshSink& m_sink;
+  uint32_t m_iVertices;
+  std::unordered_map<uint64_t, uint32_t> m_seams; ///< edge id -> vertex
+  std::map<uint64_t, std::vector<uint64_t>> m_expiry; ///< brick -> edges
+};
+
+}
+}
+
+#endif // TUVOK_ISOSURFACEEXTRACTOR_H
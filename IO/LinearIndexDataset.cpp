@@ -37,6 +37,62 @@ UINTVECTOR4 LinearIndexDataset::IndexTo4D(const BrickKey& key) const {
   assert(rv[2] < layout[2]);
   return rv;
 }
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<uint8_t>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<int8_t>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<uint16_t>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<int16_t>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<uint32_t>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<int32_t>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<float>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
+
+bool LinearIndexDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<double>&)>& f
+) const {
+  return GetBricksOneByOne(keys, f);
+}
 }
 /*
    For more information, please see: http://software.sci.utah.edu
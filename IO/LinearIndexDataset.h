@@ -1,6 +1,8 @@
 #ifndef TUVOK_LINEAR_INDEX_DATASET_H
 #define TUVOK_LINEAR_INDEX_DATASET_H
 
+#include <functional>
+#include <vector>
 #include "BrickedDataset.h"
 
 namespace tuvok {
@@ -24,6 +26,52 @@ class LinearIndexDataset : public BrickedDataset {
     virtual BrickKey IndexFrom4D(const UINTVECTOR4& four,
                                  size_t timestep) const;
     virtual UINTVECTOR4 IndexTo4D(const BrickKey& key) const;
+
+    /// Reads many bricks at once.  f(i, data) is called for every brick with
+    /// its position 'i' in 'keys'; f may keep the data by swapping it out of
+    /// the vector.  Bricks arrive in whatever order is cheapest to read, not
+    /// necessarily in the order of 'keys'.  If f returns false, the remaining
+    /// bricks are skipped.  By default this just calls GetBrick for each key.
+    /// @returns false if a brick could not be read.
+    ///@{
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<uint8_t>&)>& f) const;
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<int8_t>&)>& f) const;
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<uint16_t>&)>& f) const;
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<int16_t>&)>& f) const;
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<uint32_t>&)>& f) const;
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<int32_t>&)>& f) const;
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<float>&)>& f) const;
+    virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<double>&)>& f) const;
+    ///@}
+
+  protected:
+    template<typename T>
+    bool GetBricksOneByOne(const std::vector<BrickKey>& keys,
+                           const std::function<bool(size_t,
+                                                    std::vector<T>&)>& f) const {
+      std::vector<T> data;
+      for(size_t i=0; i < keys.size(); ++i) {
+        if(!this->GetBrick(keys[i], data)) { return false; }
+        if(!f(i, data)) { break; }
+      }
+      return true;
+    }
 };
 
 }
@@ -420,6 +420,11 @@ bool NRRDConverter::ConvertToRAW(const std::string& strSourceFilename,
       } else
       if (kvpEncoding->strValueUpper == "GZ" || kvpEncoding->strValueUpper == "GZIP")  {
         MESSAGE("NRRD data is GZIP compressed RAW format.");
+        if (KeepCompressed(tuvok::RE_GZIP)) {
+          strIntermediateFile = strRAWFile;
+          bDeleteIntermediateFile = false;
+          return true;
+        }
 
         string strUncompressedFile = strTempDir+SysTools::GetFilename(strSourceFilename)+".uncompressed";
         bool bResult = ExtractGZIPDataset(strRAWFile, strUncompressedFile, iHeaderSkip);
@@ -430,6 +435,11 @@ bool NRRDConverter::ConvertToRAW(const std::string& strSourceFilename,
       } else
       if (kvpEncoding->strValueUpper == "BZ" || kvpEncoding->strValueUpper == "BZIP2")  {
         MESSAGE("NRRD data is BZIP2 compressed RAW format.");
+        if (KeepCompressed(tuvok::RE_BZIP2)) {
+          strIntermediateFile = strRAWFile;
+          bDeleteIntermediateFile = false;
+          return true;
+        }
 
         string strUncompressedFile = strTempDir+SysTools::GetFilename(strSourceFilename)+".uncompressed";
         bool bResult = ExtractBZIP2Dataset(strRAWFile, strUncompressedFile, iHeaderSkip);
@@ -37,6 +37,7 @@
 #include "SysTools.h"
 #include "Mesh.h"
 #include <fstream>
+#include "TextSpan.h"
 #include "TuvokIOError.h"
 
 using namespace tuvok;
@@ -49,21 +50,193 @@ OBJGeoConverter::OBJGeoConverter() :
   m_vSupportedExt.push_back("OBJX");
 }
 
-inline int OBJGeoConverter::CountOccurences(const std::string& str, const std::string& substr) {
-  size_t found = str.find_first_of(substr);
-  int count = 0;
-  while (found!=std::string::npos)
-  {
-    count++;
-    found=str.find_first_of(substr,found+1);
+namespace {
+  /// What a piece of an OBJ file holds, in the order the file has it.
+  struct OBJPiece {
+    OBJPiece() : iBrokenVertices(0), iObjects(0), iMaterials(0),
+                 iPoints(0), iBadPolygons(0) {}
+
+    VertVec      vertices;
+    NormVec      normals;
+    TexCoordVec  texcoords;
+    ColorVec     colors;
+    PolygonList  polygons;
+
+    // what was skipped, for the warnings
+    size_t iBrokenVertices, iObjects, iMaterials, iPoints, iBadPolygons;
+    std::vector<std::pair<std::string, size_t>> unknownTags;
+  };
+
+  // a quick look at the tags, to size the piece's arrays
+  void ReserveOBJ(TextSpan text, OBJPiece& piece) {
+    size_t iVertices = 0, iNormals = 0, iTexCoords = 0, iColors = 0;
+    size_t iPolygons = 0;
+    TextSpan line;
+    while (text.PopLine(line)) {
+      line = line.Trimmed();
+      const TextSpan linetype = line.PopToken();
+      if (linetype.Is("v")) iVertices++;
+      else if (linetype.Is("vn")) iNormals++;
+      else if (linetype.Is("vt")) iTexCoords++;
+      else if (linetype.Is("vc")) iColors++;
+      else if (linetype.Is("f") || linetype.Is("l")) iPolygons++;
+    }
+    piece.vertices.reserve(iVertices);
+    piece.normals.reserve(iNormals);
+    piece.texcoords.reserve(iTexCoords);
+    piece.colors.reserve(iColors);
+    piece.polygons.Reserve(iPolygons);
+  }
+
+  void ParseOBJ(TextSpan text, const NumberParser& num, OBJPiece& piece) {
+    ReserveOBJ(text, piece);
+
+    IndexVec v, n, t, c;
+    TextSpan pos[7];
+    TextSpan line;
+    while (text.PopLine(line)) {
+      // remove comments
+      line = line.Trimmed().UpTo('#').Trimmed();
+      if (line.empty()) continue; // skips empty and comment lines
+
+      // find the linetype
+      const TextSpan linetype = line.PopToken();
+      if (line.empty()) continue;
+
+      if (linetype.Is("o")) {
+        piece.iObjects++;
+      } else
+      if (linetype.Is("mtllib")) {
+        piece.iMaterials++;
+      } else
+      if (linetype.Is("v")) { // vertex attrib found
+        size_t iCoords = 0;
+        for (TextSpan word = line.PopWord();!word.empty();
+             word = line.PopWord()) {
+          if (iCoords < 7) pos[iCoords] = word;
+          iCoords++;
+        }
+
+        float x,y,z;
+        if (iCoords < 3) {
+          piece.iBrokenVertices++;
+          x = (iCoords > 0) ? num.StreamFloat(pos[0]) : 0.0f;
+          y = (iCoords > 1) ? num.StreamFloat(pos[1]) : 0.0f;
+          z = 0.0f;
+        } else {
+          x = num.StreamFloat(pos[0]);
+          y = num.StreamFloat(pos[1]);
+          z = num.StreamFloat(pos[2]);
+
+          if (iCoords >= 6) {
+            // this is a "meshlab extended" obj file that includes vertex colors
+            float r = num.StreamFloat(pos[3]);
+            float g = num.StreamFloat(pos[4]);
+            float b = num.StreamFloat(pos[5]);
+            float a = (iCoords > 6) ? num.StreamFloat(pos[6]) : 1.0f;
+            piece.colors.push_back(FLOATVECTOR4(r,g,b,a));
+          } else if (iCoords > 3) {
+            // file specifies homogeneous coordinate
+            float w = num.StreamFloat(pos[3]);
+            if (w != 0) {
+              x /= w;
+              y /= w;
+              z /= w;
+            }
+          }
+        }
+        piece.vertices.push_back(FLOATVECTOR3(x,y,z));
+      } else
+      if (linetype.Is("vt")) {  // vertex texcoord found
+        float x = float(num.Atof(line.PopToken()));
+        float y = float(num.Atof(line.PopToken()));
+        piece.texcoords.push_back(FLOATVECTOR2(x,y));
+      } else
+      if (linetype.Is("vc")) {  // vertex color found
+        float x = float(num.Atof(line.PopToken()));
+        float y = float(num.Atof(line.PopToken()));
+        float z = float(num.Atof(line.PopToken()));
+        float w = float(num.Atof(line.PopToken()));
+        piece.colors.push_back(FLOATVECTOR4(x,y,z,w));
+      } else
+      if (linetype.Is("vn")) { // vertex normal found
+        float x = float(num.Atof(line.PopToken()));
+        float y = float(num.Atof(line.PopToken()));
+        float z = float(num.Atof(line.PopToken()));
+        FLOATVECTOR3 normal(x,y,z);
+        normal.normalize();
+        piece.normals.push_back(normal);
+      } else
+      if (linetype.Is("f") || linetype.Is("l")) { // face or line found
+        // the first vertex tells how all of them are given
+        TextSpan rest = line;
+        const size_t count = rest.PopToken().Count('/');
+        if (rest.empty()) continue;
+        if (count > 3) {
+          piece.iBadPolygons++;
+          continue;
+        }
+
+        v.clear(); n.clear(); t.clear(); c.clear();
+        while (!line.empty()) {
+          switch (count) {
+            case 0 :
+              v.push_back(num.Atoi(line.PopToken())-1);
+              break;
+            case 1 :
+              // as it always was, this skips every other vertex
+              v.push_back(num.Atoi(line.PopToken('/'))-1);
+              t.push_back(num.Atoi(line.PopToken())-1);
+              line.SkipToken();
+              break;
+            case 2 :
+              v.push_back(num.Atoi(line.PopToken('/'))-1);
+              if (line.front() != '/') {
+                t.push_back(num.Atoi(line.PopToken('/'))-1);
+              } else line.SkipToken('/');
+              n.push_back(num.Atoi(line.PopToken())-1);
+              break;
+            case 3 :
+              v.push_back(num.Atoi(line.PopToken('/'))-1);
+              if (line.front() != '/') {
+                t.push_back(num.Atoi(line.PopToken('/'))-1);
+              } else line.SkipToken('/');
+              if (line.front() != '/') {
+                n.push_back(num.Atoi(line.PopToken('/'))-1);
+              } else line.SkipToken('/');
+              c.push_back(num.Atoi(line.PopToken())-1);
+              break;
+          }
+        }
+
+        if (v.size() == 1) {
+          piece.iPoints++;
+          continue;
+        }
+        piece.polygons.Add(v,n,t,c);
+      } else {
+        size_t i = 0;
+        while (i<piece.unknownTags.size() &&
+               !linetype.Is(piece.unknownTags[i].first.c_str())) i++;
+        if (i == piece.unknownTags.size()) {
+          piece.unknownTags.push_back(
+            std::make_pair(SysTools::ToLowerCase(linetype.str()), size_t(0))
+          );
+        }
+        piece.unknownTags[i].second++;
+      }
+    }
+  }
+
+  template<typename T>
+  void Append(std::vector<T>& all, std::vector<T>& piece) {
+    all.insert(all.end(), piece.begin(), piece.end());
+    std::vector<T>().swap(piece);
   }
-  return count;
 }
 
 std::shared_ptr<Mesh>
 OBJGeoConverter::ConvertToMesh(const std::string& strFilename) {
-  bool bFlipVertices = false;
-
   VertVec       vertices;
   NormVec       normals;
   TexCoordVec   texcoords;
@@ -74,191 +247,98 @@ OBJGeoConverter::ConvertToMesh(const std::string& strFilename) {
   IndexVec      TCIndices;
   IndexVec      COLIndices;
 
-	std::ifstream fs;
-	std::string line;
-
-	fs.open(strFilename.c_str());
-  if (fs.fail()) {
-    // hack, we really want some kind of 'file not found' exception.
-    throw tuvok::io::DSOpenFailed(strFilename.c_str(), __FILE__, __LINE__);
+  const MappedTextFile file(strFilename);
+  const NumberParser num;
+
+  // pieces are parsed on their own, and then put together in order.
+  const std::vector<TextSpan> text = SplitLines(file.Text());
+  std::vector<OBJPiece> pieces(text.size());
+  MESSAGE("Reading %u kb in %u pieces", unsigned(file.Text().size()/1024),
+          unsigned(text.size()));
+  const int64_t iPieces = int64_t(text.size());
+#pragma omp parallel for schedule(dynamic)
+  for (int64_t i = 0;i<iPieces;i++) {
+    ParseOBJ(text[size_t(i)], num, pieces[size_t(i)]);
   }
 
-  float x,y,z,w;
+  MESSAGE("Creating Mesh Object");
+  size_t iVertices = 0, iNormals = 0, iTexCoords = 0, iColors = 0;
   size_t iVerticesPerPoly = 0;
-
-  fs.seekg(0,std::ios::end);
-  std::streamoff iFileLength = fs.tellg();
-  fs.seekg(0,std::ios::beg);
-  size_t iBytesRead = 0;
-  size_t iLine = 0;
-
-  while (!fs.fail()) {
-		getline(fs, line);
-
-    iBytesRead += line.size() + 1;
-    iLine++;
-
-		if (fs.fail()) break; // no more lines to read
-    line = SysTools::ToLowerCase(SysTools::TrimStr(line));
-
-    // remove comments
-    size_t cPos = line.find_first_of('#');
-    if (cPos != std::string::npos) line = line.substr(0,cPos);
-    line = SysTools::TrimStr(line);
-    if (line.length() == 0) continue; // skips empty and comment lines
-
-    // find the linetype
-    size_t off = line.find_first_of(" \r\n\t");
-    if (off == std::string::npos) continue;
-    std::string linetype = SysTools::TrimStrRight(line.substr(0,off));
-
-    line = SysTools::TrimStr(line.substr(linetype.length()));
-
-    if (linetype == "o") { 
-      WARNING("Skipping Object Tag in OBJ file");
-    } else
-    if (linetype == "mtllib") { 
-      WARNING("Skipping Material Library Tag in OBJ file");
-    } else
-		if (linetype == "v") { // vertex attrib found
-      std::vector< std::string > pos = SysTools::Tokenize(line, SysTools::PM_NONE);
-
-      if (pos.size() < 3) {
-        WARNING("Found broken v tag (to few coordinates, "
-                "filling with zeroes");
-        x = (pos.size() > 0) ? SysTools::FromString<float>(pos[0]) : 0.0f;
-	      y = (pos.size() > 1) ? SysTools::FromString<float>(pos[1]) : 0.0f;
-	      z = 0.0f;
-      } else {
-        x = SysTools::FromString<float>(pos[0]);
-	      y = SysTools::FromString<float>(pos[1]);
-	      z = SysTools::FromString<float>(pos[2]);
-
-        if (pos.size() >= 6) {
-          // this is a "meshlab extended" obj file that includes vertex colors
-	        float r = SysTools::FromString<float>(pos[3]);
-	        float g = SysTools::FromString<float>(pos[4]);
-	        float b = SysTools::FromString<float>(pos[5]);
-          float a = (pos.size() > 6) ? SysTools::FromString<float>(pos[6]):1.0f;
-          colors.push_back(FLOATVECTOR4(r,g,b,a));
-        } else if (pos.size() > 3) {
-          // file specifies homogeneous coordinate
-	        float w = SysTools::FromString<float>(pos[3]);
-          if (w != 0) {
-            x /= w;
-            y /= w;
-            z /= w;
-          }
-        }
-      }
-      vertices.push_back(FLOATVECTOR3(x,y,(bFlipVertices) ? -z : z));
-
-  	} else
-	  if (linetype == "vt") {  // vertex texcoord found
-      x = float(atof(GetToken(line).c_str()));
-			y = float(atof(GetToken(line).c_str()));
-			texcoords.push_back(FLOATVECTOR2(x,y));
-		} else
-	  if (linetype == "vc") {  // vertex color found
-      x = float(atof(GetToken(line).c_str()));
-			y = float(atof(GetToken(line).c_str()));
-			z = float(atof(GetToken(line).c_str()));
-			w = float(atof(GetToken(line).c_str()));
-			colors.push_back(FLOATVECTOR4(x,y,z,w));
-		} else
-    if (linetype == "vn") { // vertex normal found
-      x = float(atof(GetToken(line).c_str()));
-			y = float(atof(GetToken(line).c_str()));
-			z = float(atof(GetToken(line).c_str()));
-      FLOATVECTOR3 n(x,y,z);
-      n.normalize();
-      normals.push_back(n);
-		} else
-    if (linetype == "f" || linetype == "l") { // face or line found
-      size_t off = line.find_first_of(" \r\n\t");
-      if (off == std::string::npos) continue;
-      std::string analysis = SysTools::TrimStrRight(line.substr(0,off));
-      int count = CountOccurences(analysis,"/");
-
-      IndexVec v, n, t, c;
-      
-      while (line.length() > 0)  {
-        switch (count) {
-          case 0 : {
-                int vI = atoi(GetToken(line).c_str())-1;
-                v.push_back(vI);
-                break;
-               }
-          case 1 : {
-                int vI = atoi(GetToken(line,"/",true).c_str())-1;
-                v.push_back(vI);
-                int vT = atoi(GetToken(line).c_str())-1;
-                t.push_back(vT);
-                line = TrimToken(line);
-                break;
-               }
-          case 2 : {
-                int vI = atoi(GetToken(line,"/",true).c_str())-1;
-                v.push_back(vI);
-                if (line[0] != '/') {
-                  int vT = atoi(GetToken(line,"/",true).c_str())-1;
-                  t.push_back(vT);
-                }else line = TrimToken(line,"/",true);
-                int vN = atoi(GetToken(line).c_str())-1;
-                n.push_back(vN);
-                break;
-               }
-          case 3 : {
-                int vI = atoi(GetToken(line,"/",true).c_str())-1;
-                v.push_back(vI);
-                if (line[0] != '/') {
-                  int vT = atoi(GetToken(line,"/",true).c_str())-1;
-                  t.push_back(vT);
-                }else line = TrimToken(line,"/",true);
-                if (line[0] != '/') {
-                  int vN = atoi(GetToken(line,"/",true).c_str())-1;
-                  n.push_back(vN);
-                } else line = TrimToken(line,"/",true);
-                int vC = atoi(GetToken(line).c_str())-1;
-                c.push_back(vC);
-                break;
-               }
-        }
-        SysTools::TrimStrLeft(line);
-      }
-
-      if (v.size() == 1) {
-        WARNING("Skipping points in OBJ file");
-        continue;
-      }
-
-      if (iVerticesPerPoly == 0) iVerticesPerPoly = v.size();
-
-      if (v.size() == 2) {
-        if ( iVerticesPerPoly != 2 ) {
-          WARNING("Skipping a line in a file that also contains polygons");
-          continue;
-        }
-        AddToMesh(vertices,v,n,t,c,VertIndices,NormalIndices,TCIndices,COLIndices);
-      } else {
-        if ( iVerticesPerPoly == 2 ) {
-          WARNING("Skipping polygon in file that also contains lines");
-          continue;
-        }
-        AddToMesh(vertices,v,n,t,c,VertIndices,NormalIndices,TCIndices,COLIndices);
-      }
-
-    } else {
-      WARNING("Skipping unknown tag %s in OBJ file", linetype.c_str());
-    }
-
-    if (iLine % 5000 == 0) {
-      MESSAGE("Reading line %u (%u / %u kb)", unsigned(iLine),
-              unsigned(iBytesRead/1024),unsigned(iFileLength/1024));
+  for (size_t i = 0;i<pieces.size();i++) {
+    iVertices += pieces[i].vertices.size();
+    iNormals += pieces[i].normals.size();
+    iTexCoords += pieces[i].texcoords.size();
+    iColors += pieces[i].colors.size();
+    if (iVerticesPerPoly == 0)
+      iVerticesPerPoly = pieces[i].polygons.FirstVertexCount();
+  }
+  vertices.reserve(iVertices);
+  normals.reserve(iNormals);
+  texcoords.reserve(iTexCoords);
+  colors.reserve(iColors);
+
+  std::vector<PolygonList> polygons(pieces.size());
+  size_t iBrokenVertices = 0, iObjects = 0, iMaterials = 0, iPoints = 0;
+  size_t iBadPolygons = 0;
+  std::vector<std::pair<std::string, size_t>> unknownTags;
+  for (size_t i = 0;i<pieces.size();i++) {
+    OBJPiece& piece = pieces[i];
+    Append(vertices, piece.vertices);
+    Append(normals, piece.normals);
+    Append(texcoords, piece.texcoords);
+    Append(colors, piece.colors);
+    std::swap(polygons[i], piece.polygons);
+
+    iBrokenVertices += piece.iBrokenVertices;
+    iObjects += piece.iObjects;
+    iMaterials += piece.iMaterials;
+    iPoints += piece.iPoints;
+    iBadPolygons += piece.iBadPolygons;
+    for (size_t j = 0;j<piece.unknownTags.size();j++) {
+      size_t k = 0;
+      while (k<unknownTags.size() &&
+             unknownTags[k].first != piece.unknownTags[j].first) k++;
+      if (k == unknownTags.size())
+        unknownTags.push_back(std::make_pair(piece.unknownTags[j].first,
+                                             size_t(0)));
+      unknownTags[k].second += piece.unknownTags[j].second;
     }
-
   }
-	fs.close();
+  pieces.clear();
+
+  // the first polygon decides whether the file holds lines or polygons
+  const size_t iSkipped = AddToMesh(vertices, polygons,
+                                    (iVerticesPerPoly == 2) ? PF_LINES
+                                                            : PF_NO_LINES,
+                                    VertIndices, NormalIndices,
+                                    TCIndices, COLIndices);
+  polygons.clear();
+
+  if (iObjects)
+    WARNING("Skipping %u Object Tags in OBJ file", unsigned(iObjects));
+  if (iMaterials)
+    WARNING("Skipping %u Material Library Tags in OBJ file",
+            unsigned(iMaterials));
+  if (iBrokenVertices)
+    WARNING("Found %u broken v tags (too few coordinates), "
+            "filling with zeroes", unsigned(iBrokenVertices));
+  if (iPoints)
+    WARNING("Skipping %u points in OBJ file", unsigned(iPoints));
+  if (iBadPolygons)
+    WARNING("Skipping %u faces with more than three indices per vertex",
+            unsigned(iBadPolygons));
+  if (iSkipped) {
+    if (iVerticesPerPoly == 2)
+      WARNING("Skipping %u polygons in file that also contains lines",
+              unsigned(iSkipped));
+    else
+      WARNING("Skipping %u lines in a file that also contains polygons",
+              unsigned(iSkipped));
+  }
+  for (size_t i = 0;i<unknownTags.size();i++) {
+    WARNING("Skipping %u unknown tags %s in OBJ file",
+            unsigned(unknownTags[i].second), unknownTags[i].first.c_str());
+  }
 
   std::string desc = m_vConverterDesc + " data converted from " + SysTools::GetFilename(strFilename);
 
@@ -278,7 +358,6 @@ OBJGeoConverter::ConvertToMesh(const std::string& strFilename) {
   return m;
 }
 
-
 bool OBJGeoConverter::ConvertToNative(const Mesh& m,
                                       const std::string& strTargetFilename) {
 
@@ -392,3 +471,95 @@ bool OBJGeoConverter::ConvertToNative(const Mesh& m,
 
   return true;
 }
+
+namespace {
+  class OBJMeshSink : public MeshSink {
+  public:
+    OBJMeshSink(const std::string& strFilename, const std::string& strDesc) :
+      m_outStream(strFilename.c_str()),
+      m_iVertices(0),
+      m_iTriangles(0)
+    {
+      if (m_outStream.fail()) return;
+
+      // the counts are unknown until Close, so leave room for them.
+      const size_t iCount = std::max(strDesc.size(),
+                                     std::string("Primitives: ").size() +
+                                     ms_iDigits);
+
+      for (size_t i = 0;i<iCount+4;i++) m_outStream << "#";
+      m_outStream << std::endl;
+      m_outStream << "# " << strDesc;
+      for (size_t i = strDesc.size();i<iCount;i++) m_outStream << " ";
+      m_outStream << " #" << std::endl;
+
+      m_outStream << "# Vertices: ";
+      m_posVertices = m_outStream.tellp();
+      for (size_t i = std::string("Vertices: ").size();i<iCount;i++)
+        m_outStream << " ";
+      m_outStream << " #" << std::endl;
+
+      m_outStream << "# Primitives: ";
+      m_posTriangles = m_outStream.tellp();
+      for (size_t i = std::string("Primitives: ").size();i<iCount;i++)
+        m_outStream << " ";
+      m_outStream << " #" << std::endl;
+
+      for (size_t i = 0;i<iCount+4;i++) m_outStream << "#";
+      m_outStream << std::endl;
+    }
+
+    virtual bool Append(const VertVec& vertices, const NormVec& normals,
+                        const IndexVec& triangles) {
+      if (m_outStream.fail()) return false;
+
+      for (size_t i = 0;i<vertices.size();i++) {
+        m_outStream << "v "
+                    << vertices[i].x << " "
+                    << vertices[i].y << " "
+                    << vertices[i].z << "\n";
+      }
+      for (size_t i = 0;i<normals.size();i++) {
+        m_outStream << "vn "
+                    << normals[i].x << " "
+                    << normals[i].y << " "
+                    << normals[i].z << "\n";
+      }
+      for (size_t i = 0;i+2<triangles.size();i+=3) {
+        m_outStream << "f "
+                    << triangles[i+0]+1 << "//" << triangles[i+0]+1 << " "
+                    << triangles[i+1]+1 << "//" << triangles[i+1]+1 << " "
+                    << triangles[i+2]+1 << "//" << triangles[i+2]+1 << "\n";
+      }
+      m_iVertices += vertices.size();
+      m_iTriangles += triangles.size()/3;
+      return !m_outStream.fail();
+    }
+
+    virtual bool Close() {
+      if (m_outStream.fail()) return false;
+      m_outStream.seekp(m_posVertices);
+      m_outStream << m_iVertices;
+      m_outStream.seekp(m_posTriangles);
+      m_outStream << m_iTriangles;
+      m_outStream.close();
+      return !m_outStream.fail();
+    }
+
+  private:
+    static const size_t ms_iDigits = 20; ///< enough for any uint64_t
+    std::ofstream  m_outStream;
+    std::streampos m_posVertices;
+    std::streampos m_posTriangles;
+    uint64_t       m_iVertices;
+    uint64_t       m_iTriangles;
+  };
+}
+
+std::shared_ptr<MeshSink>
+OBJGeoConverter::CreateSink(const std::string& strTargetFilename,
+                            const std::string& strDesc,
+                            const FLOATVECTOR4&) {
+  // OBJ has no notion of a default color; OBJX colors are per vertex only.
+  return std::make_shared<OBJMeshSink>(strTargetFilename, strDesc);
+}
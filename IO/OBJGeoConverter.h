@@ -50,13 +50,15 @@ namespace tuvok {
       ConvertToMesh(const std::string& strFilename);
     virtual bool ConvertToNative(const Mesh& m,
                                  const std::string& strTargetFilename);
+    /// writes each piece as it arrives; only the counts in the header are
+    /// filled in at the end.
+    virtual std::shared_ptr<MeshSink> CreateSink(
+      const std::string& strTargetFilename, const std::string& strDesc,
+      const FLOATVECTOR4& vDefaultColor
+    );
 
     virtual bool CanExportData() const { return true; }
     virtual bool CanImportData() const { return true; }
-
-  protected:
-    int CountOccurences(const std::string& str, const std::string& substr);
-
   };
 }
 #endif // OBJGEOCONVERTER_H
@@ -37,6 +37,8 @@
 #include "SysTools.h"
 #include "Mesh.h"
 #include <fstream>
+#include <tuple>
+#include "TextSpan.h"
 #include "TuvokIOError.h"
 
 using namespace tuvok;
@@ -62,44 +64,26 @@ PLYGeoConverter::ConvertToMesh(const std::string& strFilename) {
   IndexVec      TCIndices;
   IndexVec      COLIndices;
 
-  std::ifstream fs;
-	std::string line;
+  const MappedTextFile file(strFilename);
+  TextSpan text = file.Text();
+  const NumberParser num;
 
-	fs.open(strFilename.c_str());
-  if (fs.fail()) {
-    throw tuvok::io::DSOpenFailed(strFilename.c_str(), __FILE__, __LINE__);
-  }
+  std::vector<std::pair<propType, vertexProp>> vertexProps;
+  std::vector<std::tuple<propType, propType, faceProp>> faceProps;
+  std::vector<std::pair<propType, edgeProp>> edgeProps;
 
   int iFormat = FORMAT_ASCII;
   int iReaderState = SEARCHING_MAGIC;
   size_t iVertexCount=0;
   size_t iFaceCount=0;
   size_t iLineCount=0;
-  bool bNormalsFound = false;
-  bool bTexCoordsFound = false;
-  bool bColorsFound = false;
 
   MESSAGE("Reading Header");
 
-  fs.seekg(0,std::ios::end);
-  streamoff iFileLength = fs.tellg();
-  fs.seekg(0,std::ios::beg);
-  size_t iBytesRead = 0;
-  size_t iLine = 0;
-
-	while (!fs.fail() && iReaderState < PARSING_VERTEX_DATA) {
-		getline(fs, line);
-		if (fs.fail()) break; // no more lines to read
-
-    iBytesRead += line.size() + 1;
-    iLine++;
-    if (iLine % 5000 == 0) {
-        MESSAGE("Reading Header (Line %u %u/%u kb)", unsigned(iLine),
-                unsigned(iBytesRead/1024),unsigned(iFileLength/1024));
-    }
-
+  TextSpan headerLine;
+	while (iReaderState < PARSING_VERTEX_DATA && text.PopLine(headerLine)) {
     // remove comments
-    line = SysTools::TrimStr(line);
+    string line = headerLine.Trimmed().str();
     if (line.length() == 0) continue; // skip empty lines
 
     // find the linetype
@@ -186,151 +170,209 @@ PLYGeoConverter::ConvertToMesh(const std::string& strFilename) {
     WARNING("found both, polygons and lines, in the file, ignoring lines");
   }
 
-  MESSAGE("Reading Vertices");
-
-  size_t iFacesFound = 0;
-  vertices.reserve(iVertexCount);
-  // parse data body of PLY file
-	while (!fs.fail() && iReaderState != PARSING_DONE) {
-		getline(fs, line);
-		if (fs.fail()) break; // no more lines to read
-
-    iBytesRead += line.size() + 1;
-    iLine++;
-    if (iLine % 5000 == 0) {
-      if (PARSING_VERTEX_DATA) 
-        MESSAGE("Reading Vertices (Line %u %u/%u kb)", unsigned(iLine),
-                unsigned(iBytesRead/1024),unsigned(iFileLength/1024));
-      else
-        MESSAGE("Reading Indices (Line %u %u/%u kb)", unsigned(iLine),
-                unsigned(iBytesRead/1024),unsigned(iFileLength/1024));
+  // Each line of the body is one vertex, face or edge, so counting the
+  // lines before a piece tells what it holds and where its data go.
+  if (iReaderState < PARSING_VERTEX_DATA) text = TextSpan();
+  const std::vector<TextSpan> pieces = SplitLines(text);
+  std::vector<uint64_t> firstLine(pieces.size()+1, 0);
+  const int64_t iPieces = int64_t(pieces.size());
+#pragma omp parallel for schedule(dynamic)
+  for (int64_t i = 0;i<iPieces;i++) {
+    firstLine[size_t(i)+1] = CountLines(pieces[size_t(i)]);
+  }
+  for (size_t i = 1;i<firstLine.size();i++) firstLine[i] += firstLine[i-1];
+  const uint64_t iLines = firstLine.back();
+
+  // the lines each element gets: the vertices end after iVertexCount of
+  // them (never, if that is 0), the faces after iFaceCount, and the edges
+  // once they added 2*iLineCount indices.
+  size_t iIndicesPerEdge = 0;
+  bool bEdgeColorsFound = false;
+  for (size_t i = 0;i<edgeProps.size();i++) {
+    switch (edgeProps[i].second) {
+      case EPROP_VERTEX1   :
+      case EPROP_VERTEX2   : iIndicesPerEdge++; break;
+      case EPROP_RED       :
+      case EPROP_GREEN     :
+      case EPROP_BLUE      :
+      case EPROP_OPACITY   :
+      case EPROP_INTENSITY : bEdgeColorsFound = true; break;
+      default: break;
     }
-
-
-    line = SysTools::TrimStr(line);
-
-    if (iReaderState == PARSING_VERTEX_DATA) {
-      FLOATVECTOR3 pos;
-      FLOATVECTOR3 normal(0,0,0);
-      FLOATVECTOR4 color(0,0,0,1);
-      
-      for (size_t i = 0;i<vertexProps.size();i++) {
-        string strValue = GetToken(line);
-
-
-        double fValue=0.0; int iValue=0;
-        if (vertexProps[i].first <= PROPT_DOUBLE) {
-          fValue = atof(strValue.c_str());
-          iValue = int(fValue);
-        } else {
-          iValue = atoi(strValue.c_str());
-          fValue = double(iValue);
-        }
-
-        switch (vertexProps[i].second) {
-          case VPROP_X         : pos.x = float(fValue); break;
-          case VPROP_Y         : pos.y = float(fValue); break;
-          case VPROP_Z         : pos.z = float(fValue); break;
-          case VPROP_NX        : bNormalsFound = true; normal.x = float(fValue); break;
-          case VPROP_NY        : bNormalsFound = true; normal.y = float(fValue); break;
-          case VPROP_NZ        : bNormalsFound = true; normal.z = float(fValue); break;
-          case VPROP_RED       : bColorsFound = true; color.x = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case VPROP_GREEN     : bColorsFound = true; color.y = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case VPROP_BLUE      : bColorsFound = true; color.z = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case VPROP_OPACITY   : bColorsFound = true; color.w = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case VPROP_INTENSITY : bColorsFound = true;                                 
-                                 color = (vertexProps[i].first <= PROPT_DOUBLE) ? FLOATVECTOR4(float(fValue),float(fValue),float(fValue),1.0f)
-                                                                                : FLOATVECTOR4(iValue/255.0f,iValue/255.0f,iValue/255.0f,1.0f);
-                                 break;
-          default: break;
-        }
+  }
+  uint64_t iVertexLines = iLines;
+  uint64_t iFaceLines = 0;
+  uint64_t iEdgeLines = 0;
+  if (iVertexCount > 0 && iVertexCount < iLines) {
+    iVertexLines = iVertexCount;
+    const uint64_t iRest = iLines - iVertexLines;
+    if (iFaceCount > 0) {
+      iFaceLines = std::min<uint64_t>(iFaceCount, iRest);
+    } else {
+      iEdgeLines = iRest;
+      if (iIndicesPerEdge == 0) {
+        if (iLineCount == 0) iEdgeLines = 1;
+      } else if (iLineCount > 0 && (2*iLineCount) % iIndicesPerEdge == 0) {
+        iEdgeLines = std::min<uint64_t>((2*iLineCount) / iIndicesPerEdge,
+                                        iRest);
       }
+    }
+  }
+  if (iEdgeLines == 0) bEdgeColorsFound = false;
 
-      vertices.push_back(pos);
-      if (bColorsFound) colors.push_back(color);
-      if (bNormalsFound) normals.push_back(normal);
+  bool bNormalsFound = false;
+  bool bTexCoordsFound = false;
+  bool bColorsFound = false;
+  for (size_t i = 0;i<vertexProps.size() && iVertexLines > 0;i++) {
+    switch (vertexProps[i].second) {
+      case VPROP_NX        :
+      case VPROP_NY        :
+      case VPROP_NZ        : bNormalsFound = true; break;
+      case VPROP_RED       :
+      case VPROP_GREEN     :
+      case VPROP_BLUE      :
+      case VPROP_OPACITY   :
+      case VPROP_INTENSITY : bColorsFound = true; break;
+      default: break;
+    }
+  }
 
-      if (vertices.size() == iVertexCount) {
-        iReaderState = (iFaceCount > 0) ? PARSING_FACE_DATA : PARSING_EDGE_DATA;
-        MESSAGE("Reading Faces");
-      }
-    } else if (iReaderState == PARSING_FACE_DATA) {
-
-      IndexVec v, n, t, c;
-      for (size_t i = 0;i<faceProps.size();i++) {
-        string strValue = GetToken(line);
-
-        double fValue=0.0; int iValue=0;
-        if (std::get<1>(faceProps[i]) <= PROPT_DOUBLE) {
-          fValue = atof(strValue.c_str());
-          iValue = static_cast<int>(fValue);
-        } else {
-          iValue = atoi(strValue.c_str());
-          fValue = static_cast<double>(iValue);
+  const size_t iVertexColors = bColorsFound ? size_t(iVertexLines) : 0;
+  vertices.resize(size_t(iVertexLines));
+  if (bNormalsFound) normals.resize(size_t(iVertexLines));
+  colors.resize(iVertexColors + (bEdgeColorsFound ? size_t(iEdgeLines) : 0));
+  VertIndices.resize(size_t(iEdgeLines*iIndicesPerEdge));
+  if (bEdgeColorsFound) COLIndices.resize(size_t(iEdgeLines*2));
+  std::vector<PolygonList> polygons(pieces.size());
+
+  MESSAGE("Reading %u vertices and %u %s in %u pieces",
+          unsigned(iVertexLines), unsigned(iFaceLines + iEdgeLines),
+          (iFaceCount > 0) ? "faces" : "edges", unsigned(pieces.size()));
+
+#pragma omp parallel for schedule(dynamic)
+  for (int64_t iPiece = 0;iPiece<iPieces;iPiece++) {
+    TextSpan piece = pieces[size_t(iPiece)];
+    PolygonList& pieceFaces = polygons[size_t(iPiece)];
+    IndexVec v, n, t, c;
+    TextSpan rawLine;
+    for (uint64_t iLine = firstLine[size_t(iPiece)];
+         iLine < iVertexLines + iFaceLines + iEdgeLines &&
+         piece.PopLine(rawLine);
+         iLine++) {
+      TextSpan line = rawLine.Trimmed();
+
+      if (iLine < iVertexLines) {
+        FLOATVECTOR3 pos;
+        FLOATVECTOR3 normal(0,0,0);
+        FLOATVECTOR4 color(0,0,0,1);
+
+        for (size_t i = 0;i<vertexProps.size();i++) {
+          const TextSpan strValue = line.PopToken();
+
+          double fValue=0.0; int iValue=0;
+          if (vertexProps[i].first <= PROPT_DOUBLE) {
+            fValue = num.Atof(strValue);
+            iValue = int(fValue);
+          } else {
+            iValue = num.Atoi(strValue);
+            fValue = double(iValue);
+          }
+
+          switch (vertexProps[i].second) {
+            case VPROP_X         : pos.x = float(fValue); break;
+            case VPROP_Y         : pos.y = float(fValue); break;
+            case VPROP_Z         : pos.z = float(fValue); break;
+            case VPROP_NX        : normal.x = float(fValue); break;
+            case VPROP_NY        : normal.y = float(fValue); break;
+            case VPROP_NZ        : normal.z = float(fValue); break;
+            case VPROP_RED       : color.x = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case VPROP_GREEN     : color.y = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case VPROP_BLUE      : color.z = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case VPROP_OPACITY   : color.w = (vertexProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case VPROP_INTENSITY : color = (vertexProps[i].first <= PROPT_DOUBLE) ? FLOATVECTOR4(float(fValue),float(fValue),float(fValue),1.0f)
+                                                                                  : FLOATVECTOR4(iValue/255.0f,iValue/255.0f,iValue/255.0f,1.0f);
+                                   break;
+            default: break;
+          }
         }
 
-        switch (std::get<2>(faceProps[i])) {
-          case FPROP_LIST : {
-                              for (int j = 0;j<iValue;j++) {
-                                // hack: read everything as int, regardless of the 
-                                //       type stored in std::get<1>(faceProps[i])
-                                strValue = GetToken(line);
-                                int elem = atoi(strValue.c_str());
-                                v.push_back(elem);
-                                if (bNormalsFound) n.push_back(elem);
-                                if (bTexCoordsFound) t.push_back(elem);
-                                if (bColorsFound) c.push_back(elem);
+        vertices[size_t(iLine)] = pos;
+        if (bColorsFound) colors[size_t(iLine)] = color;
+        if (bNormalsFound) normals[size_t(iLine)] = normal;
+      } else if (iFaceLines > 0) {
+        v.clear(); n.clear(); t.clear(); c.clear();
+        for (size_t i = 0;i<faceProps.size();i++) {
+          const TextSpan strValue = line.PopToken();
+
+          double fValue=0.0; int iValue=0;
+          if (std::get<1>(faceProps[i]) <= PROPT_DOUBLE) {
+            fValue = num.Atof(strValue);
+            iValue = static_cast<int>(fValue);
+          } else {
+            iValue = num.Atoi(strValue);
+            fValue = static_cast<double>(iValue);
+          }
+
+          switch (std::get<2>(faceProps[i])) {
+            case FPROP_LIST : {
+                                for (int j = 0;j<iValue;j++) {
+                                  // hack: read everything as int, regardless of the 
+                                  //       type stored in std::get<1>(faceProps[i])
+                                  int elem = num.Atoi(line.PopToken());
+                                  v.push_back(elem);
+                                  if (bNormalsFound) n.push_back(elem);
+                                  if (bTexCoordsFound) t.push_back(elem);
+                                  if (bColorsFound) c.push_back(elem);
+                                }
                               }
-                            }
-                            break;
-          default: break;
+                              break;
+            default: break;
+          }
         }
-      }
-      AddToMesh(vertices,v,n,t,c,VertIndices,NormalIndices,TCIndices,COLIndices);
-
-      iFacesFound++;
-      if (iFacesFound == iFaceCount) iReaderState = PARSING_DONE;
-    } else if (iReaderState == PARSING_EDGE_DATA) {
-      FLOATVECTOR4 color(0,0,0,1);
-      bool bEdgeColorsFound=false;
-
-      for (size_t i = 0;i<edgeProps.size();i++) {
-        string strValue = GetToken(line);
-
-        double fValue=0.0; int iValue=0;
-        if (edgeProps[i].first <= PROPT_DOUBLE) {
-          fValue = atof(strValue.c_str());
-          iValue = int(fValue);
-        } else {
-          iValue = atoi(strValue.c_str());
-          fValue = double(iValue);
-        }
-        switch (edgeProps[i].second) {
-          case EPROP_VERTEX1   : VertIndices.push_back(iValue); break;
-          case EPROP_VERTEX2   : VertIndices.push_back(iValue); break;
-          case EPROP_RED       : bEdgeColorsFound = true; color.x = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case EPROP_GREEN     : bEdgeColorsFound = true; color.y = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case EPROP_BLUE      : bEdgeColorsFound = true; color.z = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case EPROP_OPACITY   : bEdgeColorsFound = true; color.w = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
-          case EPROP_INTENSITY : bEdgeColorsFound = true;                                 
-                                 color = (edgeProps[i].first <= PROPT_DOUBLE) ? FLOATVECTOR4(float(fValue),float(fValue),float(fValue),1.0f)
-                                                                              : FLOATVECTOR4(iValue/255.0f,iValue/255.0f,iValue/255.0f,1.0f);
-                                 break;
-          default: break;
+        pieceFaces.Add(v,n,t,c);
+      } else {
+        const size_t iEdge = size_t(iLine - iVertexLines);
+        uint32_t* pIndex = VertIndices.data() + iEdge*iIndicesPerEdge;
+        FLOATVECTOR4 color(0,0,0,1);
+
+        for (size_t i = 0;i<edgeProps.size();i++) {
+          const TextSpan strValue = line.PopToken();
+
+          double fValue=0.0; int iValue=0;
+          if (edgeProps[i].first <= PROPT_DOUBLE) {
+            fValue = num.Atof(strValue);
+            iValue = int(fValue);
+          } else {
+            iValue = num.Atoi(strValue);
+            fValue = double(iValue);
+          }
+          switch (edgeProps[i].second) {
+            case EPROP_VERTEX1   : *pIndex++ = iValue; break;
+            case EPROP_VERTEX2   : *pIndex++ = iValue; break;
+            case EPROP_RED       : color.x = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case EPROP_GREEN     : color.y = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case EPROP_BLUE      : color.z = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case EPROP_OPACITY   : color.w = (edgeProps[i].first <= PROPT_DOUBLE) ? float(fValue) : iValue/255.0f; break;
+            case EPROP_INTENSITY : color = (edgeProps[i].first <= PROPT_DOUBLE) ? FLOATVECTOR4(float(fValue),float(fValue),float(fValue),1.0f)
+                                                                                : FLOATVECTOR4(iValue/255.0f,iValue/255.0f,iValue/255.0f,1.0f);
+                                   break;
+            default: break;
+          }
         }
-      }
 
-      if (bEdgeColorsFound)  {
-        COLIndices.push_back(uint32_t(colors.size()));
-        COLIndices.push_back(uint32_t(colors.size()));
-        colors.push_back(color);
+        if (bEdgeColorsFound)  {
+          COLIndices[2*iEdge] = uint32_t(iVertexColors + iEdge);
+          COLIndices[2*iEdge+1] = uint32_t(iVertexColors + iEdge);
+          colors[iVertexColors + iEdge] = color;
+        }
       }
-
-      if (VertIndices.size() == iLineCount*2) iReaderState = PARSING_DONE;
-    } else throw tuvok::io::DSParseFailed(strFilename.c_str(), "unknown parser state data",__FILE__, __LINE__);
+    }
   }
 
   MESSAGE("Creating Mesh Object");
+  if (iFaceLines > 0)
+    AddToMesh(vertices,polygons,PF_ALL,
+              VertIndices,NormalIndices,TCIndices,COLIndices);
 
   std::string desc = m_vConverterDesc + " data converted from " + SysTools::GetFilename(strFilename);
 
@@ -342,7 +384,6 @@ PLYGeoConverter::ConvertToMesh(const std::string& strFilename) {
   );
 }
 
-
 PLYGeoConverter::propType PLYGeoConverter::StringToType(const std::string& token) {
   if (token == "float" || token == "float32") return PROPT_FLOAT;
   if (token == "double" || token == "float64") return PROPT_DOUBLE;
@@ -38,7 +38,6 @@
 #define PLYGEOCONVERTER_H
 
 #include "../StdTuvokDefines.h"
-#include <tuple>
 #include "AbstrGeoConverter.h"
 
 namespace tuvok {
@@ -126,10 +125,6 @@ namespace tuvok {
       EPROP_UNKNOWN
     };
 
-    std::vector<std::pair<propType, vertexProp>> vertexProps;
-    std::vector<std::tuple<propType, propType, faceProp>> faceProps;
-    std::vector<std::pair<propType, edgeProp>> edgeProps;
-
     propType StringToType(const std::string& token);
     vertexProp StringToVProp(const std::string& token);
     faceProp StringToFProp(const std::string& token);
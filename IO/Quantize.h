@@ -42,6 +42,7 @@
 #include "UVF/Histogram1DDataBlock.h"
 #include "TuvokSizes.h"
 #include "AbstrConverter.h"
+#include "QuantizeSIMD.h"
 
 namespace { // force internal linkage.
   // Figure out what factor we should multiply each element in the data set by
@@ -239,8 +240,11 @@ namespace { namespace Fits {
 /// Must implement:
 ///    bin(T): bin the given value.  return false if we shouldn't bother
 ///            computing the histogram anymore.
+///    bin(const T*, n, max): the same for 'n' values at once, the largest of
+///            which is 'max'.
 template<typename T> struct NullHistogram {
   static bool bin(T) { return false; }
+  static bool bin(const T*, size_t, T) { return false; }
 };
 // Calculate a 12Bit histogram, but when we encounter a value which does not
 // fit (i.e., we know we'll need to quantize), don't bother anymore.
@@ -258,6 +262,10 @@ struct UnsignedHistogram {
     return calculate;
   }
 
+  bool bin(const T* data, size_t n, T mx) {
+    return bin(data, n, mx, typename std::is_unsigned<T>::type());
+  }
+
   void update(T value) {
     // Calculate our bias factor up front.
     typename ctti<T>::size_type bias;
@@ -283,6 +291,20 @@ struct UnsignedHistogram {
     }
   }
   private:
+    // if all values fit, they can be counted in one go.
+    bool bin(const T* data, size_t n, T mx, std::true_type) {
+      if(calculate && Fits::inXBits<T, sz>(mx) &&
+         static_cast<uint64_t>(mx) < histo.size()) {
+        tuvok::simd::Histogram(data, n, &histo[0], histo.size());
+        return true;
+      }
+      return bin(data, n, mx, std::false_type());
+    }
+    bool bin(const T* data, size_t n, T, std::false_type) {
+      for(size_t i=0; i < n && bin(data[i]); ++i) { }
+      return calculate;
+    }
+
     std::vector<uint64_t>& histo;
     bool calculate;
 };
@@ -327,16 +349,16 @@ std::pair<T,T> io_minmax(DataSrc<T> ds, Histogram<T, sz> histogram,
     assert(iPos <= iElems);
     progress.notify("Computing value range", iPos);
 
-    typedef typename std::vector<T>::const_iterator iterator;
-    std::pair<iterator,iterator> cur_mm = std::minmax_element(data.begin(),
-                                                              data.end());
-    t_minmax.first = std::min(t_minmax.first, *cur_mm.first);
-    t_minmax.second = std::max(t_minmax.second, *cur_mm.second);
+    // NaNs are ignored.
+    std::pair<T,T> cur_mm(std::numeric_limits<T>::max(),
+                          std::numeric_limits<T>::lowest());
+    tuvok::simd::MinMax(&data[0], n_records, cur_mm.first, cur_mm.second);
+    t_minmax.first = std::min(t_minmax.first, cur_mm.first);
+    t_minmax.second = std::max(t_minmax.second, cur_mm.second);
 
     // Run over the data again and bin the data for the histogram.
-    for(size_t i=0; i < n_records && histogram.bin(data[i]); ++i) { }
+    histogram.bin(&data[0], n_records, cur_mm.second);
   }
-  assert(iPos == iElems);
   MESSAGE("min/max is: [%g:%g]", static_cast<double>(t_minmax.first),
           static_cast<double>(t_minmax.second));
   return t_minmax;
@@ -363,6 +385,15 @@ static bool ApplyMapping(const uint64_t iElems,
   std::vector<T> sourceData(iCurrentInCoreElems);
   uint64_t iPos = 0;
 
+  // a sorted array is much quicker to search than the map.
+  std::vector<T> keys;
+  keys.reserve(binAssignments.size());
+  for(typename std::map<T, size_t>::const_iterator b = binAssignments.begin();
+      b != binAssignments.end(); ++b) {
+    assert(b->second == keys.size());
+    keys.push_back(b->first);
+  }
+
   assert(iElems > 0); // our minmax assert later will fail anyway, if false.
 
   while(iPos < iElems) {
@@ -380,14 +411,15 @@ static bool ApplyMapping(const uint64_t iElems,
     assert(iPos <= iElems);
     progress.notify("Mapping data values to bins", iPos);
 
-    // Run over the in-core data and apply mapping
+    // Run over the in-core data and apply mapping.  The bins were assigned
+    // in ascending order of the values, so a value's bin is its rank.
     for(size_t i=0; i < n_records; ++i) {
-      targetData[i] = U(binAssignments[sourceData[i]]);
+      targetData[i] = U(std::lower_bound(keys.begin(), keys.end(),
+                                         sourceData[i]) - keys.begin());
     }
 
     TargetData.WriteRAW((unsigned char*)&targetData[0], sizeof(U)*n_records);
   }
-  assert(iPos == iElems);
 
   TargetData.Close();
 
@@ -421,6 +453,56 @@ static bool ApplyMapping(const uint64_t iElems,
   return true;
 }
 
+}
+
+/// The mapping Quantize applies to each value: shift the data range to start
+/// at 0 and compress it into the range of U if it does not fit already.  The
+/// histogram gets its own factor as it (usually) has fewer bins than U has
+/// values.
+template <typename T, typename U>
+struct LinearQuantizer {
+  LinearQuantizer(std::pair<T,T> mm, size_t hist) :
+    minmax(mm),
+    hist_size(hist),
+    max_output_val(hist == 256 ? 255 : (1 << (sizeof(U)*8)) - 1),
+    fQuantFact(QuantizationFactor(max_output_val, mm.first, mm.second)),
+    fQuantFactHist(QuantizationFactor(hist-1, mm.first, mm.second)) {}
+
+  tuvok::simd::Linear<T> values() const {
+    return tuvok::simd::Linear<T>(minmax.first, fQuantFact,
+                                  uint32_t(max_output_val));
+  }
+  tuvok::simd::Linear<T> bins() const {
+    return tuvok::simd::Linear<T>(minmax.first, fQuantFactHist,
+                                  uint32_t(hist_size-1));
+  }
+  U value(T v) const { return static_cast<U>(values()(v)); }
+  U bin(T v) const { return static_cast<U>(bins()(v)); }
+  /// quantizes 'n' values; they are binned into pHist unless it is NULL.
+  void apply(const T* in, U* out, size_t n, uint64_t* pHist) const {
+    tuvok::simd::Quantize(in, out, n, values(), bins(), pHist);
+  }
+  /// false if value() is the identity, i.e. the input could be used as-is
+  bool changes_data() const {
+    return fQuantFact != 1.0 || minmax.first != 0 || sizeof(T) > 2 ||
+           sizeof(T) > sizeof(U);
+  }
+  /// true for unsigned data which already fit into the histogram; Quantize
+  /// leaves those alone.
+  bool fits() const {
+    return !ctti<T>::is_signed && minmax.second < static_cast<T>(hist_size) &&
+           sizeof(T) <= ((hist_size == 256) ? 1 : 2);
+  }
+
+  std::pair<T,T> minmax;
+  size_t hist_size;
+  size_t max_output_val;
+  double fQuantFact;
+  double fQuantFactHist;
+};
+
+namespace {
+
 /// Quantizes an (already-open) file to 'strTargetFilename'.  If 'InputData'
 /// doesn't need any quantization, this might be a no-op.
 /// @returns true if we generated 'strTargetFilename', false if the caller
@@ -464,11 +546,16 @@ static bool Quantize(LargeRAWFile& InputData,
                      UnsignedHistogram<T, sz>(aHist),
                      TuvokProgress<uint64_t>(iElems), iElems,
                      iCurrentInCoreSizeBytes);
-  assert(minmax.second >= minmax.first);
+  if(minmax.second < minmax.first) {
+    T_ERROR("No data could be read from %s.",
+            InputData.GetFilename().c_str());
+    return false;
+  }
+
+  const LinearQuantizer<T,U> q(minmax, hist_size);
 
   // Unsigned N bit data does not need to be biased/quantized.
-  if(!ctti<T>::is_signed && minmax.second < static_cast<T>(hist_size) &&
-     sizeof(T) <= ((hist_size == 256) ? 1 : 2)) {
+  if(q.fits()) {
     MESSAGE("Returning early; data does not need processing.");
 
     // if we have very few values, let the calling function know
@@ -488,15 +575,9 @@ static bool Quantize(LargeRAWFile& InputData,
     MESSAGE("We need %u bins", static_cast<unsigned>(*iBinCount));
   }
 
-  size_t max_output_val = (1 << (sizeof(U)*8)) - 1;
-  if(hist_size == 256) { max_output_val = 255; }
-  double fQuantFact = QuantizationFactor(max_output_val, minmax.first,
-                                         minmax.second);
-  double fQuantFactHist = QuantizationFactor(hist_size-1, minmax.first,
-                                             minmax.second);
-
-  bool bDataWillbeChanged = fQuantFact != 1.0 || minmax.first != 0 ||
-                            sizeof(T) > 2 || sizeof(T) > sizeof(U);
+  const size_t max_output_val = q.max_output_val;
+  const double fQuantFact = q.fQuantFact;
+  const bool bDataWillbeChanged = q.changes_data();
 
   LargeRAWFile OutputData(strTargetFilename);
   // if the only reason for quantization is the histogram computation
@@ -524,17 +605,7 @@ static bool Quantize(LargeRAWFile& InputData,
     if(iRead == 0) { break; } // bail if the read gave us nothing
 
     // calculate hist + quantize to output file.
-    for(size_t i=0; i < iRead; ++i) {
-      U iNewVal = std::min<U>(static_cast<U>(max_output_val),
-        static_cast<U>((pInData[i]-minmax.first) * fQuantFact)
-      );
-      U iHistIndex = std::min<U>(static_cast<U>(hist_size-1),
-                                 static_cast<U>((pInData[i]-minmax.first) *
-                                   fQuantFactHist)
-      );
-      pOutData[i] = iNewVal;
-      aHist[iHistIndex]++;
-    }
+    q.apply(pInData, pOutData, iRead, &aHist[0]);
     iPos += static_cast<uint64_t>(iRead);
 
     if((100*iPos)/iSize > iLastDisplayedPercent) {
@@ -0,0 +1,634 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "Basics/EndianConvert.h"
+#include "QuantizeSIMD.h"
+
+// The vector kernels are compiled for their instruction set via function
+// attributes, so the rest of the build does not need any special flags.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+# define TUVOK_SIMD_X86
+# include <immintrin.h>
+# define SSE4_FN __attribute__((target("sse4.2")))
+# define AVX2_FN __attribute__((target("avx2")))
+#endif
+
+namespace tuvok { namespace simd {
+
+namespace {
+  std::atomic<int> g_iLimit(AVX2);
+
+  Level detect() {
+#ifdef TUVOK_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) { return AVX2; }
+    if(__builtin_cpu_supports("sse4.2")) { return SSE4; }
+#endif
+    return Scalar;
+  }
+}
+
+Level Supported() {
+  static const Level l = detect();
+  return l;
+}
+Level Active() {
+  return Level(std::min<int>(Supported(), g_iLimit.load()));
+}
+void Limit(Level l) { g_iLimit.store(l); }
+
+const char* Name(Level l) {
+  switch(l) {
+    case Scalar: return "scalar";
+    case SSE4: return "SSE4.2";
+    case AVX2: return "AVX2";
+  }
+  return "unknown";
+}
+
+// ----------------------------------------------------------------------------
+// scalar kernels.  These define the results; the vector kernels handle a
+// prefix of the data and leave the remainder to them.
+namespace {
+  template<typename T> void swap_scalar(T* p, size_t n) {
+    for(size_t i=0; i < n; ++i) { p[i] = EndianConvert::Swap<T>(p[i]); }
+  }
+
+  template<typename T> void minmax_scalar(const T* p, size_t n, T& lo, T& hi) {
+    for(size_t i=0; i < n; ++i) {
+      if(p[i] < lo) { lo = p[i]; }
+      if(p[i] > hi) { hi = p[i]; }
+    }
+  }
+
+  template<typename T, typename U>
+  void quantize_scalar(const T* pIn, U* pOut, size_t n, const Linear<T>& value,
+                       const Linear<T>& bin, uint64_t* pHist) {
+    for(size_t i=0; i < n; ++i) {
+      const double d = Offset(pIn[i], value.minimum);
+      pOut[i] = static_cast<U>(Clamp(d * value.fFactor, value.iMax));
+      if(pHist) { ++pHist[Clamp(d * bin.fFactor, bin.iMax)]; }
+    }
+  }
+}
+
+#ifdef TUVOK_SIMD_X86
+// ----------------------------------------------------------------------------
+// byte swapping: a shuffle reverses every element within a 16 byte lane.
+namespace {
+  const int8_t swap_masks[3][16] = {
+    { 1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14 },
+    { 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 },
+    { 7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8 },
+  };
+  const int8_t* swap_mask(size_t iWidth) {
+    return swap_masks[iWidth == 2 ? 0 : iWidth == 4 ? 1 : 2];
+  }
+
+  /// @returns the number of bytes swapped.
+  SSE4_FN size_t swap_sse4(uint8_t* p, size_t iBytes, const int8_t* mask) {
+    const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+    size_t i=0;
+    for(; i+16 <= iBytes; i += 16) {
+      __m128i* v = reinterpret_cast<__m128i*>(p+i);
+      _mm_storeu_si128(v, _mm_shuffle_epi8(_mm_loadu_si128(v), m));
+    }
+    return i;
+  }
+  AVX2_FN size_t swap_avx2(uint8_t* p, size_t iBytes, const int8_t* mask) {
+    const __m256i m = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask))
+    );
+    size_t i=0;
+    for(; i+64 <= iBytes; i += 64) {
+      __m256i* v = reinterpret_cast<__m256i*>(p+i);
+      _mm256_storeu_si256(v, _mm256_shuffle_epi8(_mm256_loadu_si256(v), m));
+      _mm256_storeu_si256(v+1, _mm256_shuffle_epi8(_mm256_loadu_si256(v+1),
+                                                   m));
+    }
+    return i;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// min/max.  Ops<T> wrap the intrinsics for each type; the accumulators start
+// out as the current lo/hi, so a NaN never gets into them: minps/maxps
+// return their second operand when the comparison is unordered.
+namespace {
+  template<typename T> struct SSE4Ops;
+  template<typename T> struct AVX2Ops;
+
+#define SIMD_INT_OPS(T, SET, CMP)                                             \
+  template<> struct SSE4Ops<T> {                                              \
+    typedef __m128i V;                                                        \
+    SSE4_FN static V load(const T* p) {                                       \
+      return _mm_loadu_si128(reinterpret_cast<const V*>(p));                  \
+    }                                                                         \
+    SSE4_FN static void store(T* p, V v) {                                    \
+      _mm_storeu_si128(reinterpret_cast<V*>(p), v);                           \
+    }                                                                         \
+    SSE4_FN static V set1(T v) { return _mm_set1_##SET(v); }                  \
+    SSE4_FN static V vmin(V a, V b) { return _mm_min_##CMP(a, b); }           \
+    SSE4_FN static V vmax(V a, V b) { return _mm_max_##CMP(a, b); }           \
+  };                                                                          \
+  template<> struct AVX2Ops<T> {                                              \
+    typedef __m256i V;                                                        \
+    AVX2_FN static V load(const T* p) {                                       \
+      return _mm256_loadu_si256(reinterpret_cast<const V*>(p));               \
+    }                                                                         \
+    AVX2_FN static void store(T* p, V v) {                                    \
+      _mm256_storeu_si256(reinterpret_cast<V*>(p), v);                        \
+    }                                                                         \
+    AVX2_FN static V set1(T v) { return _mm256_set1_##SET(v); }               \
+    AVX2_FN static V vmin(V a, V b) { return _mm256_min_##CMP(a, b); }        \
+    AVX2_FN static V vmax(V a, V b) { return _mm256_max_##CMP(a, b); }        \
+  };
+  SIMD_INT_OPS(int8_t, epi8, epi8)
+  SIMD_INT_OPS(uint8_t, epi8, epu8)
+  SIMD_INT_OPS(int16_t, epi16, epi16)
+  SIMD_INT_OPS(uint16_t, epi16, epu16)
+  SIMD_INT_OPS(int32_t, epi32, epi32)
+  SIMD_INT_OPS(uint32_t, epi32, epu32)
+#undef SIMD_INT_OPS
+
+  // there is no 64bit min/max before AVX-512; compare and blend.  Unsigned
+  // values are compared with their sign bit flipped.
+#define SIMD_INT64_OPS(T, BIAS)                                               \
+  template<> struct SSE4Ops<T> {                                              \
+    typedef __m128i V;                                                        \
+    SSE4_FN static V load(const T* p) {                                       \
+      return _mm_loadu_si128(reinterpret_cast<const V*>(p));                  \
+    }                                                                         \
+    SSE4_FN static void store(T* p, V v) {                                    \
+      _mm_storeu_si128(reinterpret_cast<V*>(p), v);                           \
+    }                                                                         \
+    SSE4_FN static V set1(T v) { return _mm_set1_epi64x(int64_t(v)); }       \
+    SSE4_FN static V gt(V a, V b) {                                           \
+      const V bias = _mm_set1_epi64x(BIAS);                                   \
+      return _mm_cmpgt_epi64(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)); \
+    }                                                                         \
+    SSE4_FN static V vmin(V a, V b) {                                         \
+      return _mm_blendv_epi8(a, b, gt(a, b));                                 \
+    }                                                                         \
+    SSE4_FN static V vmax(V a, V b) {                                         \
+      return _mm_blendv_epi8(a, b, gt(b, a));                                 \
+    }                                                                         \
+  };                                                                          \
+  template<> struct AVX2Ops<T> {                                              \
+    typedef __m256i V;                                                        \
+    AVX2_FN static V load(const T* p) {                                       \
+      return _mm256_loadu_si256(reinterpret_cast<const V*>(p));               \
+    }                                                                         \
+    AVX2_FN static void store(T* p, V v) {                                    \
+      _mm256_storeu_si256(reinterpret_cast<V*>(p), v);                        \
+    }                                                                         \
+    AVX2_FN static V set1(T v) { return _mm256_set1_epi64x(int64_t(v)); }    \
+    AVX2_FN static V gt(V a, V b) {                                           \
+      const V bias = _mm256_set1_epi64x(BIAS);                                \
+      return _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias),                    \
+                                _mm256_xor_si256(b, bias));                   \
+    }                                                                         \
+    AVX2_FN static V vmin(V a, V b) {                                         \
+      return _mm256_blendv_epi8(a, b, gt(a, b));                              \
+    }                                                                         \
+    AVX2_FN static V vmax(V a, V b) {                                         \
+      return _mm256_blendv_epi8(a, b, gt(b, a));                              \
+    }                                                                         \
+  };
+  SIMD_INT64_OPS(int64_t, 0)
+  SIMD_INT64_OPS(uint64_t, int64_t(0x8000000000000000ull))
+#undef SIMD_INT64_OPS
+
+#define SIMD_FP_OPS(T, V128, V256, SFX)                                       \
+  template<> struct SSE4Ops<T> {                                              \
+    typedef V128 V;                                                           \
+    SSE4_FN static V load(const T* p) { return _mm_loadu_##SFX(p); }         \
+    SSE4_FN static void store(T* p, V v) { _mm_storeu_##SFX(p, v); }         \
+    SSE4_FN static V set1(T v) { return _mm_set1_##SFX(v); }                  \
+    SSE4_FN static V vmin(V a, V b) { return _mm_min_##SFX(a, b); }           \
+    SSE4_FN static V vmax(V a, V b) { return _mm_max_##SFX(a, b); }           \
+  };                                                                          \
+  template<> struct AVX2Ops<T> {                                              \
+    typedef V256 V;                                                           \
+    AVX2_FN static V load(const T* p) { return _mm256_loadu_##SFX(p); }      \
+    AVX2_FN static void store(T* p, V v) { _mm256_storeu_##SFX(p, v); }      \
+    AVX2_FN static V set1(T v) { return _mm256_set1_##SFX(v); }               \
+    AVX2_FN static V vmin(V a, V b) { return _mm256_min_##SFX(a, b); }        \
+    AVX2_FN static V vmax(V a, V b) { return _mm256_max_##SFX(a, b); }        \
+  };
+  SIMD_FP_OPS(float, __m128, __m256, ps)
+  SIMD_FP_OPS(double, __m128d, __m256d, pd)
+#undef SIMD_FP_OPS
+
+  template<typename T> void reduce_min(const T* lanes, size_t n, T& lo) {
+    for(size_t i=0; i < n; ++i) { if(lanes[i] < lo) { lo = lanes[i]; } }
+  }
+  template<typename T> void reduce_max(const T* lanes, size_t n, T& hi) {
+    for(size_t i=0; i < n; ++i) { if(lanes[i] > hi) { hi = lanes[i]; } }
+  }
+
+  /// @returns how many values were looked at; lo/hi are updated.
+  template<typename T> SSE4_FN
+  size_t minmax_sse4(const T* p, size_t n, T& lo, T& hi) {
+    typedef SSE4Ops<T> O;
+    const size_t w = sizeof(typename O::V) / sizeof(T);
+    typename O::V vlo = O::set1(lo), vhi = O::set1(hi);
+    size_t i=0;
+    for(; i+w <= n; i += w) {
+      const typename O::V v = O::load(p+i);
+      vlo = O::vmin(v, vlo);
+      vhi = O::vmax(v, vhi);
+    }
+    T lanes[sizeof(typename O::V) / sizeof(T)];
+    O::store(lanes, vlo);
+    reduce_min(lanes, w, lo);
+    O::store(lanes, vhi);
+    reduce_max(lanes, w, hi);
+    return i;
+  }
+  template<typename T> AVX2_FN
+  size_t minmax_avx2(const T* p, size_t n, T& lo, T& hi) {
+    typedef AVX2Ops<T> O;
+    const size_t w = sizeof(typename O::V) / sizeof(T);
+    // two accumulators, to hide the latency of the 64bit compare/blend.
+    typename O::V vlo[2] = { O::set1(lo), O::set1(lo) };
+    typename O::V vhi[2] = { O::set1(hi), O::set1(hi) };
+    size_t i=0;
+    for(; i+2*w <= n; i += 2*w) {
+      const typename O::V v0 = O::load(p+i);
+      const typename O::V v1 = O::load(p+i+w);
+      vlo[0] = O::vmin(v0, vlo[0]);
+      vhi[0] = O::vmax(v0, vhi[0]);
+      vlo[1] = O::vmin(v1, vlo[1]);
+      vhi[1] = O::vmax(v1, vhi[1]);
+    }
+    T lanes[sizeof(typename O::V) / sizeof(T)];
+    for(size_t a=0; a < 2; ++a) {
+      O::store(lanes, vlo[a]);
+      reduce_min(lanes, w, lo);
+      O::store(lanes, vhi[a]);
+      reduce_max(lanes, w, hi);
+    }
+    return i;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// quantization.  Offsets are converted to double exactly as Offset() does,
+// then scaled, clamped and truncated like Clamp().  64bit integers are left
+// to the scalar code: there is no vector conversion from them to double.
+namespace {
+  template<typename T> struct Vectorized :
+    std::integral_constant<bool, !(std::is_integral<T>::value &&
+                                   sizeof(T) == 8)> {};
+
+  SSE4_FN inline void u32_to_pd(__m128i d, __m128d& lo, __m128d& hi) {
+    // flip the sign bit to get a signed value, convert, add 2^31 back.
+    d = _mm_xor_si128(d, _mm_set1_epi32(int32_t(0x80000000u)));
+    const __m128d bias = _mm_set1_pd(2147483648.0);
+    lo = _mm_add_pd(_mm_cvtepi32_pd(d), bias);
+    hi = _mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(d, 8)), bias);
+  }
+  SSE4_FN inline __m128i load4_32(const int8_t* p) {
+    int32_t v; memcpy(&v, p, 4);
+    return _mm_cvtepi8_epi32(_mm_cvtsi32_si128(v));
+  }
+  SSE4_FN inline __m128i load4_32(const uint8_t* p) {
+    int32_t v; memcpy(&v, p, 4);
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+  }
+  SSE4_FN inline __m128i load4_32(const int16_t* p) {
+    return _mm_cvtepi16_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+  }
+  SSE4_FN inline __m128i load4_32(const uint16_t* p) {
+    return _mm_cvtepu16_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+  }
+  SSE4_FN inline __m128i load4_32(const int32_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  SSE4_FN inline __m128i load4_32(const uint32_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  /// Offset() of the 4 values at 'p', as two pairs of doubles.
+  template<typename T> SSE4_FN
+  inline void offsets4(const T* p, T mn, __m128d& lo, __m128d& hi) {
+    u32_to_pd(_mm_sub_epi32(load4_32(p), _mm_set1_epi32(int32_t(mn))), lo, hi);
+  }
+  SSE4_FN inline void offsets4(const float* p, float mn,
+                               __m128d& lo, __m128d& hi) {
+    const __m128 d = _mm_sub_ps(_mm_loadu_ps(p), _mm_set1_ps(mn));
+    lo = _mm_cvtps_pd(d);
+    hi = _mm_cvtps_pd(_mm_movehl_ps(d, d));
+  }
+  SSE4_FN inline void offsets4(const double* p, double mn,
+                               __m128d& lo, __m128d& hi) {
+    const __m128d m = _mm_set1_pd(mn);
+    lo = _mm_sub_pd(_mm_loadu_pd(p), m);
+    hi = _mm_sub_pd(_mm_loadu_pd(p+2), m);
+  }
+  SSE4_FN inline __m128i clamp4(__m128d lo, __m128d hi, __m128d fact,
+                                __m128d mx) {
+    const __m128d zero = _mm_setzero_pd();
+    lo = _mm_min_pd(_mm_max_pd(_mm_mul_pd(lo, fact), zero), mx);
+    hi = _mm_min_pd(_mm_max_pd(_mm_mul_pd(hi, fact), zero), mx);
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+  }
+  SSE4_FN inline void store4(uint8_t* p, __m128i v) {
+    v = _mm_packus_epi16(_mm_packus_epi32(v, v), v);
+    const int32_t b = _mm_cvtsi128_si32(v);
+    memcpy(p, &b, 4);
+  }
+  SSE4_FN inline void store4(uint16_t* p, __m128i v) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi32(v, v));
+  }
+
+  template<typename T, typename U> SSE4_FN
+  size_t quantize_sse4(const T* pIn, U* pOut, size_t n, const Linear<T>& value,
+                       const Linear<T>& bin, uint64_t* pHist) {
+    const __m128d fact = _mm_set1_pd(value.fFactor);
+    const __m128d mx = _mm_set1_pd(double(value.iMax));
+    const __m128d hfact = _mm_set1_pd(bin.fFactor);
+    const __m128d hmx = _mm_set1_pd(double(bin.iMax));
+    size_t i=0;
+    for(; i+4 <= n; i += 4) {
+      __m128d lo, hi;
+      offsets4(pIn+i, value.minimum, lo, hi);
+      store4(pOut+i, clamp4(lo, hi, fact, mx));
+      if(pHist) {
+        const __m128i b = clamp4(lo, hi, hfact, hmx);
+        ++pHist[uint32_t(_mm_cvtsi128_si32(b))];
+        ++pHist[uint32_t(_mm_extract_epi32(b, 1))];
+        ++pHist[uint32_t(_mm_extract_epi32(b, 2))];
+        ++pHist[uint32_t(_mm_extract_epi32(b, 3))];
+      }
+    }
+    return i;
+  }
+
+  AVX2_FN inline void u32_to_pd(__m256i d, __m256d& lo, __m256d& hi) {
+    d = _mm256_xor_si256(d, _mm256_set1_epi32(int32_t(0x80000000u)));
+    const __m256d bias = _mm256_set1_pd(2147483648.0);
+    lo = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(d)), bias);
+    hi = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1)),
+                       bias);
+  }
+  AVX2_FN inline __m256i load8_32(const int8_t* p) {
+    return _mm256_cvtepi8_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+  }
+  AVX2_FN inline __m256i load8_32(const uint8_t* p) {
+    return _mm256_cvtepu8_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+  }
+  AVX2_FN inline __m256i load8_32(const int16_t* p) {
+    return _mm256_cvtepi16_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+  AVX2_FN inline __m256i load8_32(const uint16_t* p) {
+    return _mm256_cvtepu16_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+  AVX2_FN inline __m256i load8_32(const int32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  AVX2_FN inline __m256i load8_32(const uint32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  template<typename T> AVX2_FN
+  inline void offsets8(const T* p, T mn, __m256d& lo, __m256d& hi) {
+    u32_to_pd(_mm256_sub_epi32(load8_32(p), _mm256_set1_epi32(int32_t(mn))),
+              lo, hi);
+  }
+  AVX2_FN inline void offsets8(const float* p, float mn,
+                               __m256d& lo, __m256d& hi) {
+    const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(p), _mm256_set1_ps(mn));
+    lo = _mm256_cvtps_pd(_mm256_castps256_ps128(d));
+    hi = _mm256_cvtps_pd(_mm256_extractf128_ps(d, 1));
+  }
+  AVX2_FN inline void offsets8(const double* p, double mn,
+                               __m256d& lo, __m256d& hi) {
+    const __m256d m = _mm256_set1_pd(mn);
+    lo = _mm256_sub_pd(_mm256_loadu_pd(p), m);
+    hi = _mm256_sub_pd(_mm256_loadu_pd(p+4), m);
+  }
+  AVX2_FN inline __m256i clamp8(__m256d lo, __m256d hi, __m256d fact,
+                                __m256d mx) {
+    const __m256d zero = _mm256_setzero_pd();
+    lo = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(lo, fact), zero), mx);
+    hi = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(hi, fact), zero), mx);
+    return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)),
+      _mm256_cvttpd_epi32(hi), 1
+    );
+  }
+  /// packs the 8 values down to 16 bits, in order, in the lower half.
+  AVX2_FN inline __m128i pack8_16(__m256i v) {
+    v = _mm256_packus_epi32(v, v);
+    return _mm256_castsi256_si128(
+      _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3,1,2,0)));
+  }
+  AVX2_FN inline void store8(uint8_t* p, __m256i v) {
+    const __m128i w = pack8_16(v);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(w, w));
+  }
+  AVX2_FN inline void store8(uint16_t* p, __m256i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), pack8_16(v));
+  }
+
+  template<typename T, typename U> AVX2_FN
+  size_t quantize_avx2(const T* pIn, U* pOut, size_t n, const Linear<T>& value,
+                       const Linear<T>& bin, uint64_t* pHist) {
+    const __m256d fact = _mm256_set1_pd(value.fFactor);
+    const __m256d mx = _mm256_set1_pd(double(value.iMax));
+    const __m256d hfact = _mm256_set1_pd(bin.fFactor);
+    const __m256d hmx = _mm256_set1_pd(double(bin.iMax));
+    size_t i=0;
+    for(; i+8 <= n; i += 8) {
+      __m256d lo, hi;
+      offsets8(pIn+i, value.minimum, lo, hi);
+      store8(pOut+i, clamp8(lo, hi, fact, mx));
+      if(pHist) {
+        // extracting is faster than storing the bins: loads from the upper
+        // half of a 256bit store are not forwarded.
+        const __m256i b = clamp8(lo, hi, hfact, hmx);
+        const __m128i b0 = _mm256_castsi256_si128(b);
+        const __m128i b1 = _mm256_extracti128_si256(b, 1);
+        ++pHist[uint32_t(_mm_cvtsi128_si32(b0))];
+        ++pHist[uint32_t(_mm_extract_epi32(b0, 1))];
+        ++pHist[uint32_t(_mm_extract_epi32(b0, 2))];
+        ++pHist[uint32_t(_mm_extract_epi32(b0, 3))];
+        ++pHist[uint32_t(_mm_cvtsi128_si32(b1))];
+        ++pHist[uint32_t(_mm_extract_epi32(b1, 1))];
+        ++pHist[uint32_t(_mm_extract_epi32(b1, 2))];
+        ++pHist[uint32_t(_mm_extract_epi32(b1, 3))];
+      }
+    }
+    return i;
+  }
+}
+#endif // TUVOK_SIMD_X86
+
+// ----------------------------------------------------------------------------
+// dispatch
+namespace {
+  template<typename T>
+  size_t minmax_simd(const T* p, size_t n, T& lo, T& hi) {
+#ifdef TUVOK_SIMD_X86
+    switch(Active()) {
+      case AVX2: return minmax_avx2(p, n, lo, hi);
+      case SSE4: return minmax_sse4(p, n, lo, hi);
+      case Scalar: break;
+    }
+#else
+    (void)p; (void)n; (void)lo; (void)hi;
+#endif
+    return 0;
+  }
+
+  template<typename T, typename U>
+  size_t quantize_simd(const T* pIn, U* pOut, size_t n, const Linear<T>& value,
+                       const Linear<T>& bin, uint64_t* pHist, std::true_type) {
+#ifdef TUVOK_SIMD_X86
+    switch(Active()) {
+      case AVX2: return quantize_avx2(pIn, pOut, n, value, bin, pHist);
+      case SSE4: return quantize_sse4(pIn, pOut, n, value, bin, pHist);
+      case Scalar: break;
+    }
+#else
+    (void)pIn; (void)pOut; (void)n; (void)value; (void)bin; (void)pHist;
+#endif
+    return 0;
+  }
+  template<typename T, typename U>
+  size_t quantize_simd(const T*, U*, size_t, const Linear<T>&,
+                       const Linear<T>&, uint64_t*, std::false_type) {
+    return 0;
+  }
+}
+
+void ByteSwap(void* pData, size_t iCount, size_t iWidth) {
+  uint8_t* p = static_cast<uint8_t*>(pData);
+  size_t iDone = 0;
+#ifdef TUVOK_SIMD_X86
+  if(iWidth == 2 || iWidth == 4 || iWidth == 8) {
+    switch(Active()) {
+      case AVX2: iDone = swap_avx2(p, iCount*iWidth, swap_mask(iWidth)); break;
+      case SSE4: iDone = swap_sse4(p, iCount*iWidth, swap_mask(iWidth)); break;
+      case Scalar: break;
+    }
+  }
+#endif
+  iCount -= iDone / iWidth;
+  p += iDone;
+  switch(iWidth) {
+    case 2: swap_scalar(reinterpret_cast<uint16_t*>(p), iCount); break;
+    case 4: swap_scalar(reinterpret_cast<uint32_t*>(p), iCount); break;
+    case 8: swap_scalar(reinterpret_cast<uint64_t*>(p), iCount); break;
+    default:
+      for(size_t i=0; i < iCount; ++i) {
+        std::reverse(p + i*iWidth, p + (i+1)*iWidth);
+      }
+      break;
+  }
+}
+
+template<typename T> void MinMax(const T* pData, size_t n, T& lo, T& hi) {
+  const size_t iDone = minmax_simd(pData, n, lo, hi);
+  minmax_scalar(pData + iDone, n - iDone, lo, hi);
+}
+
+template<typename T> void Histogram(const T* pData, size_t n,
+                                    uint64_t* pHist, size_t iBins) {
+  // no vector instruction helps with the increments, but interleaving four
+  // sub-histograms keeps runs of equal values (common: think of the
+  // background) from serializing on a single counter.
+  if(n < 4*iBins) {
+    for(size_t i=0; i < n; ++i) { ++pHist[size_t(pData[i])]; }
+    return;
+  }
+  std::vector<uint32_t> sub(4*iBins, 0);
+  uint32_t* s[4] = { &sub[0], &sub[iBins], &sub[2*iBins], &sub[3*iBins] };
+  // bounded so that the 32bit counters can never overflow.
+  const size_t iBlock = size_t(1) << 30;
+  for(size_t b=0; b < n; b += iBlock) {
+    const size_t e = std::min(n, b + iBlock);
+    size_t i=b;
+    for(; i+4 <= e; i += 4) {
+      ++s[0][size_t(pData[i])];
+      ++s[1][size_t(pData[i+1])];
+      ++s[2][size_t(pData[i+2])];
+      ++s[3][size_t(pData[i+3])];
+    }
+    for(; i < e; ++i) { ++s[0][size_t(pData[i])]; }
+    for(size_t h=0; h < iBins; ++h) {
+      pHist[h] += uint64_t(s[0][h]) + s[1][h] + s[2][h] + s[3][h];
+    }
+    std::fill(sub.begin(), sub.end(), 0);
+  }
+}
+
+template<typename T, typename U>
+void Quantize(const T* pIn, U* pOut, size_t n, const Linear<T>& value,
+              const Linear<T>& bin, uint64_t* pHist) {
+  const size_t iDone = quantize_simd(pIn, pOut, n, value, bin, pHist,
+                                     Vectorized<T>());
+  quantize_scalar(pIn + iDone, pOut + iDone, n - iDone, value, bin, pHist);
+}
+
+#define MINMAX(T) \
+  template void MinMax<T>(const T*, size_t, T&, T&);
+MINMAX(int8_t) MINMAX(uint8_t) MINMAX(int16_t) MINMAX(uint16_t)
+MINMAX(int32_t) MINMAX(uint32_t) MINMAX(int64_t) MINMAX(uint64_t)
+MINMAX(float) MINMAX(double)
+#undef MINMAX
+
+#define HISTOGRAM(T) \
+  template void Histogram<T>(const T*, size_t, uint64_t*, size_t);
+HISTOGRAM(int8_t) HISTOGRAM(uint8_t) HISTOGRAM(int16_t) HISTOGRAM(uint16_t)
+HISTOGRAM(int32_t) HISTOGRAM(uint32_t) HISTOGRAM(int64_t) HISTOGRAM(uint64_t)
+#undef HISTOGRAM
+
+#define QUANTIZE(T) \
+  template void Quantize<T,uint8_t>(const T*, uint8_t*, size_t, \
+                                    const Linear<T>&, const Linear<T>&, \
+                                    uint64_t*); \
+  template void Quantize<T,uint16_t>(const T*, uint16_t*, size_t, \
+                                     const Linear<T>&, const Linear<T>&, \
+                                     uint64_t*);
+QUANTIZE(int8_t) QUANTIZE(uint8_t) QUANTIZE(int16_t) QUANTIZE(uint16_t)
+QUANTIZE(int32_t) QUANTIZE(uint32_t) QUANTIZE(int64_t) QUANTIZE(uint64_t)
+QUANTIZE(float) QUANTIZE(double)
+#undef QUANTIZE
+
+} }
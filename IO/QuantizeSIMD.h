@@ -0,0 +1,116 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef SCIO_QUANTIZESIMD_H
+#define SCIO_QUANTIZESIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+/// The per-voxel loops of data conversion: byte swapping, finding the value
+/// range, quantizing and histogramming.  Each kernel has a scalar version and,
+/// on x86-64 with GCC or clang, SSE4.2 and AVX2 versions; which one runs is
+/// decided at runtime from what the CPU supports.  All versions give
+/// bit-identical results.
+namespace tuvok { namespace simd {
+
+enum Level { Scalar=0, SSE4, AVX2 };
+
+/// @returns the best level this CPU (and build) supports.
+Level Supported();
+/// @returns the level the kernels currently use.
+Level Active();
+/// restricts the kernels to at most level 'l'.  For testing/benchmarking.
+void Limit(Level l);
+const char* Name(Level l);
+
+/// swaps the bytes of 'iCount' elements of 'iWidth' (2, 4 or 8) bytes each.
+void ByteSwap(void* pData, size_t iCount, size_t iWidth);
+
+/// widens [lo,hi] to include all of the 'n' values.  NaNs are ignored.
+template<typename T> void MinMax(const T* pData, size_t n, T& lo, T& hi);
+
+/// ++pHist[v] for each of the 'n' values, which must all be in [0, iBins).
+/// For integer types only.
+template<typename T> void Histogram(const T* pData, size_t n,
+                                    uint64_t* pHist, size_t iBins);
+
+/// v - minimum, computed exactly for integers (v >= minimum); FP data are
+/// subtracted in their own precision.
+template<typename T> inline double Offset(T v, T minimum) {
+  return static_cast<double>(v - minimum);
+}
+template<> inline double Offset(int8_t v, int8_t minimum) {
+  return static_cast<double>(uint32_t(v) - uint32_t(minimum));
+}
+template<> inline double Offset(uint8_t v, uint8_t minimum) {
+  return static_cast<double>(uint32_t(v) - uint32_t(minimum));
+}
+template<> inline double Offset(int16_t v, int16_t minimum) {
+  return static_cast<double>(uint32_t(v) - uint32_t(minimum));
+}
+template<> inline double Offset(uint16_t v, uint16_t minimum) {
+  return static_cast<double>(uint32_t(v) - uint32_t(minimum));
+}
+template<> inline double Offset(int32_t v, int32_t minimum) {
+  return static_cast<double>(uint32_t(v) - uint32_t(minimum));
+}
+template<> inline double Offset(int64_t v, int64_t minimum) {
+  return static_cast<double>(uint64_t(v) - uint64_t(minimum));
+}
+
+/// truncates 'q' to an integer in [0, iMax].  NaN becomes 0.
+inline uint32_t Clamp(double q, uint32_t iMax) {
+  q = q > 0.0 ? q : 0.0;
+  q = q < double(iMax) ? q : double(iMax);
+  return static_cast<uint32_t>(q);
+}
+
+/// A linear mapping of T values into [0, iMax]: Clamp(Offset(v, minimum) *
+/// fFactor, iMax).
+template<typename T> struct Linear {
+  Linear(T mn, double fact, uint32_t mx) :
+    minimum(mn), fFactor(fact), iMax(mx) {}
+  uint32_t operator()(T v) const {
+    return Clamp(Offset(v, minimum) * fFactor, iMax);
+  }
+  T minimum;
+  double fFactor;
+  uint32_t iMax;
+};
+
+/// pOut[i] = value(pIn[i]); if pHist is non-NULL, ++pHist[bin(pIn[i])] too.
+/// Both mappings must use the same minimum, and value.iMax must fit into U.
+template<typename T, typename U>
+void Quantize(const T* pIn, U* pOut, size_t n, const Linear<T>& value,
+              const Linear<T>& bin, uint64_t* pHist);
+
+} }
+
+#endif // SCIO_QUANTIZESIMD_H
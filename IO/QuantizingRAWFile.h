@@ -0,0 +1,372 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef SCIO_QUANTIZINGRAWFILE_H
+#define SCIO_QUANTIZINGRAWFILE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "Basics/LargeRAWFile.h"
+#include "DecompressingRAWFile.h"
+#include "Quantize.h"
+#include "QuantizeSIMD.h"
+
+/// A read-only view of a raw file which converts the data while it is read.
+/// The conversion is done a slab of whole slices at a time; the slab is kept
+/// in core, so the scanline reads the ExtendedOctreeConverter does when it
+/// builds LOD 0 (brick row after brick row along z) hit memory instead of the
+/// disk.  Offsets (SeekPos, GetPos, ReadRAW) are in the converted data.
+/// Slabs are read from the input front to back, so the input may well be
+/// one which is slow to seek in.
+///
+/// Each slice is binned into the histogram the first time it is converted;
+/// Histogram() bins whatever was never read before returning it.
+class SlabRAWFile : public LargeRAWFile {
+public:
+  /// @param iSliceElems elements per slice, iElems elements in total
+  /// @param iSlabSlices how many slices to keep in core
+  /// @param iHistSize bins of the histogram; 0 if none should be computed.
+  SlabRAWFile(LargeRAWFile_ptr pInput,
+              size_t iInWidth, size_t iOutWidth, uint64_t iSliceElems,
+              uint64_t iElems, uint64_t iSlabSlices, size_t iHistSize) :
+    LargeRAWFile(pInput->GetFilename()),
+    m_pInput(pInput),
+    m_iInWidth(iInWidth),
+    m_iOutWidth(iOutWidth),
+    m_iSliceElems(iSliceElems),
+    m_iElems(iElems),
+    m_iSlices((iElems + iSliceElems - 1) / iSliceElems),
+    m_iSlabSlices(std::max<uint64_t>(1, std::min(iSlabSlices, m_iSlices))),
+    m_iPos(0),
+    m_iFirst(0),
+    m_iCount(0),
+    m_vBinned(size_t(m_iSlices), false),
+    m_vHist(iHistSize, 0),
+    m_bHistogramSet(false),
+    m_bFailed(false)
+  {}
+  virtual ~SlabRAWFile() {}
+
+  virtual bool Open(bool bReadWrite=false) {
+    if(bReadWrite) { return false; }
+    return m_pInput->IsOpen() || m_pInput->Open(false);
+  }
+  virtual bool IsOpen() const { return m_pInput->IsOpen(); }
+  virtual void Close() { m_pInput->Close(); }
+  virtual bool Create(uint64_t) { return false; }
+  virtual bool Append() { return false; }
+  virtual bool Truncate() { return false; }
+  virtual bool Truncate(uint64_t) { return false; }
+  virtual uint64_t GetCurrentSize() { return m_iElems * m_iOutWidth; }
+
+  virtual void SeekStart() { m_iPos = 0; }
+  virtual uint64_t SeekEnd() { m_iPos = GetCurrentSize(); return m_iPos; }
+  virtual uint64_t GetPos() { return m_iPos; }
+  virtual void SeekPos(uint64_t iPos) { m_iPos = iPos; }
+
+  virtual size_t ReadRAW(unsigned char* pData, uint64_t iCount) {
+    const uint64_t iSliceBytes = m_iSliceElems * m_iOutWidth;
+    const uint64_t iSize = GetCurrentSize();
+    size_t iRead = 0;
+    while(iCount > 0 && m_iPos < iSize) {
+      if(!Load(m_iPos / iSliceBytes)) { break; }
+      const uint64_t iSlabStart = m_iFirst * iSliceBytes;
+      const uint64_t iSlabEnd = std::min(iSize, iSlabStart +
+                                                m_iCount * iSliceBytes);
+      const size_t iChunk = size_t(std::min(iCount, iSlabEnd - m_iPos));
+      memcpy(pData, &m_vSlab[size_t(m_iPos - iSlabStart)], iChunk);
+      pData += iChunk;
+      iCount -= iChunk;
+      iRead += iChunk;
+      m_iPos += iChunk;
+    }
+    return iRead;
+  }
+
+  /// converts straight into 'pData'; does not touch the slab or histogram.
+  virtual size_t ReadRAWAt(unsigned char* pData, uint64_t iCount,
+                           uint64_t iPos) const {
+    const uint64_t iEnd = std::min(iPos + iCount, m_iElems * m_iOutWidth);
+    if(iPos >= iEnd) { return 0; }
+    const uint64_t iFirstElem = iPos / m_iOutWidth;
+    const size_t iElems = size_t((iEnd + m_iOutWidth - 1) / m_iOutWidth -
+                                 iFirstElem);
+    std::vector<uint8_t> vIn(iElems * m_iInWidth);
+    std::vector<uint8_t> vOut(iElems * m_iOutWidth);
+    const size_t iGot = m_pInput->ReadRAWAt(&vIn[0], vIn.size(),
+                                            iFirstElem * m_iInWidth) /
+                        m_iInWidth;
+    Convert(&vIn[0], &vOut[0], iGot, NULL);
+    if((iFirstElem + iGot) * m_iOutWidth < iEnd) { m_bFailed = true; }
+    const size_t iAvailable = size_t(std::min(
+      iEnd, (iFirstElem + iGot) * m_iOutWidth) - iPos);
+    const size_t iSkip = size_t(iPos - iFirstElem * m_iOutWidth);
+    if(iAvailable > 0) { memcpy(pData, &vOut[iSkip], iAvailable); }
+    return iAvailable;
+  }
+
+  virtual size_t WriteRAW(const unsigned char*, uint64_t) { return 0; }
+  virtual bool CopyRAW(uint64_t, uint64_t, uint64_t, unsigned char*,
+                       uint64_t) { return false; }
+  // the offsets given to us would mean nothing to the file underneath.
+  virtual void Hint(IOHint, uint64_t, uint64_t) const {}
+
+  /// hands over the histogram, if it is known before any data are read.
+  /// Slices are then not binned as they are converted.
+  void SetHistogram(const std::vector<uint64_t>& vHist) {
+    m_vHist = vHist;
+    m_bHistogramSet = true;
+    std::fill(m_vBinned.begin(), m_vBinned.end(), true);
+  }
+  /// @returns true if the histogram came from SetHistogram.
+  bool HistogramSet() const { return m_bHistogramSet; }
+
+  /// @returns the histogram of all data, converting what was not read yet.
+  const std::vector<uint64_t>& Histogram() {
+    if(m_vHist.empty()) { return m_vHist; }
+    const bool bWasOpen = IsOpen();
+    if(!bWasOpen) { Open(false); }
+    std::vector<uint8_t> vOut;
+    for(uint64_t s=0; s < m_iSlices; ++s) {
+      if(!m_vBinned[size_t(s)]) {
+        if(vOut.empty()) { vOut.resize(size_t(m_iSliceElems * m_iOutWidth)); }
+        ConvertSlices(s, s+1, &vOut[0]);
+      }
+    }
+    if(!bWasOpen) { Close(); }
+    return m_vHist;
+  }
+
+  /// @returns true if the input came up short or turned out to be corrupt
+  /// while it was read; what was missing reads as zeros.
+  bool Failed() const { return m_bFailed; }
+
+protected:
+  /// converts 'iElems' elements from 'in' to 'out'.  If 'pHist' is non-NULL
+  /// the elements need to be binned into it as well.  'in' is scratch space
+  /// and may be modified.
+  virtual void Convert(uint8_t* in, uint8_t* out, size_t iElems,
+                       uint64_t* pHist) const = 0;
+
+private:
+  /// makes sure slice 'iSlice' is in core.  Slices which are in the slab
+  /// already and still needed are kept.
+  bool Load(uint64_t iSlice) {
+    if(iSlice >= m_iFirst && iSlice < m_iFirst + m_iCount) { return true; }
+    if(!IsOpen() || iSlice >= m_iSlices) { return false; }
+
+    const size_t iSliceBytes = size_t(m_iSliceElems * m_iOutWidth);
+    if(m_vSlab.empty()) { m_vSlab.resize(size_t(m_iSlabSlices) * iSliceBytes); }
+
+    const uint64_t iEnd = std::min(m_iSlices, iSlice + m_iSlabSlices);
+    uint64_t iKeep = 0;
+    if(iSlice > m_iFirst && iSlice < m_iFirst + m_iCount) {
+      iKeep = m_iFirst + m_iCount - iSlice;
+      memmove(&m_vSlab[0], &m_vSlab[size_t(iSlice - m_iFirst) * iSliceBytes],
+              size_t(iKeep) * iSliceBytes);
+    }
+    m_iFirst = iSlice;
+    m_iCount = iKeep +
+               ConvertSlices(iSlice + iKeep, iEnd,
+                             &m_vSlab[size_t(iKeep) * iSliceBytes]);
+    return m_iCount > 0;
+  }
+
+  /// reads, converts and (if not done before) bins slices [iFrom, iTo).
+  /// @returns the number of slices which could be read.
+  uint64_t ConvertSlices(uint64_t iFrom, uint64_t iTo, uint8_t* pOut) {
+    if(iFrom >= iTo) { return 0; }
+    const uint64_t iFirstElem = iFrom * m_iSliceElems;
+    const size_t iElems = size_t(std::min(m_iElems, iTo * m_iSliceElems) -
+                                 iFirstElem);
+    m_vIn.resize(std::max(m_vIn.size(), iElems * m_iInWidth));
+    const size_t iGot = m_pInput->ReadRAWAt(&m_vIn[0], iElems * m_iInWidth,
+                                            iFirstElem * m_iInWidth) /
+                        m_iInWidth;
+    if(iGot < iElems) {
+      WARNING("Short read from '%s' (%llu of %llu elements)",
+              m_strFilename.c_str(), uint64_t(iGot), uint64_t(iElems));
+      m_bFailed = true;
+    } else if(iTo == m_iSlices) {
+      // the end of a pass.  Compressed data may still fail their checksum.
+      const tuvok::DecompressingRAWFile* pCompressed =
+        dynamic_cast<const tuvok::DecompressingRAWFile*>(m_pInput.get());
+      if(pCompressed && pCompressed->Failed()) { m_bFailed = true; }
+    }
+
+    uint64_t iSlices = 0;
+    for(uint64_t s=iFrom; s < iTo; ++s) {
+      const size_t iOffset = size_t((s - iFrom) * m_iSliceElems);
+      if(iOffset >= iGot) { break; }
+      const size_t iExpected = size_t(std::min(m_iSliceElems,
+                                               m_iElems - s*m_iSliceElems));
+      const size_t n = std::min(iExpected, iGot - iOffset);
+      uint8_t* pSlice = pOut + iOffset * m_iOutWidth;
+      ++iSlices;
+      if(n < iExpected) {
+        // the rest of the file is missing; never bin incomplete slices.
+        Convert(&m_vIn[iOffset * m_iInWidth], pSlice, n, NULL);
+        memset(pSlice + n * m_iOutWidth, 0, (iExpected - n) * m_iOutWidth);
+        break;
+      }
+      const bool bBin = !m_vHist.empty() && !m_vBinned[size_t(s)];
+      Convert(&m_vIn[iOffset * m_iInWidth], pSlice, n,
+              bBin ? &m_vHist[0] : NULL);
+      m_vBinned[size_t(s)] = true;
+    }
+    return iSlices;
+  }
+
+  const LargeRAWFile_ptr m_pInput;
+  const size_t m_iInWidth;
+  const size_t m_iOutWidth;
+  const uint64_t m_iSliceElems;
+  const uint64_t m_iElems;
+  const uint64_t m_iSlices;
+  const uint64_t m_iSlabSlices;
+  uint64_t m_iPos;
+  uint64_t m_iFirst; ///< first slice in m_vSlab
+  uint64_t m_iCount; ///< number of slices in m_vSlab
+  std::vector<uint8_t> m_vIn;
+  std::vector<uint8_t> m_vSlab;
+  std::vector<bool> m_vBinned;
+  std::vector<uint64_t> m_vHist;
+  bool m_bHistogramSet;
+  mutable std::atomic<bool> m_bFailed;
+};
+
+/// Presents the raw T data in 'pInput' the way 'Quantize' would have
+/// written it to a file: byte swapped if requested, and mapped through the
+/// quantizer.  If the data fit as they are (see LinearQuantizer::fits),
+/// Quantize leaves them alone, and so do we.
+template <typename T, typename U>
+class QuantizingRAWFile : public SlabRAWFile {
+public:
+  QuantizingRAWFile(LargeRAWFile_ptr pInput, bool bSwap,
+                    const LinearQuantizer<T,U>& q,
+                    uint64_t iSliceElems, uint64_t iElems,
+                    uint64_t iSlabSlices) :
+    SlabRAWFile(pInput, sizeof(T), sizeof(U), iSliceElems,
+                iElems, iSlabSlices, q.fits() ? 0 : q.hist_size),
+    m_bSwap(bSwap),
+    m_bFits(q.fits()),
+    m_Quantizer(q)
+  {}
+
+protected:
+  virtual void Convert(uint8_t* in, uint8_t* out, size_t iElems,
+                       uint64_t* pHist) const {
+    T* pIn = reinterpret_cast<T*>(in);
+    U* pOut = reinterpret_cast<U*>(out);
+    if(m_bSwap) { tuvok::simd::ByteSwap(pIn, iElems, sizeof(T)); }
+    if(m_bFits) {
+      // no histogram either: Quantize does not compute one in this case.
+      assert(pHist == NULL);
+      std::copy(pIn, pIn + iElems, pOut);
+    } else {
+      m_Quantizer.apply(pIn, pOut, iElems, pHist);
+    }
+  }
+
+private:
+  const bool m_bSwap;
+  const bool m_bFits;
+  const LinearQuantizer<T,U> m_Quantizer;
+};
+
+/// Presents the data in 'pInput' as they are, read through the slab: for
+/// inputs which are cheap to read front to back, but not to seek in, such as
+/// a tuvok::DecompressingRAWFile.
+class BufferedRAWFile : public SlabRAWFile {
+public:
+  BufferedRAWFile(LargeRAWFile_ptr pInput, uint64_t iSliceBytes,
+                  uint64_t iBytes, uint64_t iSlabSlices) :
+    SlabRAWFile(pInput, 1, 1, iSliceBytes, iBytes, iSlabSlices, 0)
+  {}
+
+protected:
+  virtual void Convert(uint8_t* in, uint8_t* out, size_t iElems,
+                       uint64_t*) const {
+    memcpy(out, in, iElems);
+  }
+};
+
+/// Computes the range of the raw T data in 'file', swapping bytes first if
+/// requested.  Values which are small enough are counted in 'aHist' along the
+/// way, which is the complete histogram if the data turn out to fit into it.
+template <typename T>
+std::pair<T,T> SwappedMinMax(LargeRAWFile& file, bool bSwap, uint64_t iElems,
+                             std::vector<uint64_t>& aHist)
+{
+  const size_t iInCoreElems = std::max<size_t>(
+    1, AbstrConverter::GetIncoreSize() / sizeof(T)
+  );
+  std::vector<T> data(size_t(std::min<uint64_t>(iInCoreElems, iElems)));
+  TuvokProgress<uint64_t> progress(iElems);
+
+  std::pair<T,T> minmax(std::numeric_limits<T>::max(),
+                        std::numeric_limits<T>::min());
+  uint64_t iPos = 0;
+  while(iPos < iElems) {
+    const size_t n = file.ReadRAWAt(
+      reinterpret_cast<unsigned char*>(&data[0]),
+      std::min<uint64_t>(iElems - iPos, data.size()) * sizeof(T),
+      iPos * sizeof(T)
+    ) / sizeof(T);
+    if(n == 0) {
+      WARNING("Short file during minmax (%llu of %llu)", iPos, iElems);
+      break;
+    }
+    if(bSwap) { tuvok::simd::ByteSwap(&data[0], n, sizeof(T)); }
+    T lo = std::numeric_limits<T>::max();
+    T hi = std::numeric_limits<T>::min();
+    tuvok::simd::MinMax(&data[0], n, lo, hi);
+    minmax.first = std::min(minmax.first, lo);
+    minmax.second = std::max(minmax.second, hi);
+    if(lo >= 0 && static_cast<uint64_t>(hi) < aHist.size()) {
+      tuvok::simd::Histogram(&data[0], n, &aHist[0], aHist.size());
+    } else {
+      for(size_t i=0; i < n; ++i) {
+        // negative values become huge here, and are not counted.
+        if(static_cast<uint64_t>(data[i]) < aHist.size()) {
+          ++aHist[size_t(static_cast<uint64_t>(data[i]))];
+        }
+      }
+    }
+    iPos += n;
+    progress.notify("Computing value range", iPos);
+  }
+  MESSAGE("min/max is: [%g:%g]", static_cast<double>(minmax.first),
+          static_cast<double>(minmax.second));
+  return minmax;
+}
+
+#endif // SCIO_QUANTIZINGRAWFILE_H
@@ -54,7 +54,9 @@
 #include "UVF/TOCBlock.h"
 #include "UVF/UVF.h"
 #include "TuvokIOError.h"
+#include "DecompressingRAWFile.h"
 #include "Quantize.h"
+#include "QuantizingRAWFile.h"
 
 using namespace std;
 using namespace tuvok;
@@ -73,15 +75,13 @@ namespace {
   template<typename Target>
   void change_endianness(unsigned char* buffer,
                          size_t bytes_read) {
-    Target* buf = reinterpret_cast<Target*>(buffer);
-    const size_t N = bytes_read / sizeof(Target);
-    std::transform(buf, buf+N, buf, EndianConvert::Swap<Target>);
+    simd::ByteSwap(buffer, bytes_read / sizeof(Target), sizeof(Target));
   }
 }
 
-static std::string convert_endianness(const std::string& strFilename,
+static std::string convert_endianness(LargeRAWFile& WrongEndianData,
+                                      const std::string& strFilename,
                                       const std::string& strTempDir,
-                                      uint64_t iHeaderSkip,
                                       unsigned iComponentSize,
                                       size_t in_core_size)
 {
@@ -92,15 +92,6 @@ static std::string convert_endianness(const std::string& strFilename,
     return "";
   }
 
-  LargeRAWFile WrongEndianData(strFilename, iHeaderSkip);
-  WrongEndianData.Open(false);
-
-  if(!WrongEndianData.IsOpen()) {
-    T_ERROR("Unable to open source file '%s'", strFilename.c_str());
-    throw DSOpenFailed(strFilename.c_str(), "Unable to open source file",
-                       __FILE__, __LINE__);
-  }
-
   const std::string tmp_file = strTempDir + SysTools::GetFilename(strFilename) +
                                ".endianness";
   LargeRAWFile ConvertedEndianData(tmp_file);
@@ -126,6 +117,11 @@ static std::string convert_endianness(const std::string& strFilename,
   while(bytes_converted < byte_length) {
     using namespace boost;
     size_t bytes_read = WrongEndianData.ReadRAW(buffer.get(), buffer_size);
+    if(bytes_read == 0) {
+      WARNING("Source data end after %llu of %llu bytes.", bytes_converted,
+              byte_length);
+      break;
+    }
     switch(iComponentSize) {
       case 16: change_endianness<uint16_t>(buffer.get(), bytes_read); break;
       case 32: change_endianness<float>(buffer.get(), bytes_read); break;
@@ -350,6 +346,128 @@ quantize(std::shared_ptr<LargeRAWFile> sourceData,
   return sourceData;
 }
 
+/// One min/max pass over the data, then a view which swaps and quantizes
+/// while the bricker reads it.  Does what convert_endianness + quantize do,
+/// but without writing the intermediate files.
+/// @returns NULL if the data need binning instead (few distinct values).
+template <typename T, typename U>
+static std::shared_ptr<SlabRAWFile>
+stream_quantized(LargeRAWFile_ptr source, bool bConvertEndianness,
+                 uint64_t iSliceElems, uint64_t iElems, uint64_t iSlabSlices)
+{
+  const size_t hist_size = (sizeof(U) == 1) ? 256 : 4096;
+  std::vector<uint64_t> aHist(hist_size, 0);
+  const std::pair<T,T> minmax = SwappedMinMax<T>(*source, bConvertEndianness,
+                                                 iElems, aHist);
+
+  const LinearQuantizer<T,U> q(minmax, hist_size);
+  if(!ctti<T>::is_signed && sizeof(U) > 1) {
+    size_t iBinCount = bins_needed<T>(minmax);
+    if(q.fits()) {
+      iBinCount = size_t(aHist.size() -
+                         std::count(aHist.begin(), aHist.end(), 0));
+    }
+    if(iBinCount > 0 && iBinCount <= 256) {
+      MESSAGE("Data will be binned to %u values, cannot stream.",
+              static_cast<unsigned>(iBinCount));
+      return std::shared_ptr<SlabRAWFile>();
+    }
+  }
+
+  std::shared_ptr<SlabRAWFile> rv(new QuantizingRAWFile<T,U>(
+    source, bConvertEndianness, q, iSliceElems, iElems, iSlabSlices
+  ));
+  if(q.fits()) {
+    // the min/max pass counted every value already.  Trimmed as
+    // Histogram1DDataBlock::Compute trims, which is what would run otherwise.
+    while(!aHist.empty() && aHist.back() == 0) { aHist.pop_back(); }
+    rv->SetHistogram(aHist);
+  }
+  return rv;
+}
+
+template <typename U>
+static std::shared_ptr<SlabRAWFile>
+stream_as(LargeRAWFile_ptr source, bool bConvertEndianness, bool bSigned,
+          unsigned iComponentSize, uint64_t iSliceElems, uint64_t iElems,
+          uint64_t iSlabSlices)
+{
+#define STREAM(T) stream_quantized<T, U>(source, bConvertEndianness, \
+                                       iSliceElems, iElems, iSlabSlices)
+  switch(iComponentSize) {
+    case 16: return bSigned ? STREAM(int16_t) : STREAM(uint16_t);
+    case 32: return bSigned ? STREAM(int32_t) : STREAM(uint32_t);
+    case 64: return bSigned ? STREAM(int64_t) : STREAM(uint64_t);
+  }
+#undef STREAM
+  return std::shared_ptr<SlabRAWFile>();
+}
+
+/// The bricker reads a brick row along z at a time, so a SlabRAWFile needs
+/// to keep at least that many slices in core.
+/// @param iInWidth bytes per element of the input
+/// @param iCoreWidth bytes per element the SlabRAWFile keeps in core
+/// @returns the number of slices to keep, 0 if that needs too much memory.
+static uint64_t slab_slices(uint64_t iSliceElems, uint64_t iSlices,
+                            uint64_t iInWidth, uint64_t iCoreWidth,
+                            uint64_t iTargetBrickSize)
+{
+  const uint64_t iSlabSlices = std::min<uint64_t>(
+    iSlices,
+    std::max<uint64_t>(iTargetBrickSize, AbstrConverter::GetIncoreSize() /
+                                         (iSliceElems*iInWidth))
+  );
+  const uint64_t iSlabBytes = iSlabSlices * iSliceElems * iCoreWidth;
+  const uint64_t iMem = Controller::ConstInstance().SysInfo().
+                          GetMaxUsableCPUMem();
+  if(iSlabBytes > iMem / 4) {
+    MESSAGE("A slab of %llu slices would need %llu MB; not streaming.",
+            iSlabSlices, iSlabBytes / (1024*1024));
+    return 0;
+  }
+  return iSlabSlices;
+}
+
+/// the streaming alternative to convert_endianness + quantize, for integer
+/// data wider than 8 bits.  The histogram is binned as the data are read;
+/// see SlabRAWFile::Histogram.
+/// @param source the data as stored, opened
+/// @param iComponentSize bit width of data, in-out param.
+/// @returns NULL if the data cannot be streamed.
+static std::shared_ptr<SlabRAWFile>
+stream(LargeRAWFile_ptr source, bool bConvertEndianness, bool bSigned,
+       bool bIsFloat, unsigned& iComponentSize, uint64_t iComponentCount,
+       uint64_t timesteps, const UINT64VECTOR3& vVolumeSize,
+       uint64_t iTargetBrickSize, bool bQuantizeTo8Bit)
+{
+  // floating point data get binned; 8 bit data has its own processing.
+  if(bIsFloat || iComponentSize <= 8) {
+    return std::shared_ptr<SlabRAWFile>();
+  }
+
+  const uint64_t iWidth = iComponentSize / 8;
+  const uint64_t iSliceElems = iComponentCount * vVolumeSize.x * vVolumeSize.y;
+  const uint64_t iSlabSlices = slab_slices(iSliceElems,
+                                           vVolumeSize.z * timesteps, iWidth,
+                                           iWidth + 2, iTargetBrickSize);
+  if(iSlabSlices == 0) { return std::shared_ptr<SlabRAWFile>(); }
+
+  const uint64_t iElems = iSliceElems * vVolumeSize.z * timesteps;
+  std::shared_ptr<SlabRAWFile> rv;
+  if(bQuantizeTo8Bit) {
+    rv = stream_as<uint8_t>(source, bConvertEndianness, bSigned,
+                            iComponentSize, iSliceElems, iElems, iSlabSlices);
+  } else {
+    rv = stream_as<uint16_t>(source, bConvertEndianness, bSigned,
+                             iComponentSize, iSliceElems, iElems, iSlabSlices);
+  }
+  if(rv) {
+    iComponentSize = bQuantizeTo8Bit ? 8 : 16;
+    rv->Open(false);
+  }
+  return rv;
+}
+
 // Create a temporary file and return the name.
 // This isn't great -- there's a race between when we close and reopen it --
 // but there's no (standard) way to turn a file descriptor into an fstream or
@@ -409,6 +527,90 @@ make_raw(std::shared_ptr<LargeRAWFile> source, uint64_t n_components,
   return components;
 }
 
+/// opens the data in 'strFilename' as they are stored.
+/// @param iBytes size of the data, uncompressed
+static LargeRAWFile_ptr open_source(const std::string& strFilename,
+                                    uint64_t iHeaderSkip,
+                                    RAWEncoding eEncoding, uint64_t iBytes)
+{
+  LargeRAWFile_ptr source;
+  if(eEncoding == RE_RAW) {
+    source.reset(new LargeRAWFile(strFilename, iHeaderSkip));
+  } else {
+    MESSAGE("Decompressing %s data as they are read.",
+            eEncoding == RE_GZIP ? "gzip" : "bzip2");
+    source.reset(new DecompressingRAWFile(strFilename, iHeaderSkip, eEncoding,
+                                          iBytes));
+  }
+  if(!source->Open(false)) {
+    using namespace tuvok::io;
+    throw DSOpenFailed(strFilename.c_str(), "Could not open data for "
+                       "processing.", __FILE__, __LINE__);
+  }
+  return source;
+}
+
+/// @returns true if reading 'file' came up short, or found its compressed
+/// data to be corrupt.  Both stick, so one check after a pass is enough.
+static bool read_failed(const LargeRAWFile_ptr& file)
+{
+  const SlabRAWFile* pSlab = dynamic_cast<const SlabRAWFile*>(file.get());
+  const DecompressingRAWFile* pCompressed =
+    dynamic_cast<const DecompressingRAWFile*>(file.get());
+  return (pSlab && pSlab->Failed()) || (pCompressed && pCompressed->Failed());
+}
+
+/// readies data which are still compressed for the bricker, which seeks
+/// around in its input: through a slab if that fits into memory, via an
+/// uncompressed temporary file if not.
+/// @returns NULL if the data could not be decompressed completely.
+static LargeRAWFile_ptr seekable(LargeRAWFile_ptr source,
+                                 const std::string& strTempFile,
+                                 uint64_t iSlices, uint64_t iTargetBrickSize)
+{
+  const uint64_t iBytes = source->GetCurrentSize();
+  const uint64_t iSliceBytes = iBytes / iSlices;
+  const uint64_t iSlabSlices = slab_slices(iSliceBytes, iSlices, 1, 2,
+                                           iTargetBrickSize);
+  if(iSlabSlices > 0) {
+    MESSAGE("Decompressing while bricking, no intermediate files needed.");
+    LargeRAWFile_ptr rv(new BufferedRAWFile(source, iSliceBytes, iBytes,
+                                            iSlabSlices));
+    rv->Open(false);
+    return rv;
+  }
+
+  MESSAGE("Decompressing to %s ...", strTempFile.c_str());
+  LargeRAWFile_ptr rv(new TempFile(strTempFile));
+  if(!rv->Create()) {
+    using namespace tuvok::io;
+    throw DSOpenFailed(strTempFile.c_str(), "Unable to create file",
+                       __FILE__, __LINE__);
+  }
+  std::vector<unsigned char> buffer(AbstrConverter::GetIncoreSize());
+  source->SeekStart();
+  size_t iRead;
+  uint64_t iTotal = 0;
+  while((iRead = source->ReadRAW(&buffer[0], buffer.size())) > 0) {
+    if(rv->WriteRAW(&buffer[0], iRead) != iRead) {
+      using namespace tuvok::io;
+      throw IOException("Write failed during decompression.", __FILE__,
+                        __LINE__);
+    }
+    iTotal += iRead;
+  }
+  if(iTotal != iBytes || read_failed(source)) {
+    T_ERROR("Decompressing %s gave %llu of %llu bytes, or corrupt data.",
+            source->GetFilename().c_str(), iTotal, iBytes);
+    source->Close();
+    return LargeRAWFile_ptr();
+  }
+  source->Close();
+  rv->Close();
+  rv->Open(false);
+  return rv;
+}
+
 bool RAWConverter::ConvertRAWDataset(const string& strFilename,
                                      const string& strTargetFilename,
                                      const string& strTempDir,
@@ -430,7 +632,9 @@ bool RAWConverter::ConvertRAWDataset(const string& strFilename,
                                      uint32_t iBrickCompressionLevel,
                                      uint32_t iBrickLayout,
                                      KVPairs* pKVPairs,
-                                     const bool bQuantizeTo8Bit)
+                                     const bool bQuantizeTo8Bit,
+                                     const bool bStreaming,
+                                     RAWEncoding eEncoding)
 {
   if (!SysTools::FileExists(strFilename)) {
     T_ERROR("Data file %s not found; maybe there is an invalid reference in "
@@ -486,39 +690,74 @@ bool RAWConverter::ConvertRAWDataset(const string& strFilename,
   string tmpQuantizedFile = strTempDir+SysTools::GetFilename(strFilename)+".quantized";
 
   std::shared_ptr<LargeRAWFile> sourceData;
-
-  if (bConvertEndianness) {
-    // the new data source is the endian-converted file.
-    size_t core_size = static_cast<size_t>(iTargetBrickSize*iTargetBrickSize*
-                                           iTargetBrickSize * iComponentSize/8);
-    string tmpEndianConvertedFile =
-      convert_endianness(strFilename, strTempDir, iHeaderSkip, iComponentSize,
-                         core_size);
-    iHeaderSkip = 0;  // the new file is straight raw without any header
-    MESSAGE("temporary source data; no header skip.");
-    sourceData = std::shared_ptr<LargeRAWFile>(
-      new TempFile(tmpEndianConvertedFile)
-    );
-  } else {
-    MESSAGE("non-temp source data, with %llu-byte header skip", iHeaderSkip);
-    sourceData = std::shared_ptr<LargeRAWFile>(
-      new LargeRAWFile(strFilename, iHeaderSkip)
-    );
-  }
-  sourceData->Open(false);
-  if(!sourceData->IsOpen()) {
-    using namespace tuvok::io;
-    throw DSOpenFailed(sourceData->GetFilename().c_str(), "Could not open data"
-                       " for processing.", __FILE__, __LINE__);
-  }
-
   Histogram1DDataBlock Histogram1D;
 
   assert((iComponentCount*vVolumeSize.volume()*timesteps) > 0);
 
-  sourceData = quantize(sourceData, tmpQuantizedFile, bSigned, bIsFloat,
-                        iComponentSize, iComponentCount, timesteps,
-                        vVolumeSize.volume(), bQuantizeTo8Bit, &Histogram1D);
+  // compressed data are decompressed as they are read, which is what each
+  // of the passes below does; that saves writing them to disk uncompressed.
+  LargeRAWFile_ptr storedData = open_source(
+    strFilename, iHeaderSkip, eEncoding,
+    iComponentCount*vVolumeSize.volume()*timesteps*iComponentSize/8
+  );
+
+  // Swapping and quantizing as the data are bricked saves writing (and
+  // reading back) two copies of the data.
+  std::shared_ptr<SlabRAWFile> streamData;
+  if(bStreaming) {
+    streamData = stream(storedData, bConvertEndianness, bSigned,
+                        bIsFloat, iComponentSize, iComponentCount, timesteps,
+                        vVolumeSize, iTargetBrickSize, bQuantizeTo8Bit);
+  }
+
+  if(streamData) {
+    MESSAGE("Converting while bricking, no intermediate files needed.");
+    sourceData = streamData;
+  } else {
+    if (bConvertEndianness) {
+      // the new data source is the endian-converted file.
+      size_t core_size = static_cast<size_t>(iTargetBrickSize *
+                                             iTargetBrickSize *
+                                             iTargetBrickSize *
+                                             iComponentSize/8);
+      string tmpEndianConvertedFile =
+        convert_endianness(*storedData, strFilename, strTempDir,
+                           iComponentSize, core_size);
+      iHeaderSkip = 0;  // the new file is straight raw without any header
+      MESSAGE("temporary source data; no header skip.");
+      sourceData = std::shared_ptr<LargeRAWFile>(
+        new TempFile(tmpEndianConvertedFile)
+      );
+      sourceData->Open(false);
+      if(!sourceData->IsOpen()) {
+        using namespace tuvok::io;
+        throw DSOpenFailed(sourceData->GetFilename().c_str(), "Could not "
+                           "open data for processing.", __FILE__, __LINE__);
+      }
+    } else {
+      MESSAGE("non-temp source data, with %llu-byte header skip",
+              iHeaderSkip);
+      sourceData = storedData;
+    }
+
+    sourceData = quantize(sourceData, tmpQuantizedFile, bSigned, bIsFloat,
+                          iComponentSize, iComponentCount, timesteps,
+                          vVolumeSize.volume(), bQuantizeTo8Bit,
+                          &Histogram1D);
+    if(sourceData == storedData && eEncoding != RE_RAW) {
+      sourceData = seekable(
+        storedData,
+        strTempDir + SysTools::GetFilename(strFilename) + ".uncompressed",
+        vVolumeSize.z * timesteps, iTargetBrickSize
+      );
+      if(!sourceData) { return false; }
+    }
+  }
+  // the min/max, endian conversion and quantization passes are done.
+  if(read_failed(storedData)) {
+    T_ERROR("Reading %s failed, aborting.", strFilename.c_str());
+    return false;
+  }
 
   // if it was signed, we un-signed it. If it was unsigned.. it was unsigned.
   bSigned = false;
@@ -615,6 +854,12 @@ bool RAWConverter::ConvertRAWDataset(const string& strFilename,
       uvfFile.Close();
       return false;
     }
+    if(read_failed(sourceData)) {
+      T_ERROR("Reading %s failed during brick generation, aborting.",
+              strFilename.c_str());
+      uvfFile.Close();
+      return false;
+    }
 
     MESSAGE("Hierarchy computation complete.");
 
@@ -627,6 +872,23 @@ bool RAWConverter::ConvertRAWDataset(const string& strFilename,
     // do not compute histograms when we are dealing with color data
     /// \todo change this if we want to support non color multi component data
     if (iComponentCount != 4 && iComponentCount != 3) {
+      // when streaming, the histogram was computed while bricking
+      if (streamData && Histogram1D.GetHistogram().empty()) {
+        std::vector<uint64_t> aHist = streamData->Histogram();
+        if(streamData->Failed()) {
+          T_ERROR("Reading %s failed during histogram computation, "
+                  "aborting.", strFilename.c_str());
+          uvfFile.Close();
+          return false;
+        }
+        Histogram1D.SetHistogram(aHist);
+        // data which were not quantized have the histogram Compute would
+        // give them; label it the same way, too.
+        if (streamData->HistogramSet() && !aHist.empty()) {
+          Histogram1D.strBlockID = "1D Histogram for datablock " +
+                                   dataVolume->strBlockID;
+        }
+      }
       // if no re-sampling was performed above, we need to compute the
       // 1d histogram here
       if (Histogram1D.GetHistogram().empty()) {
@@ -1173,6 +1435,10 @@ bool RAWConverter::ConvertToUVF(const std::list<std::string>& files,
   std::list<uint64_t> header_skip;
 
   bool success = true;
+  // a single file can be converted straight from compressed data; merging
+  // several needs each of them as they are.
+  m_bMayKeepCompressed = files.size() == 1;
+  m_eEncoding = RE_RAW;
   for(std::list<std::string>::const_iterator fn = files.begin();
       fn != files.end(); ++fn) {
     std::string intermediate;
@@ -1198,6 +1464,7 @@ bool RAWConverter::ConvertToUVF(const std::list<std::string>& files,
     header_skip.push_front(iHeaderSkip);
   }
   // then rewrite convertrawdataset to take the new list
+  m_bMayKeepCompressed = false;
 
   if (!success) {
     T_ERROR("Convert to RAW step failed, aborting.");
@@ -1273,7 +1540,9 @@ bool RAWConverter::ConvertToUVF(const std::list<std::string>& files,
                                        iBrickCompressionLevel,
                                        iBrickLayout,
                                        0,
-                                       bQuantizeTo8Bit);
+                                       bQuantizeTo8Bit,
+                                       true,
+                                       m_eEncoding);
 
   if (*bDeleteIntermediateFile.begin()) {
     Remove(merged_fn, Controller::Debug::Out());
@@ -1282,6 +1551,13 @@ bool RAWConverter::ConvertToUVF(const std::list<std::string>& files,
   return bUVFCreated;
 }
 
+bool RAWConverter::KeepCompressed(RAWEncoding eEncoding)
+{
+  if(!m_bMayKeepCompressed) { return false; }
+  m_eEncoding = eEncoding;
+  return true;
+}
+
 bool RAWConverter::Analyze(const std::string& strSourceFilename,
                            const std::string& strTempDir,
                            bool bNoUserInteraction, RangeInfo& info) {
@@ -45,6 +45,7 @@
 #include <list>
 #include "AbstrConverter.h"
 #include "Controller/Controller.h"
+#include "DecompressingRAWFile.h"
 #include "IOManager.h"  // for the size defines
 
 typedef std::vector<std::pair<std::string, std::string>> KVPairs;
@@ -74,8 +75,13 @@ public:
 
 class RAWConverter : public AbstrConverter {
 public:
+  RAWConverter() : m_bMayKeepCompressed(false), m_eEncoding(tuvok::RE_RAW) {}
   virtual ~RAWConverter() {}
 
+  /// @param bStreaming swap and quantize the data while they are bricked,
+  /// instead of via temporary files, where the data allow it.
+  /// @param eEncoding how the data are stored; compressed data are
+  /// decompressed as they are read.
   static bool ConvertRAWDataset(const std::string& strFilename,
                                 const std::string& strTargetFilename,
                                 const std::string& strTempDir,
@@ -95,7 +101,9 @@ public:
                                 uint32_t iBrickCompressionLevel,
                                 uint32_t iBrickLayout,
                                 KVPairs* pKVPairs = NULL,
-                                const bool bQuantizeTo8Bit=false);
+                                const bool bQuantizeTo8Bit=false,
+                                const bool bStreaming=true,
+                                tuvok::RAWEncoding eEncoding=tuvok::RE_RAW);
 
   static bool ExtractGZIPDataset(const std::string& strFilename,
                                  const std::string& strUncompressedFile,
@@ -170,6 +178,17 @@ public:
   /// deleted.
   /// @return true if the remove succeeded.
   static bool Remove(const std::string &, AbstrDebugOut &);
+
+protected:
+  /// For ConvertToRAW implementations with compressed data: rather than
+  /// extracting them to an intermediate file, point to the data as they are
+  /// if the caller can decompress them while it converts.
+  /// @returns false if the caller needs them extracted after all.
+  bool KeepCompressed(tuvok::RAWEncoding eEncoding);
+
+private:
+  bool m_bMayKeepCompressed; ///< ConvertToRAW may call KeepCompressed
+  tuvok::RAWEncoding m_eEncoding; ///< what ConvertToRAW's data look like
 };
 
 #endif // RAWCONVERTER_H
@@ -0,0 +1,128 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "SlicePipeline.h"
+
+namespace tuvok {
+
+bool ReadSlicesInOrder(
+  size_t iSlices,
+  const std::function<bool (size_t, std::vector<char>&)>& read,
+  const std::function<bool (size_t, const std::vector<char>&)>& write)
+{
+  // read outside the ordered region, to skip reading once a slice failed
+  std::atomic<bool> bOK(true);
+  const int64_t n = static_cast<int64_t>(iSlices);
+#pragma omp parallel
+  {
+    std::vector<char> vData;
+#pragma omp for ordered schedule(dynamic)
+    for(int64_t i=0; i < n; ++i) {
+      const size_t iSlice = static_cast<size_t>(i);
+      bool bRead = false;
+      if(bOK) { bRead = read(iSlice, vData); }
+#pragma omp ordered
+      {
+        if(bOK && !(bRead && write(iSlice, vData))) { bOK = false; }
+      }
+    }
+  }
+  return bOK;
+}
+
+namespace {
+  // spelled out with shifts, as compilers vectorize these but not calls to
+  // EndianConvert::Swap.
+  inline uint16_t ByteSwap(uint16_t v) {
+    return static_cast<uint16_t>((v >> 8) | (v << 8));
+  }
+  inline uint32_t ByteSwap(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xff00u) | ((v << 8) & 0xff0000u) |
+           (v << 24);
+  }
+  inline uint64_t ByteSwap(uint64_t v) {
+    return (uint64_t(ByteSwap(uint32_t(v))) << 32) |
+           ByteSwap(uint32_t(v >> 32));
+  }
+
+  template<typename T>
+  void SwapEach(std::vector<char>& vData) {
+    T* pData = reinterpret_cast<T*>(vData.data());
+    const size_t n = vData.size() / sizeof(T);
+    for(size_t i=0; i < n; ++i) { pData[i] = ByteSwap(pData[i]); }
+  }
+
+  template<typename T>
+  void ScaleEach(std::vector<char>& vData, float fScale, float fBias) {
+    T* pData = reinterpret_cast<T*>(vData.data());
+    const size_t n = vData.size() / sizeof(T);
+    for(size_t i=0; i < n; ++i) {
+      pData[i] = static_cast<T>(pData[i] * fScale + fBias);
+    }
+  }
+}
+
+void SwapEndianness(std::vector<char>& vData, unsigned iBits) {
+  switch(iBits) {
+    case 16: SwapEach<uint16_t>(vData); break;
+    case 32: SwapEach<uint32_t>(vData); break;
+    case 64: SwapEach<uint64_t>(vData); break;
+    default: break;
+  }
+}
+
+void ScaleAndBias(std::vector<char>& vData, unsigned iBits, bool bSigned,
+                  float fScale, float fBias) {
+  switch(iBits) {
+    case  8: if(bSigned) ScaleEach<int8_t>(vData, fScale, fBias);
+             else        ScaleEach<uint8_t>(vData, fScale, fBias);
+             break;
+    case 16: if(bSigned) ScaleEach<int16_t>(vData, fScale, fBias);
+             else        ScaleEach<uint16_t>(vData, fScale, fBias);
+             break;
+    case 32: if(bSigned) ScaleEach<int32_t>(vData, fScale, fBias);
+             else        ScaleEach<uint32_t>(vData, fScale, fBias);
+             break;
+    default: break;
+  }
+}
+
+void RGBToRGBA(const std::vector<char>& vRGB, std::vector<char>& vRGBA) {
+  const size_t n = vRGB.size() / 3;
+  vRGBA.resize(n*4);
+  for(size_t i=0; i < n; ++i) {
+    vRGBA[i*4+0] = vRGB[i*3+0];
+    vRGBA[i*4+1] = vRGB[i*3+1];
+    vRGBA[i*4+2] = vRGB[i*3+2];
+    vRGBA[i*4+3] = char(255);
+  }
+}
+
+}
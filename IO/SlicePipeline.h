@@ -0,0 +1,63 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_SLICEPIPELINE_H
+#define TUVOK_SLICEPIPELINE_H
+
+#include "StdTuvokDefines.h"
+#include <functional>
+#include <vector>
+
+namespace tuvok {
+
+/// Reads slices with 'read(i, data)' on all cores and hands them to
+/// 'write(i, data)' in order, one at a time.  A slice waits for its
+/// predecessors to be written before its thread reads the next one, so at
+/// most one slice per thread is held in memory.  Stops reading after the
+/// first failure.
+/// @returns false if a read or a write failed.
+bool ReadSlicesInOrder(
+  size_t iSlices,
+  const std::function<bool (size_t, std::vector<char>&)>& read,
+  const std::function<bool (size_t, const std::vector<char>&)>& write);
+
+/// Reverses the bytes of each 'iBits' wide value in 'vData'.
+void SwapEndianness(std::vector<char>& vData, unsigned iBits);
+
+/// Applies a rescale slope and intercept to each 'iBits' wide integer in
+/// 'vData', truncating the result to the integer's type.
+void ScaleAndBias(std::vector<char>& vData, unsigned iBits, bool bSigned,
+                  float fScale, float fBias);
+
+/// Expands 8bit RGB data to RGBA, with an opaque alpha.
+void RGBToRGBA(const std::vector<char>& vRGB, std::vector<char>& vRGBA);
+
+}
+
+#endif
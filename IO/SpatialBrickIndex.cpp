@@ -0,0 +1,122 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <limits>
+#include "SpatialBrickIndex.h"
+
+namespace tuvok {
+
+namespace {
+  const BrickMD& md(BrickTable::const_iterator b) { return b->second; }
+}
+
+SpatialBrickIndex::SpatialBrickIndex(
+  std::vector<BrickTable::const_iterator> bricks)
+{
+  m_vBricks.swap(bricks);
+  std::sort(m_vBricks.begin(), m_vBricks.end(),
+    [](BrickTable::const_iterator a, BrickTable::const_iterator b) {
+      return std::get<2>(a->first) < std::get<2>(b->first);
+    });
+}
+
+void SpatialBrickIndex::BuildTree() const {
+  std::call_once(m_TreeBuilt, [this]() {
+    m_vOrder.resize(m_vBricks.size());
+    for(size_t i=0; i < m_vOrder.size(); ++i) { m_vOrder[i] = uint32_t(i); }
+    m_vNodes.reserve(2*m_vBricks.size());
+    if(!m_vBricks.empty()) { Build(0, m_vBricks.size()); }
+  });
+}
+
+uint32_t SpatialBrickIndex::Build(size_t iFirst, size_t iLast) const {
+  const uint32_t n = uint32_t(m_vNodes.size());
+  m_vNodes.push_back(Node());
+
+  const float fMax = std::numeric_limits<float>::max();
+  FLOATVECTOR3 vLow(fMax, fMax, fMax), vHigh(-fMax, -fMax, -fMax);
+  FLOATVECTOR3 vCenterLow(vLow), vCenterHigh(vHigh);
+  for(size_t i=iFirst; i < iLast; ++i) {
+    const BrickMD& b = md(m_vBricks[m_vOrder[i]]);
+    vLow.StoreMin(b.center - b.extents * 0.5f);
+    vHigh.StoreMax(b.center + b.extents * 0.5f);
+    vCenterLow.StoreMin(b.center);
+    vCenterHigh.StoreMax(b.center);
+  }
+  m_vNodes[n].vCenter = (vLow + vHigh) * 0.5f;
+  m_vNodes[n].vExtents = vHigh - vLow;
+  m_vNodes[n].bLeaf = iLast - iFirst == 1;
+  if(m_vNodes[n].bLeaf) {
+    m_vNodes[n].iBrick = m_vOrder[iFirst];
+    return n;
+  }
+
+  // split along the axis the centers spread the most over, next to the
+  // middle but between two different center coordinates: bricks in a grid
+  // then never end up on both sides.
+  const FLOATVECTOR3 vSpread = vCenterHigh - vCenterLow;
+  const uint32_t iAxis = vSpread.x >= vSpread.y && vSpread.x >= vSpread.z ? 0
+                       : vSpread.y >= vSpread.z ? 1 : 2;
+  auto center = [&](size_t i) {
+    return md(m_vBricks[m_vOrder[i]]).center[iAxis];
+  };
+  std::sort(m_vOrder.begin()+iFirst, m_vOrder.begin()+iLast,
+    [&](uint32_t a, uint32_t b) {
+      return md(m_vBricks[a]).center[iAxis] < md(m_vBricks[b]).center[iAxis];
+    });
+  const size_t iMid = iFirst + (iLast-iFirst)/2;
+  size_t iUp = iMid, iDown = iMid;
+  while(iUp < iLast && center(iUp) == center(iUp-1)) { ++iUp; }
+  while(iDown > iFirst+1 && center(iDown) == center(iDown-1)) { --iDown; }
+  size_t iSplit = iMid; // all centers are the same: any split will do.
+  const bool bDown = center(iDown) != center(iDown-1);
+  if(iUp < iLast && (!bDown || iUp-iMid <= iMid-iDown)) {
+    iSplit = iUp;
+  } else if(bDown) {
+    iSplit = iDown;
+  }
+
+  float fLeft = -fMax, fRight = fMax;
+  for(size_t i=iFirst; i < iLast; ++i) {
+    const BrickMD& b = md(m_vBricks[m_vOrder[i]]);
+    if(i < iSplit) {
+      fLeft = std::max(fLeft, b.center[iAxis] + b.extents[iAxis] * 0.5f);
+    } else {
+      fRight = std::min(fRight, b.center[iAxis] - b.extents[iAxis] * 0.5f);
+    }
+  }
+  m_vNodes[n].iAxis = iAxis;
+  m_vNodes[n].fSplit = (fLeft + fRight) * 0.5f;
+
+  Build(iFirst, iSplit);
+  const uint32_t iRight = Build(iSplit, iLast);
+  m_vNodes[n].iRight = iRight;
+  return n;
+}
+
+}
@@ -0,0 +1,117 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_SPATIALBRICKINDEX_H
+#define TUVOK_SPATIALBRICKINDEX_H
+
+#include "StdTuvokDefines.h"
+#include <mutex>
+#include <vector>
+#include "Brick.h"
+
+namespace tuvok {
+
+/// The bricks of one timestep and LOD: a dense array in the order of their
+/// 1D indices, and a bounding volume hierarchy over their boxes.  Each inner
+/// node splits its bricks with an axis-aligned plane which no brick crosses,
+/// so visiting the side the eye is on first gives a front-to-back order
+/// without sorting, and whole subtrees can be culled at once.  The hierarchy
+/// is built on the first FrontToBack; counting bricks does not need it.
+class SpatialBrickIndex {
+public:
+  /// 'bricks' must all belong to the same timestep and LOD.
+  explicit SpatialBrickIndex(std::vector<BrickTable::const_iterator> bricks);
+
+  size_t size() const { return m_vBricks.size(); }
+  bool empty() const { return m_vBricks.empty(); }
+  /// @returns the brick with the i-th smallest 1D index.
+  BrickTable::const_iterator operator[](size_t i) const {
+    return m_vBricks[i];
+  }
+
+  /// Calls 'visit(BrickTable::const_iterator)' for the bricks in
+  /// front-to-back order as seen from 'vEye'.  Subtrees whose bounds
+  /// 'needed(center, extents)' rejects are skipped; it is only asked about
+  /// groups of bricks, the caller must still test the bricks themselves.
+  template<typename Needed, typename Visit>
+  void FrontToBack(const FLOATVECTOR3& vEye, Needed needed,
+                   Visit visit) const;
+
+  struct Node {
+    FLOATVECTOR3 vCenter;
+    FLOATVECTOR3 vExtents;
+    float fSplit;     ///< position of the splitting plane
+    uint32_t iAxis;   ///< axis the splitting plane is normal to
+    uint32_t iRight;  ///< the other child; the first one is the next node
+    uint32_t iBrick;  ///< brick of a leaf, in m_vBricks
+    bool bLeaf;
+  };
+
+private:
+  /// builds the whole hierarchy, once.
+  void BuildTree() const;
+  /// builds the subtree over m_vOrder[iFirst, iLast).  @returns its root
+  uint32_t Build(size_t iFirst, size_t iLast) const;
+
+  std::vector<BrickTable::const_iterator> m_vBricks;
+  mutable std::once_flag m_TreeBuilt;
+  mutable std::vector<uint32_t> m_vOrder; ///< m_vBricks, regrouped by the tree
+  mutable std::vector<Node> m_vNodes; ///< depth first; m_vNodes[0] is the root
+};
+
+template<typename Needed, typename Visit>
+void SpatialBrickIndex::FrontToBack(const FLOATVECTOR3& vEye, Needed needed,
+                             Visit visit) const
+{
+  BuildTree();
+  if(m_vNodes.empty()) { return; }
+  std::vector<uint32_t> stack(1, 0);
+  while(!stack.empty()) {
+    const uint32_t n = stack.back();
+    stack.pop_back();
+    const Node& node = m_vNodes[n];
+    if(node.bLeaf) {
+      visit(m_vBricks[node.iBrick]);
+      continue;
+    }
+    if(!needed(node.vCenter, node.vExtents)) { continue; }
+    // the near side goes on the stack last, so it is visited first.
+    if(vEye[node.iAxis] < node.fSplit) {
+      stack.push_back(node.iRight);
+      stack.push_back(n+1);
+    } else {
+      stack.push_back(n+1);
+      stack.push_back(node.iRight);
+    }
+  }
+}
+
+}
+
+#endif // TUVOK_SPATIALBRICKINDEX_H
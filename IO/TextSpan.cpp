@@ -0,0 +1,303 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <locale>
+#include "Basics/MemMappedFile.h"
+#include "Basics/SysTools.h"
+#include "TextSpan.h"
+#include "TuvokIOError.h"
+
+// the direct conversion relies on double arithmetic being done in double.
+#if (defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0) || defined(_M_X64)
+# define TUVOK_EXACT_DOUBLES 1
+#else
+# define TUVOK_EXACT_DOUBLES 0
+#endif
+
+namespace tuvok {
+
+namespace {
+  inline bool IsBlank(char c) {
+    return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+  }
+  // what isspace says in the C locale; strtod and strtol skip these.
+  inline bool IsSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+  inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+  inline char Lower(char c) { return (c >= 'A' && c <= 'Z') ? c-'A'+'a' : c; }
+
+  const char* FindBlank(const char* p, const char* e) {
+    while(p != e && !IsBlank(*p)) { ++p; }
+    return p;
+  }
+  const char* SkipBlanks(const char* p, const char* e) {
+    while(p != e && IsBlank(*p)) { ++p; }
+    return p;
+  }
+  const char* Find(const char* p, const char* e, char c) {
+    const void* found = memchr(p, c, static_cast<size_t>(e-p));
+    return found ? static_cast<const char*>(found) : e;
+  }
+
+  const double aPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  /// Converts all of [p, e) if it is [+-]?d*(.d*)?([eE][+-]?d+)? with at
+  /// least one mantissa digit.  Mantissas of up to 53 bits and powers of
+  /// ten up to 22 are exact doubles, so then one multiplication or division
+  /// rounds correctly, as strtod does.
+  /// @returns false for anything else.
+  bool PlainDecimal(const char* p, const char* e, double& d) {
+    if(!TUVOK_EXACT_DOUBLES) { return false; }
+    const bool bNegative = p != e && *p == '-';
+    if(p != e && (*p == '-' || *p == '+')) { ++p; }
+
+    uint64_t iMantissa = 0;
+    int iSignificant = 0;
+    int iExp = 0;
+    bool bDigits = false;
+    for(; p != e && IsDigit(*p); ++p) {
+      bDigits = true;
+      if(iMantissa != 0 || *p != '0') {
+        if(++iSignificant > 19) { return false; }
+        iMantissa = iMantissa*10 + uint64_t(*p - '0');
+      }
+    }
+    if(p != e && *p == '.') {
+      for(++p; p != e && IsDigit(*p); ++p) {
+        bDigits = true;
+        if(iMantissa != 0 || *p != '0') {
+          if(++iSignificant > 19) { return false; }
+          iMantissa = iMantissa*10 + uint64_t(*p - '0');
+        }
+        --iExp;
+      }
+    }
+    if(!bDigits) { return false; }
+    if(p != e && (*p == 'e' || *p == 'E')) {
+      ++p;
+      const bool bNegativeExp = p != e && *p == '-';
+      if(p != e && (*p == '-' || *p == '+')) { ++p; }
+      if(p == e || !IsDigit(*p)) { return false; }
+      int iE = 0;
+      for(; p != e && IsDigit(*p); ++p) {
+        if(iE < 10000) { iE = iE*10 + (*p - '0'); }
+      }
+      iExp += bNegativeExp ? -iE : iE;
+    }
+    if(p != e) { return false; }
+
+    if(iMantissa == 0) {
+      d = bNegative ? -0.0 : 0.0;
+      return true;
+    }
+    if(iMantissa > (uint64_t(1) << 53) || iExp < -22 || iExp > 22) {
+      return false;
+    }
+    d = static_cast<double>(iMantissa);
+    d = iExp < 0 ? d / aPow10[-iExp] : d * aPow10[iExp];
+    if(bNegative) { d = -d; }
+    return true;
+  }
+
+  /// Rounding the correctly rounded double to float gives the correctly
+  /// rounded float, unless the double fell exactly between two floats; and
+  /// denormal or overflowing floats are left to the library.
+  bool RoundsToFloat(double d) {
+    if(d == 0.0) { return true; }
+    const double a = std::fabs(d);
+    if(a < FLT_MIN || a > FLT_MAX) { return false; }
+    uint64_t iBits;
+    memcpy(&iBits, &d, sizeof(iBits));
+    // the 29 bits a double has beyond a float's mantissa
+    const uint64_t iHalf = uint64_t(1) << 28;
+    return (iBits & (2*iHalf - 1)) != iHalf;
+  }
+}
+
+bool TextSpan::Is(const char* s) const {
+  const char* p = begin;
+  for(; p != end && *s != '\0'; ++p, ++s) {
+    if(Lower(*p) != *s) { return false; }
+  }
+  return p == end && *s == '\0';
+}
+
+size_t TextSpan::Count(char c) const {
+  return static_cast<size_t>(std::count(begin, end, c));
+}
+
+TextSpan TextSpan::UpTo(char c) const {
+  return TextSpan(begin, Find(begin, end, c));
+}
+
+TextSpan TextSpan::Trimmed() const {
+  const char* b = SkipBlanks(begin, end);
+  const char* e = end;
+  while(e != b && IsBlank(e[-1])) { --e; }
+  return TextSpan(b, e);
+}
+
+TextSpan TextSpan::TrimmedRight() const {
+  const char* e = end;
+  while(e != begin && IsBlank(e[-1])) { --e; }
+  return TextSpan(begin, e);
+}
+
+bool TextSpan::PopLine(TextSpan& line) {
+  if(empty()) { return false; }
+  const char* nl = Find(begin, end, '\n');
+  line = TextSpan(begin, nl);
+  begin = (nl == end) ? end : nl+1;
+  return true;
+}
+
+TextSpan TextSpan::PopToken() {
+  const char* p = FindBlank(begin, end);
+  const TextSpan token(begin, p);
+  begin = SkipBlanks(p, end);
+  return token;
+}
+
+TextSpan TextSpan::PopToken(char cDelim) {
+  const char* p = Find(begin, end, cDelim);
+  if(p == end) {
+    const TextSpan all = *this;
+    begin = end;
+    return all;
+  }
+  const TextSpan token = TextSpan(begin, p).TrimmedRight();
+  begin = p+1;
+  return token;
+}
+
+void TextSpan::SkipToken() {
+  begin = SkipBlanks(FindBlank(begin, end), end);
+}
+
+void TextSpan::SkipToken(char cDelim) {
+  const char* p = Find(begin, end, cDelim);
+  begin = (p == end) ? end : p+1;
+}
+
+TextSpan TextSpan::PopWord() {
+  while(begin != end && IsSpace(*begin)) { ++begin; }
+  const char* p = begin;
+  while(p != end && !IsSpace(*p)) { ++p; }
+  const TextSpan word(begin, p);
+  begin = p;
+  return word;
+}
+
+std::vector<TextSpan> SplitLines(TextSpan text, size_t iPieceSize) {
+  std::vector<TextSpan> pieces;
+  const size_t iStep = std::max<size_t>(1, iPieceSize);
+  const char* p = text.begin;
+  while(p != text.end) {
+    const char* e = text.end;
+    if(static_cast<size_t>(text.end - p) > iStep) {
+      e = Find(p + iStep, text.end, '\n');
+      if(e != text.end) { ++e; }
+    }
+    pieces.push_back(TextSpan(p, e));
+    p = e;
+  }
+  if(pieces.empty()) { pieces.push_back(text); }
+  return pieces;
+}
+
+uint64_t CountLines(TextSpan text) {
+  if(text.empty()) { return 0; }
+  return text.Count('\n') + (text.end[-1] != '\n' ? 1 : 0);
+}
+
+NumberParser::NumberParser() :
+  m_bCDecimalPoint(strcmp(localeconv()->decimal_point, ".") == 0),
+  m_bCppDecimalPoint(
+    std::use_facet<std::numpunct<char> >(std::locale()).decimal_point() == '.'
+  )
+{
+}
+
+double NumberParser::Atof(TextSpan s) const {
+  const char* p = s.begin;
+  while(p != s.end && IsSpace(*p)) { ++p; }
+  double d;
+  if(m_bCDecimalPoint && PlainDecimal(p, s.end, d)) { return d; }
+  return atof(s.str().c_str());
+}
+
+int NumberParser::Atoi(TextSpan s) const {
+  const char* p = s.begin;
+  while(p != s.end && IsSpace(*p)) { ++p; }
+  const bool bNegative = p != s.end && *p == '-';
+  if(p != s.end && (*p == '-' || *p == '+')) { ++p; }
+  int i = 0;
+  // nine digits cannot overflow
+  for(int iDigits = 0; p != s.end && IsDigit(*p); ++p) {
+    if(++iDigits > 9) { return atoi(s.str().c_str()); }
+    i = i*10 + (*p - '0');
+  }
+  return bNegative ? -i : i;
+}
+
+float NumberParser::StreamFloat(TextSpan s) const {
+  double d;
+  if(m_bCppDecimalPoint && PlainDecimal(s.begin, s.end, d) &&
+     RoundsToFloat(d)) {
+    return static_cast<float>(d);
+  }
+  return SysTools::FromString<float>(s.str());
+}
+
+MappedTextFile::MappedTextFile(const std::string& strFilename) :
+  m_pFile(new MemMappedFile(strFilename))
+{
+  if(m_pFile->IsOpen()) {
+    const char* p = static_cast<const char*>(m_pFile->GetDataPointer());
+    m_Text = TextSpan(p, p + m_pFile->GetFileLength());
+    return;
+  }
+  // empty files cannot be mapped, but are fine.
+  m_pFile.reset();
+  std::ifstream ifs(strFilename.c_str(), std::ios::binary);
+  if(!ifs.is_open() || ifs.peek() != std::ifstream::traits_type::eof()) {
+    throw tuvok::io::DSOpenFailed(strFilename.c_str(), __FILE__, __LINE__);
+  }
+}
+
+MappedTextFile::~MappedTextFile() {}
+
+}
@@ -0,0 +1,136 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_TEXTSPAN_H
+#define TUVOK_TEXTSPAN_H
+
+#include "StdTuvokDefines.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class MemMappedFile;
+
+namespace tuvok {
+
+/// A piece of text, [begin, end), typically of a MappedTextFile.  Taking
+/// one apart never copies or allocates.  The token methods do what
+/// AbstrGeoConverter's GetToken/TrimToken do to a std::string, except that
+/// tokens are not lower cased.
+struct TextSpan {
+  TextSpan() : begin(NULL), end(NULL) {}
+  TextSpan(const char* b, const char* e) : begin(b), end(e) {}
+
+  bool empty() const { return begin == end; }
+  size_t size() const { return static_cast<size_t>(end - begin); }
+  /// the first character, or '\0' for an empty span (as std::string has).
+  char front() const { return empty() ? '\0' : *begin; }
+  std::string str() const { return std::string(begin, end); }
+
+  /// @returns true if this equals 's', ignoring (ASCII) case.
+  bool Is(const char* s) const;
+  /// @returns how often 'c' occurs.
+  size_t Count(char c) const;
+  /// @returns the text before the first 'c'; all of it if there is none.
+  TextSpan UpTo(char c) const;
+
+  /// without leading and trailing " \r\n\t"
+  TextSpan Trimmed() const;
+  TextSpan TrimmedRight() const;
+
+  /// takes the text up to the next '\n' (or the end) off the front, as
+  /// getline would.
+  /// @returns false if there is no more text.
+  bool PopLine(TextSpan& line);
+
+  /// takes the text up to the first blank (" \r\n\t") off the front and
+  /// drops the blanks after it.  Takes all of it if there is no blank.
+  TextSpan PopToken();
+  /// takes the text up to the first 'cDelim' off the front, and the
+  /// delimiter.  Takes all of it if there is no 'cDelim'.
+  TextSpan PopToken(char cDelim);
+  /// drops the text up to the first blank and the blanks after it;
+  /// drops all of it if there is no blank.
+  void SkipToken();
+  /// drops the text up to and including the first 'cDelim'; drops all of
+  /// it if there is no 'cDelim'.
+  void SkipToken(char cDelim);
+  /// takes the next word off the front, as a stringstream would read it
+  /// into a string: skips whitespace (isspace), then reads up to the next.
+  /// @returns an empty span if only whitespace is left.
+  TextSpan PopWord();
+
+  const char* begin;
+  const char* end;
+};
+
+/// Splits 'text' into pieces of about 'iPieceSize' bytes, each ending with
+/// a line, for parsing them in parallel.
+std::vector<TextSpan> SplitLines(TextSpan text, size_t iPieceSize=1<<20);
+/// @returns how many lines TextSpan::PopLine would take off 'text'.
+uint64_t CountLines(TextSpan text);
+
+/// Converts numbers the way the C and C++ libraries would, for a fraction
+/// of the cost: plain decimals are converted directly, with correct
+/// rounding; anything else is handed to the libraries.  Construct one per
+/// file, as it caches whether the current locales use a decimal point.
+class NumberParser {
+public:
+  NumberParser();
+
+  /// same as atof(s.str().c_str())
+  double Atof(TextSpan s) const;
+  /// same as atoi(s.str().c_str())
+  int Atoi(TextSpan s) const;
+  /// same as SysTools::FromString<float>(s.str()), for a non-empty 's'.
+  float StreamFloat(TextSpan s) const;
+
+private:
+  bool m_bCDecimalPoint;   ///< strtod expects a '.'
+  bool m_bCppDecimalPoint; ///< the global C++ locale expects a '.'
+};
+
+/// A text file mapped into memory, read only.
+class MappedTextFile {
+public:
+  /// @throws tuvok::io::DSOpenFailed if the file cannot be mapped.
+  explicit MappedTextFile(const std::string& strFilename);
+  ~MappedTextFile();
+
+  /// all of the file; empty for an empty file.
+  TextSpan Text() const { return m_Text; }
+
+private:
+  std::unique_ptr<MemMappedFile> m_pFile;
+  TextSpan m_Text;
+};
+
+}
+
+#endif
@@ -181,6 +181,7 @@ void TransferFunction1D::Clear() {
     (*m_pvColorData)[i] = FLOATVECTOR4(0,0,0,0);
 
   m_vValueBBox = UINT64VECTOR2(0,0);
+  m_vNonZeroRanges.clear();
 }
 
 void TransferFunction1D::FillOrTruncate(size_t iTargetSize) {
@@ -361,11 +362,16 @@ void TransferFunction1D::GetFloatArray(float** pfData) const {
 
 void TransferFunction1D::ComputeNonZeroLimits() {
   m_vValueBBox = UINT64VECTOR2(uint64_t(m_pvColorData->size()),0);
+  m_vNonZeroRanges.clear();
 
   for (size_t i = 0;i<m_pvColorData->size();i++) {
     if ((*m_pvColorData)[i][3] != 0) {
       m_vValueBBox.x = MIN(m_vValueBBox.x, i);
       m_vValueBBox.y = i;
+      if (!m_vNonZeroRanges.empty() && m_vNonZeroRanges.back().y+1 == i)
+        m_vNonZeroRanges.back().y = i;
+      else
+        m_vNonZeroRanges.push_back(UINT64VECTOR2(i, i));
     }
   }
 }
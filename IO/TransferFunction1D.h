@@ -89,9 +89,15 @@ public:
 
   void ComputeNonZeroLimits();
   const UINT64VECTOR2& GetNonZeroLimits() { return m_vValueBBox;}
+  /// the runs of entries with non-zero opacity, as [first, last] indices.
+  /// Sorted; updated by ComputeNonZeroLimits.
+  const std::vector<UINT64VECTOR2>& GetNonZeroRanges() const {
+    return m_vNonZeroRanges;
+  }
 
 private:
   UINT64VECTOR2 m_vValueBBox;
+  std::vector<UINT64VECTOR2> m_vNonZeroRanges;
 
   /// m_pvColorData exists as a shared pointer so that it can be handed off in
   /// an efficient manner to C++ code (from Lua inside of Tuvok).
@@ -35,19 +35,228 @@
   \date    September 2008
 */
 
+#include <algorithm>
+#include <cmath>
 #include <memory.h>
 #include "TransferFunction2D.h"
 #include "Controller/Controller.h"
 
 using namespace std;
 
+namespace {
+  /// The pixels [x0,x1) x [y0,y1) of a table.
+  struct Rect {
+    Rect() : x0(0), y0(0), x1(0), y1(0) {}
+    Rect(size_t ax0, size_t ay0, size_t ax1, size_t ay1) :
+      x0(ax0), y0(ay0), x1(ax1), y1(ay1) {}
+    bool Empty() const { return x0 >= x1 || y0 >= y1; }
+    void Add(const Rect& r) {
+      if (r.Empty()) return;
+      if (Empty()) { *this = r; return; }
+      x0 = min(x0, r.x0); y0 = min(y0, r.y0);
+      x1 = max(x1, r.x1); y1 = max(y1, r.y1);
+    }
+    Rect Intersect(const Rect& r) const {
+      return Rect(max(x0, r.x0), max(y0, r.y0), min(x1, r.x1), min(y1, r.y1));
+    }
+    size_t x0, y0, x1, y1;
+  };
+
+  /// the first pixel whose center is at or after 'f', clamped to [0, n].
+  size_t FirstCenter(double f, size_t n) {
+    const double c = std::ceil(f - 0.5);
+    return c <= 0.0 ? 0 : (c >= double(n) ? n : size_t(c));
+  }
+
+  FLOATVECTOR2 ToPixels(const FLOATVECTOR2& v, const VECTOR2<size_t>& vSize) {
+    return FLOATVECTOR2(v.x * float(vSize.x), v.y * float(vSize.y));
+  }
+
+  /// the pixels a swatch can cover: those with their center in the
+  /// polygon's bounding box.
+  Rect Bounds(const TFPolygon& swatch, const VECTOR2<size_t>& vSize) {
+    if (swatch.pPoints.size() < 3) return Rect();
+    FLOATVECTOR2 vMin = ToPixels(swatch.pPoints[0], vSize), vMax = vMin;
+    for (size_t i = 1;i<swatch.pPoints.size();i++) {
+      const FLOATVECTOR2 p = ToPixels(swatch.pPoints[i], vSize);
+      vMin.StoreMin(p);
+      vMax.StoreMax(p);
+    }
+    return Rect(FirstCenter(vMin.x, vSize.x), FirstCenter(vMin.y, vSize.y),
+                FirstCenter(vMax.x, vSize.x), FirstCenter(vMax.y, vSize.y));
+  }
+
+  /// A swatch's gradient, sampled into a table of premultiplied colors as
+  /// QGradient does.  Stops outside [0,1] are ignored; before the first and
+  /// after the last stop the gradient pads.
+  class Ramp {
+  public:
+    enum { Entries = 1024 };
+    explicit Ramp(std::vector<GradientStop> stops) {
+      stops.erase(std::remove_if(stops.begin(), stops.end(), OutOfRange),
+                  stops.end());
+      if (stops.empty()) return;
+      std::stable_sort(stops.begin(), stops.end(), Before);
+      m_vColors.resize(Entries);
+      size_t j = 0;
+      for (size_t i = 0;i<Entries;i++) {
+        const float t = float(i) / float(Entries-1);
+        while (j+1 < stops.size() && stops[j+1].first <= t) j++;
+        const FLOATVECTOR4 a = Premultiplied(stops[j].second);
+        if (t <= stops[j].first || j+1 == stops.size()) {
+          m_vColors[i] = a;
+        } else {
+          const FLOATVECTOR4 b = Premultiplied(stops[j+1].second);
+          const float f = (t - stops[j].first) /
+                          (stops[j+1].first - stops[j].first);
+          m_vColors[i] = a + (b - a) * f;
+        }
+      }
+    }
+    bool Empty() const { return m_vColors.empty(); }
+    /// @param t must be in [0,1]
+    const FLOATVECTOR4& operator()(float t) const {
+      return m_vColors[size_t(t * float(Entries-1) + 0.5f)];
+    }
+
+  private:
+    static bool OutOfRange(const GradientStop& s) {
+      return !(s.first >= 0.0f && s.first <= 1.0f);
+    }
+    static bool Before(const GradientStop& a, const GradientStop& b) {
+      return a.first < b.first;
+    }
+    static FLOATVECTOR4 Premultiplied(const FLOATVECTOR4& c) {
+      const float a = std::max(0.0f, std::min(c.w, 1.0f));
+      return FLOATVECTOR4(std::max(0.0f, std::min(c.x, 1.0f)) * a,
+                          std::max(0.0f, std::min(c.y, 1.0f)) * a,
+                          std::max(0.0f, std::min(c.z, 1.0f)) * a, a);
+    }
+    std::vector<FLOATVECTOR4> m_vColors;
+  };
+
+  /// Draws swatches into the float table.  Polygons are filled with the
+  /// odd-even rule, covering the pixels whose centers they contain, and
+  /// composited source-over, as QPainter does without antialiasing.
+  class Rasterizer {
+  public:
+    explicit Rasterizer(ColorData2D& table) :
+      m_table(table), m_vSize(table.GetSize()) {}
+
+    /// fills 'r' with the stretched 1D TF, or clears it.
+    void Background(const std::vector<FLOATVECTOR4>& v1D, const Rect& r) {
+      FLOATVECTOR4* row = m_table.GetDataPointer() + r.y0*m_vSize.x;
+      for (size_t x = r.x0;x<r.x1;x++) {
+        row[x] = v1D.empty() ? FLOATVECTOR4(0,0,0,0) :
+          v1D[min(v1D.size()-1,
+                  size_t((double(x)+0.5) * double(v1D.size()) /
+                         double(m_vSize.x)))];
+      }
+      for (size_t y = r.y0+1;y<r.y1;y++) {
+        std::copy(row + r.x0, row + r.x1, row + (y-r.y0)*m_vSize.x + r.x0);
+      }
+    }
+
+    /// composites the part of 'swatch' within 'clip'.
+    void Fill(const TFPolygon& swatch, const Rect& clip) {
+      const Rect r = Bounds(swatch, m_vSize).Intersect(clip);
+      if (r.Empty()) return;
+      const Ramp ramp(swatch.pGradientStops);
+      if (ramp.Empty()) return;
+
+      std::vector<FLOATVECTOR2> p(swatch.pPoints.size());
+      for (size_t i = 0;i<p.size();i++) {
+        p[i] = ToPixels(swatch.pPoints[i], m_vSize);
+      }
+      const FLOATVECTOR2 g0 = ToPixels(swatch.pGradientCoords[0], m_vSize),
+                         g1 = ToPixels(swatch.pGradientCoords[1], m_vSize);
+      const double dx = double(g1.x) - g0.x, dy = double(g1.y) - g0.y;
+      const double l2 = dx*dx + dy*dy;
+
+      std::vector<double> xs;
+      for (size_t y = r.y0;y<r.y1;y++) {
+        const double yc = double(y) + 0.5;
+        xs.clear();
+        for (size_t i = 0, j = p.size()-1;i<p.size();j = i++) {
+          if ((p[i].y <= yc) != (p[j].y <= yc)) {
+            xs.push_back(p[i].x + (yc - p[i].y) * (double(p[j].x) - p[i].x) /
+                                  (double(p[j].y) - p[i].y));
+          }
+        }
+        std::sort(xs.begin(), xs.end());
+        for (size_t k = 0;k+1<xs.size();k += 2) {
+          const size_t xa = max(r.x0, FirstCenter(xs[k], m_vSize.x));
+          const size_t xb = min(r.x1, FirstCenter(xs[k+1], m_vSize.x));
+          if (xa >= xb) continue;
+          // gradient parameter of every pixel in the span ...
+          m_t.resize(xb - xa);
+          const double fx = double(xa) + 0.5 - g0.x, fy = yc - g0.y;
+          if (swatch.bRadial) {
+            const float fInvR = l2 > 0 ? float(1.0 / std::sqrt(l2)) : 0.0f;
+            const float fy2 = float(fy*fy);
+            for (size_t i = 0;i<m_t.size();i++) {
+              const float ex = float(fx) + float(i);
+              m_t[i] = l2 > 0 ? std::sqrt(ex*ex + fy2) * fInvR : 1.0f;
+            }
+          } else {
+            const float t0 = l2 > 0 ? float((fx*dx + fy*dy) / l2) : 0.0f;
+            const float dt = l2 > 0 ? float(dx / l2) : 0.0f;
+            for (size_t i = 0;i<m_t.size();i++) m_t[i] = t0 + dt*float(i);
+          }
+          // ... its color ...
+          m_src.resize(m_t.size());
+          for (size_t i = 0;i<m_t.size();i++) {
+            m_src[i] = ramp(std::max(0.0f, std::min(m_t[i], 1.0f)));
+          }
+          // ... and source-over onto the table.
+          Composite(&m_src[0], m_table.GetDataPointer() + y*m_vSize.x + xa,
+                    m_src.size());
+        }
+      }
+    }
+
+    /// converts 'r' of the float table into the RGBA 8bit one.
+    void ToBytes(unsigned char* pPixels, const Rect& r) const {
+      for (size_t y = r.y0;y<r.y1;y++) {
+        const float* src = &m_table.GetDataPointer()[y*m_vSize.x + r.x0].x;
+        unsigned char* dst = pPixels + 4*(y*m_vSize.x + r.x0);
+        for (size_t i = 0;i<4*(r.x1-r.x0);i++) {
+          dst[i] = (unsigned char)(
+            std::max(0.0f, std::min(src[i], 1.0f)) * 255.0f + 0.5f);
+        }
+      }
+    }
+
+  private:
+    /// 'src' is premultiplied, 'dst' is not.  An element-wise loop without
+    /// branches, so that the compiler vectorizes it.
+    static void Composite(const FLOATVECTOR4* src, FLOATVECTOR4* dst,
+                          size_t n) {
+      for (size_t i = 0;i<n;i++) {
+        const float k = dst[i].w * (1.0f - src[i].w);
+        const float a = src[i].w + k;
+        const float inv = a > 0.0f ? 1.0f / a : 0.0f;
+        dst[i] = FLOATVECTOR4((src[i].x + dst[i].x*k) * inv,
+                              (src[i].y + dst[i].y*k) * inv,
+                              (src[i].z + dst[i].z*k) * inv, a);
+      }
+    }
+
+    ColorData2D& m_table;
+    const VECTOR2<size_t> m_vSize;
+    std::vector<float> m_t;
+    std::vector<FLOATVECTOR4> m_src;
+  };
+}
+
+
 TransferFunction2D::TransferFunction2D() :
   m_pvSwatches(new vector<TFPolygon>),
   m_iSize(0,0),
   m_pColorData(NULL),
   m_pPixelData(NULL),
-  m_pRCanvas(NULL),
-  m_bUseCachedData(false)
+  m_bUseCachedData(false),
+  m_bTablesValid(false)
 {
 }
 
@@ -56,8 +265,8 @@ TransferFunction2D::TransferFunction2D(const std::string& filename):
   m_iSize(0,0),
   m_pColorData(NULL),
   m_pPixelData(NULL),
-  m_pRCanvas(NULL),
-  m_bUseCachedData(false)
+  m_bUseCachedData(false),
+  m_bTablesValid(false)
 {
   Load(filename);
 }
@@ -67,8 +276,8 @@ TransferFunction2D::TransferFunction2D(const VECTOR2<size_t>& iSize):
   m_iSize(iSize),
   m_pColorData(NULL),
   m_pPixelData(NULL),
-  m_pRCanvas(NULL),
-  m_bUseCachedData(false)
+  m_bUseCachedData(false),
+  m_bTablesValid(false)
 {
   Resize(m_iSize);
 }
@@ -78,7 +287,10 @@ void TransferFunction2D::DeleteCanvasData()
 {
   delete m_pColorData;
   delete [] m_pPixelData;
-  delete m_pRCanvas;
+  m_pColorData = NULL;
+  m_pPixelData = NULL;
+  m_bUseCachedData = false;
+  m_bTablesValid = false;
 }
 
 TransferFunction2D::~TransferFunction2D(void)
@@ -222,19 +434,7 @@ bool TransferFunction2D::Save(const std::string& filename) const {
 void TransferFunction2D::GetByteArray(unsigned char** pcData) {
   if (*pcData == NULL) *pcData = new unsigned char[m_iSize.area()*4];
 
-  size_t iSize = m_iSize.area();
-  unsigned char *pcSourceDataIterator = RenderTransferFunction8Bit();
-  unsigned char *pcDataIterator = *pcData;
-  memcpy(pcDataIterator, pcSourceDataIterator, iSize*4);
-  for (size_t i = 0;i<iSize;i++) {
-    unsigned char r = *(pcDataIterator+2);
-    unsigned char b = *(pcDataIterator+0);
-
-    *(pcDataIterator+0) = r;
-    *(pcDataIterator+2) = b;
-
-    pcDataIterator+=4;
-  }
+  memcpy(*pcData, RenderTransferFunction8Bit(), m_iSize.area()*4);
 }
 
 
@@ -245,21 +445,10 @@ void TransferFunction2D::GetByteArray(unsigned char** pcData,
   float fScale = 255.0f/float(cUsedRange);
 
   size_t iSize = m_iSize.area();
-  unsigned char *pcSourceDataIterator = RenderTransferFunction8Bit();
+  const unsigned char *pcSourceDataIterator = RenderTransferFunction8Bit();
   unsigned char *pcDataIterator = *pcData;
-  memcpy(pcDataIterator, pcSourceDataIterator, iSize*4);
-  for (size_t i = 0;i<iSize;i++) {
-    unsigned char r = *(pcDataIterator+2);
-    unsigned char g = *(pcDataIterator+1);
-    unsigned char b = *(pcDataIterator+0);
-    unsigned char a = *(pcDataIterator+3);
-
-    *(pcDataIterator+0) = (unsigned char)(float(r)*fScale);
-    *(pcDataIterator+1) = (unsigned char)(float(g)*fScale);
-    *(pcDataIterator+2) = (unsigned char)(float(b)*fScale);
-    *(pcDataIterator+3) = (unsigned char)(float(a)*fScale);
-
-    pcDataIterator+=4;
+  for (size_t i = 0;i<iSize*4;i++) {
+    pcDataIterator[i] = (unsigned char)(float(pcSourceDataIterator[i])*fScale);
   }
 }
 
@@ -292,86 +481,47 @@ INTVECTOR2 TransferFunction2D::Normalized2Offscreen(FLOATVECTOR2 vfCoord, VECTOR
 }
 
 unsigned char* TransferFunction2D::RenderTransferFunction8Bit() {
-  VECTOR2<size_t> vRS = GetRenderSize();
+  if (m_pColorData != NULL && m_pColorData->GetSize() != m_iSize) {
+    DeleteCanvasData(); // resampled or loaded at another size
+  }
   if (m_pColorData == NULL) m_pColorData = new ColorData2D(m_iSize);
   if (m_pPixelData == NULL) m_pPixelData = new unsigned char[4*m_iSize.area()];
 
-#ifndef TUVOK_NO_QT
-  if (m_pRCanvas == NULL)   m_pRCanvas   = new QImage(int(vRS.x), int(vRS.y),
-                                                      QImage::Format_ARGB32);
-
-  if (m_pPixelData != NULL && m_bUseCachedData) return m_pPixelData;
-
-  m_pRCanvas->fill(0);
-
-  // render 1D trans
-  QRect imageRect(0, 0, int(vRS.x), int(vRS.y));
-  m_Painter.begin(m_pRCanvas);
-  m_Painter.drawImage(imageRect,m_Trans1DImage);
-
-  // render swatches
-  QPen noBorderPen(Qt::NoPen);
-  m_Painter.setPen(noBorderPen);
-  for (size_t i = 0;i<m_pvSwatches->size();i++) {
-    TFPolygon& currentSwatch = (*m_pvSwatches)[i];
-
-    std::vector<QPoint> pointList(currentSwatch.pPoints.size());
-    for (size_t j = 0;j<currentSwatch.pPoints.size();j++) {
-      INTVECTOR2 vPixelPos = Normalized2Offscreen(currentSwatch.pPoints[j],vRS);
-      pointList[j] = QPoint(vPixelPos.x, vPixelPos.y);
-    }
-
-    INTVECTOR2 vPixelPos0 = Normalized2Offscreen(currentSwatch.pGradientCoords[0],vRS),
-               vPixelPos1 = Normalized2Offscreen(currentSwatch.pGradientCoords[1],vRS);
-
-    QGradient* pGradientBrush;
-    if (currentSwatch.bRadial) {
-      double r = sqrt( pow(double(vPixelPos0.x-vPixelPos1.x),2.0) + pow(double(vPixelPos0.y-vPixelPos1.y),2.0));
-      pGradientBrush = new QRadialGradient(vPixelPos0.x, vPixelPos0.y, r);
-    } else {
-      pGradientBrush = new QLinearGradient(vPixelPos0.x, vPixelPos0.y, vPixelPos1.x, vPixelPos1.y);
-    }
-
-    for (size_t j = 0;j<currentSwatch.pGradientStops.size();j++) {
-      pGradientBrush->setColorAt(currentSwatch.pGradientStops[j].first,
-                   QColor(int(currentSwatch.pGradientStops[j].second[0]*255),
-                          int(currentSwatch.pGradientStops[j].second[1]*255),
-                          int(currentSwatch.pGradientStops[j].second[2]*255),
-                          int(currentSwatch.pGradientStops[j].second[3]*255)));
-    }
-
-    m_Painter.setBrush(*pGradientBrush);
-    if(!pointList.empty()) {
-      m_Painter.drawPolygon(&pointList[0], int(currentSwatch.pPoints.size()));
+  if (m_bUseCachedData) return m_pPixelData;
+
+  // Only pixels some changed swatch covers, before or after the change,
+  // need to be drawn again; to draw them, all swatches which cover them
+  // are composited again.
+  const Rect all(0, 0, m_iSize.x, m_iSize.y);
+  const vector<TFPolygon>& swatches = *m_pvSwatches;
+  Rect dirty;
+  if (!m_bTablesValid) {
+    dirty = all;
+  } else {
+    const vector<TFPolygon>& old = m_vRenderedSwatches;
+    for (size_t i = 0;i<max(old.size(), swatches.size());i++) {
+      if (i < old.size() && i < swatches.size() && old[i] == swatches[i]) {
+        continue;
+      }
+      if (i < old.size()) dirty.Add(Bounds(old[i], m_iSize));
+      if (i < swatches.size()) dirty.Add(Bounds(swatches[i], m_iSize));
     }
-    delete pGradientBrush;
   }
-  m_Painter.end();
 
-  memcpy(m_pPixelData, m_pRCanvas->scaled(int(m_iSize.x), int(m_iSize.y)).bits(), 4*m_iSize.area());
-  m_bUseCachedData = true;
-#else
-  if (!m_pvSwatches->empty()) {
-	m_pvSwatches->clear();
-	WARNING("Cannot render transfer functions without Qt, returning empty transfer function.");
-	memset(m_pPixelData, 0, 4*m_iSize.area());	
+  if (!dirty.Empty()) {
+    Rasterizer raster(*m_pColorData);
+    raster.Background(m_v1DBackground, dirty);
+    for (size_t i = 0;i<swatches.size();i++) raster.Fill(swatches[i], dirty);
+    raster.ToBytes(m_pPixelData, dirty);
   }
-#endif
+  m_vRenderedSwatches = swatches;
+  m_bTablesValid = true;
+  m_bUseCachedData = true;
   return m_pPixelData;
 }
 
 ColorData2D* TransferFunction2D::RenderTransferFunction() {
-
-  unsigned char* pPixelData = RenderTransferFunction8Bit();
-
-  FLOATVECTOR4* p = (FLOATVECTOR4*)(m_pColorData->GetDataPointer());
-  for (size_t i = 0;i<m_pColorData->GetSize().area();i++) {
-    p[i] = FLOATVECTOR4(pPixelData[4*i+2]/255.0f,
-                        pPixelData[4*i+1]/255.0f,
-                        pPixelData[4*i+0]/255.0f,
-                        pPixelData[4*i+3]/255.0f);
-  }
-
+  RenderTransferFunction8Bit();
   return m_pColorData;
 }
 
@@ -396,28 +546,29 @@ void TransferFunction2D::ComputeNonZeroLimits() {
   }
 }
 
-#ifdef TUVOK_NO_QT
-void TransferFunction2D::Update1DTrans(const TransferFunction1D*) {
-#else
 void TransferFunction2D::Update1DTrans(const TransferFunction1D* p1DTrans) {
-#endif
-#ifndef TUVOK_NO_QT
   m_Trans1D = TransferFunction1D(*p1DTrans);
 
   size_t iSize = min<size_t>(m_iSize.x,  m_Trans1D.GetSize());
 
-  m_Trans1DImage = QImage(int(iSize), 1, QImage::Format_ARGB32);
+  m_v1DBackground.resize(iSize);
   shared_ptr<vector<FLOATVECTOR4>> tfdata = m_Trans1D.GetColorData();
   for (size_t i = 0;i<iSize;i++) {
-    float r = std::max(0.0f,std::min((*tfdata)[i][0],1.0f));
-    float g = std::max(0.0f,std::min((*tfdata)[i][1],1.0f));
-    float b = std::max(0.0f,std::min((*tfdata)[i][2],1.0f));
-    float a = std::max(0.0f,std::min((*tfdata)[i][3],1.0f));
+    m_v1DBackground[i] = FLOATVECTOR4(
+      std::max(0.0f,std::min((*tfdata)[i][0],1.0f)),
+      std::max(0.0f,std::min((*tfdata)[i][1],1.0f)),
+      std::max(0.0f,std::min((*tfdata)[i][2],1.0f)),
+      std::max(0.0f,std::min((*tfdata)[i][3],1.0f)));
+  }
+  m_bTablesValid = false;
 
-    m_Trans1DImage.setPixel(int(i),0,qRgba(int(r*255),int(g*255),int(b*255),int(a*255)));
+#ifndef TUVOK_NO_QT
+  m_Trans1DImage = QImage(int(iSize), 1, QImage::Format_ARGB32);
+  for (size_t i = 0;i<iSize;i++) {
+    const FLOATVECTOR4& c = m_v1DBackground[i];
+    m_Trans1DImage.setPixel(int(i),0,qRgba(int(c.x*255),int(c.y*255),
+                                           int(c.z*255),int(c.w*255)));
   }
-#else
-  T_ERROR("Unsupported without Qt.");
 #endif
 }
 
@@ -508,6 +659,14 @@ TransferFunction2D::SwatchGet() const {
 
 // ***************************************************************************
 
+bool TFPolygon::operator==(const TFPolygon& other) const {
+  return bRadial == other.bRadial &&
+         pPoints == other.pPoints &&
+         pGradientCoords[0] == other.pGradientCoords[0] &&
+         pGradientCoords[1] == other.pGradientCoords[1] &&
+         pGradientStops == other.pGradientStops;
+}
+
 bool TFPolygon::Load(ifstream& file) {
   uint32_t iSize;
   file >> bRadial;
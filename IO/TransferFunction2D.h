@@ -49,10 +49,8 @@
 /// @todo FIXME remove this dependency:
 #ifdef TUVOK_NO_QT
 typedef void* QImage;
-typedef void* QPainter;
 #else
 # include <QtGui/QImage>
-# include <QtGui/QPainter>
 #endif
 
 #include "Basics/Vectors.h"
@@ -74,6 +72,9 @@ class TFPolygon {
     bool Load(std::ifstream& file);
     void Save(std::ofstream& file) const;
 
+    bool operator==(const TFPolygon& other) const;
+    bool operator!=(const TFPolygon& other) const { return !(*this == other); }
+
     bool                        bRadial;
     std::vector< FLOATVECTOR2 > pPoints;
     FLOATVECTOR2 pGradientCoords[2];
@@ -99,6 +100,8 @@ public:
   bool Load(const std::string& filename, const VECTOR2<size_t>& vTargetSize);
   bool Save(const std::string& filename) const;
 
+  /// Makes the next Get*Array check the swatches for changes.  Only the
+  /// bounding boxes of the swatches which changed are rasterized again.
   void InvalidateCache() {m_bUseCachedData = false;}
   void GetByteArray(unsigned char** pcData);
   void GetByteArray(unsigned char** pcData, unsigned char cUsedRange);
@@ -154,17 +157,23 @@ protected:
   TransferFunction1D m_Trans1D;
   QImage             m_Trans1DImage;
   VECTOR2<size_t>    m_iSize;
+  /// brings both tables up to date with the swatches.
   ColorData2D* RenderTransferFunction();
+  /// @returns the RGBA 8bit table, after bringing it up to date.
   unsigned char* RenderTransferFunction8Bit();
   INTVECTOR2 Normalized2Offscreen(FLOATVECTOR2 vfCoord, VECTOR2<size_t> iSize) const;
 
 private:
   ColorData2D*      m_pColorData;
   unsigned char*    m_pPixelData;
-  QPainter          m_Painter;
-  QImage*           m_pRCanvas;
   UINT64VECTOR4     m_vValueBBox;
   bool              m_bUseCachedData;
+  /// the 1D TF, stretched over each row below the swatches.  Empty until
+  /// Update1DTrans.
+  std::vector<FLOATVECTOR4> m_v1DBackground;
+  /// the swatches the tables currently show, if m_bTablesValid.
+  std::vector<TFPolygon> m_vRenderedSwatches;
+  bool              m_bTablesValid;
 
   void DeleteCanvasData();
 };
@@ -263,8 +263,6 @@ fill_buffer_from_file(std::vector<char>& buf, const char *fn,
   std::ifstream::pos_type file_size = ifs.tellg() - offset;
   ifs.seekg(offset, std::ios::beg);
 
-  MESSAGE("Reading %u byte file.", static_cast<unsigned>(file_size));
-
   // resize our buffer to be big enough for the file
   try {
     buf.resize(size_t(file_size));
@@ -0,0 +1,175 @@
+#pragma once
+
+#ifndef UVF_BRICKHISTOGRAM_H
+#define UVF_BRICKHISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+#include "TOCBlock.h"
+#include "../../Basics/ProgressTimer.h"
+#include "../../Controller/Controller.h"
+
+/// Helpers shared by the histogram data blocks: binning of arbitrary voxel
+/// types and a parallel traversal over all bricks of a TOCBlock level.
+namespace BrickHistogram {
+
+  /// histograms never get more bins than a 16 bit histogram has
+  static const size_t MaxBins = 65536;
+  /// upper limit for the memory all thread private histograms may use
+  static const uint64_t MaxMemory = uint64_t(1) << 30;
+
+  /// Maps voxel values onto histogram bins.  Integer data which fits into
+  /// the available bins is binned by value, exactly as the histograms always
+  /// were.  Anything else (e.g. 64 bit or floating point data) is binned by
+  /// range: [minimum, maximum] is split evenly so that the maximum lands in
+  /// the last bin.  Non-negative integer data always starts at bin 0.
+  struct Binning {
+    double minimum;
+    double numerator;
+    double denominator;
+    size_t bins;
+    bool exact;
+
+    Binning() : minimum(0), numerator(1), denominator(1), bins(1),
+                exact(true) {}
+
+    /// binning for 'bins' bins which have to cover [lo, hi]
+    static Binning Fixed(double lo, double hi, bool integral, size_t bins) {
+      Binning b;
+      if(!(lo <= hi)) { lo = hi = 0; } // no (valid) voxels at all
+      b.minimum = (integral && lo >= 0) ? 0 : lo;
+      b.bins = std::max<size_t>(1, bins);
+      b.exact = integral && hi - b.minimum <= double(b.bins - 1);
+      if(!b.exact) {
+        b.numerator = double(b.bins - 1);
+        b.denominator = hi - b.minimum;
+      }
+      return b;
+    }
+
+    /// binning for [lo, hi] which uses as few bins as possible but at most
+    /// 'maxBins'.
+    static Binning Range(double lo, double hi, bool integral,
+                         size_t maxBins=MaxBins) {
+      size_t bins = maxBins;
+      if(integral && lo <= hi) {
+        const double width = hi - ((lo >= 0) ? 0 : lo) + 1;
+        if(width < double(maxBins)) bins = size_t(width);
+      }
+      return Fixed(lo, hi, integral, bins);
+    }
+
+    template<typename T> size_t operator()(T value) const {
+      const double d = exact ? double(value) - minimum
+                             : (double(value) - minimum) * numerator /
+                               denominator;
+      // also catches NaNs
+      if(!(d > 0)) return 0;
+      if(d >= double(bins - 1)) return bins - 1;
+      return size_t(d);
+    }
+  };
+
+  /// @returns how many threads may each keep a private histogram of
+  /// 'iBytes' bytes.
+  inline int Threads(uint64_t iBytes) {
+#ifdef _OPENMP
+    const uint64_t iCopies = std::max<uint64_t>(1, MaxMemory /
+                                                   std::max<uint64_t>(1, iBytes));
+    return int(std::min<uint64_t>(uint64_t(omp_get_max_threads()), iCopies));
+#else
+    (void)iBytes;
+    return 1;
+#endif
+  }
+
+  /// Calls f(thread, brickData, brickSize) for every brick of level 'iLevel'.
+  /// 'iThreads' threads each claim the next unprocessed brick and decode it
+  /// into their own buffer, so at most 'iThreads' bricks are ever in memory.
+  /// 'thread' is in [0, iThreads); progress is reported as 'strWhat' and
+  /// mapped to [fFrom, fTo] of 'timer'.
+  template<typename T, typename F>
+  void ForEachBrick(const TOCBlock* source, uint64_t iLevel, int iThreads,
+                    F f, ProgressTimer& timer, const char* strWhat,
+                    float fFrom=0.0f, float fTo=1.0f) {
+    const UINT64VECTOR3 bricks = source->GetBrickCount(iLevel);
+    const int64_t iBrickCount = int64_t(bricks.volume());
+    const size_t iMaxBrickSize = size_t(source->GetMaxBrickSize().volume() *
+                                        source->GetComponentCount());
+    std::atomic<int64_t> iDone(0);
+
+#pragma omp parallel num_threads(iThreads)
+    {
+#ifdef _OPENMP
+      const int iThread = omp_get_thread_num();
+#else
+      const int iThread = 0;
+#endif
+      std::vector<T> data(iMaxBrickSize);
+      int iReported = -1;
+#pragma omp for schedule(dynamic)
+      for(int64_t i=0; i < iBrickCount; ++i) {
+        const UINT64VECTOR4 coords(uint64_t(i) % bricks.x,
+                                   (uint64_t(i) / bricks.x) % bricks.y,
+                                   uint64_t(i) / (bricks.x*bricks.y), iLevel);
+        source->GetData(reinterpret_cast<uint8_t*>(data.data()), coords);
+        f(iThread, data.data(), UINTVECTOR3(source->GetBrickSize(coords)));
+
+        const int64_t iFinished = ++iDone;
+        // only the calling thread may talk to the debug output
+        if(iThread == 0 && int(100*iFinished / iBrickCount) > iReported) {
+          iReported = int(100*iFinished / iBrickCount);
+          const float progress = fFrom + (fTo-fFrom) *
+                                 float(iFinished)/float(iBrickCount);
+          MESSAGE("%s %5.2f%% (%s)", strWhat, progress * 100.0f,
+                  timer.GetProgressMessage(progress).c_str());
+        }
+      }
+    }
+  }
+
+  /// computes the range of the first component over the non-overlap voxels
+  /// of level 'iLevel'; NaNs are ignored.
+  template<typename T>
+  void ValueRange(const TOCBlock* source, uint64_t iLevel,
+                  double& fMin, double& fMax, ProgressTimer& timer,
+                  const char* strWhat, float fFrom=0.0f, float fTo=1.0f) {
+    const int iThreads = Threads(0);
+    std::vector<double> vMin(size_t(iThreads),
+                             std::numeric_limits<double>::max());
+    std::vector<double> vMax(size_t(iThreads),
+                             -std::numeric_limits<double>::max());
+    const size_t iCompcount = size_t(source->GetComponentCount());
+    const uint32_t iOverlap = source->GetOverlap();
+
+    ForEachBrick<T>(source, iLevel, iThreads,
+      [&](int t, const T* pData, const UINTVECTOR3& size) {
+        double lo = vMin[size_t(t)], hi = vMax[size_t(t)];
+        for(uint32_t z = iOverlap; z < size.z-iOverlap; ++z) {
+          for(uint32_t y = iOverlap; y < size.y-iOverlap; ++y) {
+            const T* row = pData + iCompcount*(size_t(z)*size.x*size.y +
+                                               size_t(y)*size.x);
+            for(uint32_t x = iOverlap; x < size.x-iOverlap; ++x) {
+              const double v = double(row[iCompcount*x]);
+              if(v < lo) lo = v;
+              if(v > hi) hi = v;
+            }
+          }
+        }
+        vMin[size_t(t)] = lo;
+        vMax[size_t(t)] = hi;
+      }, timer, strWhat, fFrom, fTo);
+
+    fMin = *std::min_element(vMin.begin(), vMin.end());
+    fMax = *std::max_element(vMax.begin(), vMax.end());
+  }
+}
+
+#endif // UVF_BRICKHISTOGRAM_H
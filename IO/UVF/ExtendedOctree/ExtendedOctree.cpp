@@ -22,6 +22,7 @@
  DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <stdexcept>
 #include "ExtendedOctree.h"
 #include "Basics/nonstd.h"
@@ -306,49 +307,84 @@ const TOCEntry& ExtendedOctree::GetBrickToCData(size_t index) const {
  GetBrickData (scalar):
  
  Reads a brick from file and decompresses it if necessary. No magic here it 
- simply seeks to the position in the file, which is the header offset + the 
- brick-offset from the header, and then reads the data. Finally, checks if
- decompression is required.
+ simply reads the data at the position in the file which is the header
+ offset + the brick-offset from the header. Finally, checks if
+ decompression is required. The read is positional and does not touch the
+ shared file pointer, so many threads may fetch bricks at the same time.
 */ 
 void ExtendedOctree::GetBrickData(uint8_t* pData, uint64_t index) const {
 
   tuvok::Controller::Instance().IncrementPerfCounter(PERF_EO_BRICKS, 1.0);
 
-  if(m_vTOC[size_t(index)].m_eCompression == CT_NONE) {
+  const TOCEntry& toc = m_vTOC[size_t(index)];
+  if(toc.m_eCompression == CT_NONE) {
     // not compressed, just read it directly into the buffer.
     tuvok::StackTimer t(PERF_EO_DISK_READ);
-    m_pLargeRAWFile->SeekPos(m_iOffset+m_vTOC[size_t(index)].m_iOffset);
-    m_pLargeRAWFile->ReadRAW(pData, m_vTOC[size_t(index)].m_iLength);
+    m_pLargeRAWFile->ReadRAWAt(pData, toc.m_iLength, m_iOffset+toc.m_iOffset);
     return;
   }
 
   // the data are compressed; read them into a temporary buffer and then expand
   // that buffer into 'pData'.
+  std::shared_ptr<uint8_t> buf(new uint8_t[SourceSize(index)],
+                               nonstd::DeleteArray<uint8_t>());
+  TimedStatement(PERF_EO_DISK_READ,
+    m_pLargeRAWFile->ReadRAWAt(buf.get(), toc.m_iLength,
+                               m_iOffset+toc.m_iOffset);
+  );
+  DecodeBrick(pData, index, buf);
+}
+
+/*
+ SourceSize:
+
+ Some decompressors are told the uncompressed size as the input size too, so
+ the buffer a brick is decoded from must be large enough for either.
+ Incompressible data might come out slightly larger than it went in.
+*/
+size_t ExtendedOctree::SourceSize(uint64_t index) const {
+  const TOCEntry& toc = m_vTOC[size_t(index)];
+  if(toc.m_eCompression == CT_NONE) return size_t(toc.m_iLength);
+  const size_t uncompressedSize =
+    this->ComputeBrickSize(this->IndexToBrickCoords(index)).volume() *
+    this->GetComponentCount() *
+    this->GetComponentTypeSize();
+  return std::max(uncompressedSize, size_t(toc.m_iLength));
+}
+
+/*
+ DecodeBrick:
+
+ Turns the bytes of a brick as they are stored in the file into the brick's
+ data, i.e. copies or decompresses them into 'pData'.
+*/
+void ExtendedOctree::DecodeBrick(uint8_t* pData, uint64_t index,
+                                 std::shared_ptr<uint8_t> pSource) const {
+  const TOCEntry& toc = m_vTOC[size_t(index)];
+  if(toc.m_eCompression == CT_NONE) {
+    std::copy(pSource.get(), pSource.get() + toc.m_iLength, pData);
+    return;
+  }
+
   const size_t uncompressedSize =
     this->ComputeBrickSize(this->IndexToBrickCoords(index)).volume() *
     this->GetComponentCount() *
     this->GetComponentTypeSize();
 
-  std::shared_ptr<uint8_t> buf(new uint8_t[uncompressedSize],
-                               nonstd::DeleteArray<uint8_t>());
   std::shared_ptr<uint8_t> out(pData, nonstd::null_deleter());
-  TimedStatement(PERF_EO_DISK_READ,
-    m_pLargeRAWFile->SeekPos(m_iOffset+m_vTOC[size_t(index)].m_iOffset);
-    m_pLargeRAWFile->ReadRAW(buf.get(), m_vTOC[size_t(index)].m_iLength);
-  );
   tuvok::StackTimer decompress(PERF_EO_DECOMPRESSION);
-  switch (m_vTOC[size_t(index)].m_eCompression) {
+  switch (toc.m_eCompression) {
   case CT_ZLIB:
-    zDecompress(buf, out, uncompressedSize);
+    zDecompress(pSource, out, uncompressedSize);
     break;
   case CT_LZMA:
-    lzmaDecompress(buf, out, uncompressedSize, m_lzmaProps);
+    lzmaDecompress(pSource, out, uncompressedSize, m_lzmaProps);
     break;
   case CT_LZ4:
-    lz4Decompress(buf, out, uncompressedSize);
+    lz4Decompress(pSource, out, uncompressedSize);
     break;
   case CT_BZLIB:
-    bzDecompress(buf, size_t(m_vTOC[size_t(index)].m_iLength),
+    bzDecompress(pSource, size_t(toc.m_iLength),
                  out, uncompressedSize);
     break;
   case CT_LZHAM:
@@ -369,6 +405,75 @@ void ExtendedOctree::GetBrickData(uint8_t* pData, const UINT64VECTOR4& vBrickCoo
   GetBrickData(pData, BrickCoordsToIndex(vBrickCoords));
 }
 
+/*
+ GetBrickData (batched):
+
+ Sorts the requested bricks by their position in the file and splits them
+ into runs: a run grows as long as the next brick starts at most iMaxGap
+ bytes after the end of the previous one and the whole run stays below
+ iMaxRead bytes.  Every run is fetched with a single positional read, which
+ may include the (small) gaps, and its bricks are decoded out of that one
+ buffer.  For the usual Morton or Hilbert ordered files a set of nearby
+ bricks thus turns into a few large sequential reads instead of one seek and
+ read per brick.
+*/
+void ExtendedOctree::GetBrickData(const std::vector<UINT64VECTOR4>& vBrickCoords,
+                                  const BrickTarget& target,
+                                  const BrickDone& done,
+                                  uint64_t iMaxGap, uint64_t iMaxRead) const {
+  std::vector<std::pair<uint64_t, size_t>> order; // (ToC index, request)
+  order.reserve(vBrickCoords.size());
+  for(size_t i=0; i < vBrickCoords.size(); ++i) {
+    order.push_back(std::make_pair(BrickCoordsToIndex(vBrickCoords[i]), i));
+  }
+  std::sort(order.begin(), order.end(),
+            [this](const std::pair<uint64_t, size_t>& a,
+                   const std::pair<uint64_t, size_t>& b) {
+    const uint64_t oa = m_vTOC[size_t(a.first)].m_iOffset;
+    const uint64_t ob = m_vTOC[size_t(b.first)].m_iOffset;
+    return oa < ob || (oa == ob && a.second < b.second);
+  });
+
+  std::vector<uint8_t> run;
+  for(size_t first=0; first < order.size(); ) {
+    const uint64_t iBegin = m_vTOC[size_t(order[first].first)].m_iOffset;
+    uint64_t iEnd = iBegin + m_vTOC[size_t(order[first].first)].m_iLength;
+    size_t last = first+1;
+    for(; last < order.size(); ++last) {
+      const TOCEntry& next = m_vTOC[size_t(order[last].first)];
+      const uint64_t iNextEnd = std::max(iEnd, next.m_iOffset + next.m_iLength);
+      if(next.m_iOffset > iEnd + iMaxGap || iNextEnd - iBegin > iMaxRead) {
+        break;
+      }
+      iEnd = iNextEnd;
+    }
+
+    size_t iBufSize = size_t(iEnd - iBegin);
+    for(size_t b=first; b < last; ++b) {
+      const uint64_t index = order[b].first;
+      iBufSize = std::max(iBufSize,
+                          size_t(m_vTOC[size_t(index)].m_iOffset - iBegin) +
+                          SourceSize(index));
+    }
+    run.resize(iBufSize);
+    TimedStatement(PERF_EO_DISK_READ,
+      m_pLargeRAWFile->ReadRAWAt(run.data(), iEnd - iBegin,
+                                 m_iOffset+iBegin);
+    );
+    for(size_t b=first; b < last; ++b) {
+      tuvok::Controller::Instance().IncrementPerfCounter(PERF_EO_BRICKS, 1.0);
+      const uint64_t index = order[b].first;
+      std::shared_ptr<uint8_t> src(
+        run.data() + size_t(m_vTOC[size_t(index)].m_iOffset - iBegin),
+        nonstd::null_deleter()
+      );
+      DecodeBrick(target(order[b].second), index, src);
+      if(!done(order[b].second)) { return; }
+    }
+    first = last;
+  }
+}
+
 /*
  IsLastBrick:
  
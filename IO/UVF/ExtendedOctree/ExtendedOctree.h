@@ -31,6 +31,8 @@
 
 #include <memory>
 #include <array>
+#include <functional>
+#include <vector>
 
 #include "Basics/LargeRAWFile.h"
 // for the small fixed size vectors
@@ -264,6 +266,33 @@ public:
   */
   void GetBrickData(uint8_t* pData, const UINT64VECTOR4& vBrickCoords) const;
 
+  /// hands out the buffer brick number i of a batched read is decoded to
+  typedef std::function<uint8_t*(size_t i)> BrickTarget;
+  /// called once brick number i of a batched read is in its buffer;
+  /// returning false ends the read
+  typedef std::function<bool(size_t i)> BrickDone;
+
+  /**
+    reads many bricks at once.  The bricks are visited in the order they are
+    stored in the file, not in the order they are given, and bricks that lie
+    no more than iMaxGap bytes apart are fetched with a single read of at
+    most iMaxRead bytes.  Each brick is then decoded straight from that read
+    into the buffer 'target' gives out for it.
+    @param vBrickCoords coordinates of the bricks to read
+    @param target called with the position of a brick in vBrickCoords, must
+           return a buffer big enough for that brick
+    @param done called with the position of a brick in vBrickCoords after it
+           has been decoded; return false to skip all remaining bricks
+    @param iMaxGap the largest gap (in bytes) between two bricks that we
+           rather read over than split the read
+    @param iMaxRead the largest single read (in bytes), unless a brick on its
+           own is larger
+  */
+  void GetBrickData(const std::vector<UINT64VECTOR4>& vBrickCoords,
+                    const BrickTarget& target, const BrickDone& done,
+                    uint64_t iMaxGap=64*1024,
+                    uint64_t iMaxRead=16*1024*1024) const;
+
 
   /**
     Returns the global aspect ratio of the volume
@@ -402,6 +431,18 @@ private:
   */
   void GetBrickData(uint8_t* pData, uint64_t index) const;
 
+  /// @returns how large a buffer DecodeBrick needs for brick 'index'
+  size_t SourceSize(uint64_t index) const;
+
+  /**
+    expands the brick 'index' from its bytes as stored in the file
+    @param pData the raw (uncompressed) data of the brick
+    @param pSource the brick as it was read from the file, at least
+           SourceSize(index) bytes
+  */
+  void DecodeBrick(uint8_t* pData, uint64_t index,
+                   std::shared_ptr<uint8_t> pSource) const;
+
   /** 
     returns true iff the large raw file holding this tree's
     data is is currently in RW mode
@@ -24,10 +24,14 @@
 
 // for find_if
 #include <algorithm>
+#include <exception>
 #include <memory>
 #include <map>
 #include <unordered_map>
 #include <stdexcept>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 #include "Basics/MathTools.h"
 #include "Basics/ProgressTimer.h"
 #include "Basics/Timer.h"
@@ -63,7 +67,9 @@ ExtendedOctreeConverter::ExtendedOctreeConverter(
     m_iMemLimit(iMemLimit),
     m_iCacheAccessCounter(0),
     m_pBrickStatVec(NULL),
-    m_Progress(progress)
+    m_Progress(progress),
+    m_iThreadCount(0),
+    m_bBricksProcessed(false)
 {
   m_pProgressTimer->Start();
 }
@@ -262,9 +268,15 @@ bool ExtendedOctreeConverter::Convert(LargeRAWFile_ptr pLargeRAWFileIn,
     m_eLayout = LT_SCANLINE;
   }
 
+  // with more than one thread all bricks get their statistics and compression
+  // up front, the serial passes below then only have to move bytes around
+  m_bBricksProcessed = false;
+  if (GetThreadCount() > 1)
+    ParallelComputeStatsAndCompressAll(e);
+
   if (m_eLayout != LT_SCANLINE)
     ComputeStatsCompressAndPermuteAll(e);
-  else
+  else if (!m_bBricksProcessed)
     ComputeStatsAndCompressAll(e);
 
   // add header to file
@@ -495,8 +507,6 @@ void ExtendedOctreeConverter::ComputeStatsAndCompressAll(ExtendedOctree& tree)
       }
     }
   } else {
-    std::array<uint8_t, 5> lzmaProps;
-
     // foreach brick:
     //   load it up
     //   compress it
@@ -507,31 +517,8 @@ void ExtendedOctreeConverter::ComputeStatsAndCompressAll(ExtendedOctree& tree)
       BrickStat(m_pBrickStatVec, i, BrickData.get(), BrickSize(tree, i),
                 tree.m_iComponentCount, tree.m_eComponentType);
 
-      uint64_t newlen = 0;
-      switch (m_eCompression) {
-      case CT_ZLIB:
-        newlen = zCompress(BrickData, BrickSize(tree, i), compressed,
-                           tree.m_iCompressionLevel); // 0..9 (0 no comp)
-        break;
-      case CT_LZMA:
-        newlen = lzmaCompress(BrickData, BrickSize(tree, i), compressed,
-                              lzmaProps, tree.m_iCompressionLevel - 1); // 0..9
-        assert(lzmaProps == tree.m_lzmaProps);
-        break;
-      case CT_LZ4:
-        newlen = lz4Compress(BrickData, BrickSize(tree, i), compressed,
-                             tree.m_iCompressionLevel); // 1..17
-        break;
-      case CT_BZLIB:
-        newlen = bzCompress(BrickData, BrickSize(tree, i), compressed,
-                            tree.m_iCompressionLevel); // 1..9
-        break;
-      case CT_LZHAM:
-        throw std::runtime_error("lzham compression format is not supported anymore by Tuvok");
-        break;
-      default:
-        throw std::runtime_error("unknown compression format");
-      }
+      const uint64_t newlen = CompressBrick(tree, BrickData, BrickSize(tree, i),
+                                            compressed);
       std::shared_ptr<uint8_t> data;
 
       if(newlen < BrickSize(tree, i)) {
@@ -547,7 +534,7 @@ void ExtendedOctreeConverter::ComputeStatsAndCompressAll(ExtendedOctree& tree)
         tree.m_vTOC[i].m_iOffset = tree.m_vTOC[i-1].m_iOffset +
                                    tree.m_vTOC[i-1].m_iLength;
       }
-      tree.m_pLargeRAWFile->SeekPos(tree.m_vTOC[i].m_iOffset);
+      tree.m_pLargeRAWFile->SeekPos(tree.m_iOffset + tree.m_vTOC[i].m_iOffset);
       tree.m_pLargeRAWFile->WriteRAW(data.get(), tree.m_vTOC[i].m_iLength);
       
       if (i % iReportInterval == 0) {
@@ -563,6 +550,142 @@ void ExtendedOctreeConverter::ComputeStatsAndCompressAll(ExtendedOctree& tree)
   tree.m_iSize = tree.m_vTOC.back().m_iOffset + tree.m_vTOC.back().m_iLength;
 }
 
+/// Same as ComputeStatsAndCompressAll but loads, analyzes and compresses
+/// batches of bricks on all threads; the results are then written to disk
+/// in index order so the file is identical to the one of the serial path.
+void ExtendedOctreeConverter::ParallelComputeStatsAndCompressAll(ExtendedOctree& tree)
+{
+  FlushCache(tree); // be sure we've got everything on disk.
+  m_vBrickCache.clear(); // be double sure we don't use the cache anymore.
+
+  // fail before doing any work, rather than from within the parallel loop
+  if (m_eCompression == CT_LZHAM)
+    throw std::runtime_error("lzham compression format is not supported anymore by Tuvok");
+
+  const size_t iVoxelSize = tree.GetComponentTypeSize() *
+                            size_t(tree.m_iComponentCount);
+  const size_t maxbricksize = static_cast<size_t>(tree.m_iBrickSize.volume() *
+                                                  iVoxelSize);
+  const size_t iBrickCount = tree.m_vTOC.size();
+  const int iThreads = int(GetThreadCount());
+
+  // each brick in flight needs room for its raw and its compressed data
+  const size_t iBatchSize = std::min<size_t>(iBrickCount,
+    std::max<size_t>(size_t(iThreads), size_t(m_iMemLimit / (2*maxbricksize))));
+  std::vector<std::shared_ptr<uint8_t>> vBrickData(iBatchSize);
+  std::vector<std::shared_ptr<uint8_t>> vCompressed(iBatchSize);
+  std::vector<uint64_t> vCompressedLength(iBatchSize, 0);
+
+  // size the stats vector now so that no thread ever needs to resize it
+  if (m_pBrickStatVec &&
+      m_pBrickStatVec->size() < iBrickCount * tree.m_iComponentCount)
+    m_pBrickStatVec->resize(iBrickCount * size_t(tree.m_iComponentCount));
+
+  m_Progress.Message(_func_, "Statistics and compression using %d threads",
+                     iThreads);
+
+  // compressed bricks never grow, so the packed data of a batch always ends
+  // before the first uncompressed brick of the next batch starts
+  uint64_t writeOffset = tree.m_vTOC[0].m_iOffset;
+  for (size_t iStart = 0; iStart < iBrickCount; iStart += iBatchSize) {
+    const int64_t iCount = int64_t(std::min(iBatchSize, iBrickCount - iStart));
+
+    // an exception must not leave the parallel region (that would end the
+    // program); the first one is kept and thrown once all threads are done.
+    std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic) num_threads(iThreads)
+    for (int64_t j = 0; j < iCount; ++j) {
+      try {
+        const size_t i = iStart + size_t(j);
+        std::shared_ptr<uint8_t>& data = vBrickData[size_t(j)];
+        if (!data)
+          data.reset(new uint8_t[maxbricksize], nonstd::DeleteArray<uint8_t>());
+        tree.GetBrickData(data.get(), i);
+        if (m_pBrickStatVec)
+          BrickStat(m_pBrickStatVec, i, data.get(), BrickSize(tree, i),
+                    tree.m_iComponentCount, tree.m_eComponentType);
+        if (m_eCompression != CT_NONE)
+          vCompressedLength[size_t(j)] = CompressBrick(tree, data,
+                                                       BrickSize(tree, i),
+                                                       vCompressed[size_t(j)]);
+      } catch (...) {
+#pragma omp critical(CompressAllError)
+        if (!error) error = std::current_exception();
+      }
+    }
+    if (error) std::rethrow_exception(error);
+
+    // without compression nothing changes on disk
+    if (m_eCompression != CT_NONE) {
+      for (size_t j = 0; j < size_t(iCount); ++j) {
+        const size_t i = iStart + j;
+        TOCEntry& record = tree.m_vTOC[i];
+        std::shared_ptr<uint8_t> data;
+        if (vCompressedLength[j] < BrickSize(tree, i)) {
+          record.m_iLength = vCompressedLength[j];
+          record.m_eCompression = m_eCompression;
+          data = vCompressed[j];
+        } else {
+          record.m_iLength = BrickSize(tree, i);
+          record.m_eCompression = CT_NONE;
+          data = vBrickData[j];
+        }
+        record.m_iOffset = writeOffset;
+        writeOffset += record.m_iLength;
+        tree.m_pLargeRAWFile->SeekPos(tree.m_iOffset + record.m_iOffset);
+        tree.m_pLargeRAWFile->WriteRAW(data.get(), record.m_iLength);
+      }
+    }
+
+    m_fProgress = float(iStart + size_t(iCount)) / iBrickCount;
+    std::string msg = m_pProgressTimer->GetProgressMessage(m_fProgress);
+    m_Progress.Message(_func_, "Statistics and compression .. %5.2f%% (%s)",
+                       m_fProgress*100.0f, msg.c_str());
+  }
+
+  // do not forget to set new octree size
+  tree.m_iSize = tree.m_vTOC.back().m_iOffset + tree.m_vTOC.back().m_iLength;
+  m_bBricksProcessed = true;
+}
+
+uint64_t ExtendedOctreeConverter::CompressBrick(const ExtendedOctree& tree,
+                                                std::shared_ptr<uint8_t> pData,
+                                                uint64_t iLength,
+                                                std::shared_ptr<uint8_t>& pCompressed) const
+{
+  switch (m_eCompression) {
+  case CT_ZLIB:
+    return zCompress(pData, size_t(iLength), pCompressed,
+                     tree.m_iCompressionLevel); // 0..9 (0 no comp)
+  case CT_LZMA: {
+    // we only use the encoded props for safety checks
+    // they should be identical for all bricks of the tree
+    std::array<uint8_t, 5> props;
+    const size_t iCompressed = lzmaCompress(pData, size_t(iLength), pCompressed,
+                                            props, tree.m_iCompressionLevel - 1); // 0..9
+    assert(props == tree.m_lzmaProps);
+    return iCompressed; }
+  case CT_LZ4:
+    return lz4Compress(pData, size_t(iLength), pCompressed,
+                       tree.m_iCompressionLevel); // 1..17
+  case CT_BZLIB:
+    return bzCompress(pData, size_t(iLength), pCompressed,
+                      tree.m_iCompressionLevel); // 1..9
+  case CT_LZHAM:
+    throw std::runtime_error("lzham compression format is not supported anymore by Tuvok");
+  default:
+    throw std::runtime_error("unknown compression format");
+  }
+}
+
+uint32_t ExtendedOctreeConverter::GetThreadCount() const {
+#ifdef _OPENMP
+  return m_iThreadCount > 0 ? m_iThreadCount : uint32_t(omp_get_max_threads());
+#else
+  return 1;
+#endif
+}
+
 std::shared_ptr<uint8_t>
 ExtendedOctreeConverter::Fetch(ExtendedOctree& tree,
                                uint64_t iIndex,
@@ -576,8 +699,9 @@ ExtendedOctreeConverter::Fetch(ExtendedOctree& tree,
   tree.m_pLargeRAWFile->ReadRAW(pData.get(), record.m_iLength);
 
   // if we are touching the brick the first time compute statistics and compress
-  if ((m_pBrickStatVec->size() < (iIndex+1) * tree.m_iComponentCount) ||
-      !m_pBrickStatVec->at(iIndex * tree.m_iComponentCount).IsValid())
+  if (!m_bBricksProcessed &&
+      ((m_pBrickStatVec->size() < (iIndex+1) * tree.m_iComponentCount) ||
+       !m_pBrickStatVec->at(iIndex * tree.m_iComponentCount).IsValid()))
   {
     assert(record.m_eCompression == CT_NONE);
     assert(record.m_iLength == BrickSize(tree, iIndex));
@@ -589,34 +713,8 @@ ExtendedOctreeConverter::Fetch(ExtendedOctree& tree,
     if (m_eCompression != CT_NONE) {
       std::shared_ptr<uint8_t> pCompressed;
       // *Compress will always create a buffer sized like the input data
-      uint64_t iCompressed = 0;
-      switch (m_eCompression) {
-      case CT_ZLIB:
-        iCompressed = zCompress(pData, record.m_iLength, pCompressed,
-                                tree.m_iCompressionLevel); // 0..9 (0 no comp)
-        break;
-      case CT_LZMA: {
-        // we only use the encoded props for safety checks
-        // they should be identical for all bricks of the tree
-        std::array<uint8_t, 5> props;
-        iCompressed = lzmaCompress(pData, record.m_iLength, pCompressed,
-                                   props, tree.m_iCompressionLevel - 1); // 0..9
-        assert(props == tree.m_lzmaProps);
-        break; }
-      case CT_LZ4:
-        iCompressed = lz4Compress(pData, record.m_iLength, pCompressed,
-                                  tree.m_iCompressionLevel); // 1..17
-        break;
-      case CT_BZLIB:
-        iCompressed = bzCompress(pData, record.m_iLength, pCompressed,
-                                 tree.m_iCompressionLevel); // 1..9
-        break;
-      case CT_LZHAM:
-        throw std::runtime_error("lzham compression format is not supported anymore by Tuvok");
-        break;
-      default:
-        throw std::runtime_error("unknown compression format");
-      }
+      uint64_t const iCompressed = CompressBrick(tree, pData, record.m_iLength,
+                                                 pCompressed);
       if (iCompressed < record.m_iLength) {
         if (!pBuffer) {
           pData.reset(new uint8_t[iCompressed], nonstd::DeleteArray<uint8_t>());
@@ -32,6 +32,7 @@
 #include "ExtendedOctree.h"
 #include "VolumeTools.h"
 #include "Basics/MathTools.h"
+#include "Basics/ValueOccupancy.h"
 
 /*! \brief Stores brick statistics such as the minimum and maximum values
  */
@@ -39,16 +40,21 @@ template<class T> class BrickStats {
 public:
   BrickStats() :
     minScalar( std::numeric_limits<T>::max()),
-    maxScalar(-std::numeric_limits<T>::max())
+    maxScalar(-std::numeric_limits<T>::max()),
+    occupancy(tuvok::ValueOccupancy::All)
   {}
 
-  BrickStats(T _minScalar, T _maxScalar) :
+  BrickStats(T _minScalar, T _maxScalar,
+             uint64_t _occupancy=tuvok::ValueOccupancy::All) :
     minScalar(_minScalar),
-    maxScalar(_maxScalar)
+    maxScalar(_maxScalar),
+    occupancy(_occupancy)
   {}
 
   T minScalar;
   T maxScalar;
+  /// bins of [minScalar, maxScalar] holding values, see tuvok::ValueOccupancy
+  uint64_t occupancy;
 
   bool IsValid() const { return minScalar !=  std::numeric_limits<T>::max() &&
                                 maxScalar != -std::numeric_limits<T>::max(); }
@@ -148,6 +154,18 @@ public:
   */
   float GetProgress() const {return m_fProgress;}
 
+  /**
+    Sets the number of threads used to compute brick statistics and to
+    compress the bricks, the resulting file does not depend on this setting
+
+    @param iThreadCount number of threads, 0 uses all available cores and 1
+                        selects the serial code path
+  */
+  void SetThreadCount(uint32_t iThreadCount) {m_iThreadCount = iThreadCount;}
+
+  /// @return the number of threads the next conversion will use
+  uint32_t GetThreadCount() const;
+
 
   /**
    Exports a specific LoD Level into a continuous raw file
@@ -398,10 +416,26 @@ private:
   /// where to write progress information
   AbstrDebugOut& m_Progress;
 
+  /// threads to use for statistics and compression, 0 means all cores
+  uint32_t m_iThreadCount;
+
+  /// true iff stats and compression are already done for all bricks
+  bool m_bBricksProcessed;
+
   /// Computes max min statistics for each brick and rewrites 
   /// it using compression, if desired.
   void ComputeStatsAndCompressAll(ExtendedOctree& tree);
 
+  /// Parallel version of ComputeStatsAndCompressAll(), produces the same file
+  /// but leaves the stats and compression of each brick to a pool of threads.
+  void ParallelComputeStatsAndCompressAll(ExtendedOctree& tree);
+
+  /// Compresses a brick with the compression method of this converter.
+  /// @return the size of the compressed data stored in pCompressed
+  uint64_t CompressBrick(const ExtendedOctree& tree,
+                         std::shared_ptr<uint8_t> pData, uint64_t iLength,
+                         std::shared_ptr<uint8_t>& pCompressed) const;
+
   /// Computes max min statistics for each brick, rewrites it using compression
   /// and permutes brick ordering on disk, if desired.
   void ComputeStatsCompressAndPermuteAll(ExtendedOctree& tree);
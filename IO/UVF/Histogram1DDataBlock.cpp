@@ -1,9 +1,9 @@
 #include "Histogram1DDataBlock.h"
 
 #include "RasterDataBlock.h"
-#include "../../Basics/MathTools.h"
 #include "../../Controller/Controller.h"
 #include "../../Basics/ProgressTimer.h"
+#include "BrickHistogram.h"
 
 // simple/generic progress update message
 
@@ -58,18 +58,8 @@ uint64_t Histogram1DDataBlock::GetHeaderFromFile(LargeRAWFile_ptr pStreamFile, u
 }
 
 bool Histogram1DDataBlock::Compute(const TOCBlock* source, uint64_t iLevel) {
-  // do not try to compute a histogram for floating point data,
-  // anything beyond 32 bit or more than 1 component data
-  if (source->GetComponentType() == ExtendedOctree::CT_FLOAT32 ||
-      source->GetComponentType() == ExtendedOctree::CT_FLOAT64 ||
-      source->GetComponentTypeSize() > 4 ||
-      source->GetComponentCount() != 1) return false;
-
-  // resize histogram 
-  size_t iValueRange = size_t(MathTools::Pow2(uint64_t(source->GetComponentTypeSize()*8)));
-  m_vHistData.resize(iValueRange);
-  if (m_vHistData.size() != iValueRange) return false;
-  std::fill(m_vHistData.begin(), m_vHistData.end(), 0);
+  // do not try to compute a histogram for more than 1 component data
+  if (source->GetComponentCount() != 1) return false;
 
   // compute histogram
   switch (source->GetComponentType()) {
@@ -103,12 +93,13 @@ bool Histogram1DDataBlock::Compute(const TOCBlock* source, uint64_t iLevel) {
     case ExtendedOctree::CT_FLOAT64:
       ComputeTemplate<double>(source, iLevel);
       break;
+    default:
+      return false;
   }
 
-
   // find maximum-index non zero entry and clip histogram data
   size_t iSize = 0;
-  for (size_t i = 0;i<iValueRange;i++) if (m_vHistData[i] != 0) iSize = i+1;
+  for (size_t i = 0;i<m_vHistData.size();i++) if (m_vHistData[i] != 0) iSize = i+1;
   m_vHistData.resize(iSize);
 
   // set data block information
@@ -120,44 +111,56 @@ bool Histogram1DDataBlock::Compute(const TOCBlock* source, uint64_t iLevel) {
 template <class T> 
 void Histogram1DDataBlock::ComputeTemplate(const TOCBlock* source,
                                            uint64_t iLevel) {
-  // compute histogram by iterating over all bricks of the given level
-  UINT64VECTOR3 bricksInSourceLevel = source->GetBrickCount(iLevel);
-
-  size_t iCompcount = size_t(source->GetComponentCount());
-  T* pTempBrickData = new T[size_t(source->GetMaxBrickSize().volume())
-                            *iCompcount];
-
-  uint32_t iOverlap =source->GetOverlap();
-
   ProgressTimer timer;
   timer.Start();
 
-  for (uint64_t bz = 0;bz<bricksInSourceLevel.z;bz++) {
-    for (uint64_t by = 0;by<bricksInSourceLevel.y;by++) {
-      for (uint64_t bx = 0;bx<bricksInSourceLevel.x;bx++) {
-        UINT64VECTOR4 brickCoords(bx,by,bz,iLevel);
-        source->GetData((uint8_t*)pTempBrickData, brickCoords);
-        UINTVECTOR3 bricksize = UINTVECTOR3(source->GetBrickSize(brickCoords));
-
-        for (uint32_t z = iOverlap;z<bricksize.z-iOverlap;z++) {
-          for (uint32_t y = iOverlap;y<bricksize.y-iOverlap;y++) {
-            for (uint32_t x = iOverlap;x<bricksize.x-iOverlap;x++) {
-              // TODO: think about what todo with multi component data
-              //       right now we only pick the first component
-              size_t val = size_t(pTempBrickData[iCompcount*(x+y*bricksize.x+z*bricksize.x*bricksize.y)]);
-              m_vHistData[val]++;
-            }
+  // 8 and 16 bit unsigned data is binned by value, everything else needs
+  // to know its range first
+  BrickHistogram::Binning binning;
+  float fRangeDone = 0.0f;
+  if (sizeof(T) <= 2 && !std::numeric_limits<T>::is_signed) {
+    binning = BrickHistogram::Binning::Fixed(
+      0, double(std::numeric_limits<T>::max()), true,
+      size_t(std::numeric_limits<T>::max())+1
+    );
+  } else {
+    double fMin, fMax;
+    fRangeDone = 0.5f;
+    BrickHistogram::ValueRange<T>(source, iLevel, fMin, fMax, timer,
+                                  "Computing 1D Histogram", 0.0f, fRangeDone);
+    binning = BrickHistogram::Binning::Range(
+      fMin, fMax, std::numeric_limits<T>::is_integer
+    );
+  }
+
+  // every thread bins into its own histogram, they are summed up at the end
+  const int iThreads = BrickHistogram::Threads(binning.bins*sizeof(uint64_t));
+  std::vector<std::vector<uint64_t>> vLocalHist(static_cast<size_t>(iThreads));
+  const size_t iCompcount = size_t(source->GetComponentCount());
+  const uint32_t iOverlap = source->GetOverlap();
+
+  BrickHistogram::ForEachBrick<T>(source, iLevel, iThreads,
+    [&](int t, const T* pData, const UINTVECTOR3& bricksize) {
+      std::vector<uint64_t>& hist = vLocalHist[size_t(t)];
+      if (hist.empty()) hist.resize(binning.bins, 0);
+      for (uint32_t z = iOverlap;z<bricksize.z-iOverlap;z++) {
+        for (uint32_t y = iOverlap;y<bricksize.y-iOverlap;y++) {
+          const T* row = pData + iCompcount*(size_t(z)*bricksize.x*bricksize.y+
+                                             size_t(y)*bricksize.x);
+          for (uint32_t x = iOverlap;x<bricksize.x-iOverlap;x++) {
+            // TODO: think about what todo with multi component data
+            //       right now we only pick the first component
+            hist[binning(row[iCompcount*x])]++;
           }
         }
       }
-    }
+    }, timer, "Computing 1D Histogram", fRangeDone, 1.0f);
 
-    float progress = float(bz)/float(bricksInSourceLevel.z);
-    MESSAGE("Computing 1D Histogram %5.2f%% (%s)", 
-            progress * 100.0f,
-            timer.GetProgressMessage(progress).c_str());
+  m_vHistData.assign(binning.bins, 0);
+  for (size_t t = 0;t<vLocalHist.size();t++) {
+    const std::vector<uint64_t>& hist = vLocalHist[t];
+    for (size_t i = 0;i<hist.size();i++) m_vHistData[i] += hist[i];
   }
-  delete [] pTempBrickData;
 }
 
 
@@ -19,6 +19,8 @@ public:
   virtual Histogram1DDataBlock& operator=(const Histogram1DDataBlock& other);
   virtual uint64_t ComputeDataSize() const;
 
+  /// 8 and 16 bit unsigned data gets one bin per value; any other type is
+  /// binned as described in BrickHistogram::Binning.
   bool Compute(const TOCBlock* source, uint64_t iLevel);
   bool Compute(const RasterDataBlock* source);
   const std::vector<uint64_t>& GetHistogram() const {return m_vHistData;}
@@ -4,6 +4,7 @@
 #include "TOCBlock.h"
 #include "../../Controller/Controller.h"
 #include "../../Basics/ProgressTimer.h"
+#include "BrickHistogram.h"
 
 using namespace std;
 
@@ -70,12 +71,8 @@ bool Histogram2DDataBlock::Compute(const TOCBlock* source,
                                    uint64_t iLevel,
                                    size_t iHistoBinCount,
                                    double fMaxNonZeroValue) {
-  // do not try to compute a histogram for floating point data,
-  // anything beyond 32 bit or more than 1 component data
-  if (source->GetComponentType() == ExtendedOctree::CT_FLOAT32 ||
-    source->GetComponentType() == ExtendedOctree::CT_FLOAT64 ||
-    source->GetComponentTypeSize() > 4 ||
-    source->GetComponentCount() != 1) return false;
+  // do not try to compute a histogram for more than 1 component data
+  if (source->GetComponentCount() != 1 || iHistoBinCount == 0) return false;
 
   // resize histogram 
   m_vHistData.resize(iHistoBinCount);
@@ -118,6 +115,8 @@ bool Histogram2DDataBlock::Compute(const TOCBlock* source,
   case ExtendedOctree::CT_FLOAT64:
     ComputeTemplate<double>(source, 1.0, iLevel, iHistoBinCount, fMaxNonZeroValue);
     break;
+  default:
+    return false;
   }
 
   // set data block information
@@ -350,103 +349,85 @@ void Histogram2DDataBlock::ComputeTemplate(const TOCBlock* source, double normal
                       uint64_t iLevel, size_t iHistoBinCount,
                       double fMaxNonZeroValue) {
   // compute histogram by iterating over all bricks of the given level
-  UINT64VECTOR3 bricksInSourceLevel = source->GetBrickCount(iLevel);
-
-  size_t iCompcount = size_t(source->GetComponentCount());
-  T* pTempBrickData = new T[size_t(source->GetMaxBrickSize().volume()) *
-                            iCompcount];
-
-  uint32_t iOverlap =source->GetOverlap();
-  double fMaxGradMagnitude = 0;
+  const size_t iCompcount = size_t(source->GetComponentCount());
+  const uint32_t iOverlap = source->GetOverlap();
 
   ProgressTimer timer;
   timer.Start();
 
-  // find the maximum gradient magnitude
-  for (uint64_t bz = 0;bz<bricksInSourceLevel.z;bz++) {
-    for (uint64_t by = 0;by<bricksInSourceLevel.y;by++) {
-      for (uint64_t bx = 0;bx<bricksInSourceLevel.x;bx++) {
-
-        UINT64VECTOR4 brickCoords(bx,by,bz,iLevel);
-        source->GetData((uint8_t*)pTempBrickData, brickCoords);
-        UINTVECTOR3 bricksize = UINTVECTOR3(source->GetBrickSize(brickCoords));
-
-#ifdef _MSC_VER
-# pragma omp parallel for shared(fMaxGradMagnitude)
-        for (int32_t z = iOverlap;uint32_t(z)<bricksize.z-iOverlap;z++) {
-#else
-# pragma omp parallel for collapse(3) shared(fMaxGradMagnitude)
-        for (uint32_t z = iOverlap;z<bricksize.z-iOverlap;z++) {
-#endif
-          for (uint32_t y = iOverlap;y<bricksize.y-iOverlap;y++) {
-            for (uint32_t x = iOverlap;x<bricksize.x-iOverlap;x++) {
-              DOUBLEVECTOR3 vGradient = ComputeGradient(
-                pTempBrickData, normalizationFactor, iCompcount, bricksize,
-                UINTVECTOR3(x,y,z)
-              );
-
-              #pragma omp flush(fMaxGradMagnitude)
-              if(vGradient.length() > fMaxGradMagnitude)
-              #pragma omp critical
-              { if(vGradient.length() > fMaxGradMagnitude) {
-                  fMaxGradMagnitude = vGradient.length();
-                }
-              }
-            }
+  // find the maximum gradient magnitude and the smallest value
+  const int iRangeThreads = BrickHistogram::Threads(0);
+  std::vector<double> vMaxGrad(size_t(iRangeThreads), 0.0);
+  std::vector<double> vMinValue(size_t(iRangeThreads),
+                                std::numeric_limits<double>::max());
+  BrickHistogram::ForEachBrick<T>(source, iLevel, iRangeThreads,
+    [&](int t, const T* pData, const UINTVECTOR3& bricksize) {
+      double fMaxGrad = vMaxGrad[size_t(t)];
+      double fMinValue = vMinValue[size_t(t)];
+      for (uint32_t z = iOverlap;z<bricksize.z-iOverlap;z++) {
+        for (uint32_t y = iOverlap;y<bricksize.y-iOverlap;y++) {
+          for (uint32_t x = iOverlap;x<bricksize.x-iOverlap;x++) {
+            const DOUBLEVECTOR3 vGradient = ComputeGradient(
+              pData, normalizationFactor, iCompcount, bricksize,
+              UINTVECTOR3(x,y,z)
+            );
+            fMaxGrad = std::max(fMaxGrad, vGradient.length());
+            const size_t iCenter = size_t(x+bricksize.x*y+bricksize.x*bricksize.y*z);
+            fMinValue = std::min(fMinValue, double(pData[iCompcount*iCenter]));
           }
         }
       }
-    }
-    float progress = 0.5f*float(bz)/float(bricksInSourceLevel.z);
-    MESSAGE("Computing 2D Histogram %5.2f%% (%s)", 
-            progress * 100.0f,
-            timer.GetProgressMessage(progress).c_str());
-  }
-
-  // fill the histogram the maximum gradient magnitude
-  for (uint64_t bz = 0;bz<bricksInSourceLevel.z;bz++) {
-    for (uint64_t by = 0;by<bricksInSourceLevel.y;by++) {
-      for (uint64_t bx = 0;bx<bricksInSourceLevel.x;bx++) {
-
-        UINT64VECTOR4 brickCoords(bx,by,bz,iLevel);
-        source->GetData((uint8_t*)pTempBrickData, brickCoords);
-        UINTVECTOR3 bricksize = UINTVECTOR3(source->GetBrickSize(brickCoords));
-        #pragma omp parallel for firstprivate(fMaxGradMagnitude)
-#ifdef _MSC_VER
-        for (int32_t z = iOverlap;uint32_t(z)<bricksize.z-iOverlap;z++) {
-#else
-        for (uint32_t z = iOverlap;z<bricksize.z-iOverlap;z++) {
-#endif
-          for (uint32_t y = iOverlap;y<bricksize.y-iOverlap;y++) {
-            for (uint32_t x = iOverlap;x<bricksize.x-iOverlap;x++) {
-              const DOUBLEVECTOR3 vGradient = ComputeGradient(
-                pTempBrickData, normalizationFactor, iCompcount, bricksize,
-                UINTVECTOR3(x,y,z)
-              );
-
-              size_t iCenter = size_t(x+bricksize.x*y+bricksize.x*bricksize.y*z);
-              size_t iGradientMagnitudeIndex = std::min<size_t>(255,size_t(vGradient.length()/fMaxGradMagnitude*255.0f));
-              size_t iValue = (fMaxNonZeroValue <= double(iHistoBinCount-1)) 
-                                  ? size_t(pTempBrickData[iCenter]) 
-                                  : size_t(double(pTempBrickData[iCenter]) * double(iHistoBinCount-1)/fMaxNonZeroValue);
-              // make sure round errors don't cause index to go out of bounds
-              if (iGradientMagnitudeIndex > 255) iGradientMagnitudeIndex = 255;
-              if (iValue > iHistoBinCount-1) iValue = iHistoBinCount-1; 
-              #pragma omp atomic
-              m_vHistData[iValue][iGradientMagnitudeIndex]++;
-            }
+      vMaxGrad[size_t(t)] = fMaxGrad;
+      vMinValue[size_t(t)] = fMinValue;
+    }, timer, "Computing 2D Histogram", 0.0f, 0.5f);
+
+  const double fMaxGradMagnitude = *std::max_element(vMaxGrad.begin(),
+                                                     vMaxGrad.end());
+  const BrickHistogram::Binning binning = BrickHistogram::Binning::Fixed(
+    *std::min_element(vMinValue.begin(), vMinValue.end()), fMaxNonZeroValue,
+    std::numeric_limits<T>::is_integer, iHistoBinCount
+  );
+
+  // fill the histogram; every thread bins into its own copy, which are
+  // summed up at the end
+  const int iThreads = BrickHistogram::Threads(iHistoBinCount*256*sizeof(uint64_t));
+  std::vector<std::vector<uint64_t>> vLocalHist(static_cast<size_t>(iThreads));
+  BrickHistogram::ForEachBrick<T>(source, iLevel, iThreads,
+    [&](int t, const T* pData, const UINTVECTOR3& bricksize) {
+      std::vector<uint64_t>& hist = vLocalHist[size_t(t)];
+      if (hist.empty()) hist.resize(iHistoBinCount*256, 0);
+      for (uint32_t z = iOverlap;z<bricksize.z-iOverlap;z++) {
+        for (uint32_t y = iOverlap;y<bricksize.y-iOverlap;y++) {
+          for (uint32_t x = iOverlap;x<bricksize.x-iOverlap;x++) {
+            const DOUBLEVECTOR3 vGradient = ComputeGradient(
+              pData, normalizationFactor, iCompcount, bricksize,
+              UINTVECTOR3(x,y,z)
+            );
+
+            size_t iCenter = size_t(x+bricksize.x*y+bricksize.x*bricksize.y*z);
+            const double fGradient = (fMaxGradMagnitude > 0)
+              ? vGradient.length()/fMaxGradMagnitude*255.0f : 0.0;
+            // make sure round errors (or NaNs) don't cause index to go out
+            // of bounds
+            const size_t iGradientMagnitudeIndex = (fGradient > 0)
+              ? size_t(std::min(255.0, fGradient)) : 0;
+            const size_t iValue = binning(pData[iCompcount*iCenter]);
+            hist[iValue*256+iGradientMagnitudeIndex]++;
           }
         }
       }
+    }, timer, "Computing 2D Histogram", 0.5f, 1.0f);
+
+  const int64_t iBins = int64_t(iHistoBinCount);
+#pragma omp parallel for
+  for (int64_t i = 0;i<iBins;i++) {
+    for (size_t t = 0;t<vLocalHist.size();t++) {
+      if (vLocalHist[t].empty()) continue;
+      const uint64_t* local = &vLocalHist[t][size_t(i)*256];
+      for (size_t j = 0;j<256;j++) m_vHistData[size_t(i)][j] += local[j];
     }
-    float progress = 0.5f+0.5f*float(bz)/float(bricksInSourceLevel.z);
-    MESSAGE("Computing 2D Histogram %5.2f%% (%s)", 
-            progress * 100.0f,
-            timer.GetProgressMessage(progress).c_str());
   }
   m_fMaxGradMagnitude = float(fMaxGradMagnitude);
-
-  delete [] pTempBrickData;
 }
 
 
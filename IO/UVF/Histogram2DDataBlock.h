@@ -20,6 +20,8 @@ public:
   virtual Histogram2DDataBlock& operator=(const Histogram2DDataBlock& other);
   virtual uint64_t ComputeDataSize() const;
 
+  /// values are binned into 'iHistoBinCount' bins just like the 1D histogram
+  /// of the same data, see BrickHistogram::Binning.
   bool Compute(const TOCBlock* source, uint64_t iLevel, size_t iHistoBinCount,
                double fMaxNonZeroValue);
   bool Compute(const RasterDataBlock* source,
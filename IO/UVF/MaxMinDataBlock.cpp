@@ -34,6 +34,7 @@ MaxMinDataBlock::MaxMinDataBlock(const MaxMinDataBlock &other) :
   DataBlock(other),
   m_GlobalMaxMin(other.m_GlobalMaxMin),
   m_vfMaxMinData(other.m_vfMaxMinData),
+  m_vOccupancy(other.m_vOccupancy),
   m_iComponentCount(other.m_iComponentCount)
 {
 }
@@ -47,6 +48,7 @@ MaxMinDataBlock& MaxMinDataBlock::operator=(const MaxMinDataBlock& other) {
   m_iComponentCount = other.m_iComponentCount;
   m_GlobalMaxMin = other.m_GlobalMaxMin;
   m_vfMaxMinData = other.m_vfMaxMinData;
+  m_vOccupancy = other.m_vOccupancy;
 
   return *this;
 }
@@ -91,6 +93,24 @@ uint64_t MaxMinDataBlock::GetHeaderFromFile(LargeRAWFile_ptr pStreamFile, uint64
     }
   }
 
+  // Newer files append the bins each brick occupies.  Older readers never
+  // see them, as they continue at the next block's offset.
+  m_vOccupancy.clear();
+  const uint64_t iEnd = ulOffsetToNextDataBlock != 0
+                      ? iOffset + ulOffsetToNextDataBlock
+                      : pStreamFile->GetCurrentSize();
+  const uint64_t iCount = ulBrickCount * m_iComponentCount;
+  if(pStreamFile->GetPos() + sizeof(uint64_t) * (1 + iCount) <= iEnd) {
+    uint64_t iBins;
+    pStreamFile->ReadData(iBins, bIsBigEndian);
+    if(iBins == ValueOccupancy::Bins) {
+      m_vOccupancy.resize(size_t(iCount));
+      for(size_t i = 0; i < m_vOccupancy.size(); ++i) {
+        pStreamFile->ReadData(m_vOccupancy[i], bIsBigEndian);
+      }
+    }
+  }
+
   return pStreamFile->GetPos() - iOffset;
 }
 
@@ -115,6 +135,13 @@ uint64_t MaxMinDataBlock::CopyToFile(LargeRAWFile_ptr pStreamFile, uint64_t iOff
       pStreamFile->WriteData((*i)[j].maxGradient, bIsBigEndian);
     }
   }
+  if(HasOccupancy()) {
+    uint64_t iBins = ValueOccupancy::Bins;
+    pStreamFile->WriteData(iBins, bIsBigEndian);
+    for(size_t i = 0; i < m_vOccupancy.size(); ++i) {
+      pStreamFile->WriteData(m_vOccupancy[i], bIsBigEndian);
+    }
+  }
 
   return pStreamFile->GetPos() - iOffset;
 }
@@ -138,7 +165,9 @@ uint64_t MaxMinDataBlock::ComputeDataSize() const {
                 "assuming there are 4 values per element/component!");
   return sizeof(uint64_t) +                              // length of the vector
          sizeof(uint64_t) +                              // component count
-         32 * m_vfMaxMinData.size() * m_iComponentCount; // vector of data
+         32 * m_vfMaxMinData.size() * m_iComponentCount + // vector of data
+         (HasOccupancy() ? sizeof(uint64_t) *             // bin count and
+                           (1 + m_vOccupancy.size()) : 0); // occupancy
 }
 
 const MinMaxBlock& MaxMinDataBlock::GetValue(size_t iIndex, size_t iComponent) const {
@@ -149,6 +178,14 @@ const MinMaxBlock& MaxMinDataBlock::GetValue(size_t iIndex, size_t iComponent) c
   return m_vfMaxMinData[iIndex][iComponent];
 }
 
+uint64_t MaxMinDataBlock::GetOccupancy(size_t iIndex, size_t iComponent) const {
+  const size_t i = iIndex * m_iComponentCount + iComponent;
+  if(iComponent >= m_iComponentCount || i >= m_vOccupancy.size()) {
+    return ValueOccupancy::All;
+  }
+  return m_vOccupancy[i];
+}
+
 void MaxMinDataBlock::StartNewValue() {
   vector<MinMaxBlock> elems;
   MinMaxBlock elem(std::numeric_limits<double>::max(),
@@ -157,6 +194,9 @@ void MaxMinDataBlock::StartNewValue() {
                   -std::numeric_limits<double>::max());
   for (uint64_t i = 0;i<m_iComponentCount;i++) elems.push_back(elem);  
   m_vfMaxMinData.push_back(elems);
+  if (HasOccupancy())
+    m_vOccupancy.resize(m_vOccupancy.size() + m_iComponentCount,
+                        ValueOccupancy::All);
 }
 
 void MaxMinDataBlock::MergeData(const std::vector<DOUBLEVECTOR4>& fMaxMinData)
@@ -179,6 +219,7 @@ void MaxMinDataBlock::SetDataFromFlatVector(BrickStatVec& source, uint64_t iComp
   size_t brickCount = size_t(source.size()/stcc);
   
   m_vfMaxMinData.resize(brickCount);
+  m_vOccupancy.resize(brickCount*stcc);
   for (size_t i = 0;i<brickCount;++i) {
     m_vfMaxMinData[i].resize(stcc);
 
@@ -189,6 +230,7 @@ void MaxMinDataBlock::SetDataFromFlatVector(BrickStatVec& source, uint64_t iComp
                        std::numeric_limits<double>::max());
 
       m_vfMaxMinData[i][j] = data;
+      m_vOccupancy[i*stcc+j] = source[i*stcc+j].occupancy;
       m_GlobalMaxMin[j].Merge(data);
     }
   }
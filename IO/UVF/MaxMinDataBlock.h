@@ -24,6 +24,10 @@ public:
   virtual uint64_t ComputeDataSize() const;
 
   const tuvok::MinMaxBlock& GetValue(size_t iIndex, size_t iComponent=0) const;
+  /// @returns which bins of the brick's scalar range hold values (see
+  /// tuvok::ValueOccupancy); all of them if the file does not say.
+  uint64_t GetOccupancy(size_t iIndex, size_t iComponent=0) const;
+  bool HasOccupancy() const { return !m_vOccupancy.empty(); }
   void StartNewValue();
   void MergeData(const std::vector<DOUBLEVECTOR4>& fMaxMinData);
   void SetDataFromFlatVector(BrickStatVec& source, uint64_t iComponentCount);
@@ -39,6 +43,8 @@ public:
 protected:
   std::vector<tuvok::MinMaxBlock> m_GlobalMaxMin;
   MaxMinVec   m_vfMaxMinData;
+  /// per brick and component; empty for files written before we had it.
+  std::vector<uint64_t> m_vOccupancy;
   size_t  m_iComponentCount;
 
   virtual uint64_t GetHeaderFromFile(LargeRAWFile_ptr pStreamFile, uint64_t iOffset,
@@ -1201,38 +1201,47 @@ RasterDataBlock::GetBrickByteSize(const std::vector<uint64_t>& vLOD,
 }
 
 LargeRAWFile_ptr
-RasterDataBlock::SeekToBrick(const std::vector<uint64_t>& vLOD,
-                             const std::vector<uint64_t>& vBrick) const
+RasterDataBlock::LocateBrick(const std::vector<uint64_t>& vLOD,
+                             const std::vector<uint64_t>& vBrick,
+                             uint64_t& iOffset) const
 {
   if (m_pTempFile == LargeRAWFile_ptr() && 
       m_pStreamFile == LargeRAWFile_ptr()) return LargeRAWFile_ptr();
   if (m_vLODOffsets.empty()) { return LargeRAWFile_ptr(); }
 
-  LargeRAWFile_ptr  pStreamFile;
-  uint64_t iOffset = GetLocalDataPointerOffset(vLOD, vBrick)/8;
+  iOffset = GetLocalDataPointerOffset(vLOD, vBrick)/8;
 
   if (m_pStreamFile) {
     // add global offset
     iOffset += m_iOffset;
     // add size of header
     iOffset += DataBlock::GetOffsetToNextBlock() + ComputeHeaderSize();
-    pStreamFile = m_pStreamFile;
-  } else {
-    pStreamFile = m_pTempFile;
+    return m_pStreamFile;
   }
-  pStreamFile->SeekPos(iOffset);
+  return m_pTempFile;
+}
+
+LargeRAWFile_ptr
+RasterDataBlock::SeekToBrick(const std::vector<uint64_t>& vLOD,
+                             const std::vector<uint64_t>& vBrick) const
+{
+  uint64_t iOffset = 0;
+  LargeRAWFile_ptr pStreamFile = LocateBrick(vLOD, vBrick, iOffset);
+  if (pStreamFile) pStreamFile->SeekPos(iOffset);
   return pStreamFile;
 }
 
+// reads at the brick's position rather than seeking there, so that bricks
+// may be read from several threads at once.
 bool RasterDataBlock::GetData(uint8_t* vData, size_t bytes,
                               const std::vector<uint64_t>& vLOD,
                               const std::vector<uint64_t>& vBrick) const
 {
-  LargeRAWFile_ptr pStreamFile = SeekToBrick(vLOD, vBrick);
+  uint64_t iOffset = 0;
+  LargeRAWFile_ptr pStreamFile = LocateBrick(vLOD, vBrick, iOffset);
   if(!pStreamFile) { return false; }
 
-  pStreamFile->ReadRAW(vData, bytes);
-  return true;
+  return pStreamFile->ReadRAWAt(vData, bytes, iOffset) == bytes;
 }
 
 bool RasterDataBlock::ValidLOD(const std::vector<uint64_t>& vLOD) const
@@ -351,6 +351,10 @@ protected:
                          const std::vector<uint64_t>& vPrefixProd,
                          const std::vector<uint64_t>& vBrickPrefixProduct) const;
 private:
+  /// finds the file holding the brick and the brick's position in it.
+  LargeRAWFile_ptr LocateBrick(const std::vector<uint64_t>& vLOD,
+                               const std::vector<uint64_t>& vBrick,
+                               uint64_t& iOffset) const;
   LargeRAWFile_ptr SeekToBrick(const std::vector<uint64_t>& vLOD,
                             const std::vector<uint64_t>& vBrick) const;
   bool GetData(unsigned char*, size_t bytes,
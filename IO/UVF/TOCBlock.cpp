@@ -234,6 +234,12 @@ void TOCBlock::GetData(uint8_t* pData, UINT64VECTOR4 coordinates) const {
   m_ExtendedOctree.GetBrickData(pData, coordinates);
 }
 
+void TOCBlock::GetData(const std::vector<UINT64VECTOR4>& vCoordinates,
+                       const ExtendedOctree::BrickTarget& target,
+                       const ExtendedOctree::BrickDone& done) const {
+  m_ExtendedOctree.GetBrickData(vCoordinates, target, done);
+}
+
 UINT64VECTOR3 TOCBlock::GetBrickCount(uint64_t iLoD) const {
   return m_ExtendedOctree.GetBrickCount(iLoD);
 }
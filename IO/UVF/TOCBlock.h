@@ -80,6 +80,11 @@ public:
                      AbstrDebugOut* pDebugOut=NULL) const;
 
   void GetData(uint8_t* pData, UINT64VECTOR4 coordinates) const;
+  /// reads many bricks with as few reads as possible, see
+  /// ExtendedOctree::GetBrickData
+  void GetData(const std::vector<UINT64VECTOR4>& vCoordinates,
+               const ExtendedOctree::BrickTarget& target,
+               const ExtendedOctree::BrickDone& done) const;
 
   uint64_t GetLoDCount() const;
   UINT64VECTOR3 GetBrickCount(uint64_t iLoD) const;
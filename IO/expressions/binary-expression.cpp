@@ -29,6 +29,7 @@
 
 #include "binary-expression.h"
 #include "constant.h"
+#include "program.h"
 
 namespace tuvok { namespace expression {
 
@@ -83,4 +84,10 @@ double BinaryExpression::Evaluate(size_t i) const {
   return 0.0;
 }
 
+size_t BinaryExpression::Compile(Program& p) const {
+  const size_t lhs = this->GetChild(0)->Compile(p);
+  const size_t rhs = this->GetChild(1)->Compile(p);
+  return p.EmitBinary(this->oper, lhs, rhs);
+}
+
 }}
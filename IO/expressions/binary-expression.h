@@ -41,6 +41,7 @@ class BinaryExpression : public Expression {
     virtual void Print(std::ostream&) const;
 
     virtual double Evaluate(size_t) const;
+    virtual size_t Compile(Program&) const;
 
   private:
     enum OpType oper;
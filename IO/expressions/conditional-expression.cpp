@@ -26,6 +26,7 @@
    DEALINGS IN THE SOFTWARE.
 */
 #include "conditional-expression.h"
+#include "program.h"
 
 namespace tuvok { namespace expression {
 
@@ -52,4 +53,11 @@ double ConditionalExpression::Evaluate(size_t idx) const {
   return false_path->Evaluate(idx);
 }
 
+size_t ConditionalExpression::Compile(Program& p) const {
+  const size_t boolean = this->GetChild(0)->Compile(p);
+  const size_t true_path = this->GetChild(1)->Compile(p);
+  const size_t false_path = this->GetChild(2)->Compile(p);
+  return p.EmitSelect(boolean, true_path, false_path);
+}
+
 }}
@@ -26,6 +26,7 @@
    DEALINGS IN THE SOFTWARE.
 */
 #include "constant.h"
+#include "program.h"
 
 namespace tuvok { namespace expression {
 
@@ -35,5 +36,8 @@ void Constant::Analyze() const throw(semantic::Error) {
   // Nothing.  A constant can never be "wrong".
 }
 void Constant::Print(std::ostream& os) const { os << this->value; }
+size_t Constant::Compile(Program& p) const {
+  return p.EmitConstant(this->value);
+}
 
 }}
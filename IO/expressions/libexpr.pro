@@ -9,6 +9,7 @@ INCLUDEPATH      += ../../ ../../Basics ../ ../3rdParty/boost
 unix:QMAKE_CXXFLAGS += -std=c++0x
 unix:QMAKE_CXXFLAGS += -fno-strict-aliasing
 unix:QMAKE_CFLAGS += -fno-strict-aliasing
+!macx:unix:QMAKE_CXXFLAGS += -fopenmp
 
 # On mac we completely disable warnings in this library. flex and bison are not playing nice with clang.
 macx:QMAKE_CXXFLAGS += -stdlib=libc++ -mmacosx-version-min=10.7 -w
@@ -25,5 +26,6 @@ SOURCES += \
   binary-expression.cpp \
   conditional-expression.cpp \
   constant.cpp          \
+  program.cpp           \
   treenode.cpp          \
   volume.cpp
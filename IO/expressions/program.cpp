@@ -0,0 +1,220 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "program.h"
+
+namespace tuvok { namespace expression {
+
+namespace {
+  // must match BinaryExpression's notion of equality.
+  inline double fp_equal(double a, double b) { return fabs(a-b) < 0.001; }
+}
+
+const size_t Program::Block;
+
+Program::Program(const Node& tree) : registers(0), volumes(0), result(0)
+{
+  this->result = tree.Compile(*this);
+}
+
+size_t Program::NewRegister()
+{
+  this->is_constant.push_back(false);
+  return this->registers++;
+}
+
+size_t Program::EmitLoad(size_t volume)
+{
+  this->volumes = std::max(this->volumes, volume+1);
+  const Instruction i = { LOAD, this->NewRegister(), volume, 0, 0 };
+  this->code.push_back(i);
+  return i.dst;
+}
+
+size_t Program::EmitConstant(double value)
+{
+  const size_t r = this->NewRegister();
+  this->is_constant[r] = true;
+  this->constants.push_back(std::make_pair(r, value));
+  return r;
+}
+
+size_t Program::EmitBinary(OpType op, size_t lhs, size_t rhs)
+{
+  Code c = ADD;
+  switch(op) {
+    case OP_PLUS:         c = ADD; break;
+    case OP_MINUS:        c = SUB; break;
+    case OP_DIVIDE:       c = DIV; break;
+    case OP_MULTIPLY:     c = MUL; break;
+    case OP_GREATER_THAN: c = GT; break;
+    case OP_LESS_THAN:    c = LT; break;
+    case OP_EQUAL_TO:     c = EQ; break;
+  }
+  // fold operations on constants right away.
+  if(this->is_constant[lhs] && this->is_constant[rhs]) {
+    double a = 0.0, b = 0.0;
+    for(size_t i=0; i < this->constants.size(); ++i) {
+      if(this->constants[i].first == lhs) { a = this->constants[i].second; }
+      if(this->constants[i].first == rhs) { b = this->constants[i].second; }
+    }
+    switch(c) {
+      case ADD: return this->EmitConstant(a + b);
+      case SUB: return this->EmitConstant(a - b);
+      case MUL: return this->EmitConstant(a * b);
+      case DIV: return this->EmitConstant(a / b);
+      case GT:  return this->EmitConstant(a > b);
+      case LT:  return this->EmitConstant(a < b);
+      case EQ:  return this->EmitConstant(fp_equal(a, b));
+      default: assert(1 == 0); break;
+    }
+  }
+  const Instruction i = { c, this->NewRegister(), lhs, rhs, 0 };
+  this->code.push_back(i);
+  return i.dst;
+}
+
+size_t Program::EmitSelect(size_t cond, size_t yes, size_t no)
+{
+  if(this->is_constant[cond]) {
+    for(size_t i=0; i < this->constants.size(); ++i) {
+      if(this->constants[i].first == cond) {
+        return this->constants[i].second != 0.0 ? yes : no;
+      }
+    }
+  }
+  const Instruction i = { SELECT, this->NewRegister(), cond, yes, no };
+  this->code.push_back(i);
+  return i.dst;
+}
+
+template<typename T>
+void Program::Run(const std::vector<const T*>& inputs, T* output,
+                  size_t n) const
+{
+  assert(inputs.size() >= this->volumes);
+  std::vector<double> regs(std::max<size_t>(this->registers, 1) * Block);
+  for(size_t i=0; i < this->constants.size(); ++i) {
+    std::fill(regs.begin() + this->constants[i].first * Block,
+              regs.begin() + (this->constants[i].first+1) * Block,
+              this->constants[i].second);
+  }
+  double* r = &regs[0];
+
+  for(size_t start=0; start < n; start += Block) {
+    const size_t len = std::min(Block, n - start);
+    for(size_t j=0; j < this->code.size(); ++j) {
+      const Instruction& in = this->code[j];
+      double* d = r + in.dst*Block;
+      const double* a = r + in.a*Block;
+      const double* b = r + in.b*Block;
+      const double* c = r + in.c*Block;
+      switch(in.code) {
+        case LOAD: {
+          const T* src = inputs[in.a] + start;
+          for(size_t i=0; i < len; ++i) { d[i] = static_cast<double>(src[i]); }
+          break;
+        }
+        case ADD: for(size_t i=0; i < len; ++i) { d[i] = a[i] + b[i]; } break;
+        case SUB: for(size_t i=0; i < len; ++i) { d[i] = a[i] - b[i]; } break;
+        case MUL: for(size_t i=0; i < len; ++i) { d[i] = a[i] * b[i]; } break;
+        case DIV: for(size_t i=0; i < len; ++i) { d[i] = a[i] / b[i]; } break;
+        case GT: for(size_t i=0; i < len; ++i) { d[i] = a[i] > b[i]; } break;
+        case LT: for(size_t i=0; i < len; ++i) { d[i] = a[i] < b[i]; } break;
+        case EQ:
+          for(size_t i=0; i < len; ++i) { d[i] = fp_equal(a[i], b[i]); }
+          break;
+        case SELECT:
+          for(size_t i=0; i < len; ++i) { d[i] = a[i] != 0.0 ? b[i] : c[i]; }
+          break;
+      }
+    }
+    // The cast is as (in)valid as the one in the tree-walking 'evaluate'.
+    const double* res = r + this->result*Block;
+    T* out = output + start;
+    for(size_t i=0; i < len; ++i) { out[i] = static_cast<T>(res[i]); }
+  }
+}
+
+template<typename T>
+void evaluate(const Program& p,
+              const std::vector<std::vector<std::vector<T>>>& bricks,
+              std::vector<std::vector<T>>& output)
+{
+  // Bricks are split into pieces of a few blocks, so that a batch of few
+  // (or differently sized) bricks still keeps all threads busy.
+  const size_t piece = Program::Block * 64;
+  std::vector<std::pair<size_t, size_t>> work; // (brick, first voxel)
+  output.resize(bricks.size());
+  for(size_t b=0; b < bricks.size(); ++b) {
+    assert(bricks[b].size() >= p.Volumes());
+    const size_t n = bricks[b].empty() ? 0 : bricks[b][0].size();
+    output[b].resize(n);
+    for(size_t i=0; i < bricks[b].size(); ++i) {
+      assert(bricks[b][i].size() == n);
+    }
+    for(size_t v=0; v < n; v += piece) { work.push_back(std::make_pair(b, v)); }
+  }
+
+  const int64_t pieces = static_cast<int64_t>(work.size());
+#pragma omp parallel for schedule(dynamic)
+  for(int64_t w=0; w < pieces; ++w) {
+    const size_t b = work[size_t(w)].first;
+    const size_t first = work[size_t(w)].second;
+    std::vector<const T*> inputs(bricks[b].size());
+    for(size_t i=0; i < inputs.size(); ++i) {
+      inputs[i] = &bricks[b][i][first];
+    }
+    p.Run(inputs, &output[b][first],
+          std::min(piece, output[b].size() - first));
+  }
+}
+
+#define INSTANTIATE(T) \
+  template void Program::Run<T>(const std::vector<const T*>&, T*, \
+                                size_t) const; \
+  template void evaluate<T>(const Program&, \
+                            const std::vector<std::vector<std::vector<T>>>&, \
+                            std::vector<std::vector<T>>&);
+INSTANTIATE(int8_t)
+INSTANTIATE(uint8_t)
+INSTANTIATE(int16_t)
+INSTANTIATE(uint16_t)
+INSTANTIATE(int32_t)
+INSTANTIATE(uint32_t)
+INSTANTIATE(int64_t)
+INSTANTIATE(uint64_t)
+INSTANTIATE(float)
+INSTANTIATE(double)
+#undef INSTANTIATE
+
+}}
@@ -0,0 +1,102 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+/// \brief An expression AST lowered to a flat program over blocks of voxels.
+#ifndef TUVOK_EXPRESSION_PROGRAM_H
+#define TUVOK_EXPRESSION_PROGRAM_H
+
+#include <cstddef>
+#include <vector>
+
+#include "treenode.h"
+
+namespace tuvok { namespace expression {
+
+/// A register program equivalent to an expression tree.  Every instruction
+/// processes a block of voxels at once, in doubles (as Node::Evaluate does),
+/// so the per voxel work is a few tight loops instead of a virtual call per
+/// node; only loading the inputs and storing the result know the data type.
+/// A Program is immutable once built, so one program can be Run from any
+/// number of threads at the same time.
+class Program {
+  public:
+    /// number of voxels each instruction processes at once
+    static const size_t Block = 1024;
+
+    /// lowers 'tree', which must have passed semantic analysis.
+    explicit Program(const Node& tree);
+
+    /// @returns one more than the largest volume index used, i.e. how many
+    /// inputs Run needs.
+    size_t Volumes() const { return volumes; }
+
+    /// Evaluates the expression for 'n' voxels.  inputs[i] points to the
+    /// voxels of 'v[i]'.
+    template<typename T>
+    void Run(const std::vector<const T*>& inputs, T* output, size_t n) const;
+
+    /// Building blocks for Node::Compile.  Each returns the register which
+    /// will hold the result.
+    ///@{
+    size_t EmitLoad(size_t volume);
+    size_t EmitConstant(double value);
+    size_t EmitBinary(OpType op, size_t lhs, size_t rhs);
+    /// cond != 0 ? yes : no.  Both sides are evaluated, which is fine since
+    /// expressions have no side effects.
+    size_t EmitSelect(size_t cond, size_t yes, size_t no);
+    ///@}
+
+  private:
+    enum Code { LOAD, ADD, SUB, MUL, DIV, GT, LT, EQ, SELECT };
+    struct Instruction {
+      Code code;
+      size_t dst, a, b, c;
+    };
+
+    size_t NewRegister();
+
+    std::vector<Instruction> code;
+    /// registers holding constants, with their values.  They are filled once
+    /// per Run instead of by an instruction.
+    std::vector<std::pair<size_t, double>> constants;
+    std::vector<bool> is_constant; ///< per register
+    size_t registers;
+    size_t volumes;
+    size_t result;
+};
+
+/// Evaluates 'p' for a batch of independent bricks, in parallel.
+/// bricks[b][i] is the data of 'v[i]' in brick b; output[b] is resized to
+/// hold the result for brick b.
+template<typename T>
+void evaluate(const Program& p,
+              const std::vector<std::vector<std::vector<T>>>& bricks,
+              std::vector<std::vector<T>>& output);
+
+}}
+
+#endif // TUVOK_EXPRESSION_PROGRAM_H
@@ -40,6 +40,8 @@
 
 namespace tuvok { namespace expression {
 
+class Program;
+
 class Node {
   public:
     virtual ~Node();
@@ -64,6 +66,10 @@ class Node {
 
     virtual double Evaluate(size_t idx) const=0;
 
+    /// Appends the instructions computing this node to the program.
+    /// @returns the register holding the node's value.
+    virtual size_t Compile(Program&) const=0;
+
   protected:
     const std::shared_ptr<Node> GetChild(size_t index) const;
 
@@ -73,7 +79,8 @@ class Node {
 
 namespace { template<typename T> void NullDeleter(T*) {} }
 
-/// Evaluates the expression.
+/// Evaluates the expression, one voxel at a time.  See Program for a
+/// faster way.
 /// @param tree: the AST for the expression
 /// @param volumes: input volumes
 /// @param output: the output volume.
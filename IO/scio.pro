@@ -149,6 +149,7 @@ SOURCES += \
   ./BOVConverter.cpp \
   ./BrickedDataset.cpp \
   ./Dataset.cpp \
+  ./DecompressingRAWFile.cpp \
   ./DICOM/DICOMParser.cpp \
   ./DirectoryParser.cpp \
   ./DSFactory.cpp \
@@ -172,10 +173,13 @@ SOURCES += \
   ./PLYGeoConverter.cpp \
   ./StLGeoConverter.cpp \
   ./XML3DGeoConverter.cpp \
+  ./QuantizeSIMD.cpp \
   ./QVISConverter.cpp \
   ./RAWConverter.cpp \
   ./REKConverter.cpp \
+  ./SlicePipeline.cpp \
   ./StkConverter.cpp \
+  ./TextSpan.cpp \
   ./MRCConverter.cpp \
   ./TiffVolumeConverter.cpp \
   ./TransferFunction1D.cpp \
@@ -241,6 +245,7 @@ HEADERS += \
   ./BrickedDataset.h \
   ./Brick.h \
   ./Dataset.h \
+  ./DecompressingRAWFile.h \
   ./DICOM/DICOMParser.h \
   ./DirectoryParser.h \
   ./DSFactory.h \
@@ -269,10 +274,13 @@ HEADERS += \
   ./StLGeoConverter.h \
   ./XML3DGeoConverter.h \
   ./Quantize.h \
+  ./QuantizeSIMD.h \
   ./QVISConverter.h \
   ./RAWConverter.h \
   ./REKConverter.h \
+  ./SlicePipeline.h \
   ./StkConverter.h \
+  ./TextSpan.h \
   ./MRCConverter.h \
   ./test/dicom.h \
   ./test/jpeg.h \
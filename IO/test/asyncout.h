@@ -0,0 +1,136 @@
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "DebugOut/AsyncOut.h"
+#include "DebugOut/TextfileOut.h"
+#include "Basics/Timer.h"
+#include "util-test.h"
+
+namespace {
+  // remembers what it is given.  'gate' lets a test stall the writer.
+  struct Recorder : public AbstrDebugOut {
+    Recorder() : gate(true) {
+      SetOutput(true, true, true, true);
+    }
+    virtual void printf(enum DebugChannel channel, const char* source,
+                        const char* msg) {
+      while(!gate.load()) { }
+      channels.push_back(channel);
+      lines.push_back(std::string(source) + ": " + msg);
+    }
+    virtual void printf(const char *s) const {
+      raw.push_back(s);
+    }
+    std::atomic<bool> gate;
+    std::vector<DebugChannel> channels;
+    std::vector<std::string> lines;
+    mutable std::vector<std::string> raw;
+  };
+
+  // messages from several threads all arrive, each thread's in order.
+  void tconcurrent() {
+    const int iThreads = 4, iMessages = 2000;
+    Recorder* rec = new Recorder();
+    AsyncOut out(rec, iThreads*iMessages);
+#pragma omp parallel for num_threads(4)
+    for(int t=0; t < iThreads; ++t) {
+      for(int i=0; i < iMessages; ++i) {
+        out.Message("src", "%d %d", t, i);
+      }
+    }
+    out.Flush();
+    TS_ASSERT_EQUALS(out.Dropped(), 0U);
+    TS_ASSERT_EQUALS(rec->lines.size(), size_t(iThreads*iMessages));
+    std::vector<int> next(iThreads, 0);
+    for(size_t l=0; l < rec->lines.size(); ++l) {
+      int t, i;
+      TS_ASSERT_EQUALS(sscanf(rec->lines[l].c_str(), "src: %d %d", &t, &i),
+                       2);
+      TS_ASSERT(t >= 0 && t < iThreads);
+      TS_ASSERT_EQUALS(i, next[t]);
+      next[t] = i+1;
+      TS_ASSERT_EQUALS(rec->channels[l], AbstrDebugOut::CHANNEL_MESSAGE);
+    }
+  }
+
+  // messages longer than a slot are not cut off.
+  void tlong() {
+    Recorder* rec = new Recorder();
+    AsyncOut out(rec);
+    const std::string big(5000, 'x');
+    out.Warning("src", "%s!", big.c_str());
+    out.printf(big.c_str());
+    out.Flush();
+    TS_ASSERT_EQUALS(rec->lines.size(), 1U);
+    TS_ASSERT_EQUALS(rec->lines[0], "src: " + big + "!");
+    TS_ASSERT_EQUALS(rec->channels[0], AbstrDebugOut::CHANNEL_WARNING);
+    TS_ASSERT_EQUALS(rec->raw.size(), 1U);
+    TS_ASSERT_EQUALS(rec->raw[0], big);
+  }
+
+  // nothing is queued for a channel which is off.
+  void tchannels() {
+    Recorder* rec = new Recorder();
+    AsyncOut out(rec);
+    out.SetShowMessages(false);
+    TS_ASSERT(!rec->ShowMessages());
+    out.Message("src", "hidden");
+    out.Error("src", "shown");
+    out.Flush();
+    TS_ASSERT_EQUALS(rec->lines.size(), 1U);
+    TS_ASSERT_EQUALS(rec->lines[0], "src: shown");
+  }
+
+  // a full buffer drops messages instead of blocking, and says so later.
+  void tdrop() {
+    Recorder* rec = new Recorder();
+    rec->gate = false;
+    AsyncOut out(rec, 4);
+    const size_t iMessages = 100;
+    for(size_t i=0; i < iMessages; ++i) { out.Message("src", "%u", unsigned(i)); }
+    TS_ASSERT(out.Dropped() > 0);
+    rec->gate = true;
+    out.Flush();
+    TS_ASSERT_EQUALS(rec->lines.size() - 1 + out.Dropped(), iMessages);
+    TS_ASSERT(rec->lines.back().find("dropped") != std::string::npos);
+    TS_ASSERT_EQUALS(rec->channels.back(), AbstrDebugOut::CHANNEL_WARNING);
+  }
+
+  // how long the logging thread is busy, writing directly and via AsyncOut.
+  void tbench() {
+    const size_t iMessages = 20000;
+    std::ofstream ofs;
+    const std::string fn = mk_tmpfile(ofs, std::ios::out);
+    ofs.close();
+    double fTime[2];
+    for(size_t a=0; a < 2; ++a) {
+      TextfileOut* file = new TextfileOut(fn);
+      file->SetShowMessages(true);
+      AbstrDebugOut* out = file;
+      if(a) { out = new AsyncOut(file, iMessages); }
+      Timer t;
+      t.Start();
+      for(size_t i=0; i < iMessages; ++i) {
+        out->Message("bench", "brick <%u,%u,%u> found in the cache",
+                     unsigned(i), unsigned(i/7), unsigned(i/11));
+      }
+      fTime[a] = t.Elapsed();
+      delete out;
+    }
+    remove(fn.c_str());
+    fprintf(stderr, "\n%u messages: %.1f ms direct, %.1f ms async\n",
+            unsigned(iMessages), fTime[0], fTime[1]);
+  }
+}
+
+class AsyncOutTests : public CxxTest::TestSuite {
+public:
+  void test_concurrent() { tconcurrent(); }
+  void test_long() { tlong(); }
+  void test_channels() { tchannels(); }
+  void test_drop() { tdrop(); }
+  void test_bench() { tbench(); }
+};
@@ -90,6 +90,49 @@ void sizes() {
   TS_ASSERT_EQUALS(c.size(), 0U);
 }
 
+// the least recently *used* brick goes first, not the oldest one added.
+void lru_order() {
+  BrickCache c;
+  for(size_t i=0; i < 3; ++i) {
+    std::vector<uint8_t> data(1, uint8_t(i));
+    c.add(BrickKey(0,0,i), data);
+  }
+  TS_ASSERT(c.lookup(BrickKey(0,0,0), uint8_t(0)) != NULL);
+  c.remove(); // should evict brick 1.
+  TS_ASSERT(c.lookup(BrickKey(0,0,1), uint8_t(0)) == NULL);
+  TS_ASSERT(c.lookup(BrickKey(0,0,0), uint8_t(0)) != NULL);
+  TS_ASSERT(c.lookup(BrickKey(0,0,2), uint8_t(0)) != NULL);
+  c.remove(); // now brick 0 is the oldest.
+  TS_ASSERT(c.lookup(BrickKey(0,0,0), uint8_t(0)) == NULL);
+  TS_ASSERT(c.lookup(BrickKey(0,0,2), uint8_t(0)) != NULL);
+  TS_ASSERT_EQUALS(c.size(), 1U);
+}
+
+void reserve() {
+  BrickCache c;
+  c.capacity(12);
+  for(size_t i=0; i < 3; ++i) {
+    std::vector<uint16_t> data(2, uint16_t(i));
+    c.reserve(data.size()*sizeof(uint16_t));
+    c.add(BrickKey(0,0,i), data);
+  }
+  TS_ASSERT_EQUALS(c.size(), 3U*2U*sizeof(uint16_t));
+  c.reserve(4); // all 12 bytes used; need to drop one brick to fit 4 more.
+  TS_ASSERT_EQUALS(c.size(), 8U);
+  TS_ASSERT(c.lookup(BrickKey(0,0,0), uint16_t(0)) == NULL);
+  TS_ASSERT(c.lookup(BrickKey(0,0,2), uint16_t(0)) != NULL);
+  // larger than the whole budget: everything goes, but it still fits.
+  c.reserve(42);
+  TS_ASSERT_EQUALS(c.size(), 0U);
+  {
+    std::vector<uint8_t> big(42);
+    c.add(BrickKey(0,0,3), big);
+  }
+  TS_ASSERT_EQUALS(c.size(), 42U);
+  c.capacity(8); // shrinking evicts.
+  TS_ASSERT_EQUALS(c.size(), 0U);
+}
+
 namespace {
   template<typename T>
   void normal(std::vector<T>& data, const T& mean, const T& stddev) {
@@ -138,5 +181,7 @@ public:
   void test_sizes() { sizes(); }
   void test_lookup_bug() { lookup_bug(); }
   void test_lookup_bug16() { lookup_bug16(); }
+  void test_lru_order() { lru_order(); }
+  void test_reserve() { reserve(); }
 //  void test_add_many() { add_many(); }
 };
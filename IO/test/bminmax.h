@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "BMinMax.h"
+
+using namespace tuvok;
+
+namespace {
+  // the straightforward version: one voxel at a time, all in double.
+  template<typename T>
+  MinMaxBlock reference(const std::vector<T>& v, const UINT64VECTOR3& n) {
+    const double fNorm = std::numeric_limits<T>::is_integer ?
+                         double(std::numeric_limits<T>::max()) : 1.0;
+    MinMaxBlock mm(std::numeric_limits<double>::max(),
+                   -std::numeric_limits<double>::max(),
+                   std::numeric_limits<double>::max(), 0.0);
+    const uint64_t stride[3] = { 1, n.x, n.x*n.y };
+    for(uint64_t z=0; z < n.z; ++z) {
+      for(uint64_t y=0; y < n.y; ++y) {
+        for(uint64_t x=0; x < n.x; ++x) {
+          const uint64_t p[3] = { x, y, z };
+          const uint64_t i = x + n.x*(y + n.y*z);
+          mm.minScalar = std::min(mm.minScalar, double(v[i]));
+          mm.maxScalar = std::max(mm.maxScalar, double(v[i]));
+          double g = 0.0;
+          for(size_t a=0; a < 3; ++a) {
+            const uint64_t lo = p[a] > 0 ? i - stride[a] : i;
+            const uint64_t hi = p[a]+1 < n[a] ? i + stride[a] : i;
+            const double d = (double(v[hi]) - double(v[lo])) / fNorm /
+                             (lo != i && hi != i ? 2.0 : 1.0);
+            g += d*d;
+          }
+          mm.minGradient = std::min(mm.minGradient, std::sqrt(g));
+          mm.maxGradient = std::max(mm.maxGradient, std::sqrt(g));
+        }
+      }
+    }
+    return mm;
+  }
+
+  template<typename T> void tcompare(std::mt19937& gen, double fLo,
+                                     double fHi) {
+    const UINT64VECTOR3 sizes[] = {
+      UINT64VECTOR3(1,1,1), UINT64VECTOR3(7,1,1), UINT64VECTOR3(1,5,3),
+      UINT64VECTOR3(2,2,2), UINT64VECTOR3(13,9,6), UINT64VECTOR3(33,17,5),
+    };
+    std::uniform_real_distribution<double> dist(fLo, fHi);
+    MinMaxScratch scratch;
+    for(size_t s=0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+      const UINT64VECTOR3& n = sizes[s];
+      std::vector<T> v(size_t(n.volume()));
+      for(size_t i=0; i < v.size(); ++i) { v[i] = T(dist(gen)); }
+      const MinMaxBlock r = reference(v, n);
+      const MinMaxBlock m = minmax_voxels(v.data(), n, scratch);
+      TS_ASSERT_EQUALS(m.minScalar, r.minScalar);
+      TS_ASSERT_EQUALS(m.maxScalar, r.maxScalar);
+      TS_ASSERT_DELTA(m.minGradient, r.minGradient, 1e-5 * r.maxGradient);
+      TS_ASSERT_DELTA(m.maxGradient, r.maxGradient, 1e-5 * r.maxGradient);
+    }
+  }
+
+  // a ramp has the same gradient everywhere, faces included.
+  void tramp() {
+    const UINT64VECTOR3 n(10, 4, 3);
+    std::vector<uint16_t> v(size_t(n.volume()));
+    for(size_t i=0; i < v.size(); ++i) { v[i] = uint16_t(100 * (i % n.x)); }
+    MinMaxScratch scratch;
+    const MinMaxBlock m = minmax_voxels(v.data(), n, scratch);
+    TS_ASSERT_EQUALS(m.minScalar, 0.0);
+    TS_ASSERT_EQUALS(m.maxScalar, 900.0);
+    TS_ASSERT_DELTA(m.minGradient, 100.0 / 65535.0, 1e-9);
+    TS_ASSERT_DELTA(m.maxGradient, 100.0 / 65535.0, 1e-9);
+  }
+}
+
+class BMinMaxTests : public CxxTest::TestSuite {
+public:
+  void test_reference() {
+    std::mt19937 gen(19);
+    tcompare<uint8_t>(gen, 0, 255);
+    tcompare<int8_t>(gen, -128, 127);
+    tcompare<uint16_t>(gen, 0, 65535);
+    tcompare<int16_t>(gen, -32768, 32767);
+    tcompare<uint32_t>(gen, 0, 4e9);
+    tcompare<int32_t>(gen, -2e9, 2e9);
+    tcompare<float>(gen, -1e3, 1e3);
+    tcompare<double>(gen, -1e6, 1e6);
+  }
+  void test_ramp() { tramp(); }
+};
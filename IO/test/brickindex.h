@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "SpatialBrickIndex.h"
+
+using namespace tuvok;
+
+namespace {
+  // a grid of bricks of width 1, but for the last one along each axis,
+  // which is only half as wide.
+  void grid(BrickTable& table, size_t ts, size_t lod, const UINTVECTOR3& n) {
+    size_t i = 0;
+    for(unsigned z=0; z < n.z; ++z) {
+      for(unsigned y=0; y < n.y; ++y) {
+        for(unsigned x=0; x < n.x; ++x, ++i) {
+          const UINTVECTOR3 p(x, y, z);
+          BrickMD md;
+          for(size_t a=0; a < 3; ++a) {
+            md.extents[a] = p[a]+1 == n[a] ? 0.5f : 1.0f;
+            md.center[a] = float(p[a]) + md.extents[a] * 0.5f;
+          }
+          md.n_voxels = UINTVECTOR3(16, 16, 16);
+          table.insert(std::make_pair(BrickKey(ts, lod, i), md));
+        }
+      }
+    }
+  }
+
+  std::vector<BrickTable::const_iterator> select(const BrickTable& table,
+                                                 size_t ts, size_t lod) {
+    std::vector<BrickTable::const_iterator> v;
+    for(auto b=table.cbegin(); b != table.cend(); ++b) {
+      if(std::get<0>(b->first) == ts && std::get<1>(b->first) == lod) {
+        v.push_back(b);
+      }
+    }
+    return v;
+  }
+
+  bool overlaps(const FLOATVECTOR3& c0, const FLOATVECTOR3& e0,
+                const FLOATVECTOR3& c1, const FLOATVECTOR3& e1) {
+    for(size_t a=0; a < 3; ++a) {
+      if(std::fabs(c0[a] - c1[a]) * 2.0f >= e0[a] + e1[a]) { return false; }
+    }
+    return true;
+  }
+
+  struct Any {
+    bool operator()(const FLOATVECTOR3&, const FLOATVECTOR3&) const {
+      return true;
+    }
+  };
+
+  std::vector<size_t> order(const SpatialBrickIndex& idx,
+                            const FLOATVECTOR3& eye) {
+    std::vector<size_t> v;
+    idx.FrontToBack(eye, Any(), [&](BrickTable::const_iterator b) {
+      v.push_back(std::get<2>(b->first));
+    });
+    return v;
+  }
+
+  void tdense() {
+    BrickTable table;
+    grid(table, 0, 0, UINTVECTOR3(5, 3, 4));
+    grid(table, 0, 1, UINTVECTOR3(3, 2, 2));
+    grid(table, 1, 0, UINTVECTOR3(5, 3, 4));
+    SpatialBrickIndex idx(select(table, 0, 0));
+    TS_ASSERT_EQUALS(idx.size(), 60U);
+    for(size_t i=0; i < idx.size(); ++i) {
+      TS_ASSERT_EQUALS(std::get<0>(idx[i]->first), 0U);
+      TS_ASSERT_EQUALS(std::get<1>(idx[i]->first), 0U);
+      TS_ASSERT_EQUALS(std::get<2>(idx[i]->first), i);
+    }
+    TS_ASSERT(SpatialBrickIndex(select(table, 2, 0)).empty());
+    order(SpatialBrickIndex(select(table, 2, 0)), FLOATVECTOR3(0,0,0));
+  }
+
+  // of two neighbours, the one on the eye's side of their common face must
+  // come first, wherever the eye is.
+  void tfront_to_back() {
+    const UINTVECTOR3 n(7, 4, 5);
+    BrickTable table;
+    grid(table, 0, 0, n);
+    SpatialBrickIndex idx(select(table, 0, 0));
+    const FLOATVECTOR3 eyes[] = {
+      FLOATVECTOR3(-3, -2, -9), FLOATVECTOR3(20, 1.5f, 2.2f),
+      FLOATVECTOR3(3.3f, 2.7f, 1.1f), FLOATVECTOR3(6.2f, -1, 30),
+      FLOATVECTOR3(0.5f, 3.9f, 4.4f),
+    };
+    for(size_t e=0; e < sizeof(eyes)/sizeof(eyes[0]); ++e) {
+      const std::vector<size_t> v = order(idx, eyes[e]);
+      TS_ASSERT_EQUALS(v.size(), size_t(n.volume()));
+      std::vector<size_t> pos(v.size(), v.size());
+      for(size_t i=0; i < v.size(); ++i) { pos[v[i]] = i; }
+      TS_ASSERT(std::find(pos.begin(), pos.end(), v.size()) == pos.end());
+      const size_t stride[3] = { 1, n.x, n.x*n.y };
+      for(size_t b=0; b < v.size(); ++b) {
+        const UINTVECTOR3 p(unsigned(b % n.x), unsigned((b / n.x) % n.y),
+                            unsigned(b / (n.x*n.y)));
+        for(size_t a=0; a < 3; ++a) {
+          if(p[a]+1 == n[a]) { continue; }
+          const size_t next = b + stride[a];
+          if(eyes[e][a] < float(p[a]+1)) {
+            TS_ASSERT(pos[b] < pos[next]);
+          } else {
+            TS_ASSERT(pos[next] < pos[b]);
+          }
+        }
+      }
+    }
+  }
+
+  // only groups overlapping the query are descended into.
+  void tcull() {
+    const UINTVECTOR3 n(16, 16, 16);
+    BrickTable table;
+    grid(table, 0, 0, n);
+    SpatialBrickIndex idx(select(table, 0, 0));
+    const FLOATVECTOR3 qc(4.2f, 11.0f, 7.7f), qe(3.0f, 2.0f, 5.0f);
+    size_t iTests = 0;
+    std::vector<size_t> found;
+    idx.FrontToBack(FLOATVECTOR3(0,0,0),
+      [&](const FLOATVECTOR3& c, const FLOATVECTOR3& e) {
+        ++iTests;
+        return overlaps(c, e, qc, qe);
+      },
+      [&](BrickTable::const_iterator b) {
+        if(overlaps(b->second.center, b->second.extents, qc, qe)) {
+          found.push_back(std::get<2>(b->first));
+        }
+      });
+    std::vector<size_t> expected;
+    for(size_t i=0; i < idx.size(); ++i) {
+      if(overlaps(idx[i]->second.center, idx[i]->second.extents, qc, qe)) {
+        expected.push_back(i);
+      }
+    }
+    std::sort(found.begin(), found.end());
+    TS_ASSERT(found == expected);
+    TS_ASSERT(!found.empty());
+    TS_ASSERT(iTests < idx.size() / 4);
+  }
+
+  // building the list of bricks of one timestep + LOD which overlap a
+  // query box, in depth order: the old filter + sort over the whole table
+  // versus the index.
+  void tbench() {
+    const size_t iTimesteps = 16, iLODs = 4;
+    for(unsigned n=8; n <= 32; n *= 2) {
+      BrickTable table;
+      for(size_t t=0; t < iTimesteps; ++t) {
+        for(size_t l=0; l < iLODs; ++l) {
+          const unsigned w = std::max(1U, n >> l);
+          grid(table, t, l, UINTVECTOR3(w, w, w));
+        }
+      }
+      const FLOATVECTOR3 qc(n*0.3f, n*0.5f, n*0.5f), qe(n*0.5f, n*0.5f, n);
+      const FLOATVECTOR3 eye(-1.0f, n*0.4f, n*0.6f);
+      const size_t iRuns = 20;
+
+      clock_t start = clock();
+      size_t iOld = 0;
+      for(size_t r=0; r < iRuns; ++r) {
+        std::vector<std::pair<float, size_t>> list;
+        for(auto b=table.cbegin(); b != table.cend(); ++b) {
+          if(std::get<0>(b->first) != 3 || std::get<1>(b->first) != 0) {
+            continue;
+          }
+          if(overlaps(b->second.center, b->second.extents, qc, qe)) {
+            list.push_back(std::make_pair((b->second.center - eye).length(),
+                                          std::get<2>(b->first)));
+          }
+        }
+        std::sort(list.begin(), list.end());
+        iOld = list.size();
+      }
+      const double fOld = double(clock() - start) / CLOCKS_PER_SEC / iRuns;
+
+      start = clock();
+      SpatialBrickIndex idx(select(table, 3, 0));
+      // the hierarchy is built by the first query.
+      idx.FrontToBack(eye,
+        [](const FLOATVECTOR3&, const FLOATVECTOR3&) { return false; },
+        [](BrickTable::const_iterator) {});
+      const double fBuild = double(clock() - start) / CLOCKS_PER_SEC;
+      start = clock();
+      size_t iNew = 0;
+      for(size_t r=0; r < iRuns; ++r) {
+        std::vector<size_t> list;
+        idx.FrontToBack(eye,
+          [&](const FLOATVECTOR3& c, const FLOATVECTOR3& e) {
+            return overlaps(c, e, qc, qe);
+          },
+          [&](BrickTable::const_iterator b) {
+            if(overlaps(b->second.center, b->second.extents, qc, qe)) {
+              list.push_back(std::get<2>(b->first));
+            }
+          });
+        iNew = list.size();
+      }
+      const double fNew = double(clock() - start) / CLOCKS_PER_SEC / iRuns;
+      TS_ASSERT_EQUALS(iOld, iNew);
+      fprintf(stderr, "\n%6u bricks (%7u in table): scan+sort %.3f ms, "
+              "index %.3f ms (built in %.3f ms)", n*n*n,
+              unsigned(table.size()), fOld*1e3, fNew*1e3, fBuild*1e3);
+    }
+    fprintf(stderr, "\n");
+  }
+}
+
+class SpatialBrickIndexTests : public CxxTest::TestSuite {
+public:
+  void test_dense() { tdense(); }
+  void test_front_to_back() { tfront_to_back(); }
+  void test_cull() { tcull(); }
+  void test_bench() { tbench(); }
+};
@@ -0,0 +1,290 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "3rdParty/bzip2/bzlib.h"
+#include "3rdParty/zlib/zlib.h"
+#include "DecompressingRAWFile.h"
+#include "RAWConverter.h"
+#include "util-test.h"
+
+namespace {
+  const std::string header = "NRRD0004\ntype: uint8\nencoding: gzip\n\n";
+
+  // compressible, but not trivially so.
+  std::vector<char> data(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<char> v(n);
+    for(size_t i=0; i < n; ++i) {
+      v[i] = char((i / 1000) % 7 + gen() % 5);
+    }
+    return v;
+  }
+
+  std::vector<char> deflated(const char* p, size_t n, int iWindowBits) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, iWindowBits, 8,
+                 Z_DEFAULT_STRATEGY);
+    std::vector<char> out(deflateBound(&z, uLong(n)) + 64);
+    z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(p));
+    z.avail_in = uInt(n);
+    z.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    z.avail_out = uInt(out.size());
+    TS_ASSERT_EQUALS(deflate(&z, Z_FINISH), Z_STREAM_END);
+    out.resize(z.total_out);
+    deflateEnd(&z);
+    return out;
+  }
+
+  std::vector<char> gzip(const std::vector<char>& d) {
+    return deflated(&d[0], d.size(), 16 + MAX_WBITS);
+  }
+
+  void put(std::vector<char>& out, uint32_t v, size_t iBytes) {
+    for(size_t i=0; i < iBytes; ++i) { out.push_back(char(v >> (8*i))); }
+  }
+
+  // 'd' in blocks of 'iBlock' bytes, as bgzip writes it.
+  std::vector<char> bgzf(const std::vector<char>& d, size_t iBlock) {
+    std::vector<char> out;
+    for(size_t i=0; i <= d.size(); i += iBlock) {
+      // the last block is the empty end-of-file marker.
+      const size_t n = std::min(iBlock, d.size() - i);
+      const std::vector<char> def = deflated(n ? &d[i] : "", n, -MAX_WBITS);
+      const char fixed[] = { '\x1f', '\x8b', 8, 4, 0, 0, 0, 0, 0, '\xff',
+                             6, 0, 'B', 'C', 2, 0 };
+      out.insert(out.end(), fixed, fixed + sizeof(fixed));
+      put(out, uint32_t(18 + def.size() + 8 - 1), 2);
+      out.insert(out.end(), def.begin(), def.end());
+      put(out, uint32_t(crc32(crc32(0, Z_NULL, 0),
+                              reinterpret_cast<const Bytef*>(n ? &d[i] : ""),
+                              uInt(n))), 4);
+      put(out, uint32_t(n), 4);
+    }
+    return out;
+  }
+
+  std::vector<char> bzip2(const std::vector<char>& d) {
+    std::vector<char> out(d.size() + d.size()/100 + 600);
+    unsigned iSize = unsigned(out.size());
+    TS_ASSERT_EQUALS(BZ2_bzBuffToBuffCompress(&out[0], &iSize,
+                                              const_cast<char*>(&d[0]),
+                                              unsigned(d.size()), 9, 0, 0),
+                     BZ_OK);
+    out.resize(iSize);
+    return out;
+  }
+
+  // writes 'header' and the given data to a new file.
+  std::string write(const std::vector<char>& d) {
+    std::ofstream ofs;
+    const std::string fn = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    ofs.write(header.c_str(), header.size());
+    ofs.write(&d[0], d.size());
+    return fn;
+  }
+
+  std::vector<char> read_all(LargeRAWFile& f, size_t iChunk) {
+    std::vector<char> v;
+    std::vector<char> chunk(iChunk);
+    size_t n;
+    while((n = f.ReadRAW(reinterpret_cast<unsigned char*>(&chunk[0]),
+                         chunk.size())) > 0) {
+      v.insert(v.end(), chunk.begin(), chunk.begin() + n);
+    }
+    return v;
+  }
+
+  // reads all, then bits here and there: ahead, back, and past the end.
+  void check(const std::string& fn, RAWEncoding e,
+             const std::vector<char>& expected, bool bBGZF) {
+    DecompressingRAWFile f(fn, header.size(), e, expected.size());
+    TS_ASSERT(f.Open(false));
+    TS_ASSERT_EQUALS(f.IsBGZF(), bBGZF);
+    TS_ASSERT_EQUALS(f.GetCurrentSize(), expected.size());
+    TS_ASSERT(read_all(f, 12345) == expected);
+
+    std::vector<char> v(1000);
+    unsigned char* p = reinterpret_cast<unsigned char*>(&v[0]);
+    const size_t at[] = { 17, 5000000, 123, 4*1024*1024 - 10,
+                          expected.size() - 500 };
+    for(size_t i=0; i < sizeof(at)/sizeof(at[0]); ++i) {
+      const size_t n = std::min<size_t>(v.size(), expected.size() - at[i]);
+      TS_ASSERT_EQUALS(f.ReadRAWAt(p, v.size(), at[i]), n);
+      TS_ASSERT(std::equal(v.begin(), v.begin() + n,
+                           expected.begin() + at[i]));
+    }
+    f.SeekPos(expected.size());
+    TS_ASSERT_EQUALS(f.ReadRAW(p, v.size()), 0U);
+    f.SeekStart();
+    TS_ASSERT_EQUALS(f.ReadRAW(p, v.size()), v.size());
+    TS_ASSERT(std::equal(v.begin(), v.end(), expected.begin()));
+    f.Close();
+  }
+
+  void tgzip() {
+    const std::vector<char> d = data(11*1024*1024 + 17, 1);
+    const std::string fn = write(gzip(d));
+    clean tmp = cleanup(fn);
+    check(fn, RE_GZIP, d, false);
+  }
+
+  // members follow each other; whatever follows them is ignored.
+  void tmembers() {
+    const std::vector<char> a = data(6*1024*1024, 2), b = data(1, 3),
+                            c = data(5*1024*1024 + 3, 4);
+    std::vector<char> z = gzip(a), all = a;
+    const std::vector<char> zb = gzip(b), zc = gzip(c);
+    z.insert(z.end(), zb.begin(), zb.end());
+    z.insert(z.end(), zc.begin(), zc.end());
+    z.insert(z.end(), 100, '\0');
+    all.insert(all.end(), b.begin(), b.end());
+    all.insert(all.end(), c.begin(), c.end());
+    const std::string fn = write(z);
+    clean tmp = cleanup(fn);
+    check(fn, RE_GZIP, all, false);
+  }
+
+  // BGZF blocks are inflated in parallel; plain members may follow them.
+  void tbgzf() {
+    const std::vector<char> d = data(9*1024*1024 + 5, 5);
+    const std::string fn = write(bgzf(d, 65280));
+    clean tmp = cleanup(fn);
+    check(fn, RE_GZIP, d, true);
+
+    const std::vector<char> e = data(3*1024*1024, 6);
+    std::vector<char> mixed = bgzf(d, 65280), all = d;
+    const std::vector<char> ze = gzip(e);
+    mixed.insert(mixed.end(), ze.begin(), ze.end());
+    all.insert(all.end(), e.begin(), e.end());
+    const std::string fnmixed = write(mixed);
+    clean tmpmixed = cleanup(fnmixed);
+    check(fnmixed, RE_GZIP, all, true);
+  }
+
+  void tbzip2() {
+    const std::vector<char> a = data(5*1024*1024 + 1, 7),
+                            b = data(1024*1024, 8);
+    std::vector<char> z = bzip2(a), all = a;
+    const std::vector<char> zb = bzip2(b);
+    z.insert(z.end(), zb.begin(), zb.end());
+    all.insert(all.end(), b.begin(), b.end());
+    const std::string fn = write(z);
+    clean tmp = cleanup(fn);
+    check(fn, RE_BZIP2, all, false);
+  }
+
+  // damaged data end the stream early, rather than giving garbage.
+  void tcorrupt() {
+    const std::vector<char> d = data(6*1024*1024, 9);
+    std::vector<char> z = gzip(d);
+    std::vector<char> b = bgzf(d, 65280);
+    for(size_t i=z.size()/2; i < z.size()/2 + 64; ++i) { z[i] ^= 0x5a; }
+    for(size_t i=b.size()/2; i < b.size()/2 + 64; ++i) { b[i] ^= 0x5a; }
+    const std::string fnz = write(z), fnb = write(b);
+    clean tmp = cleanup(fnz).add(fnb);
+
+    DecompressingRAWFile fz(fnz, header.size(), RE_GZIP, d.size());
+    TS_ASSERT(fz.Open(false));
+    const std::vector<char> vz = read_all(fz, 1 << 20);
+    TS_ASSERT(vz.size() < d.size());
+    TS_ASSERT(std::equal(vz.begin(), vz.begin() + std::min<size_t>(
+                           vz.size(), 1024*1024), d.begin()));
+
+    DecompressingRAWFile fb(fnb, header.size(), RE_GZIP, d.size());
+    TS_ASSERT(fb.Open(false));
+    const std::vector<char> vb = read_all(fb, 1 << 20);
+    TS_ASSERT(vb.size() < d.size());
+    TS_ASSERT(std::equal(vb.begin(), vb.end(), d.begin()));
+  }
+
+  // nor do they convert to a data set, however the converter reads them.
+  void tcorrupt_convert() {
+    const std::vector<char> d = data(8*1024*1024, 10);
+    std::vector<char> truncated = gzip(d), crc = gzip(d), bz = bzip2(d);
+    truncated.resize(truncated.size() / 2);
+    crc[crc.size() - 8] ^= 1; // all data are there; only the checksum is off
+    for(size_t i=bz.size()/2; i < bz.size()/2 + 64; ++i) { bz[i] ^= 0x5a; }
+    const std::string fn[3] = { write(truncated), write(crc), write(bz) };
+    const RAWEncoding e[3] = { RE_GZIP, RE_GZIP, RE_BZIP2 };
+    const std::string uvf = ".decompress-corrupt.uvf";
+    clean tmp = cleanup(fn[0]).add(fn[1]).add(fn[2]).add(uvf);
+    for(size_t i=0; i < 3; ++i) {
+      TS_ASSERT(!RAWConverter::ConvertRAWDataset(
+        fn[i], uvf, "", header.size(), 8, 1, 1, false, false, false,
+        UINT64VECTOR3(256, 256, 128), FLOATVECTOR3(1,1,1), "decompress",
+        "test", 32, 2, false, false, 1, 1, 0, NULL, false, true, e[i]));
+      TS_ASSERT(!RAWConverter::ConvertRAWDataset(
+        fn[i], uvf, "", header.size(), 16, 1, 1, false, false, false,
+        UINT64VECTOR3(256, 256, 64), FLOATVECTOR3(1,1,1), "decompress",
+        "test", 32, 2, false, false, 1, 1, 0, NULL, false, true, e[i]));
+      TS_ASSERT(!RAWConverter::ConvertRAWDataset(
+        fn[i], uvf, "", header.size(), 16, 1, 1, false, false, false,
+        UINT64VECTOR3(256, 256, 64), FLOATVECTOR3(1,1,1), "decompress",
+        "test", 32, 2, false, false, 1, 1, 0, NULL, false, false, e[i]));
+    }
+  }
+
+  std::vector<char> slurp(const std::string& fn) {
+    std::ifstream ifs(fn.c_str(), std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(ifs),
+                             std::istreambuf_iterator<char>());
+  }
+
+  // converting compressed data gives what converting them uncompressed
+  // does, whichever way the converter takes through its passes.
+  template<typename T>
+  void tconvert_type(bool bSwap, bool bStreaming) {
+    const UINT64VECTOR3 size(40, 30, 70);
+    std::mt19937 gen(sizeof(T));
+    std::normal_distribution<double> dist(120.0, 40.0);
+    std::vector<char> raw(size_t(size.volume()) * sizeof(T));
+    T* values = reinterpret_cast<T*>(&raw[0]);
+    for(size_t i=0; i < size.volume(); ++i) {
+      values[i] = T(std::max(0.0, std::min(dist(gen), 250.0)));
+    }
+
+    const std::string fnraw = write(raw), fnz = write(gzip(raw)),
+                      fnbz = write(bzip2(raw));
+    const std::string uvf[3] = { ".decompress-raw.uvf", ".decompress-gz.uvf",
+                                 ".decompress-bz.uvf" };
+    clean tmp = cleanup(fnraw).add(fnz).add(fnbz).add(uvf[0]).add(uvf[1]).
+                  add(uvf[2]);
+    const std::string fn[3] = { fnraw, fnz, fnbz };
+    const RAWEncoding e[3] = { RE_RAW, RE_GZIP, RE_BZIP2 };
+    for(size_t i=0; i < 3; ++i) {
+      TS_ASSERT(RAWConverter::ConvertRAWDataset(
+        fn[i], uvf[i], "", header.size(), sizeof(T)*8, 1, 1, bSwap,
+        std::numeric_limits<T>::is_signed, !std::numeric_limits<T>::is_integer,
+        size, FLOATVECTOR3(1,1,1), "decompress", "test", 32, 2, false, false,
+        1, 1, 0, NULL, false, bStreaming, e[i]));
+    }
+    const std::vector<char> expected = slurp(uvf[0]);
+    TS_ASSERT(!expected.empty());
+    TS_ASSERT(slurp(uvf[1]) == expected);
+    TS_ASSERT(slurp(uvf[2]) == expected);
+  }
+
+  void tconvert() {
+    tconvert_type<uint8_t>(false, true);
+    tconvert_type<int16_t>(true, true);
+    tconvert_type<int16_t>(false, false);
+    tconvert_type<float>(false, true);
+  }
+}
+
+class DecompressTests : public CxxTest::TestSuite {
+public:
+  void test_gzip() { tgzip(); }
+  void test_members() { tmembers(); }
+  void test_bgzf() { tbgzf(); }
+  void test_bzip2() { tbzip2(); }
+  void test_corrupt() { tcorrupt(); tcorrupt_convert(); }
+  void test_convert() { tconvert(); }
+};
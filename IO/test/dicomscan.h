@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <utime.h>
+#include <cxxtest/TestSuite.h>
+#include "DICOM/DICOMParser.h"
+#include "util-test.h"
+
+namespace {
+  void put16(std::vector<char>& d, uint16_t v) {
+    d.push_back(char(v & 0xff));
+    d.push_back(char(v >> 8));
+  }
+  void put32(std::vector<char>& d, uint32_t v) {
+    put16(d, uint16_t(v & 0xffff));
+    put16(d, uint16_t(v >> 16));
+  }
+  // an explicit VR little endian element with a short length field.
+  void element(std::vector<char>& d, uint16_t group, uint16_t elem,
+               const char* vr, std::string value, char pad=' ') {
+    if(value.size() % 2) { value.push_back(pad); }
+    put16(d, group); put16(d, elem);
+    d.push_back(vr[0]); d.push_back(vr[1]);
+    put16(d, uint16_t(value.size()));
+    d.insert(d.end(), value.begin(), value.end());
+  }
+  void element(std::vector<char>& d, uint16_t group, uint16_t elem,
+               uint16_t value) {
+    put16(d, group); put16(d, elem);
+    d.push_back('U'); d.push_back('S');
+    put16(d, 2);
+    put16(d, value);
+  }
+  // OB/OW elements have a reserved field and a long length.
+  void element(std::vector<char>& d, uint16_t group, uint16_t elem,
+               const char* vr, const std::vector<char>& value) {
+    put16(d, group); put16(d, elem);
+    d.push_back(vr[0]); d.push_back(vr[1]);
+    put16(d, 0);
+    put32(d, uint32_t(value.size()));
+    d.insert(d.end(), value.begin(), value.end());
+  }
+  std::string str(double v) {
+    std::ostringstream s;
+    s << v;
+    return s.str();
+  }
+
+  struct Slice {
+    uint32_t series, image;
+    float z;
+    uint16_t rows, cols;
+    size_t iPrivate; ///< bytes of an unused element before the image's tags
+  };
+
+  // a minimal 16bit DICOM whose voxels are the slice's image number.
+  std::vector<char> dicom(const Slice& s) {
+    std::vector<char> d(128, 0);
+    d.push_back('D'); d.push_back('I'); d.push_back('C'); d.push_back('M');
+    std::vector<char> meta;
+    element(meta, 0x2, 0x10, "UI", "1.2.840.10008.1.2.1", '\0');
+    put16(d, 0x2); put16(d, 0x0); d.push_back('U'); d.push_back('L');
+    put16(d, 4); put32(d, uint32_t(meta.size()));
+    d.insert(d.end(), meta.begin(), meta.end());
+
+    element(d, 0x8, 0x60, "CS", "CT");
+    if(s.iPrivate) {
+      element(d, 0x9, 0x10, "OB", std::vector<char>(s.iPrivate, 'x'));
+    }
+    element(d, 0x20, 0x11, "IS", str(s.series));
+    element(d, 0x20, 0x13, "IS", str(s.image));
+    element(d, 0x20, 0x32, "DS", "0\\0\\" + str(s.z));
+    element(d, 0x28, 0x10, s.rows);
+    element(d, 0x28, 0x11, s.cols);
+    element(d, 0x28, 0x100, 16);
+    element(d, 0x28, 0x101, 12);
+    std::vector<char> pixels;
+    for(size_t i=0; i < size_t(s.rows)*s.cols; ++i) {
+      put16(pixels, uint16_t(s.image));
+    }
+    element(d, 0x7fe0, 0x10, "OW", pixels);
+    return d;
+  }
+
+  struct TmpDir {
+    TmpDir() {
+      char templ[64];
+      strcpy(templ, ".dicomscan.XXXXXX");
+      path = mkdtemp(templ);
+    }
+    ~TmpDir() {
+      for(size_t i=0; i < files.size(); ++i) { remove(files[i].c_str()); }
+      rmdir(path.c_str());
+    }
+    std::string write(const std::string& name, const std::vector<char>& d) {
+      const std::string fn = path + "/" + name;
+      std::ofstream ofs(fn.c_str(), std::ios::binary | std::ios::trunc);
+      ofs.write(&d[0], d.size());
+      if(std::find(files.begin(), files.end(), fn) == files.end()) {
+        files.push_back(fn);
+      }
+      return fn;
+    }
+    std::string path;
+    std::vector<std::string> files;
+  };
+
+  const DICOMStackInfo* stack(const DICOMParser& p, uint32_t series,
+                              uint16_t rows) {
+    for(size_t i=0; i < p.m_FileStacks.size(); ++i) {
+      const DICOMStackInfo* s =
+        static_cast<const DICOMStackInfo*>(p.m_FileStacks[i]);
+      if(s->m_iSeries == series && s->m_ivSize.y == rows) { return s; }
+    }
+    return NULL;
+  }
+
+  void write_series(TmpDir& dir) {
+    const Slice slices[] = {
+      { 2, 3, 5.0f, 4, 6, 0 }, { 2, 1, 1.0f, 4, 6, 0 },
+      { 2, 2, 3.0f, 4, 6, 0 }, { 1, 2, 1.5f, 4, 6, 0 },
+      { 1, 1, 0.0f, 4, 6, 0 }, { 1, 1, 0.0f, 8, 6, 0 },
+    };
+    for(size_t i=0; i < sizeof(slices)/sizeof(slices[0]); ++i) {
+      dir.write("slice" + str(double(i)) + ".dcm", dicom(slices[i]));
+    }
+    const std::string text = "not a DICOM, but long enough to look at "
+                             "its 129th byte... " + std::string(200, '.');
+    dir.write("readme.txt", std::vector<char>(text.begin(), text.end()));
+  }
+
+  // files are grouped by series and geometry, and ordered by image number.
+  void tgroup() {
+    TmpDir dir;
+    write_series(dir);
+    DICOMParser p;
+    p.GetDirInfo(dir.path);
+    TS_ASSERT_EQUALS(p.m_FileStacks.size(), 3U);
+    const DICOMStackInfo* two = stack(p, 2, 4);
+    TS_ASSERT(two != NULL);
+    if(two == NULL) { return; }
+    TS_ASSERT_EQUALS(two->m_Elements.size(), 3U);
+    for(size_t i=0; i < two->m_Elements.size(); ++i) {
+      SimpleFileInfo* f = two->m_Elements[i];
+      TS_ASSERT_EQUALS(f->m_iImageIndex, i+1);
+      TS_ASSERT_EQUALS(f->GetDataSize(), 4U*6U*2U);
+      std::vector<char> data;
+      TS_ASSERT(f->GetData(data));
+      TS_ASSERT_EQUALS(data.size(), 4U*6U*2U);
+      TS_ASSERT_EQUALS(data[46], char(i+1));
+      TS_ASSERT_EQUALS(data[47], char(0));
+    }
+    TS_ASSERT_EQUALS(two->m_fvfAspect.z, 2.0f);
+    const DICOMStackInfo* one = stack(p, 1, 4);
+    TS_ASSERT(one != NULL);
+    if(one) { TS_ASSERT_EQUALS(one->m_Elements.size(), 2U); }
+    TS_ASSERT(stack(p, 1, 8) != NULL);
+    TS_ASSERT(static_cast<const DICOMStackInfo*>(
+                p.m_FileStacks.front())->m_iSeries <=
+              static_cast<const DICOMStackInfo*>(
+                p.m_FileStacks.back())->m_iSeries);
+  }
+
+  // headers which do not fit into the first block read are parsed all the
+  // same.
+  void tlong_header() {
+    TmpDir dir;
+    const Slice s = { 5, 1, 0.0f, 16, 16, 200*1024+3 };
+    const std::vector<char> d = dicom(s);
+    const std::string fn = dir.write("long.dcm", d);
+    DICOMFileInfo info;
+    TS_ASSERT(DICOMParser::GetDICOMFileInfo(fn, info));
+    TS_ASSERT_EQUALS(info.m_iSeries, 5U);
+    TS_ASSERT_EQUALS(info.m_ivSize, UINTVECTOR3(16, 16, 1));
+    TS_ASSERT_EQUALS(info.GetOffsetToData(), d.size() - 16*16*2);
+  }
+
+  void set_mtime(const std::string& fn, time_t t) {
+    struct utimbuf times;
+    times.actime = times.modtime = t;
+    TS_ASSERT_EQUALS(utime(fn.c_str(), &times), 0);
+  }
+
+  // the index is trusted for files whose size and time did not change.
+  void tindex() {
+    TmpDir dir;
+    write_series(dir);
+    std::ofstream ofs;
+    const std::string index = mk_tmpfile(ofs, std::ios::out);
+    ofs.close();
+    remove(index.c_str());
+    clean tmp = cleanup(index);
+
+    {
+      DICOMParser p;
+      p.SetScanIndex(index);
+      p.GetDirInfo(dir.path);
+      TS_ASSERT_EQUALS(p.m_FileStacks.size(), 3U);
+    }
+    std::ifstream exists(index.c_str());
+    TS_ASSERT(exists.good());
+    exists.close();
+
+    // same size, same time, different series: only a real scan sees it.
+    const Slice moved = { 3, 1, 0.0f, 4, 6, 0 };
+    const std::string fn = dir.write("slice4.dcm", dicom(moved));
+    set_mtime(fn, 1000000000);
+    {
+      DICOMParser p;
+      p.SetScanIndex(index);
+      p.GetDirInfo(dir.path);
+      TS_ASSERT_EQUALS(p.m_FileStacks.size(), 4U);
+    }
+    {
+      DICOMParser p;
+      p.SetScanIndex(index);
+      p.GetDirInfo(dir.path);
+      TS_ASSERT_EQUALS(p.m_FileStacks.size(), 4U);
+    }
+    const Slice back = { 1, 1, 0.0f, 4, 6, 0 };
+    dir.write("slice4.dcm", dicom(back));
+    set_mtime(fn, 1000000000);
+    {
+      DICOMParser cached, uncached;
+      cached.SetScanIndex(index);
+      cached.GetDirInfo(dir.path);
+      uncached.GetDirInfo(dir.path);
+      TS_ASSERT_EQUALS(cached.m_FileStacks.size(), 4U);
+      TS_ASSERT_EQUALS(uncached.m_FileStacks.size(), 3U);
+    }
+    set_mtime(fn, 1000000001);
+    {
+      DICOMParser p;
+      p.SetScanIndex(index);
+      p.GetDirInfo(dir.path);
+      TS_ASSERT_EQUALS(p.m_FileStacks.size(), 3U);
+    }
+
+    // a damaged index is ignored.
+    {
+      std::fstream fs(index.c_str(),
+                      std::ios::in | std::ios::out | std::ios::binary);
+      fs.seekg(0, std::ios::end);
+      const std::streamoff size = fs.tellg();
+      fs.seekg(size - 1);
+      const char last = char(fs.get());
+      fs.seekp(size - 1);
+      fs.put(last ^ 0x42);
+    }
+    dir.write("slice4.dcm", dicom(moved));
+    set_mtime(fn, 1000000001);
+    {
+      DICOMParser p;
+      p.SetScanIndex(index);
+      p.GetDirInfo(dir.path);
+      TS_ASSERT_EQUALS(p.m_FileStacks.size(), 4U);
+    }
+  }
+
+  // imports get an index of their own per directory.
+  void tindex_per_directory() {
+    TmpDir a, b;
+    write_series(a);
+    write_series(b);
+    const std::string index = DICOMParser::ScanIndexFor(a.path);
+    TS_ASSERT(!index.empty());
+    TS_ASSERT_EQUALS(index, DICOMParser::ScanIndexFor(a.path));
+    TS_ASSERT_DIFFERS(index, DICOMParser::ScanIndexFor(b.path));
+    remove(index.c_str());
+    clean tmp = cleanup(index);
+    for(size_t i=0; i < 2; ++i) {
+      DICOMParser p;
+      p.SetScanIndex(index);
+      p.GetDirInfo(a.path);
+      TS_ASSERT_EQUALS(p.m_FileStacks.size(), 3U);
+      std::ifstream exists(index.c_str());
+      TS_ASSERT(exists.good());
+    }
+  }
+}
+
+class DICOMScanTests : public CxxTest::TestSuite {
+public:
+  void test_group() { tgroup(); }
+  void test_long_header() { tlong_header(); }
+  void test_index() { tindex(); }
+  void test_index_per_directory() { tindex_per_directory(); }
+};
@@ -0,0 +1,221 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+#include "Basics/Timer.h"
+#include "UVF/UVFBasic.h"
+#include "UVF/ExtendedOctree/ExtendedOctreeConverter.h"
+#include "util-test.h"
+
+namespace {
+  // converts the raw 16bit 'n'^3 volume 'raw' into an octree file.
+  void convert(const std::string& raw, size_t n, COMPRESSION_TYPE ct,
+               LAYOUT_TYPE layout, uint32_t threads, const char* uvf,
+               BrickStatVec& stats) {
+    ExtendedOctreeConverter conv(UINT64VECTOR3(32,32,32), 2, 64*1024*1024,
+                                 Controller::Debug::Out());
+    conv.SetThreadCount(threads);
+    const bool converted = conv.Convert(
+      raw, 0, ExtendedOctree::CT_UINT16, 1, UINT64VECTOR3(n,n,n),
+      DOUBLEVECTOR3(1,1,1), uvf, 0, &stats, ct, 1, false, false, layout
+    );
+    TS_ASSERT(converted);
+  }
+
+  // converts 'n'^3 normally-distributed 16bit voxels into an octree file.
+  // @returns the name of the octree file.
+  std::string mk_octree(size_t n, COMPRESSION_TYPE ct, const char* uvf) {
+    std::ofstream ofs;
+    const std::string raw = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    gen_normal<uint16_t>(ofs, n*n*n*sizeof(uint16_t), 2048, 400);
+    ofs.close();
+
+    BrickStatVec stats;
+    convert(raw, n, ct, LT_MORTON, 0, uvf, stats);
+    std::remove(raw.c_str());
+    return std::string(uvf);
+  }
+
+  std::vector<char> slurp(const std::string& fn) {
+    std::ifstream ifs(fn.c_str(), std::ios::in | std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(ifs),
+                             std::istreambuf_iterator<char>());
+  }
+
+  // the parallel converter must produce exactly the file the serial one does.
+  void parallel_convert(COMPRESSION_TYPE ct, LAYOUT_TYPE layout) {
+    const size_t n = 80;
+    std::ofstream ofs;
+    const std::string raw = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    // half noise, half constant: some bricks compress, others don't.
+    gen_normal<uint16_t>(ofs, n*n*n*sizeof(uint16_t)/2, 2048, 400);
+    gen_constant<uint16_t>(ofs, n*n*n*sizeof(uint16_t)/2, 42);
+    ofs.close();
+    clean rawtmp = cleanup(raw);
+
+    const char* serial = ".eoctree-serial.uvf";
+    const char* parallel = ".eoctree-parallel.uvf";
+    clean stmp = cleanup(serial);
+    clean ptmp = cleanup(parallel);
+    BrickStatVec sstats, pstats;
+    convert(raw, n, ct, layout, 1, serial, sstats);
+    convert(raw, n, ct, layout, 4, parallel, pstats);
+
+    TS_ASSERT(slurp(serial) == slurp(parallel));
+    TS_ASSERT_EQUALS(sstats.size(), pstats.size());
+    for(size_t i=0; i < std::min(sstats.size(), pstats.size()); ++i) {
+      TS_ASSERT_EQUALS(sstats[i].minScalar, pstats[i].minScalar);
+      TS_ASSERT_EQUALS(sstats[i].maxScalar, pstats[i].maxScalar);
+      TS_ASSERT_EQUALS(sstats[i].occupancy, pstats[i].occupancy);
+    }
+  }
+
+  size_t brick_bytes(const ExtendedOctree& tree, size_t i) {
+    return size_t(tree.ComputeBrickSize(tree.IndexToBrickCoords(i)).volume() *
+                  tree.GetComponentCount() * tree.GetComponentTypeSize());
+  }
+  size_t n_bricks(const ExtendedOctree& tree) {
+    size_t n = 0;
+    for(uint64_t lod=0; lod < tree.GetLODCount(); ++lod) {
+      n += size_t(tree.GetBrickCount(lod).volume());
+    }
+    return n;
+  }
+
+  // reads every brick from many threads at once; they must match what we get
+  // when reading them one at a time.
+  void concurrent_read(COMPRESSION_TYPE ct) {
+    const std::string fn = mk_octree(96, ct, ".eoctree-test.uvf");
+    clean tmp = cleanup(fn);
+    ExtendedOctree tree;
+    TS_ASSERT(tree.Open(fn, 0, UVFVERSION));
+
+    const size_t nb = n_bricks(tree);
+    std::vector<std::vector<uint8_t>> serial(nb);
+    for(size_t i=0; i < nb; ++i) {
+      serial[i].resize(brick_bytes(tree, i));
+      tree.GetBrickData(serial[i].data(), tree.IndexToBrickCoords(i));
+    }
+
+    std::vector<std::vector<uint8_t>> parallel(nb);
+    const int64_t nbi = int64_t(nb);
+    for(size_t rep=0; rep < 4; ++rep) {
+#pragma omp parallel for schedule(dynamic)
+      for(int64_t i=0; i < nbi; ++i) {
+        parallel[size_t(i)].resize(brick_bytes(tree, size_t(i)));
+        tree.GetBrickData(parallel[size_t(i)].data(),
+                          tree.IndexToBrickCoords(uint64_t(i)));
+      }
+      for(size_t i=0; i < nb; ++i) {
+        TS_ASSERT(parallel[i] == serial[i]);
+      }
+    }
+    tree.Close();
+  }
+
+  // batched reads must return exactly what single brick reads do, no matter
+  // how the bricks are grouped into reads.
+  void batched_read(COMPRESSION_TYPE ct) {
+    const std::string fn = mk_octree(96, ct, ".eoctree-batch.uvf");
+    clean tmp = cleanup(fn);
+    ExtendedOctree tree;
+    TS_ASSERT(tree.Open(fn, 0, UVFVERSION));
+
+    // every other brick, backwards, and one of them twice.
+    const size_t nb = n_bricks(tree);
+    std::vector<UINT64VECTOR4> coords;
+    for(size_t i=nb; i > 0; i -= std::min<size_t>(i, 2)) {
+      coords.push_back(tree.IndexToBrickCoords(i-1));
+    }
+    coords.push_back(coords.front());
+
+    std::vector<std::vector<uint8_t>> serial(coords.size());
+    for(size_t i=0; i < coords.size(); ++i) {
+      serial[i].resize(brick_bytes(tree, size_t(tree.BrickCoordsToIndex(coords[i]))));
+      tree.GetBrickData(serial[i].data(), coords[i]);
+    }
+
+    const uint64_t gaps[] = {64*1024, 0, 0};
+    const uint64_t reads[] = {16*1024*1024, 1, 64*1024};
+    for(size_t g=0; g < 3; ++g) {
+      std::vector<std::vector<uint8_t>> batched(coords.size());
+      size_t done = 0;
+      tree.GetBrickData(coords,
+        [&](size_t i) {
+          batched[i].resize(serial[i].size());
+          return batched[i].data();
+        },
+        [&](size_t) { ++done; return true; }, gaps[g], reads[g]);
+      TS_ASSERT_EQUALS(done, coords.size());
+      for(size_t i=0; i < coords.size(); ++i) {
+        TS_ASSERT(batched[i] == serial[i]);
+      }
+    }
+
+    // stopping early
+    size_t done = 0;
+    std::vector<uint8_t> buf(brick_bytes(tree, 0));
+    tree.GetBrickData(coords, [&](size_t) { return buf.data(); },
+                      [&](size_t) { return ++done < 3; });
+    TS_ASSERT_EQUALS(done, 3u);
+    tree.Close();
+  }
+
+  // not really a test: reports read throughput for 1,2,4,... threads.
+  void read_bench(COMPRESSION_TYPE ct, const char* name) {
+    const std::string fn = mk_octree(256, ct, ".eoctree-bench.uvf");
+    clean tmp = cleanup(fn);
+    ExtendedOctree tree;
+    TS_ASSERT(tree.Open(fn, 0, UVFVERSION));
+    const int64_t nb = int64_t(n_bricks(tree));
+    size_t bytes = 0;
+    for(int64_t i=0; i < nb; ++i) { bytes += brick_bytes(tree, size_t(i)); }
+
+#ifdef _OPENMP
+    const int maxthreads = omp_get_max_threads();
+#else
+    const int maxthreads = 1;
+#endif
+    for(int threads=1; threads <= maxthreads; threads *= 2) {
+      Timer t; t.Start();
+#pragma omp parallel num_threads(threads)
+      {
+        std::vector<uint8_t> buf;
+#pragma omp for schedule(dynamic)
+        for(int64_t i=0; i < nb; ++i) {
+          buf.resize(brick_bytes(tree, size_t(i)));
+          tree.GetBrickData(buf.data(), tree.IndexToBrickCoords(uint64_t(i)));
+        }
+      }
+      const double ms = t.Elapsed();
+      fprintf(stderr, "\n%s, %2d threads: %8.2f MB/s", name, threads,
+              (bytes / (1024.0*1024.0)) / (ms / 1000.0));
+    }
+    tree.Close();
+  }
+}
+
+class ExtendedOctreeTests : public CxxTest::TestSuite {
+public:
+  void test_concurrent_raw() { concurrent_read(CT_NONE); }
+  void test_concurrent_zlib() { concurrent_read(CT_ZLIB); }
+  void test_concurrent_lz4() { concurrent_read(CT_LZ4); }
+  void test_batched_raw() { batched_read(CT_NONE); }
+  void test_batched_lz4() { batched_read(CT_LZ4); }
+  void test_batched_bzlib() { batched_read(CT_BZLIB); }
+  void test_parallel_raw() { parallel_convert(CT_NONE, LT_SCANLINE); }
+  void test_parallel_zlib() { parallel_convert(CT_ZLIB, LT_SCANLINE); }
+  void test_parallel_lz4_morton() { parallel_convert(CT_LZ4, LT_MORTON); }
+  void test_parallel_zlib_hilbert() { parallel_convert(CT_ZLIB, LT_HILBERT); }
+  void test_parallel_bzlib_morton() { parallel_convert(CT_BZLIB, LT_MORTON); }
+  void test_read_bench() {
+    read_bench(CT_NONE, "uncompressed");
+    read_bench(CT_LZ4, "lz4");
+    read_bench(CT_ZLIB, "zlib");
+  }
+};
@@ -0,0 +1,163 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "expressions/parser.h"
+#include "expressions/program.h"
+#include "expressions/treenode.h"
+
+using namespace tuvok::expression;
+
+namespace {
+  // parses 'expr'; the tree lives until parser_free.  The grammar wants
+  // parentheses around every nested binary expression.
+  Node* parse(const std::string& expr) {
+    parser_set_string(expr.c_str());
+    if(yyparse() == 1) {
+      TS_FAIL(("could not parse " + expr).c_str());
+      return NULL;
+    }
+    return parser_tree_root();
+  }
+
+  template<typename T>
+  std::vector<std::vector<T>> inputs(size_t n, double scale, double offset) {
+    std::vector<std::vector<T>> v(3, std::vector<T>(n));
+    for(size_t i=0; i < n; ++i) {
+      v[0][i] = static_cast<T>(offset + scale * ((i * 7) % 101) / 100.0);
+      v[1][i] = static_cast<T>(offset + scale * ((i * 13) % 37) / 36.0);
+      v[2][i] = static_cast<T>(offset + scale * (i % 2));
+    }
+    return v;
+  }
+
+  // the program must give exactly what the tree walk gives.
+  template<typename T>
+  void compare(const std::string& expr, std::vector<std::vector<T>>& in) {
+    Node* tree = parse(expr);
+    if(tree == NULL) { parser_free(); return; }
+    std::vector<T> expected;
+    evaluate(*tree, in, expected);
+
+    const Program p(*tree);
+    std::vector<const T*> ptrs;
+    for(size_t i=0; i < in.size(); ++i) { ptrs.push_back(&in[i][0]); }
+    std::vector<T> got(expected.size());
+    p.Run(ptrs, &got[0], got.size());
+    size_t wrong = 0;
+    for(size_t i=0; i < got.size(); ++i) {
+      if(got[i] != expected[i]) { ++wrong; }
+    }
+    if(wrong) { fprintf(stderr, "\n'%s': %u wrong\n", expr.c_str(),
+                        static_cast<unsigned>(wrong)); }
+    TS_ASSERT_EQUALS(wrong, 0U);
+    parser_free();
+  }
+
+  const char* expressions[] = {
+    "v[0]",
+    "42",
+    "(v[0] + (v[1] * 2)) - 1",
+    "(v[0] - v[1]) / 4",
+    "v[1] / v[0]",
+    "v[0] > v[1]",
+    "v[0] < (0.5 * v[2])",
+    "v[0] = v[1]",
+    "(2 * 3) + v[2]",
+    "v[0] > v[1] ? v[0] : v[1]",
+    "((v[2] > 0) ? v[0] : (1 + 1)) + ((3 > 2) ? v[1] : v[0])",
+    "(v[0] > 0.25) ? ((v[1] > 0.5) ? v[2] : (v[0] * v[1])) : 0",
+  };
+  const size_t n_expressions = sizeof(expressions) / sizeof(expressions[0]);
+}
+
+class ProgramTests : public CxxTest::TestSuite {
+public:
+  void test_matches_tree_float() {
+    // not a multiple of the block size
+    std::vector<std::vector<float>> in = inputs<float>(3*Program::Block + 17,
+                                                       1.0, 0.5);
+    for(size_t e=0; e < n_expressions; ++e) { compare(expressions[e], in); }
+  }
+  void test_matches_tree_integers() {
+    std::vector<std::vector<uint8_t>> in8 = inputs<uint8_t>(2500, 60, 2);
+    std::vector<std::vector<int16_t>> in16 = inputs<int16_t>(2500, 2000, -901);
+    for(size_t e=0; e < n_expressions; ++e) {
+      compare(expressions[e], in8);
+      compare(expressions[e], in16);
+    }
+  }
+  void test_wide_integers() {
+    // out of the tree walk's reach: Volume cannot read 32bit data.
+    Node* tree = parse("(v[0] > 3000000000) ? (v[0] - v[1]) : (v[1] + 1)");
+    if(tree == NULL) { parser_free(); return; }
+    const Program p(*tree);
+    TS_ASSERT_EQUALS(p.Volumes(), 2U);
+    const size_t n = 5000;
+    std::vector<uint32_t> a(n), b(n), out(n);
+    for(size_t i=0; i < n; ++i) {
+      a[i] = 4000000000U - uint32_t(i) * 400000U;
+      b[i] = uint32_t(i) * 3;
+    }
+    std::vector<const uint32_t*> in;
+    in.push_back(&a[0]);
+    in.push_back(&b[0]);
+    p.Run(in, &out[0], n);
+    for(size_t i=0; i < n; ++i) {
+      TS_ASSERT_EQUALS(out[i], a[i] > 3000000000U ? a[i] - b[i] : b[i] + 1);
+    }
+    parser_free();
+  }
+  void test_parallel_bricks() {
+    Node* tree = parse("(v[0] * 2) + v[1]");
+    if(tree == NULL) { parser_free(); return; }
+    const Program p(*tree);
+    // bricks of different sizes, one much larger than the rest.
+    const size_t sizes[] = { 1, 0, 1000, 300000, 4097 };
+    std::vector<std::vector<std::vector<int32_t>>> bricks;
+    for(size_t s=0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+      bricks.push_back(std::vector<std::vector<int32_t>>(2,
+                       std::vector<int32_t>(sizes[s])));
+      for(size_t i=0; i < sizes[s]; ++i) {
+        bricks.back()[0][i] = int32_t(i * s) - 70000;
+        bricks.back()[1][i] = int32_t(s);
+      }
+    }
+    std::vector<std::vector<int32_t>> out;
+    evaluate(p, bricks, out);
+    TS_ASSERT_EQUALS(out.size(), bricks.size());
+    for(size_t s=0; s < out.size(); ++s) {
+      TS_ASSERT_EQUALS(out[s].size(), sizes[s]);
+      for(size_t i=0; i < out[s].size(); ++i) {
+        TS_ASSERT_EQUALS(out[s][i], bricks[s][0][i] * 2 + bricks[s][1][i]);
+      }
+    }
+    parser_free();
+  }
+  void test_performance() {
+    Node* tree = parse("(v[0] > 0.5) ? ((v[0] * 2) + v[1]) : (v[1] - v[2])");
+    if(tree == NULL) { parser_free(); return; }
+    std::vector<std::vector<float>> in = inputs<float>(size_t(1) << 22, 1.0,
+                                                       0.0);
+    std::vector<float> expected, got(in[0].size());
+
+    clock_t start = clock();
+    evaluate(*tree, in, expected);
+    const double ttree = double(clock() - start) / CLOCKS_PER_SEC;
+
+    const Program p(*tree);
+    std::vector<const float*> ptrs;
+    for(size_t i=0; i < in.size(); ++i) { ptrs.push_back(&in[i][0]); }
+    start = clock();
+    p.Run(ptrs, &got[0], got.size());
+    const double tprog = double(clock() - start) / CLOCKS_PER_SEC;
+    TS_ASSERT(got == expected);
+
+    fprintf(stderr, "\n4M voxels, one thread: tree %.3fs, program %.3fs\n",
+            ttree, tprog);
+    parser_free();
+  }
+};
@@ -0,0 +1,265 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "Basics/Mesh.h"
+#include "Basics/SysTools.h"
+#include "OBJGeoConverter.h"
+#include "PLYGeoConverter.h"
+#include "TextSpan.h"
+#include "util-test.h"
+
+namespace {
+  TextSpan span(const std::string& s) {
+    return TextSpan(s.data(), s.data() + s.size());
+  }
+
+  std::string write(const std::string& text) {
+    std::ofstream ofs;
+    const std::string fn = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    ofs.write(text.data(), text.size());
+    return fn;
+  }
+
+  // the fast paths give the very bits the libraries do, and whatever they
+  // cannot handle goes to the libraries.
+  void tnumbers() {
+    const char* tricky[] = {
+      "0", "-0", "1", "+.5", "5.", ".", "-", "1e", "1e+", "e5", "1e-45",
+      "16777217", "-16777219.0", "33554434", "1.6777217e7", "0.1",
+      "3.4028235e38", "3.4028236e38", "1.17549435e-38", "1.1754942e-38",
+      "1e22", "1e23", "1e-22", "1e-23", "9007199254740993",
+      "18446744073709551616", "1.00000000000000000000000000001",
+      "00000000000000000000000000000001.5", "1.0000000596046447753906250",
+      "123456789012345678901234", "2147483648", "-2147483649", "1e400",
+      "-1e400", "1e-400", "inf", "-INF", "nan", "0x1p3", "12abc", "1,5",
+      "1.5.3", "--1", " 7", "\t-3.25",
+    };
+    std::vector<std::string> numbers(tricky,
+                                      tricky + sizeof(tricky)/sizeof(char*));
+    std::mt19937 gen(25);
+    for(size_t i=0; i < 20000; ++i) {
+      std::ostringstream s;
+      s << (gen() % 3 ? "" : "-") << gen() % 100000;
+      if(gen() % 4) { s << "." << gen() % 1000000; }
+      if(gen() % 5 == 0) { s << "e" << int(gen() % 80) - 40; }
+      numbers.push_back(s.str());
+    }
+
+    const NumberParser num;
+    size_t iWrong = 0;
+    for(size_t i=0; i < numbers.size(); ++i) {
+      const std::string& s = numbers[i];
+      const double d = atof(s.c_str()), dFast = num.Atof(span(s));
+      if(memcmp(&d, &dFast, sizeof(double)) != 0 ||
+         atoi(s.c_str()) != num.Atoi(span(s))) {
+        ++iWrong;
+      }
+      if(!isspace(s[0])) {
+        const float f = SysTools::FromString<float>(s),
+                    fFast = num.StreamFloat(span(s));
+        if(memcmp(&f, &fFast, sizeof(float)) != 0) { ++iWrong; }
+      }
+    }
+    TS_ASSERT_EQUALS(iWrong, 0U);
+  }
+
+  // pieces end at line ends and together are the whole text.
+  void tlines() {
+    const std::string text = "v 1 2 3\n\nf 1 2 3\r\nlast";
+    TS_ASSERT_EQUALS(CountLines(span(text)), 4U);
+    TS_ASSERT_EQUALS(CountLines(span(text + "\n")), 4U);
+    TS_ASSERT_EQUALS(CountLines(span("")), 0U);
+    for(size_t iSize=1; iSize < text.size() + 2; ++iSize) {
+      const std::vector<TextSpan> pieces = SplitLines(span(text), iSize);
+      std::string all;
+      uint64_t iLines = 0;
+      for(size_t i=0; i < pieces.size(); ++i) {
+        TS_ASSERT(!pieces[i].empty());
+        if(i+1 < pieces.size()) { TS_ASSERT_EQUALS(pieces[i].end[-1], '\n'); }
+        all += pieces[i].str();
+        iLines += CountLines(pieces[i]);
+      }
+      TS_ASSERT_EQUALS(all, text);
+      TS_ASSERT_EQUALS(iLines, 4U);
+    }
+
+    const std::string face = "  F\t10//9  5//9\r";
+    TextSpan t = span(face);
+    TextSpan line;
+    TS_ASSERT(t.PopLine(line));
+    line = line.Trimmed();
+    TS_ASSERT(line.PopToken().Is("f"));
+    TS_ASSERT_EQUALS(line.front(), '1');
+    TS_ASSERT_EQUALS(line.UpTo(' ').Count('/'), 2U);
+    TS_ASSERT_EQUALS(line.PopToken('/').str(), "10");
+    line.SkipToken('/');
+    TS_ASSERT_EQUALS(line.PopToken().str(), "9");
+    TS_ASSERT_EQUALS(line.str(), "5//9");
+    TS_ASSERT(!t.PopLine(line));
+  }
+
+  // a quad is fanned into triangles, broken vertices are padded and
+  // comments dropped; normals come along with their vertices.
+  void tobj_small() {
+    const std::string fn = write(
+      "# a unit square\n"
+      "v 0 0 0\n"
+      "V 1 0 0 # upper case tag\n"
+      "v\t1 1 0\n"
+      "v 0 1\n"
+      "vn 0 0 1\r\n"
+      "usemtl ignored\n"
+      "f 1//1 2//1 3//1 4//1\n"
+      "f 1//1 2//1 3//1"
+    );
+    clean tmp = cleanup(fn);
+    OBJGeoConverter conv;
+    std::shared_ptr<Mesh> m = conv.ConvertToMesh(fn);
+    TS_ASSERT_EQUALS(m->GetMeshType(), Mesh::MT_TRIANGLES);
+    TS_ASSERT_EQUALS(m->GetVertices().size(), 4U);
+    TS_ASSERT_EQUALS(m->GetVertices()[1], FLOATVECTOR3(1, 0, 0));
+    TS_ASSERT_EQUALS(m->GetVertices()[3], FLOATVECTOR3(0, 1, 0));
+    TS_ASSERT_EQUALS(m->GetNormals().size(), 1U);
+    const uint32_t expected[] = { 0, 1, 2, 0, 2, 3, 0, 1, 2 };
+    TS_ASSERT(m->GetVertexIndices() ==
+              IndexVec(expected, expected + sizeof(expected)/sizeof(uint32_t)));
+    TS_ASSERT(m->GetNormalIndices() == IndexVec(9, 0));
+    TS_ASSERT(m->GetTexCoordIndices().empty());
+  }
+
+  // the first polygon decides between lines and polygons.
+  void tobj_lines() {
+    const std::string fn = write("v 0 0 0\nv 1 0 0\nv 1 1 0\n"
+                                 "l 1 2\nf 1 2 3\nl 2 3\n");
+    clean tmp = cleanup(fn);
+    OBJGeoConverter conv;
+    std::shared_ptr<Mesh> m = conv.ConvertToMesh(fn);
+    TS_ASSERT_EQUALS(m->GetMeshType(), Mesh::MT_LINES);
+    const uint32_t expected[] = { 0, 1, 1, 2 };
+    TS_ASSERT(m->GetVertexIndices() == IndexVec(expected, expected + 4));
+  }
+
+  // large files are parsed in pieces; nothing is lost or reordered where
+  // they meet.
+  void tobj_large() {
+    std::mt19937 gen(7);
+    std::ostringstream s;
+    s.precision(10);
+    VertVec vertices;
+    IndexVec indices;
+    const size_t n = 100000;
+    for(size_t i=0; i < n; ++i) {
+      const FLOATVECTOR3 v(float(gen() % 20000) / 8, float(gen() % 20000) / 4,
+                           -float(gen() % 20000) / 2);
+      s << "v " << v.x << " " << v.y << " " << v.z << "\n";
+      vertices.push_back(v);
+    }
+    for(size_t i=0; i < 2*n; ++i) {
+      s << "f";
+      for(size_t j=0; j < 3; ++j) {
+        indices.push_back(uint32_t(gen() % n));
+        s << (j ? " " : "\t") << indices.back()+1;
+      }
+      s << "\n";
+    }
+    const std::string fn = write(s.str());
+    clean tmp = cleanup(fn);
+    OBJGeoConverter conv;
+    std::shared_ptr<Mesh> m = conv.ConvertToMesh(fn);
+    TS_ASSERT(m->GetVertices() == vertices);
+    TS_ASSERT(m->GetVertexIndices() == indices);
+    TS_ASSERT(m->GetTexCoordIndices().empty());
+  }
+
+  // vertices with colors and normals, faces of any size and edges.
+  void tply_small() {
+    const std::string header =
+      "ply\nformat ascii 1.0\ncomment test\nelement vertex 4\n"
+      "property float x\nproperty float y\nproperty float z\n"
+      "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+    const std::string vertices =
+      "0 0 0 255 0 0\n1 0 0 0 255 0\n1 1 0 0 0 255\n0 1 0 255 255 255\n";
+
+    const std::string fnfaces = write(header +
+      "element face 2\nproperty list uchar int vertex_indices\nend_header\n" +
+      vertices + "4 0 1 2 3\r\n3 0 1 2");
+    const std::string fnedges = write(header +
+      "element edge 2\nproperty int vertex1\nproperty int vertex2\n"
+      "end_header\n" + vertices + "0 1\n2 3\n");
+    clean tmp = cleanup(fnfaces).add(fnedges);
+
+    PLYGeoConverter conv;
+    std::shared_ptr<Mesh> m = conv.ConvertToMesh(fnfaces);
+    TS_ASSERT_EQUALS(m->GetMeshType(), Mesh::MT_TRIANGLES);
+    TS_ASSERT_EQUALS(m->GetVertices().size(), 4U);
+    TS_ASSERT_EQUALS(m->GetColors().size(), 4U);
+    TS_ASSERT_EQUALS(m->GetColors()[2], FLOATVECTOR4(0, 0, 1, 1));
+    const uint32_t faces[] = { 0, 1, 2, 0, 2, 3, 0, 1, 2 };
+    TS_ASSERT(m->GetVertexIndices() ==
+              IndexVec(faces, faces + sizeof(faces)/sizeof(uint32_t)));
+    TS_ASSERT_EQUALS(m->GetColorIndices().size(), 9U);
+
+    m = conv.ConvertToMesh(fnedges);
+    TS_ASSERT_EQUALS(m->GetMeshType(), Mesh::MT_LINES);
+    const uint32_t edges[] = { 0, 1, 2, 3 };
+    TS_ASSERT(m->GetVertexIndices() == IndexVec(edges, edges + 4));
+  }
+
+  void tply_large() {
+    std::mt19937 gen(8);
+    const size_t n = 100000;
+    std::ostringstream s;
+    s.precision(10);
+    s << "ply\nformat ascii 1.0\nelement vertex " << n << "\n"
+         "property float x\nproperty float y\nproperty float z\n"
+         "property float nx\nproperty float ny\nproperty float nz\n"
+         "element face " << 2*n << "\n"
+         "property list uchar int vertex_indices\nend_header\n";
+    VertVec vertices;
+    NormVec normals;
+    IndexVec indices;
+    for(size_t i=0; i < n; ++i) {
+      const FLOATVECTOR3 v(float(gen() % 20000) / 8, float(gen() % 20000) / 4,
+                           -float(gen() % 20000) / 2);
+      s << v.x << " " << v.y << " " << v.z << " 0 0 1\n";
+      vertices.push_back(v);
+      normals.push_back(FLOATVECTOR3(0, 0, 1));
+    }
+    for(size_t i=0; i < 2*n; ++i) {
+      s << "3";
+      for(size_t j=0; j < 3; ++j) {
+        indices.push_back(uint32_t(gen() % n));
+        s << " " << indices.back();
+      }
+      s << "\n";
+    }
+    const std::string fn = write(s.str());
+    clean tmp = cleanup(fn);
+    PLYGeoConverter conv;
+    std::shared_ptr<Mesh> m = conv.ConvertToMesh(fn);
+    TS_ASSERT(m->GetVertices() == vertices);
+    TS_ASSERT(m->GetNormals() == normals);
+    TS_ASSERT(m->GetVertexIndices() == indices);
+    TS_ASSERT(m->GetNormalIndices() == indices);
+  }
+}
+
+class GeoParseTests : public CxxTest::TestSuite {
+public:
+  void test_numbers() { tnumbers(); }
+  void test_lines() { tlines(); }
+  void test_obj_small() { tobj_small(); }
+  void test_obj_lines() { tobj_lines(); }
+  void test_obj_large() { tobj_large(); }
+  void test_ply_small() { tply_small(); }
+  void test_ply_large() { tply_large(); }
+};
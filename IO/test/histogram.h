@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+#include "UVF/UVFBasic.h"
+#include "UVF/BrickHistogram.h"
+#include "UVF/Histogram1DDataBlock.h"
+#include "UVF/Histogram2DDataBlock.h"
+#include "UVF/MaxMinDataBlock.h"
+#include "UVF/TOCBlock.h"
+#include "util-test.h"
+
+namespace {
+  template<typename T> ExtendedOctree::COMPONENT_TYPE component_type();
+  template<> ExtendedOctree::COMPONENT_TYPE component_type<uint16_t>() {
+    return ExtendedOctree::CT_UINT16;
+  }
+  template<> ExtendedOctree::COMPONENT_TYPE component_type<int16_t>() {
+    return ExtendedOctree::CT_INT16;
+  }
+  template<> ExtendedOctree::COMPONENT_TYPE component_type<uint64_t>() {
+    return ExtendedOctree::CT_UINT64;
+  }
+  template<> ExtendedOctree::COMPONENT_TYPE component_type<float>() {
+    return ExtendedOctree::CT_FLOAT32;
+  }
+
+  // writes 'n'^3 normally-distributed voxels and bricks them into 'toc'.
+  // @returns the voxels.
+  template<typename T>
+  std::vector<T> mk_toc(TOCBlock& toc, size_t n, T mean, T stddev) {
+    std::ofstream ofs;
+    const std::string raw = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    gen_normal<T>(ofs, n*n*n*sizeof(T), mean, stddev);
+    ofs.close();
+    clean tmp = cleanup(raw);
+
+    std::vector<T> data(n*n*n);
+    {
+      std::ifstream ifs(raw.c_str(), std::ios::in | std::ios::binary);
+      ifs.read(reinterpret_cast<char*>(data.data()), data.size()*sizeof(T));
+    }
+
+    std::shared_ptr<MaxMinDataBlock> mm(new MaxMinDataBlock(1));
+    const bool bricked = toc.FlatDataToBrickedLOD(
+      raw, raw + ".toc", component_type<T>(), 1, UINT64VECTOR3(n,n,n),
+      DOUBLEVECTOR3(1,1,1), UINT64VECTOR3(32,32,32), 2, false, false,
+      64*1024*1024, mm, &Controller::Debug::Out(), CT_LZ4, 1, LT_MORTON
+    );
+    TS_ASSERT(bricked);
+    return data;
+  }
+
+  // histogram of 'data' computed the simple way: integers get a bin per
+  // value, counted from 0 unless some are negative, if there are few enough
+  // of them; otherwise the range is spread over all bins, with the smallest
+  // value in the first and the largest in the last.
+  template<typename T>
+  std::vector<uint64_t> reference(const std::vector<T>& data) {
+    const T lo = *std::min_element(data.begin(), data.end());
+    const T hi = *std::max_element(data.begin(), data.end());
+    const bool integral = std::numeric_limits<T>::is_integer;
+    const T first = (integral && lo >= 0) ? T(0) : lo;
+    const size_t maxBins = BrickHistogram::MaxBins;
+    const bool perValue = integral &&
+                          double(hi) - double(first) < double(maxBins);
+    std::vector<uint64_t> hist(perValue ? size_t(hi - first) + 1 : maxBins,
+                               0);
+    for(size_t i=0; i < data.size(); ++i) {
+      const T v = data[i];
+      size_t bin;
+      if(perValue) {
+        bin = size_t(v - first);
+      } else if(integral) {
+        bin = size_t(uint64_t(v - first) * (maxBins - 1) /
+                     uint64_t(hi - first));
+      } else {
+        bin = std::min(maxBins - 1,
+                       size_t((double(v) - double(first)) * (maxBins - 1) /
+                              (double(hi) - double(first))));
+      }
+      ++hist[bin];
+    }
+    while(!hist.empty() && hist.back() == 0) { hist.pop_back(); }
+    return hist;
+  }
+
+  template<typename T>
+  void hist1d(T mean, T stddev) {
+    TOCBlock toc(UVFVERSION);
+    const std::vector<T> data = mk_toc<T>(toc, 80, mean, stddev);
+
+    Histogram1DDataBlock hist;
+    TS_ASSERT(hist.Compute(&toc, 0));
+    const std::vector<uint64_t> expected = reference(data);
+    TS_ASSERT_EQUALS(hist.GetHistogram().size(), expected.size());
+    TS_ASSERT(hist.GetHistogram() == expected);
+  }
+
+  // the 2D histogram must agree with the 1D histogram when we sum up all
+  // gradients, and must not depend on the number of threads.
+  void hist2d() {
+    TOCBlock toc(UVFVERSION);
+    const std::vector<uint16_t> data = mk_toc<uint16_t>(toc, 80, 2048, 400);
+    const uint16_t maxval = *std::max_element(data.begin(), data.end());
+
+    Histogram1DDataBlock h1;
+    TS_ASSERT(h1.Compute(&toc, 0));
+    const std::vector<uint64_t>& hist1 = h1.GetHistogram();
+
+    Histogram2DDataBlock parallel;
+    TS_ASSERT(parallel.Compute(&toc, 0, hist1.size(), maxval));
+    const std::vector<std::vector<uint64_t>>& hist2 = parallel.GetHistogram();
+    TS_ASSERT_EQUALS(hist2.size(), hist1.size());
+    for(size_t i=0; i < std::min(hist1.size(), hist2.size()); ++i) {
+      uint64_t sum = 0;
+      for(size_t j=0; j < hist2[i].size(); ++j) { sum += hist2[i][j]; }
+      TS_ASSERT_EQUALS(sum, hist1[i]);
+    }
+
+#ifdef _OPENMP
+    const int threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    Histogram2DDataBlock serial;
+    TS_ASSERT(serial.Compute(&toc, 0, hist1.size(), maxval));
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    TS_ASSERT(serial.GetHistogram() == hist2);
+    TS_ASSERT_EQUALS(serial.GetMaxGradMagnitude(),
+                     parallel.GetMaxGradMagnitude());
+  }
+
+  void binning() {
+    // small non-negative integer ranges are binned by value
+    BrickHistogram::Binning b = BrickHistogram::Binning::Range(3, 1000, true);
+    TS_ASSERT_EQUALS(b.bins, 1001u);
+    TS_ASSERT_EQUALS(b(uint64_t(3)), 3u);
+    TS_ASSERT_EQUALS(b(uint64_t(1000)), 1000u);
+    // ... signed ones start at their minimum
+    b = BrickHistogram::Binning::Range(-10, 10, true);
+    TS_ASSERT_EQUALS(b.bins, 21u);
+    TS_ASSERT_EQUALS(b(int32_t(-10)), 0u);
+    TS_ASSERT_EQUALS(b(int32_t(10)), 20u);
+    // anything else is split evenly, the maximum landing in the last bin
+    b = BrickHistogram::Binning::Range(-1.0, 1.0, false);
+    TS_ASSERT_EQUALS(b.bins, BrickHistogram::MaxBins);
+    TS_ASSERT_EQUALS(b(-1.0f), 0u);
+    TS_ASSERT_EQUALS(b(1.0f), BrickHistogram::MaxBins-1);
+    TS_ASSERT_EQUALS(b(std::numeric_limits<float>::quiet_NaN()), 0u);
+    b = BrickHistogram::Binning::Range(0, 1e12, true);
+    TS_ASSERT_EQUALS(b.bins, BrickHistogram::MaxBins);
+    TS_ASSERT_EQUALS(b(uint64_t(1e12)), BrickHistogram::MaxBins-1);
+  }
+}
+
+class HistogramTests : public CxxTest::TestSuite {
+public:
+  void test_binning() { binning(); }
+  void test_hist1d_uint16() { hist1d<uint16_t>(2048, 400); }
+  void test_hist1d_int16() { hist1d<int16_t>(0, 400); }
+  void test_hist1d_uint64() {
+    hist1d<uint64_t>(uint64_t(1) << 40, uint64_t(1) << 36);
+  }
+  void test_hist1d_float() { hist1d<float>(0.0f, 10.0f); }
+  void test_hist2d() { hist2d(); }
+};
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <utility>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "IsosurfaceExtractor.h"
+#include "Mesh.h"
+#include "OBJGeoConverter.h"
+#include "RAWConverter.h"
+#include "uvfDataset.h"
+#include "util-test.h"
+
+using namespace tuvok;
+
+namespace {
+  const UINT64VECTOR3 domain(29, 23, 31);
+
+  // distance from a point off the volume's center; the isosurface at 9 is a
+  // sphere crossing many brick boundaries, but not the volume's.
+  std::vector<float> sphere() {
+    std::vector<float> v(size_t(domain.volume()));
+    for(uint64_t z=0; z < domain.z; ++z) {
+      for(uint64_t y=0; y < domain.y; ++y) {
+        for(uint64_t x=0; x < domain.x; ++x) {
+          v[size_t(x + domain.x*(y + domain.y*z))] = float(std::sqrt(
+            (x-13.7)*(x-13.7) + (y-11.2)*(y-11.2) + (z-15.1)*(z-15.1)));
+        }
+      }
+    }
+    return v;
+  }
+
+  struct MemorySink : public MeshSink {
+    MemorySink() : closed(false) {}
+    virtual bool Append(const VertVec& v, const NormVec& n,
+                        const IndexVec& t) {
+      vertices.insert(vertices.end(), v.begin(), v.end());
+      normals.insert(normals.end(), n.begin(), n.end());
+      triangles.insert(triangles.end(), t.begin(), t.end());
+      return true;
+    }
+    virtual bool Close() { closed = true; return true; }
+    VertVec vertices;
+    NormVec normals;
+    IndexVec triangles;
+    bool closed;
+  };
+
+  // cuts the volume into bricks of 'size' owned voxels.  'ghost' voxels
+  // are added on both sides, by clamping at the volume's boundary (as TOC
+  // blocks do), or only between bricks (as raster data blocks do).
+  void extract(const std::vector<float>& data, uint64_t size, uint64_t ghost,
+               bool bClampGhost, MeshSink& sink) {
+    std::vector<uint64_t> starts[3];
+    for(size_t a=0; a < 3; ++a) {
+      for(uint64_t s=0; s < domain[a]; s += size) { starts[a].push_back(s); }
+    }
+    iso::Welder welder(domain, starts, sink);
+
+    uint64_t iBrick = 0;
+    for(size_t bz=0; bz < starts[2].size(); ++bz) {
+      for(size_t by=0; by < starts[1].size(); ++by) {
+        for(size_t bx=0; bx < starts[0].size(); ++bx, ++iBrick) {
+          const size_t b[3] = { bx, by, bz };
+          iso::BrickExtent e;
+          UINT64VECTOR3 after;
+          for(size_t a=0; a < 3; ++a) {
+            e.vFirst[a] = starts[a][b[a]];
+            e.vOwned[a] = std::min(size, domain[a] - e.vFirst[a]);
+            const bool bLast = b[a]+1 == starts[a].size();
+            e.vGhost[a] = bClampGhost || b[a] > 0 ? ghost : 0;
+            after[a] = bClampGhost || !bLast ? ghost : 0;
+            e.vVoxels[a] = e.vGhost[a] + e.vOwned[a] + after[a];
+          }
+          std::vector<float> brick(size_t(e.vVoxels.volume()));
+          size_t i = 0;
+          for(uint64_t z=0; z < e.vVoxels.z; ++z) {
+            for(uint64_t y=0; y < e.vVoxels.y; ++y) {
+              for(uint64_t x=0; x < e.vVoxels.x; ++x, ++i) {
+                int64_t p[3] = { int64_t(x), int64_t(y), int64_t(z) };
+                for(size_t a=0; a < 3; ++a) {
+                  p[a] += int64_t(e.vFirst[a]) - int64_t(e.vGhost[a]);
+                  p[a] = std::max<int64_t>(0, std::min<int64_t>(
+                    p[a], int64_t(domain[a])-1));
+                }
+                brick[i] = data[size_t(p[0] + domain.x*(p[1] +
+                                                        domain.y*p[2]))];
+              }
+            }
+          }
+          iso::BrickMesh mesh;
+          iso::March(&brick[0], e, domain, 9.0f, mesh);
+          TS_ASSERT(welder.Add(iBrick, mesh));
+        }
+      }
+    }
+  }
+
+  void single(const std::vector<float>& data, MeshSink& sink) {
+    extract(data, std::max(domain.x, std::max(domain.y, domain.z)), 0,
+            false, sink);
+  }
+
+  // a closed surface without duplicate vertices: every edge belongs to
+  // exactly two triangles, once in each direction.
+  void check_closed(const MemorySink& m) {
+    std::map<std::pair<uint32_t,uint32_t>, int> edges;
+    TS_ASSERT_EQUALS(m.triangles.size() % 3, 0);
+    for(size_t t=0; t+2 < m.triangles.size(); t += 3) {
+      for(size_t i=0; i < 3; ++i) {
+        const uint32_t a = m.triangles[t+i], b = m.triangles[t+(i+1)%3];
+        TS_ASSERT(a < m.vertices.size());
+        if(a == b) continue; // degenerate (vertex at a grid point)
+        ++edges[std::make_pair(a, b)];
+      }
+    }
+    size_t iOpen = 0;
+    for(auto e = edges.cbegin(); e != edges.cend(); ++e) {
+      auto back = edges.find(std::make_pair(e->first.second, e->first.first));
+      if(back == edges.end() || back->second != e->second) { ++iOpen; }
+    }
+    TS_ASSERT_EQUALS(iOpen, 0U);
+  }
+
+  bool less(const FLOATVECTOR3& a, const FLOATVECTOR3& b) {
+    return a.x < b.x || (a.x == b.x && (a.y < b.y ||
+                                        (a.y == b.y && a.z < b.z)));
+  }
+
+  void compare(const MemorySink& whole, const MemorySink& bricked) {
+    TS_ASSERT_EQUALS(whole.vertices.size(), bricked.vertices.size());
+    TS_ASSERT_EQUALS(whole.triangles.size(), bricked.triangles.size());
+    VertVec a(whole.vertices), b(bricked.vertices);
+    std::sort(a.begin(), a.end(), less);
+    std::sort(b.begin(), b.end(), less);
+    TS_ASSERT(a == b);
+    check_closed(bricked);
+  }
+
+  // the sphere as 8 bit data: 'scale' values per voxel, capped at 'cap'.
+  std::vector<uint8_t> sphere8(float scale, float cap) {
+    const std::vector<float> d = sphere();
+    std::vector<uint8_t> v(d.size());
+    for(size_t i=0; i < d.size(); ++i) {
+      v[i] = uint8_t(std::min(d[i] * scale, cap));
+    }
+    return v;
+  }
+
+  // converts the data to a UVF of several bricks and extracts the surface
+  // from that; it must be the one marching the whole volume gives, at the
+  // isovalue the data's type can hold.
+  void extract_uvf(const std::vector<uint8_t>& data, double fIsovalue) {
+    std::string raw;
+    {
+      std::ofstream ofs;
+      raw = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+      ofs.write(reinterpret_cast<const char*>(&data[0]), data.size());
+    }
+    const std::string uvf = raw + ".uvf";
+    clean tmp = cleanup(raw).add(uvf);
+    TS_ASSERT(RAWConverter::ConvertRAWDataset(
+      raw, uvf, "", 0, 8, 1, 1, false, false, false, domain,
+      FLOATVECTOR3(1,1,1), "isosurface", "test", 16, 2, false, false, 0, 0,
+      0));
+
+    MemorySink bricked;
+    {
+      const UVFDataset ds(uvf, 16, false);
+      TS_ASSERT(ds.GetBrickLayout(0, 0).volume() > 1);
+      TS_ASSERT(ExtractIsosurface(ds, 0, fIsovalue, FLOATVECTOR3(1,1,1),
+                                  bricked));
+    }
+
+    iso::BrickExtent e;
+    e.vVoxels = e.vOwned = domain;
+    e.vGhost = e.vFirst = UINT64VECTOR3(0,0,0);
+    iso::BrickMesh mesh;
+    iso::March(&data[0], e, domain, uint8_t(fIsovalue), mesh);
+    // placed as ExtractIsosurface places it
+    const FLOATVECTOR3 vExtent = FLOATVECTOR3(domain) * FLOATVECTOR3(1,1,1);
+    for(size_t v=0; v < mesh.vertices.size(); ++v) {
+      mesh.vertices[v] = (mesh.vertices[v] * FLOATVECTOR3(1,1,1) -
+                          vExtent / 2.0f) / vExtent.maxVal();
+    }
+    MemorySink whole;
+    whole.Append(mesh.vertices, mesh.normals, mesh.triangles);
+    TS_ASSERT(!whole.vertices.empty());
+    compare(whole, bricked);
+  }
+}
+
+class IsosurfaceTests : public CxxTest::TestSuite {
+public:
+  void test_single_brick() {
+    const std::vector<float> data = sphere();
+    MemorySink whole;
+    single(data, whole);
+    TS_ASSERT(!whole.vertices.empty());
+    TS_ASSERT_EQUALS(whole.vertices.size(), whole.normals.size());
+    check_closed(whole);
+    // normals point outwards, along the distance's gradient.
+    for(size_t i=0; i < whole.vertices.size(); ++i) {
+      const FLOATVECTOR3 r = whole.vertices[i] -
+                             FLOATVECTOR3(13.7f, 11.2f, 15.1f);
+      TS_ASSERT_DELTA(r.length(), 9.0f, 0.05f);
+      TS_ASSERT((r ^ whole.normals[i]) > 0.0f);
+    }
+  }
+  void test_welded_seams() {
+    const std::vector<float> data = sphere();
+    MemorySink whole;
+    single(data, whole);
+    for(uint64_t size=4; size <= 16; size *= 2) {
+      MemorySink toc, raster;
+      extract(data, size, 2, true, toc);
+      extract(data, size, 1, false, raster);
+      compare(whole, toc);
+      compare(whole, raster);
+    }
+  }
+  void test_uvf() {
+    // across the bricks' boundaries, through their ghost voxels
+    extract_uvf(sphere8(8.0f, 255.0f), 72.5);
+    // nothing in the data is above 9, which 9.5 is in the data's type
+    extract_uvf(sphere8(1.0f, 9.0f), 9.5);
+  }
+  void test_obj_sink() {
+    const std::vector<float> data = sphere();
+    MemorySink whole;
+    single(data, whole);
+
+    std::ofstream ofs;
+    const std::string fn = mk_tmpfile(ofs, std::ios::out);
+    ofs.close();
+    const std::string obj = fn + ".obj";
+    {
+      OBJGeoConverter conv;
+      std::shared_ptr<MeshSink> sink = conv.CreateSink(obj, "test",
+                                                       FLOATVECTOR4(1,1,1,1));
+      extract(data, 8, 2, true, *sink);
+      TS_ASSERT(sink->Close());
+
+      std::shared_ptr<Mesh> m = conv.ConvertToMesh(obj);
+      TS_ASSERT(m);
+      if(m) {
+        TS_ASSERT_EQUALS(m->GetVertices().size(), whole.vertices.size());
+        TS_ASSERT_EQUALS(m->GetNormals().size(), whole.normals.size());
+        TS_ASSERT_EQUALS(m->GetVertexIndices().size(),
+                         whole.triangles.size());
+      }
+    }
+    remove(fn.c_str());
+    remove(obj.c_str());
+  }
+};
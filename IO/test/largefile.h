@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <algorithm>
 #include <functional>
@@ -10,6 +11,8 @@
 #include "LargeFileC.h"
 #include "LargeFileFD.h"
 #include "LargeFileMMap.h"
+#include "LargeFileURing.h"
+#include "Timer.h"
 
 #include "util-test.h"
 
@@ -504,6 +507,126 @@ namespace {
   }
 }
 
+namespace {
+  // a file whose every 32bit word holds its own index.
+  std::string tmp_counting(size_t words) {
+    std::ofstream ofs;
+    const std::string tmpf = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    std::vector<uint32_t> data(words);
+    for(size_t i=0; i < words; ++i) { data[i] = uint32_t(i); }
+    ofs.write(reinterpret_cast<const char*>(data.data()),
+              data.size()*sizeof(uint32_t));
+    ofs.close();
+    return tmpf;
+  }
+
+  // 'n' reads somewhere in a file of 'words' words, between 'minlen' and
+  // 'maxlen' bytes long, word aligned.
+  std::vector<std::pair<uint64_t, size_t>> random_reads(size_t n, size_t words,
+                                                        size_t minlen,
+                                                        size_t maxlen) {
+    std::vector<std::pair<uint64_t, size_t>> reads;
+    srand(42);
+    for(size_t i=0; i < n; ++i) {
+      const size_t len = (minlen + size_t(rand()) % (maxlen-minlen+1)) & ~3;
+      const size_t word = size_t(rand()) % (words - len/4);
+      reads.push_back(std::make_pair(uint64_t(word)*4, len));
+    }
+    return reads;
+  }
+
+  // lots of hints, some read, some not, some reads never hinted; read in a
+  // different order than hinted.
+  void lf_uring_batch(bool direct) {
+    const size_t words = 4*1024*1024;
+    const std::string tmpf = tmp_counting(words);
+    clean f = cleanup(tmpf);
+    const std::vector<std::pair<uint64_t, size_t>> reads =
+      random_reads(300, words, 4, 2*LargeFileURing::BufferSize);
+
+    const uint64_t header = 64;
+    LargeFileURing lf(tmpf, std::ios::in, 0);
+    lf.direct(direct);
+    lf.open(std::ios::in);
+    for(size_t i=0; i < reads.size(); i += 2) {
+      lf.enqueue(reads[i].first, reads[i].second);
+    }
+    lf.submit();
+    lf.poll();
+    for(size_t j=0; j < reads.size(); ++j) {
+      const size_t i = (j*7) % reads.size();
+      std::shared_ptr<const void> mem = lf.rd(reads[i].first, reads[i].second);
+      TS_ASSERT_EQUALS(lf.gcount(), reads[i].second);
+      const uint32_t* data = static_cast<const uint32_t*>(mem.get());
+      const uint32_t first = uint32_t(reads[i].first / 4);
+      for(size_t w=0; w < reads[i].second/4; ++w) {
+        if(data[w] != first + w) {
+          TS_FAIL("wrong data");
+          break;
+        }
+      }
+    }
+    lf.close();
+
+    // the header offset applies to hinted reads, too.
+    LargeFileURing hdr(tmpf, std::ios::in, header);
+    hdr.enqueue(0, 4096);
+    std::shared_ptr<const void> mem = hdr.rd(0, 4096);
+    TS_ASSERT_EQUALS(static_cast<const uint32_t*>(mem.get())[0],
+                     uint32_t(header/4));
+    // data stays valid after the file is gone
+    hdr.close();
+    TS_ASSERT_EQUALS(static_cast<const uint32_t*>(mem.get())[1023],
+                     uint32_t(header/4 + 1023));
+  }
+
+  template<class T> double bench_backend(const std::string& fn,
+                                         const std::vector<std::pair<uint64_t, size_t>>& reads,
+                                         bool hint) {
+    T lf(fn, std::ios::in);
+    Timer t; t.Start();
+    size_t bytes = 0;
+    if(hint) {
+      for(size_t i=0; i < reads.size(); ++i) {
+        lf.enqueue(reads[i].first, reads[i].second);
+      }
+    }
+    for(size_t i=0; i < reads.size(); ++i) {
+      std::shared_ptr<const void> mem = lf.rd(reads[i].first, reads[i].second);
+      bytes += reads[i].second;
+    }
+    const double ms = t.Elapsed();
+    return (bytes / (1024.0*1024.0)) / (ms / 1000.0);
+  }
+
+  // not really a test: reports throughput of random brick sized reads (32^3
+  // to 64^3 16bit voxels) for each of the backends.  The file was just
+  // written, so it is probably in the page cache and this mostly measures
+  // the per-read overhead.
+  void lf_bench() {
+    const size_t words = 64*1024*1024;
+    const std::string tmpf = tmp_counting(words);
+    clean f = cleanup(tmpf);
+    const std::vector<std::pair<uint64_t, size_t>> reads =
+      random_reads(512, words, 32*32*32*2, 64*64*64*2);
+
+    fprintf(stderr, "\nC:              %8.2f MB/s",
+            bench_backend<LargeFileC>(tmpf, reads, false));
+    fprintf(stderr, "\nFD:             %8.2f MB/s",
+            bench_backend<LargeFileFD>(tmpf, reads, false));
+    fprintf(stderr, "\nMMap:           %8.2f MB/s",
+            bench_backend<LargeFileMMap>(tmpf, reads, false));
+    fprintf(stderr, "\nAIO:            %8.2f MB/s",
+            bench_backend<LargeFileAIO>(tmpf, reads, false));
+    fprintf(stderr, "\nAIO, hinted:    %8.2f MB/s",
+            bench_backend<LargeFileAIO>(tmpf, reads, true));
+    fprintf(stderr, "\nio_uring:       %8.2f MB/s",
+            bench_backend<LargeFileURing>(tmpf, reads, false));
+    fprintf(stderr, "\nio_uring, hinted: %6.2f MB/s",
+            bench_backend<LargeFileURing>(tmpf, reads, true));
+  }
+}
+
 class LargeFileTests : public CxxTest::TestSuite {
 public:
   void test_truncate() { lf_truncate(); }
@@ -560,4 +683,21 @@ public:
   void test_c_truncate() { lf_generic_truncate<LargeFileC>(); }
   void test_c_wroffset() { lf_generic_wroffset<LargeFileC>(); }
   void test_c_rdoffset() { lf_generic_rdoffset<LargeFileC>(); }
+
+  void test_uring_open() { lf_generic_open<LargeFileURing>(); }
+  void test_uring_read() { lf_generic_read<LargeFileURing>(); }
+  void test_uring_write() { lf_generic_write<LargeFileURing>(); }
+  void test_uring_write_only() { lf_generic_write_only<LargeFileURing>(); }
+  void test_uring_header() { lf_generic_header<LargeFileURing>(); }
+  void test_uring_large_header() { lf_generic_large_header<LargeFileURing>(); }
+  void test_uring_enqueue() { lf_generic_enqueue<LargeFileURing>(); }
+  void test_uring_reopen() { lf_generic_reopen<LargeFileURing>(); }
+  void test_uring_rw_single() { lf_generic_rw_single<LargeFileURing>(); }
+  void test_uring_truncate() { lf_generic_truncate<LargeFileURing>(); }
+  void test_uring_wroffset() { lf_generic_wroffset<LargeFileURing>(); }
+  void test_uring_rdoffset() { lf_generic_rdoffset<LargeFileURing>(); }
+  void test_uring_batch() { lf_uring_batch(false); }
+  void test_uring_batch_direct() { lf_uring_batch(true); }
+
+  void test_bench() { lf_bench(); }
 };
@@ -0,0 +1,182 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "Basics/LargeRAWFile.h"
+#include "Basics/ValueOccupancy.h"
+#include "UVF/MaxMinDataBlock.h"
+#include "UVF/ExtendedOctree/ExtendedOctreeConverter.h"
+#include "util-test.h"
+
+using namespace tuvok;
+
+namespace {
+  ValueOccupancy occupancy(const std::vector<double>& values) {
+    ValueOccupancy o;
+    for(size_t i=0; i < values.size(); ++i) {
+      o.fMin = std::min(o.fMin, values[i]);
+      o.fMax = std::max(o.fMax, values[i]);
+    }
+    const ValueOccupancy::Binning bin(o.fMin, o.fMax);
+    o.iBins = 0;
+    for(size_t i=0; i < values.size(); ++i) {
+      o.iBins |= uint64_t(1) << bin(values[i]);
+    }
+    return o;
+  }
+
+  ValueRanges range(double lo, double hi) {
+    return ValueRanges(1, std::make_pair(lo, hi));
+  }
+
+  // a range around any value of a brick must hit it, however narrow.
+  void tconservative() {
+    std::mt19937 gen(42);
+    for(size_t t=0; t < 200; ++t) {
+      std::uniform_real_distribution<double> bounds(-1e4, 1e4);
+      double lo = bounds(gen), hi = bounds(gen);
+      if(lo > hi) { std::swap(lo, hi); }
+      std::uniform_real_distribution<double> dist(lo, hi);
+      std::vector<double> values(1 + t % 17);
+      for(size_t i=0; i < values.size(); ++i) {
+        values[i] = t % 3 == 0 ? std::floor(dist(gen)) : dist(gen);
+      }
+      const ValueOccupancy o = occupancy(values);
+      for(size_t i=0; i < values.size(); ++i) {
+        TS_ASSERT(o.Intersects(range(values[i], values[i])));
+        TS_ASSERT(o.Intersects(range(values[i] - 0.5, values[i])));
+        ValueRanges r;
+        r.push_back(std::make_pair(lo - 2.0, lo - 1.0));
+        r.push_back(std::make_pair(values[i], std::nextafter(values[i], 1e5)));
+        r.push_back(std::make_pair(hi + 1.0, hi + 2.0));
+        TS_ASSERT(o.Intersects(r));
+      }
+      TS_ASSERT(!o.Intersects(range(hi + 1.0, hi + 2.0)));
+      TS_ASSERT(!o.Intersects(ValueRanges()));
+    }
+  }
+
+  // air and a little bone: min/max says any TF shows it, occupancy knows
+  // a soft tissue TF does not.
+  void tsparse() {
+    std::vector<double> values(1000, 0.0);
+    values[17] = values[512] = 1000.0;
+    const ValueOccupancy o = occupancy(values);
+    TS_ASSERT_EQUALS(o.iBins, (uint64_t(1) << 63) | 1);
+    TS_ASSERT(!o.Intersects(range(200, 600)));
+    TS_ASSERT(o.Intersects(range(990, 1010)));
+    TS_ASSERT(o.Intersects(range(-10, 5)));
+    ValueRanges two;
+    two.push_back(std::make_pair(100.0, 200.0));
+    two.push_back(std::make_pair(300.0, 400.0));
+    TS_ASSERT(!o.Intersects(two));
+    two.push_back(std::make_pair(900.0, 1000.0));
+    TS_ASSERT(o.Intersects(two));
+    // without bins, we are back to min/max.
+    TS_ASSERT(ValueOccupancy(o.fMin, o.fMax).Intersects(range(200, 600)));
+    // a constant brick occupies its one value only.
+    const ValueOccupancy c = occupancy(std::vector<double>(8, 5.0));
+    TS_ASSERT(c.Intersects(range(5, 5)));
+    TS_ASSERT(!c.Intersects(range(5.5, 6)));
+  }
+
+  // the converter records the bins of every brick, for every LOD.
+  void tconvert() {
+    const size_t n = 70;
+    std::vector<uint16_t> data(n*n*n, 0);
+    for(size_t i=0; i < data.size(); i += 97) { data[i] = 1000; }
+    std::ofstream ofs;
+    const std::string raw = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&data[0]),
+              data.size() * sizeof(uint16_t));
+    ofs.close();
+    const char* uvf = ".occupancy.uvf";
+    clean rawtmp = cleanup(raw);
+    clean uvftmp = cleanup(uvf);
+
+    ExtendedOctreeConverter conv(UINT64VECTOR3(32,32,32), 2, 64*1024*1024,
+                                 Controller::Debug::Out());
+    BrickStatVec stats;
+    TS_ASSERT(conv.Convert(raw, 0, ExtendedOctree::CT_UINT16, 1,
+                           UINT64VECTOR3(n,n,n), DOUBLEVECTOR3(1,1,1), uvf, 0,
+                           &stats, CT_NONE, 1, false, false, LT_SCANLINE));
+    TS_ASSERT(stats.size() > 27);
+    size_t iFull = 0;
+    for(size_t i=0; i < stats.size(); ++i) {
+      const ValueOccupancy o(stats[i].minScalar, stats[i].maxScalar,
+                             stats[i].occupancy);
+      TS_ASSERT_DIFFERS(o.iBins, 0U);
+      TS_ASSERT_DIFFERS(o.iBins, ValueOccupancy::All);
+      if(o.fMin == 0.0 && o.fMax == 1000.0) {
+        ++iFull;
+        TS_ASSERT(!o.Intersects(range(200, 600)));
+      }
+      TS_ASSERT(o.Intersects(range(o.fMin, o.fMin)));
+      TS_ASSERT(o.Intersects(range(o.fMax, o.fMax)));
+    }
+    // the finest level's bricks all hold both; the averaged ones may not.
+    TS_ASSERT(iFull >= 27);
+  }
+
+  // exposes the block's I/O.
+  struct OpenMaxMin : public MaxMinDataBlock {
+    OpenMaxMin() : MaxMinDataBlock(1) {}
+    uint64_t Write(LargeRAWFile_ptr f, uint64_t off, bool last) {
+      return CopyToFile(f, off, false, last);
+    }
+    uint64_t Size() const { return GetOffsetToNextBlock(); }
+  };
+
+  // the bins survive a round trip; blocks written without them read as
+  // 'all bins occupied'.
+  void tmaxmin_block() {
+    std::ofstream ofs;
+    const std::string fn = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    ofs.close();
+    clean tmp = cleanup(fn);
+
+    BrickStatVec stats;
+    stats.push_back(BrickStats<double>(0.0, 1000.0, 0x8000000000000001ULL));
+    stats.push_back(BrickStats<double>(3.0, 4.0, 0x2ULL));
+    OpenMaxMin with;
+    with.SetDataFromFlatVector(stats, 1);
+    OpenMaxMin without;
+    without.StartNewValue();
+    std::vector<DOUBLEVECTOR4> mm(1, DOUBLEVECTOR4(1.0, 2.0, 0.0, 0.0));
+    without.MergeData(mm);
+
+    LargeRAWFile_ptr f(new LargeRAWFile(fn));
+    TS_ASSERT(f->Create());
+    const uint64_t iFirst = with.Write(f, 0, false);
+    TS_ASSERT_EQUALS(iFirst, with.Size());
+    const uint64_t iSecond = without.Write(f, iFirst, false);
+    TS_ASSERT_EQUALS(iSecond, without.Size());
+    const uint64_t iThird = with.Write(f, iFirst + iSecond, true);
+    TS_ASSERT_EQUALS(iThird, with.Size());
+    f->Close();
+
+    TS_ASSERT(f->Open(false));
+    MaxMinDataBlock a(f, 0, false), b(f, iFirst, false),
+                    c(f, iFirst + iSecond, false);
+    TS_ASSERT(a.HasOccupancy());
+    TS_ASSERT_EQUALS(a.GetOccupancy(0), 0x8000000000000001ULL);
+    TS_ASSERT_EQUALS(a.GetOccupancy(1), 0x2ULL);
+    TS_ASSERT_EQUALS(a.GetValue(1).maxScalar, 4.0);
+    TS_ASSERT(!b.HasOccupancy());
+    TS_ASSERT_EQUALS(b.GetOccupancy(0), ValueOccupancy::All);
+    TS_ASSERT_EQUALS(b.GetValue(0).minScalar, 1.0);
+    TS_ASSERT(c.HasOccupancy());
+    TS_ASSERT_EQUALS(c.GetOccupancy(1), 0x2ULL);
+    f->Close();
+  }
+}
+
+class ValueOccupancyTests : public CxxTest::TestSuite {
+public:
+  void test_conservative() { tconservative(); }
+  void test_sparse() { tsparse(); }
+  void test_convert() { tconvert(); }
+  void test_maxmin_block() { tmaxmin_block(); }
+};
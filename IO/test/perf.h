@@ -0,0 +1,155 @@
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "Basics/PerfRegistry.h"
+
+using namespace tuvok;
+
+namespace {
+  const PerfRegistry::Stats* find(const std::vector<PerfRegistry::Stats>& s,
+                                  const std::string& name) {
+    for(size_t i=0; i < s.size(); ++i) {
+      if(s[i].name == name) { return &s[i]; }
+    }
+    return NULL;
+  }
+
+  void tbuiltin() {
+    PerfRegistry perf;
+    TS_ASSERT_EQUALS(perf.Count(), size_t(PERF_END));
+    TS_ASSERT_EQUALS(perf.Find("PERF_DY_LOAD_BRICK"),
+                     PerfRegistry::ID(PERF_DY_LOAD_BRICK));
+    TS_ASSERT_EQUALS(perf.Units(PERF_POOL_UPLOADED_MEM), "bytes");
+    TS_ASSERT_EQUALS(perf.Find("no.such.counter"), PerfRegistry::Invalid);
+
+    const PerfRegistry::ID id = perf.Register("test.new", "milliseconds");
+    TS_ASSERT_EQUALS(id, PerfRegistry::ID(PERF_END));
+    TS_ASSERT_EQUALS(perf.Register("test.new", "milliseconds"), id);
+    TS_ASSERT_EQUALS(perf.Name(id), "test.new");
+  }
+
+  // queries report what happened since the last query of the same counter.
+  void tquery() {
+    PerfRegistry perf;
+    perf.Add(PERF_EO_BRICKS, 1.0);
+    perf.Add(PERF_EO_BRICKS, 2.0);
+    TS_ASSERT_EQUALS(perf.Query(PERF_EO_BRICKS), 3.0);
+    TS_ASSERT_EQUALS(perf.Query(PERF_EO_BRICKS), 0.0);
+    perf.Add(PERF_EO_BRICKS, 4.0);
+    TS_ASSERT_EQUALS(perf.Query(PERF_EO_BRICKS), 4.0);
+    TS_ASSERT_EQUALS(perf.Query(PERF_EO_DISK_READ), 0.0);
+  }
+
+  // many threads hammering the same counter must not lose any samples.
+  void tconcurrent() {
+    PerfRegistry perf;
+    const PerfRegistry::ID id = perf.Register("test.concurrent", "counter");
+    const int64_t n = 400000;
+#pragma omp parallel for
+    for(int64_t i=0; i < n; ++i) {
+      perf.Add(id, 1.0);
+      perf.Add(PERF_EO_BRICKS, 2.0);
+    }
+    TS_ASSERT_EQUALS(perf.Query(id), double(n));
+    TS_ASSERT_EQUALS(perf.Query(PERF_EO_BRICKS), 2.0*n);
+
+    const std::vector<PerfRegistry::Stats> s = perf.Snapshot(false);
+    TS_ASSERT(find(s, "test.concurrent") != NULL);
+    if(find(s, "test.concurrent")) {
+      TS_ASSERT_EQUALS(find(s, "test.concurrent")->count, uint64_t(n));
+    }
+  }
+
+  void tpercentiles() {
+    PerfRegistry perf;
+    const PerfRegistry::ID id = perf.Register("test.latency", "milliseconds");
+    for(size_t i=1; i <= 1000; ++i) { perf.Add(id, double(i)); }
+
+    std::vector<PerfRegistry::Stats> s = perf.Snapshot(true);
+    TS_ASSERT_EQUALS(s.size(), 1u);
+    const PerfRegistry::Stats* lat = find(s, "test.latency");
+    TS_ASSERT(lat != NULL);
+    if(!lat) { return; }
+    TS_ASSERT_EQUALS(lat->count, 1000u);
+    TS_ASSERT_EQUALS(lat->sum, 500500.0);
+    TS_ASSERT_DELTA(lat->mean, 500.5, 1e-9);
+    TS_ASSERT_DELTA(lat->p50, 500.0, 500.0*0.065);
+    TS_ASSERT_DELTA(lat->p99, 990.0, 990.0*0.065);
+    TS_ASSERT_EQUALS(lat->max, 1000.0);
+
+    // a new frame only sees the new samples
+    TS_ASSERT(perf.Snapshot(true).empty());
+    perf.Add(id, 0.5);
+    perf.Add(id, 0.5);
+    s = perf.Snapshot(true);
+    TS_ASSERT_EQUALS(s.size(), 1u);
+    if(s.size() == 1) {
+      TS_ASSERT_EQUALS(s[0].count, 2u);
+      TS_ASSERT_DELTA(s[0].p99, 0.5, 0.5*0.065);
+      TS_ASSERT(s[0].max <= 0.5*1.07);
+    }
+  }
+
+  // threads come and go; what they recorded stays.
+  void tthread_exit() {
+    PerfRegistry perf;
+    const PerfRegistry::ID id = perf.Register("test.exit", "milliseconds");
+    perf.Add(id, 1.0);
+    for(size_t round=0; round < 4; ++round) {
+      std::vector<std::thread> threads;
+      for(size_t t=0; t < 8; ++t) {
+        threads.push_back(std::thread([&perf, id, t]() {
+          for(size_t i=0; i < 1000; ++i) { perf.Add(id, double(t+2)); }
+        }));
+      }
+      for(size_t t=0; t < threads.size(); ++t) { threads[t].join(); }
+    }
+    // (2+3+...+9) per round
+    TS_ASSERT_EQUALS(perf.Query(id), 1.0 + 4*1000*44.0);
+    const std::vector<PerfRegistry::Stats> s = perf.Snapshot(true);
+    TS_ASSERT(find(s, "test.exit") != NULL);
+    if(find(s, "test.exit")) {
+      TS_ASSERT_EQUALS(find(s, "test.exit")->count, 1u + 4*8*1000);
+      TS_ASSERT_EQUALS(find(s, "test.exit")->max, 9.0);
+    }
+  }
+
+  void texport() {
+    PerfRegistry perf;
+    const PerfRegistry::ID id = perf.Register("test.\"export\"", "bytes");
+    perf.Add(id, 42.0);
+    perf.Add(PERF_DY_LOAD_BRICK, 3.0);
+
+    const std::string json = perf.JSON(false);
+    TS_ASSERT(json.find("\"test.\\\"export\\\"\": {\"units\": \"bytes\", "
+                        "\"count\": 1, \"sum\": 42") != std::string::npos);
+    TS_ASSERT(json.find("\"PERF_DY_LOAD_BRICK\"") != std::string::npos);
+    TS_ASSERT(json.find("PERF_EO_BRICKS") == std::string::npos);
+
+    std::istringstream csv(perf.CSV(true));
+    std::string line;
+    std::vector<std::string> lines;
+    while(std::getline(csv, line)) { lines.push_back(line); }
+    TS_ASSERT_EQUALS(lines.size(), 3u);
+    if(lines.size() == 3) {
+      TS_ASSERT_EQUALS(lines[0], "name,units,count,sum,mean,p50,p99,max");
+      TS_ASSERT_EQUALS(lines[1].find("PERF_DY_LOAD_BRICK,milliseconds,1,3,3,"),
+                       0u);
+    }
+    TS_ASSERT_EQUALS(perf.CSV(false), "name,units,count,sum,mean,p50,p99,max\n");
+  }
+}
+
+class PerfRegistryTests : public CxxTest::TestSuite {
+public:
+  void test_builtin() { tbuiltin(); }
+  void test_query() { tquery(); }
+  void test_concurrent() { tconcurrent(); }
+  void test_percentiles() { tpercentiles(); }
+  void test_thread_exit() { tthread_exit(); }
+  void test_export() { texport(); }
+};
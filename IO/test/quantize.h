@@ -2,7 +2,9 @@
 #include <cstdlib>
 #include <time.h>
 #include <algorithm>
+#include <fstream>
 #include <functional>
+#include <iterator>
 #include <vector>
 
 #include <cxxtest/TestSuite.h>
@@ -11,6 +13,8 @@
 #include "Controller/Controller.h"
 #include "UVF/Histogram1DDataBlock.h"
 #include "../Quantize.h"
+#include "../QuantizingRAWFile.h"
+#include "../RAWConverter.h"
 
 #include "util-test.h"
 
@@ -264,6 +268,136 @@ void verify_8b_type() {
   }
 }
 
+// the streamed conversion must produce exactly what Quantize writes, no matter
+// in which order the data are read.
+template<typename T, typename U>
+void verify_stream(T mean, T stddev, bool bSwap) {
+  const size_t X = 24, Y = 20, Z = 30;
+  const size_t N = X*Y*Z;
+  std::string fn, swapfn, outfn;
+  {
+    std::ofstream dataf;
+    fn = mk_tmpfile(dataf, std::ios::out | std::ios::binary);
+    gen_normal<T>(dataf, N*sizeof(T), mean, stddev);
+    dataf.close();
+    outfn = mk_tmpfile(dataf, std::ios::out | std::ios::binary);
+    dataf.close();
+  }
+  std::vector<T> data(N);
+  {
+    std::ifstream ifs(fn.c_str(), std::ios::in | std::ios::binary);
+    ifs.read(reinterpret_cast<char*>(&data[0]), N*sizeof(T));
+  }
+  if(bSwap) {
+    std::ofstream dataf;
+    swapfn = mk_tmpfile(dataf, std::ios::out | std::ios::binary);
+    for(size_t i=0; i < N; ++i) {
+      const T v = EndianConvert::Swap<T>(data[i]);
+      dataf.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+  }
+  clean fclean = cleanup(fn).add(outfn).add(swapfn);
+
+  // the classic way: quantize into a file
+  Histogram1DDataBlock hist1d;
+  {
+    BStreamDescriptor bsd;
+    bsd.elements = N;
+    bsd.components = 1;
+    bsd.width = sizeof(T);
+    bsd.is_signed = ctti<T>::is_signed;
+    bsd.fp = false;
+    bsd.big_endian = EndianConvert::IsBigEndian();
+    bsd.timesteps = 1;
+    LargeRAWFile input(fn); input.Open(false);
+    if(!Quantize<T,U>(input, bsd, outfn, &hist1d)) { outfn = fn; }
+  }
+  std::vector<U> expected(N);
+  {
+    std::ifstream ifs(outfn.c_str(), std::ios::in | std::ios::binary);
+    ifs.read(reinterpret_cast<char*>(&expected[0]), N*sizeof(U));
+  }
+
+  // ... and streamed
+  const std::string infn = bSwap ? swapfn : fn;
+  std::vector<uint64_t> aHist(sizeof(U) == 1 ? 256 : 4096, 0);
+  std::pair<T,T> minmax;
+  {
+    LargeRAWFile input(infn); input.Open(false);
+    minmax = SwappedMinMax<T>(input, bSwap, N, aHist);
+  }
+  TS_ASSERT_EQUALS(minmax.first, *std::min_element(data.begin(), data.end()));
+  TS_ASSERT_EQUALS(minmax.second, *std::max_element(data.begin(), data.end()));
+  const LinearQuantizer<T,U> q(minmax, aHist.size());
+  QuantizingRAWFile<T,U> stream(LargeRAWFile_ptr(new LargeRAWFile(infn)),
+                                bSwap, q, X*Y, N, 4);
+  TS_ASSERT(stream.Open(false));
+  TS_ASSERT_EQUALS(stream.GetCurrentSize(), N*sizeof(U));
+
+  // read scanlines of overlapping slabs, as the bricker does
+  std::vector<U> line(X);
+  for(size_t z0=0; z0 < Z; z0 += 5) {
+    for(size_t z=(z0 > 0 ? z0-2 : 0); z < std::min(Z, z0+7); ++z) {
+      for(size_t y=0; y < Y; ++y) {
+        stream.SeekPos((z*X*Y + y*X)*sizeof(U));
+        TS_ASSERT_EQUALS(stream.ReadRAW(reinterpret_cast<unsigned char*>(
+                                          &line[0]), X*sizeof(U)),
+                         X*sizeof(U));
+        TS_ASSERT(std::equal(line.begin(), line.end(),
+                             expected.begin() + z*X*Y + y*X));
+      }
+    }
+  }
+  std::vector<U> all(N);
+  stream.SeekStart();
+  TS_ASSERT_EQUALS(stream.ReadRAW(reinterpret_cast<unsigned char*>(&all[0]),
+                                  N*sizeof(U)), N*sizeof(U));
+  TS_ASSERT(all == expected);
+  TS_ASSERT_EQUALS(stream.ReadRAWAt(reinterpret_cast<unsigned char*>(&all[0]),
+                                    3*sizeof(U), 7*sizeof(U)), 3*sizeof(U));
+  TS_ASSERT(std::equal(all.begin(), all.begin()+3, expected.begin()+7));
+
+  if(q.fits()) {
+    // Quantize leaves the histogram to be computed later; it just counts.
+    TS_ASSERT(hist1d.GetHistogram().empty());
+    std::vector<uint64_t> counts(aHist.size(), 0);
+    for(size_t i=0; i < N; ++i) { ++counts[size_t(data[i])]; }
+    TS_ASSERT(aHist == counts);
+  } else {
+    TS_ASSERT(stream.Histogram() == hist1d.GetHistogram());
+  }
+}
+
+static std::vector<char> slurp(const std::string& fn) {
+  std::ifstream ifs(fn.c_str(), std::ios::in | std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(ifs),
+                           std::istreambuf_iterator<char>());
+}
+
+// a volume converted while streaming gives the very UVF file which the
+// intermediate files give.
+template<typename T>
+void verify_stream_uvf(T mean, T stddev, bool bSwap, bool b8Bit) {
+  const UINT64VECTOR3 size(40, 30, 70);
+  std::string fn;
+  {
+    std::ofstream dataf;
+    fn = mk_tmpfile(dataf, std::ios::out | std::ios::binary);
+    gen_normal<T>(dataf, size.volume()*sizeof(T), mean, stddev);
+  }
+  const std::string uvf[2] = { ".quantize-files.uvf", ".quantize-stream.uvf" };
+  clean fclean = cleanup(fn).add(uvf[0]).add(uvf[1]);
+  for(size_t i=0; i < 2; ++i) {
+    TS_ASSERT(RAWConverter::ConvertRAWDataset(
+      fn, uvf[i], "", 0, sizeof(T)*8, 1, 1, bSwap, ctti<T>::is_signed,
+      false, size, FLOATVECTOR3(1,1,1), "quantize", "test", 32, 2, false,
+      false, 1, 1, 0, NULL, b8Bit, i == 1));
+  }
+  const std::vector<char> files = slurp(uvf[0]);
+  TS_ASSERT(!files.empty());
+  TS_ASSERT(slurp(uvf[1]) == files);
+}
+
 class QuantizeTests : public CxxTest::TestSuite {
 public:
   void test_byte() { verify_type<tbyte>(); }
@@ -281,4 +415,27 @@ public:
   void test_8b_ushort() { verify_8b_type<unsigned short>(); }
   void test_8b_int() { verify_8b_type<int>(); }
   void test_8b_uint() { verify_8b_type<unsigned int>(); }
+
+  void test_stream_short() {
+    verify_stream<short, unsigned short>(0, 8000, false);
+    verify_stream<short, unsigned short>(0, 8000, true);
+  }
+  void test_stream_ushort_fits() {
+    verify_stream<unsigned short, unsigned short>(2000, 300, true);
+  }
+  void test_stream_uint() {
+    verify_stream<uint32_t, unsigned short>(1u << 24, 1u << 22, true);
+  }
+  void test_stream_int64() {
+    verify_stream<int64_t, unsigned short>(0, int64_t(1) << 40, true);
+  }
+  void test_stream_8b() {
+    verify_stream<int32_t, unsigned char>(0, 100000, true);
+  }
+  void test_stream_uvf() {
+    verify_stream_uvf<short>(0, 8000, true, false);
+    verify_stream_uvf<unsigned short>(2000, 300, false, false);
+    verify_stream_uvf<uint32_t>(1u << 24, 1u << 22, true, false);
+    verify_stream_uvf<int32_t>(0, 100000, false, true);
+  }
 };
@@ -1,6 +1,7 @@
 #include <array>
 #include <cstdint>
 #include <fstream>
+#include <iterator>
 #include <cxxtest/TestSuite.h>
 #include "Basics/SysTools.h"
 #include "Controller/Controller.h"
@@ -415,6 +416,171 @@ void tminmax_dynamic() {
   TS_ASSERT_DELTA(mm.maxScalar, 63.0, 0.001);
 }
 
+static std::vector<char> slurp(const char* fn) {
+  std::ifstream ifs(fn, std::ios::in | std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(ifs),
+                           std::istreambuf_iterator<char>());
+}
+
+// every precomputed min/max must be what we would compute dynamically.
+static void verify_precomputed(const DynamicBrickingDS& pre,
+                               const DynamicBrickingDS& dyn) {
+  TS_ASSERT_EQUALS(pre.GetTotalBrickCount(), dyn.GetTotalBrickCount());
+  for(auto b=dyn.BricksBegin(); b != dyn.BricksEnd(); ++b) {
+    const MinMaxBlock p = pre.MaxMinForKey(b->first);
+    const MinMaxBlock d = dyn.MaxMinForKey(b->first);
+    TS_ASSERT_EQUALS(p.minScalar, d.minScalar);
+    TS_ASSERT_EQUALS(p.maxScalar, d.maxScalar);
+    TS_ASSERT_EQUALS(p.minGradient, d.minGradient);
+    TS_ASSERT_EQUALS(p.maxGradient, d.maxGradient);
+  }
+}
+
+// precomputed min/maxes go to a sidecar file, which is reused as long as it
+// is intact and matches the data.
+void tminmax_precompute() {
+  std::shared_ptr<UVFDataset> ds = mk8x8testdata();
+  const char* sidecar = ".16x8x16-out.uvf.cached";
+  std::remove(sidecar);
+  clean tmp = cleanup(sidecar);
+  const std::array<size_t,3> bsize = {{16,8,16}};
+  DynamicBrickingDS dyn(ds, bsize, cacheBytes, DynamicBrickingDS::MM_DYNAMIC);
+  {
+    DynamicBrickingDS cold(ds, bsize, cacheBytes,
+                           DynamicBrickingDS::MM_PRECOMPUTE);
+    verify_precomputed(cold, dyn);
+  }
+  TS_ASSERT(SysTools::FileExists(sidecar));
+  const std::vector<char> saved = slurp(sidecar);
+  {
+    DynamicBrickingDS warm(ds, bsize, cacheBytes,
+                           DynamicBrickingDS::MM_PRECOMPUTE);
+    verify_precomputed(warm, dyn);
+  }
+  TS_ASSERT(slurp(sidecar) == saved);
+
+  // a damaged file gets rebuilt.
+  {
+    std::fstream fs(sidecar, std::ios::in | std::ios::out | std::ios::binary);
+    fs.seekp(-1, std::ios::end);
+    fs.put(saved.back() ^ 0x42);
+  }
+  {
+    DynamicBrickingDS damaged(ds, bsize, cacheBytes,
+                              DynamicBrickingDS::MM_PRECOMPUTE);
+    verify_precomputed(damaged, dyn);
+  }
+  TS_ASSERT(slurp(sidecar) == saved);
+
+  // so does one which belongs to a different version of the data.  The
+  // source file's size is recorded 16 bytes into the header.
+  {
+    std::fstream fs(sidecar, std::ios::in | std::ios::out | std::ios::binary);
+    const uint64_t size = 42;
+    fs.seekp(16);
+    fs.write(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+  }
+  {
+    DynamicBrickingDS stale(ds, bsize, cacheBytes,
+                            DynamicBrickingDS::MM_PRECOMPUTE);
+    verify_precomputed(stale, dyn);
+  }
+  TS_ASSERT(slurp(sidecar) == saved);
+
+  // ... and one in the old, unversioned format: a count, then the records.
+  {
+    std::ofstream ofs(sidecar, std::ios::trunc | std::ios::binary);
+    const uint64_t rec[4] = { 1, 0, 0, 0 };
+    const double mm[2] = { -1000.0, 1000.0 };
+    ofs.write(reinterpret_cast<const char*>(rec), sizeof(rec));
+    ofs.write(reinterpret_cast<const char*>(mm), sizeof(mm));
+  }
+  {
+    DynamicBrickingDS legacy(ds, bsize, cacheBytes,
+                             DynamicBrickingDS::MM_PRECOMPUTE);
+    verify_precomputed(legacy, dyn);
+  }
+  TS_ASSERT(slurp(sidecar) == saved);
+}
+
+// a view must describe exactly the data GetBrick gives us.
+static void verify_views(DynamicBrickingDS& dynamic) {
+  for(auto b=dynamic.BricksBegin(); b != dynamic.BricksEnd(); ++b) {
+    std::vector<uint8_t> dense, copied;
+    BrickView<uint8_t> view;
+    TS_ASSERT(dynamic.GetBrick(b->first, dense));
+    TS_ASSERT(dynamic.GetBrickView(b->first, view));
+    const UINTVECTOR3 n = dynamic.GetBrickVoxelCounts(b->first);
+    TS_ASSERT_EQUALS(view.size[0], n[0]);
+    TS_ASSERT_EQUALS(view.size[1], n[1]);
+    TS_ASSERT_EQUALS(view.size[2], n[2]);
+    view.copy(copied);
+    TS_ASSERT(copied == dense);
+    // ... and so does walking it by hand.
+    for(size_t z=0; z < n[2]; ++z) {
+      for(size_t y=0; y < n[1]; ++y) {
+        for(size_t x=0; x < n[0]; ++x) {
+          TS_ASSERT_EQUALS(
+            view.data.get()[(z*view.imageHeight + y)*view.rowLength + x],
+            dense[(z*n[1] + y)*n[0] + x]
+          );
+        }
+      }
+    }
+  }
+}
+
+void tbrick_view() {
+  std::shared_ptr<UVFDataset> ds = mk8x8testdata();
+  {
+    DynamicBrickingDS dynamic(ds, {{6,16,16}}, cacheBytes);
+    verify_views(dynamic);
+  }
+  {
+    DynamicBrickingDS nocache(ds, {{6,16,16}}, 0);
+    verify_views(nocache);
+  }
+  // a view keeps its data alive, even after the cache has dropped it.
+  DynamicBrickingDS dynamic(ds, {{6,16,16}}, cacheBytes);
+  BrickView<uint8_t> view;
+  std::vector<uint8_t> before, after;
+  TS_ASSERT(dynamic.GetBrickView(BrickKey(0,0,1), view));
+  view.copy(before);
+  dynamic.SetCacheSize(0);
+  view.copy(after);
+  TS_ASSERT(before == after);
+}
+
+// views of a 4x3x2 two-component block: whole, whole rows, partial rows.
+void tbrick_view_copy() {
+  std::shared_ptr<std::vector<uint16_t>> mem(new std::vector<uint16_t>(48));
+  for(size_t i=0; i < mem->size(); ++i) { (*mem)[i] = uint16_t(i); }
+  const size_t sizes[3][3] = {{4,3,2}, {4,2,2}, {2,2,2}};
+  const size_t offsets[3] = {0, 1, 1};
+  for(size_t c=0; c < 3; ++c) {
+    BrickView<uint16_t> view;
+    view.rowLength = 4;
+    view.imageHeight = 3;
+    view.components = 2;
+    for(size_t i=0; i < 3; ++i) { view.size[i] = sizes[c][i]; }
+    const size_t first = (c == 1 ? offsets[c]*4 : offsets[c]) * 2;
+    view.data = std::shared_ptr<const uint16_t>(mem, mem->data() + first);
+    TS_ASSERT_EQUALS(view.dense(), c == 0);
+
+    std::vector<uint16_t> copied;
+    view.copy(copied);
+    TS_ASSERT_EQUALS(copied.size(), view.elems());
+    size_t i=0;
+    for(size_t z=0; z < view.size[2]; ++z) {
+      for(size_t y=0; y < view.size[1]; ++y) {
+        for(size_t x=0; x < view.size[0]*2; ++x, ++i) {
+          TS_ASSERT_EQUALS(copied[i], (*mem)[first + (z*3 + y)*4*2 + x]);
+        }
+      }
+    }
+  }
+}
+
 void tcache_disable() {
   std::shared_ptr<UVFDataset> ds = mk8x8testdata();
   DynamicBrickingDS dynamic(ds, {{6,16,16}}, cacheBytes);
@@ -423,6 +589,69 @@ void tcache_disable() {
   verify_half_split(dynamic);
 }
 
+// prefetched bricks must be the same as those read on demand.
+void tprefetch() {
+  std::shared_ptr<UVFDataset> ds = mk8x8testdata();
+  std::vector<BrickKey> keys;
+  std::vector<std::vector<uint8_t>> reference;
+  {
+    DynamicBrickingDS dynamic(ds, {{6,16,16}}, 0);
+    for(auto b=dynamic.BricksBegin(); b != dynamic.BricksEnd(); ++b) {
+      if(std::get<1>(b->first) != 0) { continue; }
+      keys.push_back(b->first);
+      reference.push_back(std::vector<uint8_t>());
+      TS_ASSERT(dynamic.GetBrick(b->first, reference.back()));
+    }
+  }
+
+  DynamicBrickingDS dynamic(ds, {{6,16,16}}, cacheBytes);
+  dynamic.Prefetch(keys);
+  dynamic.Prefetch(keys); // requesting bricks twice should not hurt.
+  for(size_t i=0; i < keys.size(); ++i) {
+    std::vector<uint8_t> d;
+    TS_ASSERT(dynamic.GetBrick(keys[i], d));
+    TS_ASSERT(d == reference[i]);
+  }
+  // prefetching bricks which are cached already is a no-op.
+  dynamic.Prefetch(keys);
+  verify_half_split(dynamic);
+
+  // going away while the prefetcher is still busy must be fine, too.
+  DynamicBrickingDS busy(ds, {{6,16,16}}, cacheBytes);
+  busy.Prefetch(keys);
+}
+
+// readers and prefetchers racing for the same source bricks all end up with
+// the same data.
+void tconcurrent() {
+  std::shared_ptr<UVFDataset> ds = mk8x8testdata();
+  std::vector<BrickKey> keys;
+  std::vector<std::vector<uint8_t>> reference;
+  {
+    DynamicBrickingDS dynamic(ds, {{6,16,16}}, 0);
+    for(auto b=dynamic.BricksBegin(); b != dynamic.BricksEnd(); ++b) {
+      if(std::get<1>(b->first) != 0) { continue; }
+      keys.push_back(b->first);
+      reference.push_back(std::vector<uint8_t>());
+      TS_ASSERT(dynamic.GetBrick(b->first, reference.back()));
+    }
+  }
+
+  for(size_t rep=0; rep < 8; ++rep) {
+    DynamicBrickingDS dynamic(ds, {{6,16,16}}, cacheBytes);
+    if(rep % 2) { dynamic.Prefetch(keys); }
+    const int64_t n = static_cast<int64_t>(keys.size());
+    size_t wrong = 0;
+#pragma omp parallel for schedule(dynamic) num_threads(8) reduction(+:wrong)
+    for(int64_t i=0; i < 4*n; ++i) {
+      const size_t k = static_cast<size_t>(i % n);
+      std::vector<uint8_t> d;
+      if(!dynamic.GetBrick(keys[k], d) || d != reference[k]) { ++wrong; }
+    }
+    TS_ASSERT_EQUALS(wrong, 0U);
+  }
+}
+
 void tengine_four() {
   if(!check_for_engine()) { TS_FAIL("need engine for this test"); }
   std::shared_ptr<UVFDataset> ds(new UVFDataset("engine.uvf", 256, false,
@@ -521,7 +750,12 @@ public:
   void test_brick_sizes() { tbsizes(); }
   void test_precompute() { tprecompute(); }
   void test_minmax_dynamic() { tminmax_dynamic(); }
+  void test_minmax_precompute() { tminmax_precompute(); }
   void test_cache_disable() { tcache_disable(); }
+  void test_prefetch() { tprefetch(); }
+  void test_concurrent() { tconcurrent(); }
+  void test_brick_view() { tbrick_view(); }
+  void test_brick_view_copy() { tbrick_view_copy(); }
   void test_engine_four() { tengine_four(); }
   void test_rmi_bench() { rmi_bench(); }
   void test_rescale() { trescale(); }
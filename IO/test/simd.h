@@ -0,0 +1,217 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "Basics/EndianConvert.h"
+#include "QuantizeSIMD.h"
+
+using namespace tuvok;
+
+namespace {
+  // sizes which leave every possible remainder for the vector loops.
+  const size_t sizes[] = { 0, 1, 7, 15, 16, 17, 31, 33, 63, 64, 65, 127, 1000,
+                           4099 };
+
+  template<typename T> typename std::enable_if<std::is_integral<T>::value,
+                                               std::vector<T>>::type
+  random_values(size_t n, std::mt19937_64& rng) {
+    std::vector<T> v(n);
+    for(size_t i=0; i < n; ++i) { v[i] = static_cast<T>(rng()); }
+    return v;
+  }
+  template<typename T> typename std::enable_if<!std::is_integral<T>::value,
+                                               std::vector<T>>::type
+  random_values(size_t n, std::mt19937_64& rng) {
+    std::normal_distribution<T> dist(T(100), T(1000));
+    std::vector<T> v(n);
+    for(size_t i=0; i < n; ++i) { v[i] = dist(rng); }
+    // the odd special value; must neither crash nor differ between paths.
+    if(n > 3) {
+      v[n/3] = std::numeric_limits<T>::quiet_NaN();
+      v[n/2] = T(-0.0);
+    }
+    return v;
+  }
+
+  template<typename T> bool same(const std::vector<T>& a,
+                                 const std::vector<T>& b) {
+    return a.size() == b.size() &&
+           (a.empty() || memcmp(&a[0], &b[0], a.size()*sizeof(T)) == 0);
+  }
+
+  /// runs 'f' at every level the CPU supports, the scalar one first.
+  template<typename Fun> void each_level(Fun f) {
+    for(int l=simd::Scalar; l <= simd::Supported(); ++l) {
+      simd::Limit(simd::Level(l));
+      f(simd::Level(l));
+    }
+    simd::Limit(simd::AVX2);
+  }
+
+  template<typename T> void tswap() {
+    std::mt19937_64 rng(42);
+    for(size_t s=0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+      const std::vector<T> data = random_values<T>(sizes[s], rng);
+      std::vector<T> ref(data);
+      for(size_t i=0; i < ref.size(); ++i) {
+        ref[i] = EndianConvert::Swap<T>(ref[i]);
+      }
+      each_level([&](simd::Level) {
+        std::vector<T> v(data);
+        if(!v.empty()) { simd::ByteSwap(&v[0], v.size(), sizeof(T)); }
+        TS_ASSERT(same(v, ref));
+      });
+    }
+  }
+
+  template<typename T> void tminmax() {
+    std::mt19937_64 rng(43);
+    for(size_t s=0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+      const std::vector<T> data = random_values<T>(sizes[s], rng);
+      T lo0 = std::numeric_limits<T>::max();
+      T hi0 = std::numeric_limits<T>::lowest();
+      each_level([&](simd::Level l) {
+        T lo = std::numeric_limits<T>::max();
+        T hi = std::numeric_limits<T>::lowest();
+        if(!data.empty()) { simd::MinMax(&data[0], data.size(), lo, hi); }
+        if(l == simd::Scalar) { lo0 = lo; hi0 = hi; }
+        // (+0 and -0 compare equal; which one is found may differ.)
+        TS_ASSERT_EQUALS(lo, lo0);
+        TS_ASSERT_EQUALS(hi, hi0);
+        TS_ASSERT(!(lo != lo) && !(hi != hi)); // NaNs are ignored
+      });
+    }
+  }
+
+  template<typename T> void thistogram() {
+    std::mt19937_64 rng(44);
+    const size_t bins = 4096;
+    for(size_t s=0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+      std::vector<T> data = random_values<T>(sizes[s] * 8, rng);
+      std::vector<uint64_t> ref(bins, 0);
+      for(size_t i=0; i < data.size(); ++i) {
+        data[i] = T(data[i] % (sizeof(T) == 1 ? 256 : bins));
+        ++ref[size_t(data[i])];
+      }
+      std::vector<uint64_t> hist(bins, 0);
+      if(!data.empty()) {
+        simd::Histogram(&data[0], data.size(), &hist[0], bins);
+      }
+      TS_ASSERT(hist == ref);
+    }
+  }
+
+  template<typename T, typename U> void tquantize() {
+    std::mt19937_64 rng(45);
+    const uint32_t maxout = sizeof(U) == 1 ? 255 : 65535;
+    const uint32_t bins = sizeof(U) == 1 ? 256 : 4096;
+    for(size_t s=0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+      const std::vector<T> data = random_values<T>(sizes[s], rng);
+      T lo = std::numeric_limits<T>::max();
+      T hi = std::numeric_limits<T>::lowest();
+      if(!data.empty()) { simd::MinMax(&data[0], data.size(), lo, hi); }
+      const double range = data.empty() ? 1.0 : double(hi) - double(lo);
+      const double fact = std::min(maxout / range, 1.0);
+      const simd::Linear<T> value(lo, fact, maxout);
+      const simd::Linear<T> bin(lo, (bins-1) / range, bins-1);
+
+      std::vector<U> out0;
+      std::vector<uint64_t> hist0;
+      each_level([&](simd::Level l) {
+        std::vector<U> out(data.size());
+        std::vector<uint64_t> hist(bins, 0);
+        if(!data.empty()) {
+          simd::Quantize(&data[0], &out[0], data.size(), value, bin, &hist[0]);
+        }
+        if(l == simd::Scalar) {
+          out0 = out;
+          hist0 = hist;
+          // the scalar path is the one everything else is checked against;
+          // make sure it is what it claims to be.
+          for(size_t i=0; i < data.size(); ++i) {
+            TS_ASSERT_EQUALS(out[i], U(value(data[i])));
+          }
+        }
+        TS_ASSERT(same(out, out0));
+        TS_ASSERT(hist == hist0);
+        // ... and without histogram
+        std::vector<U> out2(data.size());
+        if(!data.empty()) {
+          simd::Quantize(&data[0], &out2[0], data.size(), value, bin, NULL);
+        }
+        TS_ASSERT(same(out2, out0));
+      });
+    }
+  }
+
+  // Not really a test; reports throughput of each kernel at each level.
+  void bench() {
+    const size_t n = 16*1024*1024;
+    std::mt19937_64 rng(46);
+    const std::vector<int16_t> data = random_values<int16_t>(n, rng);
+    std::vector<int16_t> tmp(data);
+    std::vector<uint16_t> out(n);
+    std::vector<uint64_t> hist(4096, 0);
+    const simd::Linear<int16_t> value(-32768, 1.0, 65535);
+    const simd::Linear<int16_t> bin(-32768, 4095.0/65535.0, 4095);
+    const double mb = double(n * sizeof(int16_t)) / (1024.0*1024.0);
+
+    each_level([&](simd::Level l) {
+      clock_t start = clock();
+      simd::ByteSwap(&tmp[0], n, sizeof(int16_t));
+      const double tswap = double(clock() - start) / CLOCKS_PER_SEC;
+
+      start = clock();
+      int16_t lo = 32767, hi = -32768;
+      simd::MinMax(&data[0], n, lo, hi);
+      const double tmm = double(clock() - start) / CLOCKS_PER_SEC;
+
+      start = clock();
+      simd::Quantize(&data[0], &out[0], n, value, bin, &hist[0]);
+      const double tq = double(clock() - start) / CLOCKS_PER_SEC;
+
+      fprintf(stderr, "\n%-7s swap: %.0f MB/s, minmax: %.0f MB/s, "
+              "quantize+histogram: %.0f MB/s", simd::Name(l),
+              mb / std::max(tswap, 1e-6), mb / std::max(tmm, 1e-6),
+              mb / std::max(tq, 1e-6));
+    });
+  }
+}
+
+class SIMDTests : public CxxTest::TestSuite {
+public:
+  void test_swap() {
+    tswap<uint16_t>(); tswap<int16_t>(); tswap<uint32_t>(); tswap<float>();
+    tswap<uint64_t>(); tswap<double>();
+  }
+  void test_minmax() {
+    tminmax<int8_t>(); tminmax<uint8_t>(); tminmax<int16_t>();
+    tminmax<uint16_t>(); tminmax<int32_t>(); tminmax<uint32_t>();
+    tminmax<int64_t>(); tminmax<uint64_t>(); tminmax<float>();
+    tminmax<double>();
+  }
+  void test_histogram() {
+    thistogram<uint8_t>(); thistogram<uint16_t>(); thistogram<uint32_t>();
+    thistogram<uint64_t>();
+  }
+  void test_quantize_8bit() {
+    tquantize<int8_t,uint8_t>(); tquantize<uint8_t,uint8_t>();
+    tquantize<int16_t,uint8_t>(); tquantize<uint16_t,uint8_t>();
+    tquantize<int32_t,uint8_t>(); tquantize<uint32_t,uint8_t>();
+    tquantize<int64_t,uint8_t>(); tquantize<uint64_t,uint8_t>();
+    tquantize<float,uint8_t>(); tquantize<double,uint8_t>();
+  }
+  void test_quantize_16bit() {
+    tquantize<int8_t,uint16_t>(); tquantize<uint8_t,uint16_t>();
+    tquantize<int16_t,uint16_t>(); tquantize<uint16_t,uint16_t>();
+    tquantize<int32_t,uint16_t>(); tquantize<uint32_t,uint16_t>();
+    tquantize<int64_t,uint16_t>(); tquantize<uint64_t,uint16_t>();
+    tquantize<float,uint16_t>(); tquantize<double,uint16_t>();
+  }
+  void test_bench() { bench(); }
+};
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "Basics/EndianConvert.h"
+#include "SlicePipeline.h"
+
+using namespace tuvok;
+
+namespace {
+  std::vector<char> slice(size_t i) {
+    std::vector<char> v(100 + i % 7);
+    for(size_t j=0; j < v.size(); ++j) { v[j] = char(i*13 + j); }
+    return v;
+  }
+
+  // slices come out in order, whichever thread read them and however long
+  // that took.
+  void tin_order() {
+    const size_t n = 200;
+    std::vector<size_t> written;
+    size_t iWrong = 0;
+    TS_ASSERT(ReadSlicesInOrder(n,
+      [](size_t i, std::vector<char>& v) {
+        std::this_thread::sleep_for(std::chrono::microseconds((i*7919) % 500));
+        v = slice(i);
+        return true;
+      },
+      [&](size_t i, const std::vector<char>& v) {
+        written.push_back(i);
+        if(v != slice(i)) { ++iWrong; }
+        return true;
+      }));
+    TS_ASSERT_EQUALS(written.size(), n);
+    for(size_t i=0; i < written.size(); ++i) {
+      TS_ASSERT_EQUALS(written[i], i);
+    }
+    TS_ASSERT_EQUALS(iWrong, 0U);
+  }
+
+  // nothing after a failed slice is written.
+  void tfailure() {
+    std::vector<size_t> written;
+    TS_ASSERT(!ReadSlicesInOrder(100,
+      [](size_t i, std::vector<char>& v) { v = slice(i); return i != 37; },
+      [&](size_t i, const std::vector<char>&) {
+        written.push_back(i);
+        return true;
+      }));
+    TS_ASSERT_EQUALS(written.size(), 37U);
+    for(size_t i=0; i < written.size(); ++i) {
+      TS_ASSERT_EQUALS(written[i], i);
+    }
+
+    written.clear();
+    TS_ASSERT(!ReadSlicesInOrder(100,
+      [](size_t i, std::vector<char>& v) { v = slice(i); return true; },
+      [&](size_t i, const std::vector<char>&) {
+        written.push_back(i);
+        return i != 12;
+      }));
+    TS_ASSERT_EQUALS(written.size(), 13U);
+  }
+
+  template<typename T>
+  std::vector<char> bytes(const std::vector<T>& values) {
+    std::vector<char> v(values.size()*sizeof(T));
+    memcpy(&v[0], &values[0], v.size());
+    return v;
+  }
+
+  template<typename T>
+  void tswap_type() {
+    std::mt19937 gen(sizeof(T));
+    std::vector<T> values(1001);
+    for(size_t i=0; i < values.size(); ++i) { values[i] = T(gen()); }
+    std::vector<char> v = bytes(values);
+    SwapEndianness(v, sizeof(T)*8);
+    for(size_t i=0; i < values.size(); ++i) {
+      values[i] = EndianConvert::Swap<T>(values[i]);
+    }
+    TS_ASSERT(v == bytes(values));
+  }
+
+  void tswap() {
+    tswap_type<uint16_t>();
+    tswap_type<uint32_t>();
+    std::vector<char> v(17, 'x');
+    SwapEndianness(v, 8);
+    TS_ASSERT(v == std::vector<char>(17, 'x'));
+  }
+
+  // the same as the slice-by-slice loops did: in float, then truncated.
+  template<typename T>
+  void tscale_type(bool bSigned, float fScale, float fBias) {
+    std::mt19937 gen(sizeof(T) + bSigned);
+    std::vector<T> values(999);
+    for(size_t i=0; i < values.size(); ++i) { values[i] = T(gen() % 100); }
+    std::vector<char> v = bytes(values);
+    ScaleAndBias(v, sizeof(T)*8, bSigned, fScale, fBias);
+    for(size_t i=0; i < values.size(); ++i) {
+      const float sbValue = values[i] * fScale + fBias;
+      values[i] = T(sbValue);
+    }
+    TS_ASSERT(v == bytes(values));
+  }
+
+  void tscale() {
+    tscale_type<uint8_t>(false, 2.0f, 0.0f);
+    tscale_type<int8_t>(true, 0.5f, -20.0f);
+    tscale_type<uint16_t>(false, 1.5f, 3.0f);
+    tscale_type<int16_t>(true, 1.0f, -1024.0f);
+    tscale_type<uint32_t>(false, 3.0f, 0.0f);
+    tscale_type<int32_t>(true, 0.25f, -7.5f);
+  }
+
+  void trgba() {
+    std::vector<char> rgb(3*50), rgba;
+    for(size_t i=0; i < rgb.size(); ++i) { rgb[i] = char(i); }
+    RGBToRGBA(rgb, rgba);
+    TS_ASSERT_EQUALS(rgba.size(), 4*50U);
+    for(size_t i=0; i < 50; ++i) {
+      TS_ASSERT_EQUALS(rgba[i*4+0], char(i*3+0));
+      TS_ASSERT_EQUALS(rgba[i*4+1], char(i*3+1));
+      TS_ASSERT_EQUALS(rgba[i*4+2], char(i*3+2));
+      TS_ASSERT_EQUALS(rgba[i*4+3], char(255));
+    }
+  }
+}
+
+class SlicePipelineTests : public CxxTest::TestSuite {
+public:
+  void test_in_order() { tin_order(); }
+  void test_failure() { tfailure(); }
+  void test_swap() { tswap(); }
+  void test_scale() { tscale(); }
+  void test_rgba() { trgba(); }
+};
@@ -0,0 +1,184 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cxxtest/TestSuite.h>
+#include "Images/StackExporter.h"
+#include "TransferFunction1D.h"
+#include "util-test.h"
+
+namespace {
+  const UINT64VECTOR3 domain(37, 23, 19);
+
+  unsigned char voxel(uint64_t x, uint64_t y, uint64_t z, uint64_t c) {
+    return (unsigned char)((x*7 + y*31 + z*101 + c*53) & 0xff);
+  }
+
+  struct StackDir {
+    StackDir() {
+      char templ[64];
+      strcpy(templ, ".stackexport.XXXXXX");
+      path = mkdtemp(templ);
+    }
+    ~StackDir() {
+      for(size_t i=0; i < files.size(); ++i) { remove(files[i].c_str()); }
+      rmdir(path.c_str());
+    }
+    std::string name(const std::string& stack, uint64_t i) {
+      std::ostringstream s;
+      s << path << "/stack" << stack << "_" << i+1 << ".raw";
+      files.push_back(s.str());
+      return s.str();
+    }
+    std::string path;
+    std::vector<std::string> files;
+  };
+
+  std::vector<unsigned char> read(const std::string& fn) {
+    std::ifstream ifs(fn.c_str(), std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(ifs),
+                                      std::istreambuf_iterator<char>());
+  }
+
+  // checks images [0,n) of a stack; 'at' maps an image and pixel to the
+  // voxel it shows.
+  void check(StackDir& dir, const std::string& stack, uint64_t n,
+             const UINT64VECTOR2& size, uint64_t iComponents,
+             const std::function<UINT64VECTOR3(uint64_t, uint64_t,
+                                               uint64_t)>& at) {
+    const uint64_t iImageComponents = iComponents == 4 ? 4 : 3;
+    for(uint64_t i=0; i < n; ++i) {
+      const std::vector<unsigned char> image = read(dir.name(stack, i));
+      TS_ASSERT_EQUALS(image.size(), size.area()*iImageComponents);
+      if(image.size() != size.area()*iImageComponents) { continue; }
+      size_t iWrong = 0;
+      for(uint64_t v=0; v < size.y; ++v) {
+        for(uint64_t u=0; u < size.x; ++u) {
+          const UINT64VECTOR3 p = at(i, u, v);
+          for(uint64_t c=0; c < iImageComponents; ++c) {
+            const unsigned char expected = c < iComponents ?
+              voxel(p.x, p.y, p.z, c) : 0;
+            if(image[size_t((v*size.x + u)*iImageComponents + c)] !=
+               expected) {
+              ++iWrong;
+            }
+          }
+        }
+      }
+      TS_ASSERT_EQUALS(iWrong, 0U);
+    }
+    // and no more than that
+    TS_ASSERT(!std::ifstream(dir.name(stack, n).c_str()).good());
+  }
+
+  // all three stacks show the volume's voxels where a per-voxel gather
+  // would put them, however many passes the memory limit takes.
+  void tall_dirs(uint64_t iComponents, uint64_t iMaxMem) {
+    std::vector<unsigned char> data;
+    for(uint64_t z=0; z < domain.z; ++z) {
+      for(uint64_t y=0; y < domain.y; ++y) {
+        for(uint64_t x=0; x < domain.x; ++x) {
+          for(uint64_t c=0; c < iComponents; ++c) {
+            data.push_back(voxel(x, y, z, c));
+          }
+        }
+      }
+    }
+    std::ofstream ofs;
+    const std::string raw = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&data[0]), data.size());
+    ofs.close();
+    clean tmp = cleanup(raw);
+
+    StackDir dir;
+    TS_ASSERT(StackExporter::WriteStacks(raw, dir.path + "/stack.raw", NULL,
+                                         8, iComponents, 1.0f, domain, true,
+                                         iMaxMem));
+    check(dir, "_x", domain.x, UINT64VECTOR2(domain.z, domain.y), iComponents,
+          [](uint64_t x, uint64_t u, uint64_t v) {
+            return UINT64VECTOR3(x, v, u);
+          });
+    check(dir, "_y", domain.y, UINT64VECTOR2(domain.x, domain.z), iComponents,
+          [](uint64_t y, uint64_t u, uint64_t v) {
+            return UINT64VECTOR3(u, y, v);
+          });
+    check(dir, "_z", domain.z, UINT64VECTOR2(domain.x, domain.y), iComponents,
+          [](uint64_t z, uint64_t u, uint64_t v) {
+            return UINT64VECTOR3(u, v, z);
+          });
+  }
+
+  // scalar data goes through the TF, in every stack.
+  void ttransfer_function() {
+    std::vector<uint16_t> data(size_t(domain.volume()));
+    for(size_t i=0; i < data.size(); ++i) { data[i] = uint16_t(i % 1000); }
+    std::ofstream ofs;
+    const std::string raw = mk_tmpfile(ofs, std::ios::out | std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&data[0]),
+              data.size()*sizeof(uint16_t));
+    ofs.close();
+    clean tmp = cleanup(raw);
+
+    TransferFunction1D tf(256);
+    for(size_t i=0; i < tf.GetSize(); ++i) {
+      tf.SetColor(i, FLOATVECTOR4(i/255.0f, 1.0f - i/255.0f, 0.5f, 1.0f));
+    }
+    const float fRescale = 0.25f;
+    StackDir dir;
+    TS_ASSERT(StackExporter::WriteStacks(raw, dir.path + "/stack.raw", &tf,
+                                         16, 1, fRescale, domain, true,
+                                         3*domain.x*domain.y));
+    auto rgba = [&](uint64_t x, uint64_t y, uint64_t z) {
+      const uint16_t value = data[size_t(x + domain.x*(y + domain.y*z))];
+      const FLOATVECTOR4 c = tf.GetColor(
+        std::min(size_t(value*fRescale), tf.GetSize()-1));
+      return UINTVECTOR4(unsigned((unsigned char)(c.x*255)),
+                         unsigned((unsigned char)(c.y*255)),
+                         unsigned((unsigned char)(c.z*255)),
+                         unsigned((unsigned char)(c.w*255)));
+    };
+    size_t iWrong = 0;
+    for(uint64_t z=0; z < domain.z; ++z) {
+      const std::vector<unsigned char> image = read(dir.name("_z", z));
+      TS_ASSERT_EQUALS(image.size(), 4*domain.x*domain.y);
+      if(image.size() != 4*domain.x*domain.y) { continue; }
+      for(uint64_t y=0; y < domain.y; ++y) {
+        for(uint64_t x=0; x < domain.x; ++x) {
+          const unsigned char* p = &image[size_t(4*(x + domain.x*y))];
+          if(UINTVECTOR4(p[0], p[1], p[2], p[3]) != rgba(x, y, z)) {
+            ++iWrong;
+          }
+        }
+      }
+    }
+    for(uint64_t x=0; x < domain.x; ++x) {
+      const std::vector<unsigned char> image = read(dir.name("_x", x));
+      TS_ASSERT_EQUALS(image.size(), 4*domain.z*domain.y);
+      if(image.size() != 4*domain.z*domain.y) { continue; }
+      for(uint64_t y=0; y < domain.y; ++y) {
+        for(uint64_t z=0; z < domain.z; ++z) {
+          const unsigned char* p = &image[size_t(4*(z + domain.z*y))];
+          if(UINTVECTOR4(p[0], p[1], p[2], p[3]) != rgba(x, y, z)) {
+            ++iWrong;
+          }
+        }
+      }
+    }
+    for(uint64_t y=0; y < domain.y; ++y) { dir.name("_y", y); }
+    TS_ASSERT_EQUALS(iWrong, 0U);
+  }
+}
+
+class StackExporterTests : public CxxTest::TestSuite {
+public:
+  void test_one_pass() { tall_dirs(4, 0); }
+  void test_few_passes() { tall_dirs(3, 2*domain.volume()); }
+  void test_pass_per_slice() { tall_dirs(2, 1); }
+  void test_transfer_function() { ttransfer_function(); }
+};
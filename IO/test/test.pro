@@ -52,7 +52,7 @@ contains(QMAKE_PRL_CONFIG, shared) {
 }
 
 #TEST_HEADERS=quantize.h largefile.h rebricking.h cbi.h bcache.h
-TEST_HEADERS=quantize.h largefile.h rebricking.h bcache.h
+TEST_HEADERS=quantize.h largefile.h rebricking.h bcache.h eoctree.h histogram.h perf.h simd.h isosurface.h exprprogram.h asyncout.h brickindex.h occupancy.h bminmax.h dicomscan.h tf2d.h stackexport.h slicepipeline.h decompress.h geoparse.h
 
 TG_PARAMS=--have-eh --abort-on-fail --no-static-init --error-printer
 alltests.target = alltests.cpp
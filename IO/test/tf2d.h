@@ -0,0 +1,183 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "TransferFunction1D.h"
+#include "TransferFunction2D.h"
+
+namespace {
+  const VECTOR2<size_t> tfsize(64, 32);
+
+  TFPolygon quad(float x0, float y0, float x1, float y1,
+                 const FLOATVECTOR4& c0, const FLOATVECTOR4& c1) {
+    TFPolygon p;
+    p.pPoints.push_back(FLOATVECTOR2(x0, y0));
+    p.pPoints.push_back(FLOATVECTOR2(x1, y0));
+    p.pPoints.push_back(FLOATVECTOR2(x1, y1));
+    p.pPoints.push_back(FLOATVECTOR2(x0, y1));
+    p.pGradientCoords[0] = FLOATVECTOR2(x0, y0);
+    p.pGradientCoords[1] = FLOATVECTOR2(x1, y0);
+    p.pGradientStops.push_back(GradientStop(0.0f, c0));
+    p.pGradientStops.push_back(GradientStop(1.0f, c1));
+    return p;
+  }
+
+  std::vector<FLOATVECTOR4> floats(TransferFunction2D& tf) {
+    float* data = NULL;
+    tf.GetFloatArray(&data);
+    std::vector<FLOATVECTOR4> v(tf.GetSize().area());
+    for(size_t i=0; i < v.size(); ++i) {
+      v[i] = FLOATVECTOR4(data[4*i], data[4*i+1], data[4*i+2], data[4*i+3]);
+    }
+    delete[] data;
+    return v;
+  }
+
+  std::vector<unsigned char> bytes(TransferFunction2D& tf) {
+    unsigned char* data = NULL;
+    tf.GetByteArray(&data);
+    std::vector<unsigned char> v(data, data + 4*tf.GetSize().area());
+    delete[] data;
+    return v;
+  }
+
+  // a constant swatch covers the pixels whose centers it contains.
+  void tcoverage() {
+    TransferFunction2D tf(tfsize);
+    const FLOATVECTOR4 red(1, 0, 0, 1);
+    tf.SwatchPushBack(quad(0.25f, 0.25f, 0.75f, 0.75f, red, red));
+    const std::vector<FLOATVECTOR4> f = floats(tf);
+    const std::vector<unsigned char> b = bytes(tf);
+    for(size_t y=0; y < tfsize.y; ++y) {
+      for(size_t x=0; x < tfsize.x; ++x) {
+        const size_t i = x + y*tfsize.x;
+        const bool in = x >= 16 && x < 48 && y >= 8 && y < 24;
+        TS_ASSERT_EQUALS(f[i], in ? red : FLOATVECTOR4(0, 0, 0, 0));
+        TS_ASSERT_EQUALS(b[4*i+0], in ? 255 : 0);
+        TS_ASSERT_EQUALS(b[4*i+1], 0);
+        TS_ASSERT_EQUALS(b[4*i+3], in ? 255 : 0);
+      }
+    }
+    tf.ComputeNonZeroLimits();
+    TS_ASSERT_EQUALS(tf.GetNonZeroLimits(), UINT64VECTOR4(16, 47, 8, 23));
+  }
+
+  // linear gradients run along their axis and pad beyond it; radial ones
+  // grow with the distance from their center.
+  void tgradients() {
+    TransferFunction2D tf(tfsize);
+    TFPolygon lin = quad(0, 0, 1, 1, FLOATVECTOR4(0, 0, 0, 1),
+                         FLOATVECTOR4(1, 1, 1, 1));
+    lin.pGradientCoords[0] = FLOATVECTOR2(0.25f, 0.0f);
+    lin.pGradientCoords[1] = FLOATVECTOR2(0.75f, 0.0f);
+    tf.SwatchPushBack(lin);
+    std::vector<FLOATVECTOR4> f = floats(tf);
+    for(size_t x=0; x < tfsize.x; ++x) {
+      const float t = std::max(0.0f, std::min((x + 0.5f - 16.0f) / 32.0f,
+                                              1.0f));
+      TS_ASSERT_DELTA(f[x + 5*tfsize.x].x, t, 1.0f/1023);
+      TS_ASSERT_EQUALS(f[x + 5*tfsize.x].w, 1.0f);
+    }
+
+    TFPolygon rad = lin;
+    rad.bRadial = true;
+    rad.pGradientCoords[0] = FLOATVECTOR2(0.5f, 0.5f);
+    rad.pGradientCoords[1] = FLOATVECTOR2(0.75f, 0.5f);
+    tf.SwatchUpdate(0, rad);
+    tf.InvalidateCache();
+    f = floats(tf);
+    for(size_t y=0; y < tfsize.y; ++y) {
+      for(size_t x=0; x < tfsize.x; ++x) {
+        const float dx = (x + 0.5f - 32.0f) / 16.0f;
+        const float dy = (y + 0.5f - 16.0f) / 16.0f;
+        const float t = std::min(std::sqrt(dx*dx + dy*dy), 1.0f);
+        TS_ASSERT_DELTA(f[x + y*tfsize.x].y, t, 1.0f/1023);
+      }
+    }
+  }
+
+  // swatches composite over each other and over the 1D TF, source-over.
+  void tcomposite() {
+    TransferFunction2D tf(tfsize);
+    TransferFunction1D tf1d(tfsize.x / 2);
+    for(size_t i=0; i < tf1d.GetSize(); ++i) {
+      tf1d.SetColor(i, FLOATVECTOR4(0, 0, float(i) / 31, 0.5f));
+    }
+    tf.Update1DTrans(&tf1d);
+    const FLOATVECTOR4 green(0, 1, 0, 0.5f);
+    tf.SwatchPushBack(quad(0.5f, 0, 1, 1, green, green));
+    const std::vector<FLOATVECTOR4> f = floats(tf);
+    for(size_t x=0; x < tfsize.x; ++x) {
+      const FLOATVECTOR4 bg(0, 0, float(x/2) / 31, 0.5f);
+      const FLOATVECTOR4 c = f[x + 7*tfsize.x];
+      if(x < 32) {
+        TS_ASSERT_EQUALS(c, bg);
+      } else {
+        TS_ASSERT_DELTA(c.w, 0.75f, 1e-6f);
+        TS_ASSERT_DELTA(c.y, 0.5f / 0.75f, 1e-6f);
+        TS_ASSERT_DELTA(c.z, bg.z * 0.25f / 0.75f, 1e-6f);
+      }
+    }
+  }
+
+  // after any sequence of edits, the tables are what drawing everything
+  // from scratch gives.
+  void tincremental() {
+    std::mt19937 gen(21);
+    std::uniform_real_distribution<float> u(-0.1f, 1.1f);
+    const VECTOR2<size_t> size(256, 128);
+    TransferFunction2D tf(size);
+    TransferFunction1D tf1d(size.x);
+    for(size_t i=0; i < tf1d.GetSize(); ++i) {
+      tf1d.SetColor(i, FLOATVECTOR4(u(gen), u(gen), u(gen), u(gen)));
+    }
+    tf.Update1DTrans(&tf1d);
+
+    std::uniform_real_distribution<float> c(0.0f, 1.0f);
+    auto swatch = [&]() {
+      TFPolygon p;
+      p.bRadial = c(gen) < 0.5f;
+      const size_t n = 3 + gen() % 5;
+      for(size_t i=0; i < n; ++i) {
+        p.pPoints.push_back(FLOATVECTOR2(u(gen), u(gen)));
+      }
+      p.pGradientCoords[0] = FLOATVECTOR2(u(gen), u(gen));
+      p.pGradientCoords[1] = FLOATVECTOR2(u(gen), u(gen));
+      for(size_t i=0; i < 1 + gen() % 3; ++i) {
+        p.pGradientStops.push_back(GradientStop(c(gen),
+          FLOATVECTOR4(c(gen), c(gen), c(gen), c(gen))));
+      }
+      return p;
+    };
+    for(size_t i=0; i < 6; ++i) { tf.SwatchPushBack(swatch()); }
+
+    for(size_t edit=0; edit < 40; ++edit) {
+      const size_t n = tf.SwatchArrayGetSize();
+      switch(gen() % 5) {
+        case 0: tf.SwatchPushBack(swatch()); break;
+        case 1: if(n > 1) { tf.SwatchErase(gen() % n); } break;
+        case 2: tf.SwatchUpdate(gen() % n, swatch()); break;
+        case 3: tf.SwatchInsertPoint(gen() % n, 0,
+                                     FLOATVECTOR2(u(gen), u(gen))); break;
+        case 4: (*tf.m_pvSwatches)[gen() % n].pGradientCoords[1] =
+                  FLOATVECTOR2(u(gen), u(gen)); break;
+      }
+      tf.InvalidateCache();
+
+      TransferFunction2D fresh(size);
+      fresh.Update1DTrans(&tf1d);
+      *fresh.m_pvSwatches = *tf.m_pvSwatches;
+      TS_ASSERT(floats(tf) == floats(fresh));
+      TS_ASSERT(bytes(tf) == bytes(fresh));
+    }
+  }
+}
+
+class TransferFunction2DTests : public CxxTest::TestSuite {
+public:
+  void test_coverage() { tcoverage(); }
+  void test_gradients() { tgradients(); }
+  void test_composite() { tcomposite(); }
+  void test_incremental() { tincremental(); }
+};
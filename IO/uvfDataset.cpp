@@ -27,6 +27,7 @@
 */
 
 #include <cstring>
+#include <map>
 #include <sstream>
 
 #include "uvfDataset.h"
@@ -1204,6 +1205,17 @@ MinMaxBlock UVFDataset::MaxMinForKey(const BrickKey& k) const {
   }
 }
 
+ValueOccupancy UVFDataset::OccupancyForKey(const BrickKey& k) const {
+  const MinMaxBlock maxMinElement = MaxMinForKey(k);
+  uint64_t iBins = ValueOccupancy::All;
+  if (m_bToCBlock) {
+    const TOCTimestep* ts = dynamic_cast<const TOCTimestep*>(m_timesteps[std::get<0>(k)]);
+    size_t iLinIndex = size_t(ts->GetDB()->GetLinearBrickIndex(KeyToTOCVector(k)));
+    iBins = ts->m_pMaxMinData->GetOccupancy(iLinIndex, ts->GetDB()->GetComponentCount() == 4 ? 3 : 0);
+  }
+  return ValueOccupancy(maxMinElement.minScalar, maxMinElement.maxScalar, iBins);
+}
+
 bool UVFDataset::ContainsData(const BrickKey &k, double isoval) const
 {
   // if we have no max min data we have to assume that every block is visible
@@ -1220,6 +1232,13 @@ bool UVFDataset::ContainsData(const BrickKey &k, double fMin,double fMax) const
   return (fMax >= maxMinElement.minScalar && fMin <= maxMinElement.maxScalar);
 }
 
+bool UVFDataset::ContainsData(const BrickKey &k, const ValueRanges& ranges) const
+{
+  // if we have no max min data we have to assume that every block is visible
+  if(NULL == m_timesteps[std::get<0>(k)]->m_pMaxMinData) {return true;}
+  return OccupancyForKey(k).Intersects(ranges);
+}
+
 bool UVFDataset::ContainsData(const BrickKey &k, double fMin,double fMax, double fMinGradient,double fMaxGradient) const
 {
   // if we have no max min data we have to assume that every block is visible
@@ -1718,6 +1737,56 @@ UVFDataset::GetBrickTemplate(const BrickKey& k, std::vector<T>& vData) const
   }
 }
 
+// Bricks of different timesteps live in different TOC blocks, so each
+// timestep's bricks are read as a batch of their own.
+template <class T> bool
+UVFDataset::GetBricksTemplate(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<T>&)>& f
+) const
+{
+  if(!m_bToCBlock) {
+    return GetBricksOneByOne(keys, f);
+  }
+
+  std::map<size_t, std::vector<size_t>> perTimestep;
+  for(size_t i=0; i < keys.size(); ++i) {
+    perTimestep[std::get<0>(keys[i])].push_back(i);
+  }
+
+  std::vector<T> vData;
+  bool bContinue = true;
+  for(auto t = perTimestep.cbegin(); t != perTimestep.cend() && bContinue;
+      ++t) {
+    const std::vector<size_t>& requests = t->second;
+    const TOCBlock* db = static_cast<TOCTimestep*>(m_timesteps[t->first])->GetDB();
+    std::vector<UINT64VECTOR4> coords(requests.size());
+    for(size_t j=0; j < requests.size(); ++j) {
+      coords[j] = KeyToTOCVector(keys[requests[j]]);
+    }
+
+    db->GetData(coords,
+      [&](size_t j) {
+        vData.resize(size_t(db->GetComponentTypeSize() *
+                            db->GetComponentCount() *
+                            db->GetBrickSize(coords[j]).volume()) / sizeof(T));
+        return reinterpret_cast<uint8_t*>(vData.data());
+      },
+      [&](size_t j) {
+        if(db->GetAtlasSize(coords[j]).area() != 0) {
+          uint8_t* pData = reinterpret_cast<uint8_t*>(vData.data());
+          VolumeTools::DeAtalasify(vData.size() * sizeof(T),
+                                   db->GetAtlasSize(coords[j]),
+                                   db->GetMaxBrickSize(),
+                                   db->GetBrickSize(coords[j]), pData, pData);
+        }
+        bContinue = f(requests[j], vData);
+        return bContinue;
+      });
+  }
+  return true;
+}
+
 bool UVFDataset::GetBrick(const BrickKey& k, std::vector<uint8_t>& vData) const {
   return GetBrickTemplate<uint8_t>(k,vData);
 }
@@ -1750,6 +1819,62 @@ bool UVFDataset::GetBrick(const BrickKey& k, std::vector<double>& vData) const {
   return GetBrickTemplate<double>(k,vData);
 }
 
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<uint8_t>&)>& f
+) const {
+  return GetBricksTemplate<uint8_t>(keys, f);
+}
+
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<int8_t>&)>& f
+) const {
+  return GetBricksTemplate<int8_t>(keys, f);
+}
+
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<uint16_t>&)>& f
+) const {
+  return GetBricksTemplate<uint16_t>(keys, f);
+}
+
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<int16_t>&)>& f
+) const {
+  return GetBricksTemplate<int16_t>(keys, f);
+}
+
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<uint32_t>&)>& f
+) const {
+  return GetBricksTemplate<uint32_t>(keys, f);
+}
+
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<int32_t>&)>& f
+) const {
+  return GetBricksTemplate<int32_t>(keys, f);
+}
+
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<float>&)>& f
+) const {
+  return GetBricksTemplate<float>(keys, f);
+}
+
+bool UVFDataset::GetBricks(
+  const std::vector<BrickKey>& keys,
+  const std::function<bool(size_t, std::vector<double>&)>& f
+) const {
+  return GetBricksTemplate<double>(keys, f);
+}
+
 std::pair<FLOATVECTOR3, FLOATVECTOR3> UVFDataset::GetTextCoords(BrickTable::const_iterator brick, bool bUseOnlyPowerOfTwo) const {
   if (m_bToCBlock) {
     const UINT64VECTOR4 coords = KeyToTOCVector(brick->first);
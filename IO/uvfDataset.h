@@ -119,13 +119,45 @@ public:
   virtual bool GetBrick(const BrickKey&, std::vector<float>&) const;
   virtual bool GetBrick(const BrickKey&, std::vector<double>&) const;
 
+  /// Reads bricks which are close together in the file with a single read.
+  ///@{
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<uint8_t>&)>& f) const;
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<int8_t>&)>& f) const;
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<uint16_t>&)>& f) const;
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<int16_t>&)>& f) const;
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<uint32_t>&)>& f) const;
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<int32_t>&)>& f) const;
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<float>&)>& f) const;
+  virtual bool GetBricks(const std::vector<BrickKey>& keys,
+                         const std::function<bool(size_t,
+                                                  std::vector<double>&)>& f) const;
+  ///@}
+
   /// Acceleration queries.
   virtual bool ContainsData(const BrickKey &k, double isoval) const;
   virtual bool ContainsData(const BrickKey &k, double fMin,double fMax) const;
   virtual bool ContainsData(const BrickKey &k, double fMin,double fMax,
                             double fMinGradient,double fMaxGradient) const;
+  virtual bool ContainsData(const BrickKey &k, const ValueRanges& ranges) const;
   /// @returns the min/max scalar and gradient values for the given brick
   tuvok::MinMaxBlock MaxMinForKey(const BrickKey& k) const;
+  /// @returns the bins of the brick's scalar range which hold values, if the
+  /// file was converted with them; all bins otherwise.
+  virtual tuvok::ValueOccupancy OccupancyForKey(const BrickKey& k) const;
 
   // LOD Data
   /// @todo fixme -- this should take a brick key and just ignore the spatial
@@ -225,6 +257,10 @@ private:
 
   template <class T> bool GetBrickTemplate(const BrickKey& k,
                                            std::vector<T>& vData) const;
+  template <class T> bool GetBricksTemplate(
+    const std::vector<BrickKey>& keys,
+    const std::function<bool(size_t, std::vector<T>&)>& f
+  ) const;
 
 private:
   bool                                  m_bToCBlock;
@@ -120,6 +120,7 @@ void LuaClassConstructor::postExecFailure(LuaScripting* ss,
   string removeClass = inst.fqName();
   removeClass += " = nil";
 
+  ss->invalidateHandles();
   luaL_dostring(ss->getLuaState(), removeClass.c_str());
 }
 
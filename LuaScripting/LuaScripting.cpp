@@ -123,6 +123,7 @@ LuaScripting::LuaScripting()
 , mMemberReg(new LuaMemberRegUnsafe(this))
 , mClassCons(new LuaClassConstructor(this))
 , mVerboseMode(false)
+, mHandleGeneration(0)
 {
   mL = lua_newstate(luaInternalAlloc, NULL);
 
@@ -882,6 +883,7 @@ void LuaScripting::deleteAllClassInstances()
 void LuaScripting::destroyClassInstanceTable(int tableIndex)
 {
   LuaStackRAII _a(mL, 0, 0);
+  invalidateHandles();
 
   if (lua_getmetatable(mL, tableIndex) == 0)
     throw LuaError("Unable to obtain function metatable.");
@@ -921,6 +923,7 @@ void LuaScripting::destroyClassInstanceTable(int tableIndex)
 void LuaScripting::cleanupClassConstructors()
 {
   LuaStackRAII _a(mL, 0, 0);
+  invalidateHandles();
 
   for (vector<string>::iterator it = mRegisteredClasses.begin();
       it != mRegisteredClasses.end(); ++it)
@@ -1003,6 +1006,7 @@ void LuaScripting::removeFunctionsFromTable(int parentTable,
                                             const char* tableName)
 {
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
+  invalidateHandles();
   // Iterate over the first table on the stack.
   int tablePos = lua_gettop(mL);
 
@@ -1431,6 +1435,7 @@ void LuaScripting::bindClosureTableWithFQName(const string& fqName,
                                               int tableIndex)
 {
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
+  invalidateHandles();
 
   // Tokenize the fully qualified name.
   const string delims(QUALIFIED_NAME_DELIMITER);
@@ -1858,6 +1863,8 @@ bool LuaScripting::getFunctionTable(const std::string& fqName)
 //-----------------------------------------------------------------------------
 void LuaScripting::unregisterFunction(const std::string& fqName)
 {
+  invalidateHandles();
+
   // Lookup the function table based on the fully qualified name.
   int baseStackIndex = lua_gettop(mL);
 
@@ -2199,25 +2206,118 @@ void LuaScripting::copyDefaultsTableToLastExec(int funTableIndex)
 //-----------------------------------------------------------------------------
 void LuaScripting::prepForExecution(const std::string& fqName)
 {
-  if (getFunctionTable(fqName) == false) {
+  prepForExecution(lookup(fqName));
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::prepForExecution(const LuaFunHandle& fun)
+{
+  if (!fun.isValid() || fun.mSlot >= mResolved.size())
+    throw LuaNonExistantFunction("Invalid function handle.");
+  refreshHandle(fun.mSlot);
+
+  // The __call function, followed by the function table. The table will be
+  // the first parameter to the function we call.
+  const ResolvedFun& r = mResolved[fun.mSlot];
+  lua_rawgeti(mL, LUA_REGISTRYINDEX, r.callRef);
+  lua_rawgeti(mL, LUA_REGISTRYINDEX, r.tableRef);
+}
+
+//-----------------------------------------------------------------------------
+LuaFunHandle LuaScripting::resolve(const std::string& fqName)
+{
+  LuaFunHandle fun = lookup(fqName);
+  mResolved[fun.mSlot].handedOut = true;
+  return fun;
+}
+
+//-----------------------------------------------------------------------------
+LuaFunHandle LuaScripting::lookup(const std::string& fqName)
+{
+  std::unordered_map<std::string, size_t>::const_iterator it =
+      mResolvedSlots.find(fqName);
+  size_t slot;
+  if (it != mResolvedSlots.end())
+  {
+    slot = it->second;
+  }
+  else
+  {
+    ResolvedFun r = {fqName, LUA_NOREF, LUA_NOREF, mHandleGeneration - 1,
+                     false};
+    if (mFreeSlots.empty())
+    {
+      slot = mResolved.size();
+      mResolved.push_back(r);
+    }
+    else
+    {
+      slot = mFreeSlots.back();
+      mFreeSlots.pop_back();
+      mResolved[slot] = r;
+    }
+    mResolvedSlots[fqName] = slot;
+  }
+  refreshHandle(slot);
+  return LuaFunHandle(slot);
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::invalidateHandles()
+{
+  ++mHandleGeneration;
+
+  // Every slot is looked up again anyway. Names only the cexec overloads
+  // used are dropped, or every class instance ever called by name would
+  // keep a slot.
+  for (size_t slot = 0; slot < mResolved.size(); ++slot)
+  {
+    ResolvedFun& r = mResolved[slot];
+    luaL_unref(mL, LUA_REGISTRYINDEX, r.tableRef);
+    luaL_unref(mL, LUA_REGISTRYINDEX, r.callRef);
+    r.tableRef = r.callRef = LUA_NOREF;
+    if (!r.handedOut && !r.name.empty())
+    {
+      mResolvedSlots.erase(r.name);
+      r.name.clear();
+      mFreeSlots.push_back(slot);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::refreshHandle(size_t slot)
+{
+  if (mResolved[slot].generation == mHandleGeneration) return;
+
+  LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
+  ResolvedFun& r = mResolved[slot];
+  luaL_unref(mL, LUA_REGISTRYINDEX, r.tableRef);
+  luaL_unref(mL, LUA_REGISTRYINDEX, r.callRef);
+  r.tableRef = r.callRef = LUA_NOREF;
+
+  if (getFunctionTable(r.name) == false) {
     std::ostringstream nf;
-    nf << "Could not find '" << fqName << "' function.";
+    nf << "Could not find '" << r.name << "' function.";
     throw LuaNonExistantFunction(nf.str(), _func_, __LINE__);
   }
 
   if (lua_getmetatable(mL, -1) == 0)
+  {
+    lua_pop(mL, 1);
     throw LuaError("Unable to find function metatable.");
+  }
   lua_getfield(mL, -1, "__call");
+  r.callRef = luaL_ref(mL, LUA_REGISTRYINDEX);
+  lua_pop(mL, 1); // Pop the metatable.
+  r.tableRef = luaL_ref(mL, LUA_REGISTRYINDEX);
+  r.generation = mHandleGeneration;
+}
 
-  // Remove metatable.
-  lua_remove(mL, lua_gettop(mL) - 1);
-
-  // Push a reference of the function table. This will be the first parameter
-  // to the function we call.
-  lua_pushvalue(mL, -2);
-
-  // Remove the function table we pushed with getFunctionTable.
-  lua_remove(mL, lua_gettop(mL) - 2);
+//-----------------------------------------------------------------------------
+const std::string& LuaScripting::funName(const LuaFunHandle& fun) const
+{
+  return mResolved.at(fun.mSlot).name;
 }
 
 //-----------------------------------------------------------------------------
@@ -2233,6 +2333,8 @@ void LuaScripting::executeFunctionOnStack(int nparams, int nret)
 //-----------------------------------------------------------------------------
 void LuaScripting::exec(const std::string& cmd)
 {
+  // Arbitrary Lua code may rebind any function name.
+  invalidateHandles();
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
   luaL_loadstring(mL, cmd.c_str());
   lua_call(mL, 0, 0);
@@ -2240,9 +2342,15 @@ void LuaScripting::exec(const std::string& cmd)
 
 //-----------------------------------------------------------------------------
 void LuaScripting::cexec(const std::string& cmd)
+{
+  cexec(lookup(cmd));
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::cexec(const LuaFunHandle& fun)
 {
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-  prepForExecution(cmd);
+  prepForExecution(fun);
   executeFunctionOnStack(0, 0);
 }
 
@@ -2343,6 +2451,7 @@ bool LuaScripting::getClassTable(LuaClassInstance inst)
 void LuaScripting::deleteLuaClassInstance(LuaClassInstance inst)
 {
   LuaStackRAII _a(mL, 0, 0);
+  invalidateHandles();
 
   if (getFunctionTable(inst.fqName()))
   {
@@ -2636,6 +2745,7 @@ void LuaScripting::endCommandGroup()
 //==============================================================================
 
 #ifdef LUASCRIPTING_UNIT_TESTS
+#include <ctime>
 #include "utestCommon.h"
 using namespace tuvok;
 
@@ -3431,6 +3541,78 @@ SUITE(TestLuaScriptingSystem)
 
   // More unit tests are spread out amongst the Lua* files.
 
+  int handleSum = 0;
+  int handleAdd(int a)    {handleSum += a; return handleSum;}
+  int handleNegate(int a) {return -a;}
+  void handleNop()        {}
+
+  TEST(TestFunctionHandles)
+  {
+    TEST_HEADER;
+
+    unique_ptr<LuaScripting> sc(new LuaScripting());
+
+    sc->registerFunction(&handleAdd, "handles.add", "", false);
+    // Like functions called every frame, keep it out of the provenance log.
+    sc->setProvenanceExempt("handles.add");
+
+    CHECK_THROW(sc->resolve("handles.none"), LuaNonExistantFunction);
+    CHECK(LuaFunHandle().isValid() == false);
+
+    handleSum = 0;
+    LuaFunHandle add = sc->resolve("handles.add");
+    CHECK(add.isValid());
+    sc->cexec(add, 2);
+    CHECK_EQUAL(5, sc->cexecRet<int>(add, 3));
+    CHECK_EQUAL(6, sc->cexecRet<int>("handles.add", 1));
+
+    // Handles follow the name: they fail once it is gone, and pick up
+    // whatever is registered under it later.
+    sc->setExpectedExceptionFlag(true);
+    sc->exec("handles.add = nil");
+    CHECK_THROW(sc->cexec(add, 1), LuaNonExistantFunction);
+    CHECK_THROW(sc->cexec("handles.add", 1), LuaNonExistantFunction);
+    sc->setExpectedExceptionFlag(false);
+    sc->registerFunction(&handleNegate, "handles.add", "", false);
+    CHECK_EQUAL(-4, sc->cexecRet<int>(add, 4));
+    CHECK_EQUAL(-7, sc->cexecRet<int>("handles.add", 7));
+
+    // Names only called by name are forgotten when registrations change,
+    // and their slots reused; handles from resolve keep theirs.
+    sc->registerFunction(&handleAdd, "handles.other", "", false);
+    sc->cexec("handles.other", 0);
+    sc->exec("handles.other = nil");
+    sc->registerFunction(&handleAdd, "handles.more", "", false);
+    handleSum = 0;
+    CHECK_EQUAL(2, sc->cexecRet<int>("handles.more", 2));
+    CHECK_EQUAL(-3, sc->cexecRet<int>(add, 3));
+
+    // Neither do names called without arguments, such as per instance
+    // functions of class instances which come and go.
+    const size_t slots = sc->getNumHandleSlots();
+    for (int i = 0; i < 100; ++i)
+    {
+      std::ostringstream name;
+      name << "handles.nop" << i;
+      sc->registerFunction(&handleNop, name.str(), "", false);
+      sc->cexec(name.str());
+      sc->exec(name.str() + " = nil");
+    }
+    CHECK(sc->getNumHandleSlots() <= slots + 1);
+
+    // Calls per second, by name and through a handle.
+    sc->setProvenanceExempt("handles.add");
+    const int calls = 200000;
+    clock_t start = clock();
+    for (int i = 0; i < calls; ++i) sc->cexec("handles.add", i);
+    const double byName = double(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    for (int i = 0; i < calls; ++i) sc->cexec(add, i);
+    const double byHandle = double(clock() - start) / CLOCKS_PER_SEC;
+    printf("cexec by name: %.0f calls/s, by handle: %.0f calls/s\n",
+           calls / byName, calls / byHandle);
+  }
+
   /// TODO: Add tests for passing shared_ptr's around, and how they work
   /// with regards to the undo/redo stack.
 
@@ -41,8 +41,12 @@
 #ifndef TUVOK_LUASCRIPTING_H_
 #define TUVOK_LUASCRIPTING_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #ifndef LUASCRIPTING_NO_TUVOK
 
@@ -80,6 +84,28 @@ class LuaMemberRegUnsafe;
 class LuaClassConstructor;
 template <class T> class LuaClassRegistration;
 
+/// A registered function, looked up once.  Calling through a handle skips
+/// splitting the fully qualified name and walking the tables it names, which
+/// matters for functions called every frame.  Obtain handles from
+/// LuaScripting::resolve; they may be used as long as the LuaScripting
+/// instance that created them lives.  When functions are registered or
+/// unregistered, or arbitrary Lua code runs, handles are looked up again on
+/// their next use, so a handle to an unregistered function throws just like
+/// calling it by name does.
+class LuaFunHandle
+{
+public:
+  LuaFunHandle() : mSlot(NO_SLOT) {}
+  bool isValid() const {return mSlot != NO_SLOT;}
+
+private:
+  friend class LuaScripting;
+  explicit LuaFunHandle(size_t slot) : mSlot(slot) {}
+
+  static const size_t NO_SLOT = ~size_t(0);
+  size_t mSlot;
+};
+
 /// Usage Note: If you construct any Lua Class instances that retain a
 /// shared_ptr reference to this LuaScripting class, be sure to call
 /// removeAllRegistrations before deleting LuaScripting.
@@ -252,13 +278,22 @@ public:
   template <typename T>
   T execRet(const std::string& cmd);
 
+  /// Looks up a registered function for later calls with cexec/cexecRet.
+  /// Throws LuaNonExistantFunction if there is no such function.
+  ///
+  /// Example: LuaFunHandle f = resolve("renderer.eye");
+  ///          cexec(f, a, b, ...);
+  LuaFunHandle resolve(const std::string& fqName);
+
   /// The following functions allow you to call a function using C++ types.
   /// These function are more efficient than the exec functions given above.
+  /// The function is given by name or, faster yet, by a handle from resolve.
   /// The general form of these functions is given in the below example
   ///
   /// Example: cexec("myFunc", a, b, c, d, ...)
   ///@{
   void cexec(const std::string& cmd);
+  void cexec(const LuaFunHandle& fun);
 
   // Include the cexec function prototypes.
   TUVOK_LUA_CEXEC_FUNCTIONS
@@ -275,6 +310,8 @@ public:
   ///@{
   template <typename T>
   T cexecRet(const std::string& cmd);
+  template <typename T>
+  T cexecRet(const LuaFunHandle& fun);
 
   // Include the cexecRet function prototypes.
   TUVOK_LUA_CEXEC_RET_FUNCTIONS
@@ -405,6 +442,10 @@ public:
   /// Any public use of this function should be for testing purposes only.
   lua_State* getLuaState() const {return mL;}
 
+  /// Number of function handle slots, free ones included.
+  /// Any public use of this function should be for testing purposes only.
+  size_t getNumHandleSlots() const {return mResolved.size();}
+
   /// Notifies the scripting system of an object's deletion.
   /// Use this function in the object's destructor if you believe deleteClass
   /// was not called on the object (E.G. the object is GUI window, and the user
@@ -495,6 +536,23 @@ private:
 
   /// Prepare function for execution (places function on the top of the stack).
   void prepForExecution(const std::string& fqName);
+  void prepForExecution(const LuaFunHandle& fun);
+
+  /// Looks the handle's function up again if registrations changed since
+  /// it was last looked up.
+  void refreshHandle(size_t slot);
+
+  /// Name of the function behind the handle.
+  const std::string& funName(const LuaFunHandle& fun) const;
+
+  /// Resolves a name for the name based cexec/cexecRet.  Unlike slots handed
+  /// out by resolve, these are forgotten when handles are invalidated.
+  LuaFunHandle lookup(const std::string& fqName);
+
+  /// Makes all handles look their function up again before their next use.
+  /// Releases the references they hold, so deleted class instances and
+  /// unregistered functions can be collected.
+  void invalidateHandles();
 
   /// Execute the function on the top of the stack. Works excatly like lua_call.
   void executeFunctionOnStack(int nparams, int nret);
@@ -703,6 +761,21 @@ private:
 
   bool                              mVerboseMode;
 
+  /// A function resolved for a LuaFunHandle: registry references to its
+  /// table and the table's __call function.
+  struct ResolvedFun
+  {
+    std::string name;
+    int         tableRef;
+    int         callRef;
+    uint64_t    generation; ///< mHandleGeneration at lookup time
+    bool        handedOut;  ///< returned by resolve; the slot is kept
+  };
+  std::vector<ResolvedFun>                mResolved;     ///< handle slots
+  std::unordered_map<std::string, size_t> mResolvedSlots;///< name -> slot
+  std::vector<size_t>                     mFreeSlots;    ///< unused slots
+  uint64_t                                mHandleGeneration;
+
   /// These structures were created in order to handle void return types easily
   ///@{
   template <typename FunPtr, typename Ret>
@@ -933,6 +1006,8 @@ void LuaScripting::registerClassStatic(
 template <typename T>
 T LuaScripting::execRet(const std::string& cmd)
 {
+  // Arbitrary Lua code may rebind any function name.
+  invalidateHandles();
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
 
   std::string retCmd = "return " + cmd;
@@ -945,9 +1020,15 @@ T LuaScripting::execRet(const std::string& cmd)
 
 template <typename T>
 T LuaScripting::cexecRet(const std::string& name)
+{
+  return cexecRet<T>(lookup(name));
+}
+
+template <typename T>
+T LuaScripting::cexecRet(const LuaFunHandle& fun)
 {
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-  prepForExecution(name);
+  prepForExecution(fun);
   executeFunctionOnStack(0, 1);
   T ret = LuaStrictStack<T>::get(mL, lua_gettop(mL));
   lua_pop(mL, 1); // Pop return value.
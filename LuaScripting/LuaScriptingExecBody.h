@@ -35,9 +35,14 @@
 
   template <typename P1>
   void LuaScripting::cexec(const std::string& name, P1 p1)
+  {
+    cexec(lookup(name), p1);
+  }
+  template <typename P1>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -47,7 +52,7 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -55,9 +60,14 @@
   }
   template <typename P1, typename P2>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2)
+  {
+    cexec(lookup(name), p1, p2);
+  }
+  template <typename P1, typename P2>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -67,8 +77,8 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -77,9 +87,14 @@
   }
   template <typename P1, typename P2, typename P3>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3)
+  {
+    cexec(lookup(name), p1, p2, p3);
+  }
+  template <typename P1, typename P2, typename P3>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -89,9 +104,9 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -101,9 +116,14 @@
   }
   template <typename P1, typename P2, typename P3, typename P4>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4)
+  {
+    cexec(lookup(name), p1, p2, p3, p4);
+  }
+  template <typename P1, typename P2, typename P3, typename P4>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -113,10 +133,10 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -127,9 +147,14 @@
   }
   template <typename P1, typename P2, typename P3, typename P4, typename P5>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5)
+  {
+    cexec(lookup(name), p1, p2, p3, p4, p5);
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -139,11 +164,11 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -155,9 +180,14 @@
   }
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6)
+  {
+    cexec(lookup(name), p1, p2, p3, p4, p5, p6);
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -167,12 +197,12 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -185,9 +215,14 @@
   }
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7)
+  {
+    cexec(lookup(name), p1, p2, p3, p4, p5, p6, p7);
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -197,13 +232,13 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -217,9 +252,14 @@
   }
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8)
+  {
+    cexec(lookup(name), p1, p2, p3, p4, p5, p6, p7, p8);
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -229,14 +269,14 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P8>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P8>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -251,9 +291,14 @@
   }
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9)
+  {
+    cexec(lookup(name), p1, p2, p3, p4, p5, p6, p7, p8, p9);
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -263,15 +308,15 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P8>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P9>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P8>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P9>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -287,9 +332,14 @@
   }
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10>
   void LuaScripting::cexec(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10)
+  {
+    cexec(lookup(name), p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10>
+  void LuaScripting::cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -299,16 +349,16 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P8>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P9>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P10>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P8>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P9>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P10>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -326,9 +376,14 @@
   
   template <typename T, typename P1>
   T LuaScripting::cexecRet(const std::string& name, P1 p1)
+  {
+    return cexecRet<T>(lookup(name), p1);
+  }
+  template <typename T, typename P1>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -338,7 +393,7 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -349,9 +404,14 @@
   }
   template <typename T, typename P1, typename P2>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2)
+  {
+    return cexecRet<T>(lookup(name), p1, p2);
+  }
+  template <typename T, typename P1, typename P2>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -361,8 +421,8 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -374,9 +434,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3);
+  }
+  template <typename T, typename P1, typename P2, typename P3>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -386,9 +451,9 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -401,9 +466,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3, typename P4>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3, p4);
+  }
+  template <typename T, typename P1, typename P2, typename P3, typename P4>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -413,10 +483,10 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -430,9 +500,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3, p4, p5);
+  }
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -442,11 +517,11 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -461,9 +536,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3, p4, p5, p6);
+  }
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -473,12 +553,12 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -494,9 +574,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3, p4, p5, p6, p7);
+  }
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -506,13 +591,13 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -529,9 +614,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3, p4, p5, p6, p7, p8);
+  }
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -541,14 +631,14 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P8>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P8>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -566,9 +656,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3, p4, p5, p6, p7, p8, p9);
+  }
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -578,15 +673,15 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P8>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P9>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P8>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P9>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
@@ -605,9 +700,14 @@
   }
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10>
   T LuaScripting::cexecRet(const std::string& name, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10)
+  {
+    return cexecRet<T>(lookup(name), p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);
+  }
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10>
+  T LuaScripting::cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10)
   {
     LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-    prepForExecution(name);
+    prepForExecution(fun);
   #ifdef TUVOK_DEBUG_LUA_USE_RTTI_CHECKS
     int ftable = lua_gettop(mL);
     lua_getfield(mL, ftable, TBL_MD_NUM_PARAMS);
@@ -617,16 +717,16 @@
     lua_getfield(mL, ftable, LuaScripting::TBL_MD_TYPES_TABLE);
     int ttable = lua_gettop(mL);
     int check_pos = 0;
-    Tuvok_luaCheckParam<P1>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P2>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P3>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P4>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P5>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P6>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P7>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P8>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P9>(mL, name, ttable, check_pos++);
-    Tuvok_luaCheckParam<P10>(mL, name, ttable, check_pos++);
+    Tuvok_luaCheckParam<P1>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P2>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P3>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P4>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P5>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P6>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P7>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P8>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P9>(mL, funName(fun), ttable, check_pos++);
+    Tuvok_luaCheckParam<P10>(mL, funName(fun), ttable, check_pos++);
     lua_pop(mL, 1);
   #endif
     LuaStrictStack<P1>::push(mL, p1);
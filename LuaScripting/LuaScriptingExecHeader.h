@@ -36,46 +36,86 @@
 #define TUVOK_LUA_CEXEC_FUNCTIONS \
   template <typename P1> \
   void cexec(const std::string& cmd, P1 p1);\
+  template <typename P1> \
+  void cexec(const LuaFunHandle& fun, P1 p1);\
   template <typename P1, typename P2> \
   void cexec(const std::string& cmd, P1 p1, P2 p2);\
+  template <typename P1, typename P2> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2);\
   template <typename P1, typename P2, typename P3> \
   void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3);\
+  template <typename P1, typename P2, typename P3> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3);\
   template <typename P1, typename P2, typename P3, typename P4> \
   void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4);\
+  template <typename P1, typename P2, typename P3, typename P4> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4);\
   template <typename P1, typename P2, typename P3, typename P4, typename P5> \
   void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5);\
+  template <typename P1, typename P2, typename P3, typename P4, typename P5> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5);\
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6> \
   void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6);\
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6);\
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7> \
   void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7);\
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7);\
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8> \
   void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8);\
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8);\
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9> \
   void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9);\
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9> \
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9);\
+  template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10> \
+  void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10);\
   template <typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10> \
-  void cexec(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10);
+  void cexec(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10);
   
 #define TUVOK_LUA_CEXEC_RET_FUNCTIONS \
   template <typename T, typename P1> \
   T cexecRet(const std::string& cmd, P1 p1);\
+  template <typename T, typename P1> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1);\
   template <typename T, typename P1, typename P2> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2);\
+  template <typename T, typename P1, typename P2> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2);\
   template <typename T, typename P1, typename P2, typename P3> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3);\
+  template <typename T, typename P1, typename P2, typename P3> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3);\
   template <typename T, typename P1, typename P2, typename P3, typename P4> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4);\
+  template <typename T, typename P1, typename P2, typename P3, typename P4> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4);\
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5);\
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5);\
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6);\
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6);\
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7);\
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7);\
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8);\
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8);\
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9> \
   T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9);\
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9> \
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9);\
+  template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10> \
+  T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10);\
   template <typename T, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9, typename P10> \
-  T cexecRet(const std::string& cmd, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10);
+  T cexecRet(const LuaFunHandle& fun, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9, P10 p10);
   
 #define TUVOK_LUA_SETDEFAULTS_FUNCTIONS \
   template <typename P1> \
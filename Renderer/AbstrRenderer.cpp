@@ -43,6 +43,8 @@
 #include "Basics/GeometryGenerator.h"
 #include "Basics/SysTools.h"
 #include "IO/Tuvok_QtPlugins.h"
+#include "IO/BrickedDataset.h"
+#include "IO/DynamicBrickingDS.h"
 #include "IO/IOManager.h"
 #include "IO/TransferFunction1D.h"
 #include "IO/TransferFunction2D.h"
@@ -919,6 +921,20 @@ bool AbstrRenderer::RegionNeedsBrick(const RenderRegion& rr,
   return true;
 }
 
+bool AbstrRenderer::RegionMayNeedBox(const RenderRegion& rr,
+                                     const FLOATVECTOR3& vCenter,
+                                     const FLOATVECTOR3& vExtension) const
+{
+  // 2D regions do not cull spatially; see RegionNeedsBrick.
+  if(rr.is2D()) { return true; }
+  if(!m_FrustumCullingLOD.IsVisible(vCenter, vExtension)) { return false; }
+  // if all corners of the box are clipped, so is everything within it.
+  Brick b;
+  b.vCenter = vCenter;
+  b.vExtension = vExtension;
+  return !(m_bClipPlaneOn && Clipped(rr, b));
+}
+
 /// @return true if this brick is clipped by a clipping plane.
 bool AbstrRenderer::Clipped(const RenderRegion& rr, const Brick& b) const
 {
@@ -966,23 +982,20 @@ bool AbstrRenderer::ContainsData(const BrickKey& key) const
   // render mode dictates how we look at data ...
   switch (m_eRenderMode) {
     case RM_1DTRANS:
-      // ... in 1D we only care about the range of data in a brick
-      bContainsData = m_pDataset->ContainsData(
-                        key,
-                        double(m_p1DTrans->GetNonZeroLimits().x) * fRescaleFactor,
-                        double(m_p1DTrans->GetNonZeroLimits().y) * fRescaleFactor
-                      );
+      // ... in 1D we only care about which data values are in a brick
+      bContainsData = m_pDataset->ContainsData(key, NonZero1DValueRanges());
       break;
-    case RM_2DTRANS:
+    case RM_2DTRANS: {
       // ... in 2D we also need to concern ourselves w/ min/max gradients
+      const DOUBLEVECTOR2 vGradients = NonZero2DGradientRange();
       bContainsData = m_pDataset->ContainsData(
                         key,
                         double(m_p2DTrans->GetNonZeroLimits().x) * fRescaleFactor,
                         double(m_p2DTrans->GetNonZeroLimits().y) * fRescaleFactor,
-                        double(m_p2DTrans->GetNonZeroLimits().z),
-                        double(m_p2DTrans->GetNonZeroLimits().w)
+                        vGradients.x, vGradients.y
                       );
       break;
+    }
     case RM_ISOSURFACE:
       // ... and in isosurface mode we only care about a single value.
       bContainsData = m_pDataset->ContainsData(key, m_fIsovalue);
@@ -996,6 +1009,48 @@ bool AbstrRenderer::ContainsData(const BrickKey& key) const
   return bContainsData;
 }
 
+DOUBLEVECTOR2 AbstrRenderer::NonZero2DGradientRange() const
+{
+  const UINT64VECTOR4& limits = m_p2DTrans->GetNonZeroLimits();
+  if (limits.z > limits.w) {
+    return DOUBLEVECTOR2(std::numeric_limits<double>::max(),
+                        -std::numeric_limits<double>::max());
+  }
+  // The shaders look a magnitude up at 1 - magnitude/MaxGradientMagnitude,
+  // so row 0 is the steepest; linear interpolation reaches into the rows
+  // next to the non-zero ones, and everything beyond the ends is clamped.
+  const double fMaxGradient = (m_pDataset->MaxGradientMagnitude() == 0) ?
+                              1.0 : m_pDataset->MaxGradientMagnitude();
+  const double fRows = double(m_p2DTrans->GetSize().y);
+  const double fMin = (double(limits.w) + 2.0 >= fRows) ?
+                      -std::numeric_limits<double>::max() :
+                      fMaxGradient * (1.0 - (double(limits.w) + 2.0) / fRows);
+  const double fMax = (limits.z < 1) ?
+                      std::numeric_limits<double>::max() :
+                      fMaxGradient * (1.0 - (double(limits.z) - 1.0) / fRows);
+  return DOUBLEVECTOR2(fMin, fMax);
+}
+
+ValueRanges AbstrRenderer::NonZero1DValueRanges() const
+{
+  double fMaxValue = (m_pDataset->GetRange().first > m_pDataset->GetRange().second) ?
+                          m_p1DTrans->GetSize() : m_pDataset->GetRange().second;
+  double fRescaleFactor = fMaxValue / double(m_p1DTrans->GetSize()-1);
+
+  // Linear interpolation reaches one entry past either end of a run, so a
+  // value next to it still shows; the lookup clamps to the table.
+  const uint64_t iLast = uint64_t(m_p1DTrans->GetSize()) - 1;
+  const std::vector<UINT64VECTOR2>& vRuns = m_p1DTrans->GetNonZeroRanges();
+  ValueRanges ranges(vRuns.size());
+  for (size_t i = 0; i < vRuns.size(); ++i) {
+    const uint64_t iLow = (vRuns[i].x > 0) ? vRuns[i].x - 1 : 0;
+    const uint64_t iHigh = std::min(vRuns[i].y + 1, iLast);
+    ranges[i] = std::make_pair(double(iLow) * fRescaleFactor,
+                               double(iHigh) * fRescaleFactor);
+  }
+  return ranges;
+}
+
 vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistanceCriterion) {
   vector<Brick> vBrickList;
   UINT64VECTOR3 vDomainSize = m_pDataset->GetDomainSize(0);
@@ -1014,13 +1069,7 @@ vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistance
           static_cast<unsigned>(m_pDataset->GetBrickCount(size_t(m_iCurrentLOD),
                                                           m_iTimestep)));
 
-  BrickTable::const_iterator brick = m_pDataset->BricksBegin();
-  for(; brick != m_pDataset->BricksEnd(); ++brick) {
-    // skip over the brick if it's for the wrong timestep or LOD
-    if(std::get<0>(brick->first) != m_iTimestep ||
-       std::get<1>(brick->first) != m_iCurrentLOD) {
-      continue;
-    }
+  auto consider = [&](BrickTable::const_iterator brick) {
     const BrickMD& bmd = brick->second;
     Brick b;
     b.vExtension = bmd.extents * vScale;
@@ -1045,7 +1094,7 @@ vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistance
               static_cast<unsigned>(std::get<0>(brick->first)),
               static_cast<unsigned>(std::get<1>(brick->first)),
               static_cast<unsigned>(std::get<2>(brick->first)));
-      continue;
+      return;
     }
 
     if(b.bIsEmpty) {
@@ -1078,23 +1127,60 @@ vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistance
         b.fDistance = brick_distance(b, GetFirst3DRegion()->modelView[0]);
       }
     }
-/*
-MESSAGE("considering brick <%zu,%zu,%zu>", std::get<0>(brick->first),
-            std::get<1>(brick->first), std::get<2>(brick->first));
-            */
 
     // add the brick to the list of active bricks
     vBrickList.push_back(b);
-  }
-
-  // depth sort bricks
+  };
 
   /// @todo FIXME?: we need to do smarter sorting.  If we've got multiple 3D
   /// regions, they might need different orderings.  However, we want to try to
   /// traverse bricks in a similar order, because the IO will rape us
   /// otherwise.
   /// For now, IV3D doesn't support multiple 3D regions in a single renderer.
-  sort(vBrickList.begin(), vBrickList.end());
+  const BrickedDataset* bds = dynamic_cast<const BrickedDataset*>(m_pDataset);
+  if(bds) {
+    // the index hands us the bricks of this timestep + LOD already in depth
+    // order, and lets us cull whole groups of them.  Culling uses the same
+    // scale as RegionNeedsBrick.
+    UINT64VECTOR3 vLODSize = m_pDataset->GetDomainSize(size_t(m_iCurrentLOD));
+    FLOATVECTOR3 vCullScale = FLOATVECTOR3(m_pDataset->GetScale());
+    vCullScale /= (vCullScale * FLOATVECTOR3(vLODSize) /
+                   float(vLODSize.maxVal())).maxVal();
+    FLOATVECTOR3 vEye(0,0,0);
+    std::shared_ptr<RenderRegion3D> region3D = GetFirst3DRegion();
+    if(region3D) {
+      vEye = (FLOATVECTOR4(0,0,0,1) *
+              region3D->modelView[0].inverse()).xyz() / vScale;
+    }
+    auto mayNeed = [&](const FLOATVECTOR3& vCenter,
+                       const FLOATVECTOR3& vExtension) {
+      for(auto reg = renderRegions.cbegin(); reg != renderRegions.cend();
+          ++reg) {
+        if(RegionMayNeedBox(**reg, vCenter * vCullScale,
+                            vExtension * vCullScale)) {
+          return true;
+        }
+      }
+      return false;
+    };
+    bds->GetBrickIndex(size_t(m_iTimestep), size_t(m_iCurrentLOD))
+      ->FrontToBack(vEye, mayNeed, consider);
+    if(bUseResidencyAsDistanceCriterion) {
+      std::stable_partition(vBrickList.begin(), vBrickList.end(),
+                            [](const Brick& b) { return b.fDistance < 1; });
+    }
+  } else {
+    BrickTable::const_iterator brick = m_pDataset->BricksBegin();
+    for(; brick != m_pDataset->BricksEnd(); ++brick) {
+      // skip over the brick if it's for the wrong timestep or LOD
+      if(std::get<0>(brick->first) == m_iTimestep &&
+         std::get<1>(brick->first) == m_iCurrentLOD) {
+        consider(brick);
+      }
+    }
+    // depth sort bricks
+    sort(vBrickList.begin(), vBrickList.end());
+  }
 
   return vBrickList;
 }
@@ -1195,6 +1281,7 @@ void AbstrRenderer::PlanFrame(RenderRegion3D& region) {
       MESSAGE("Building new brick list for LOD %llu...", m_iCurrentLOD);
       m_vCurrentBrickList = BuildSubFrameBrickList();
       MESSAGE("%u bricks made the cut.", uint32_t(m_vCurrentBrickList.size()));
+      PrefetchBricks(m_vCurrentBrickList);
       if (m_bDoStereoRendering) {
         m_vLeftEyeBrickList =
           BuildLeftEyeSubFrameBrickList(region.modelView[1], m_vCurrentBrickList);
@@ -1211,6 +1298,21 @@ void AbstrRenderer::PlanFrame(RenderRegion3D& region) {
   }
 }
 
+// Bricks are read as they are rendered, one after the other.  Data sets
+// which can read ahead then have the rest of the list loading meanwhile.
+void AbstrRenderer::PrefetchBricks(const vector<Brick>& vBricks) const {
+  const DynamicBrickingDS* ds =
+    dynamic_cast<const DynamicBrickingDS*>(m_pDataset);
+  if(!ds) { return; }
+  vector<BrickKey> keys;
+  keys.reserve(vBricks.size());
+  for(vector<Brick>::const_iterator b = vBricks.begin(); b != vBricks.end();
+      ++b) {
+    if(!IsVolumeResident(b->kBrick)) { keys.push_back(b->kBrick); }
+  }
+  if(!keys.empty()) { ds->Prefetch(keys); }
+}
+
 void AbstrRenderer::PlanHQMIPFrame(RenderRegion& renderRegion) {
   // compute modelviewmatrix and pass it to the culling object
   renderRegion.modelView[0] = renderRegion.rotation*renderRegion.translation*m_mView[0];
@@ -1236,6 +1338,7 @@ void AbstrRenderer::PlanHQMIPFrame(RenderRegion& renderRegion) {
 
   // build new brick todo-list
   m_vCurrentBrickList = BuildSubFrameBrickList(true);
+  PrefetchBricks(m_vCurrentBrickList);
 
   m_iBricksRenderedInThisSubFrame = 0;
 
@@ -832,15 +832,27 @@ class AbstrRenderer {
     bool RegionNeedsBrick(const RenderRegion& rr, const BrickKey& key,
                           const BrickMD& bmd,
                           bool& bIsEmptyButInFrustum) const;
+    /// @return false if no brick within the given (scaled) box can be
+    /// needed to render the given region.
+    bool RegionMayNeedBox(const RenderRegion& rr, const FLOATVECTOR3& vCenter,
+                          const FLOATVECTOR3& vExtension) const;
     /// @return true if this brick is clipped by a clipping plane.
     bool Clipped(const RenderRegion&, const Brick&) const;
     /// does the current brick contain relevant data?
     bool ContainsData(const BrickKey&) const;
+    /// @return the data values the 1D TF gives a non-zero opacity.
+    ValueRanges NonZero1DValueRanges() const;
+    /// @return the gradient magnitudes the 2D TF's non-zero rows can be
+    /// looked up for, in the units of MinMaxBlock's gradients.
+    DOUBLEVECTOR2 NonZero2DGradientRange() const;
     std::vector<Brick>  BuildSubFrameBrickList(bool bUseResidencyAsDistanceCriterion=false);
     std::vector<Brick>  BuildLeftEyeSubFrameBrickList(
                           const FLOATMATRIX4& modelview,
                           const std::vector<Brick>& vRightEyeBrickList
                         ) const;
+    /// starts reading the bricks which are not resident yet in the
+    /// background, if the data set can do that.
+    void                PrefetchBricks(const std::vector<Brick>& vBricks) const;
     void                CompletedASubframe(RenderRegion* region);
     void                RestartTimer(const size_t iTimerIndex);
     void                RestartTimers();
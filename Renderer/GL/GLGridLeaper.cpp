@@ -657,7 +657,7 @@ UINTVECTOR4 GLGridLeaper::RecomputeBrickVisibility(bool bForceSynchronousUpdate)
   case RM_1DTRANS: {
     double const fMin = double(m_p1DTrans->GetNonZeroLimits().x) * fRescaleFactor;
     double const fMax = double(m_p1DTrans->GetNonZeroLimits().y) * fRescaleFactor;
-    if (m_VisibilityState.NeedsUpdate(fMin, fMax) ||
+    if (m_VisibilityState.NeedsUpdate(fMin, fMax, NonZero1DValueRanges()) ||
         bForceSynchronousUpdate) {
       vEmptyBrickCount = m_pVolumePool->RecomputeVisibility(m_VisibilityState, m_iTimestep, bForceSynchronousUpdate);
     }
@@ -665,8 +665,9 @@ UINTVECTOR4 GLGridLeaper::RecomputeBrickVisibility(bool bForceSynchronousUpdate)
   case RM_2DTRANS: {
     double const fMin = double(m_p2DTrans->GetNonZeroLimits().x) * fRescaleFactor;
     double const fMax = double(m_p2DTrans->GetNonZeroLimits().y) * fRescaleFactor;
-    double const fMinGradient = double(m_p2DTrans->GetNonZeroLimits().z);
-    double const fMaxGradient = double(m_p2DTrans->GetNonZeroLimits().w);
+    DOUBLEVECTOR2 const vGradients = NonZero2DGradientRange();
+    double const fMinGradient = vGradients.x;
+    double const fMaxGradient = vGradients.y;
     if (m_VisibilityState.NeedsUpdate(fMin, fMax, fMinGradient, fMaxGradient) ||
         bForceSynchronousUpdate) {
       vEmptyBrickCount = m_pVolumePool->RecomputeVisibility(m_VisibilityState, m_iTimestep, bForceSynchronousUpdate);
@@ -80,6 +80,16 @@ GLTexture3D::GLTexture3D(uint32_t iSizeX, uint32_t iSizeY, uint32_t iSizeZ,
   GL(glBindTexture(GL_TEXTURE_3D, prevTex));
 }
 
+void GLTexture3D::SetData(const UINTVECTOR3& offset, const UINTVECTOR3& size,
+                          uint32_t rowLength, uint32_t imageHeight,
+                          const void *pixels, bool bRestoreBinding) {
+  GL(glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength));
+  GL(glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, imageHeight));
+  SetData(offset, size, pixels, bRestoreBinding);
+  GL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+  GL(glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0));
+}
+
 void GLTexture3D::SetData(const UINTVECTOR3& offset, const UINTVECTOR3& size,
                           const void *pixels, bool bRestoreBinding) {
   GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
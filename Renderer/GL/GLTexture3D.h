@@ -73,6 +73,11 @@ class GLTexture3D : public GLTexture {
     virtual void SetData(const void *pixels, bool bRestoreBinding=true);
     void SetData(const UINTVECTOR3& offset, const UINTVECTOR3& size,
                  const void *pixels, bool bRestoreBinding=true);
+    /// as above, but rows of 'pixels' are 'rowLength' texels apart and its
+    /// slices are 'imageHeight' rows apart.  Zero means "tightly packed".
+    void SetData(const UINTVECTOR3& offset, const UINTVECTOR3& size,
+                 uint32_t rowLength, uint32_t imageHeight,
+                 const void *pixels, bool bRestoreBinding=true);
 
     virtual std::shared_ptr<void> GetData();
 
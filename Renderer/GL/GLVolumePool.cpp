@@ -229,9 +229,10 @@ GLVolumePool::GLVolumePool(const UINTVECTOR3& poolSize,
   for (uint32_t i = 0; i < m_vMinMaxScalar.size(); i++) {
     UINTVECTOR4 const vBrickID = GetVectorBrickID(i);
     BrickKey const key = m_pDataset->IndexFrom4D(vBrickID, m_iMinMaxScalarTimestep);
-    MinMaxBlock imme = m_pDataset->MaxMinForKey(key);
-    m_vMinMaxScalar[i].min = imme.minScalar;
-    m_vMinMaxScalar[i].max = imme.maxScalar;
+    ValueOccupancy const occupancy = m_pDataset->OccupancyForKey(key);
+    m_vMinMaxScalar[i].min = occupancy.fMin;
+    m_vMinMaxScalar[i].max = occupancy.fMax;
+    m_vMinMaxScalar[i].occupancy = occupancy.iBins;
   }
 
   switch (m_eDebugMode) {
@@ -670,8 +671,9 @@ std::string GLVolumePool::GetShaderFragment(uint32_t iMetaTextureUnit,
 }
 
 
-void GLVolumePool::UploadBrick(uint32_t iBrickID, const UINTVECTOR3& vVoxelSize, void* pData, 
-                               size_t iInsertPos, uint64_t iTimeOfCreation)
+void GLVolumePool::UploadBrick(uint32_t iBrickID, const UINTVECTOR3& vVoxelSize, const void* pData,
+                               size_t iInsertPos, uint64_t iTimeOfCreation,
+                               uint32_t iRowLength, uint32_t iImageHeight)
 {
   StackTimer ubrick(PERF_POOL_UPLOAD_BRICK);
   PoolSlotData& slot = m_vPoolSlotData[iInsertPos];
@@ -713,7 +715,8 @@ void GLVolumePool::UploadBrick(uint32_t iBrickID, const UINTVECTOR3& vVoxelSize,
   UploadMetadataTexel(slot.m_iBrickID);
 
   // upload brick to 3D texture
-  m_pPoolDataTexture->SetData(slot.PositionInPool() * m_maxTotalBrickSize, vVoxelSize, pData);
+  m_pPoolDataTexture->SetData(slot.PositionInPool() * m_maxTotalBrickSize, vVoxelSize,
+                              iRowLength, iImageHeight, pData);
 }
 
 namespace {
@@ -765,18 +768,26 @@ void GLVolumePool::UploadFirstBrick(const UINTVECTOR3& m_vVoxelSize, void* pData
   UploadBrick(iLastBrickIndex, m_vVoxelSize, pData, m_vPoolSlotData.size()-1, std::numeric_limits<uint64_t>::max());
 }
 
-bool GLVolumePool::UploadBrick(const BrickElemInfo& metaData, void* pData) {
+bool GLVolumePool::UploadBrick(const BrickElemInfo& metaData, const void* pData,
+                               uint32_t iRowLength, uint32_t iImageHeight) {
   // in this frame we already replaced all bricks (except the single low-res brick)
   // in the pool so now we should render them first
   if (m_iInsertPos >= m_vPoolSlotData.size()-1)
     return false;
 
   int32_t iBrickID = GetIntegerBrickID(metaData.m_vBrickID);
-  UploadBrick(iBrickID, metaData.m_vVoxelSize, pData, m_iInsertPos, m_iTimeOfCreation++);
+  UploadBrick(iBrickID, metaData.m_vVoxelSize, pData, m_iInsertPos, m_iTimeOfCreation++,
+              iRowLength, iImageHeight);
   m_iInsertPos++;
   return true;
 }
 
+size_t GLVolumePool::GetFreeUploadSlots() const {
+  // the last slot is reserved for the single low-res brick
+  return m_iInsertPos+1 < m_vPoolSlotData.size()
+           ? m_vPoolSlotData.size()-1 - m_iInsertPos : 0;
+}
+
 bool GLVolumePool::IsBrickResident(const UINTVECTOR4& vBrickID) const {
 
   int32_t iBrickID = GetIntegerBrickID(vBrickID);
@@ -971,7 +982,11 @@ namespace {
     switch (eRenderMode) {
     case AbstrRenderer::RM_1DTRANS:
       return (visibility.Get1DTransfer().fMax >= vMinMaxScalar[iBrickID].min &&
-              visibility.Get1DTransfer().fMin <= vMinMaxScalar[iBrickID].max);
+              visibility.Get1DTransfer().fMin <= vMinMaxScalar[iBrickID].max) &&
+             ValueOccupancy(vMinMaxScalar[iBrickID].min,
+                            vMinMaxScalar[iBrickID].max,
+                            vMinMaxScalar[iBrickID].occupancy).Intersects(
+                              visibility.Get1DRanges());
       break;
     case AbstrRenderer::RM_2DTRANS:
       return (visibility.Get2DTransfer().fMax >= vMinMaxScalar[iBrickID].min &&
@@ -1357,37 +1372,74 @@ namespace {
     return vEmptyBrickCount;
   }
 
+  // Uploads 'vBrickIDs' until the pool needs to render first.  If the
+  // dataset can hand out a view of its own memory, that's uploaded directly
+  // and the pool needs no copy.  All other bricks are requested in a single
+  // batch, which lets the dataset fetch bricks that are close to each other
+  // in its file with a single read.  Brick debugging needs dense data, so it
+  // always reads the bricks.
   template<typename T, bool brickDebug>
   uint32_t UploadBricksToBrickPoolT(
     GLVolumePool& pool,
     std::vector<UINTVECTOR4> const& vBrickIDs,
     const LinearIndexDataset* pDataset,
-    size_t iTimestep,
-    const size_t maxUsedBrickVoxelCount // we pass it in here to avoid the pDataset->GetMaxUsedBrickSize() loop over all bricks
+    size_t iTimestep
   ) {
     uint32_t iPagedBricks = 0;
-    std::vector<T> vUploadMem(maxUsedBrickVoxelCount);
-    Timer t;
-    for (auto missingBrick = vBrickIDs.cbegin(); missingBrick < vBrickIDs.cend(); missingBrick++) {
-      UINTVECTOR4 const& vBrickID = *missingBrick;
-      BrickKey const key = pDataset->IndexFrom4D(vBrickID, iTimestep);
-      UINTVECTOR3 const vVoxelSize = pDataset->GetBrickVoxelCounts(key);
-
-      // upload brick core
-      {
+    // don't read what the pool could not take anyway
+    const size_t iBrickCount = std::min(vBrickIDs.size(),
+                                        pool.GetFreeUploadSlots());
+
+    std::vector<BrickKey> vKeys;
+    std::vector<UINTVECTOR4> vBatchIDs;
+    for (size_t i = 0; i < iBrickCount; ++i) {
+      BrickKey const key = pDataset->IndexFrom4D(vBrickIDs[i], iTimestep);
+      BrickView<T> view;
+      bool bView = false;
+      if (!brickDebug) {
         tuvok::StackTimer poolGetBrick(PERF_POOL_GET_BRICK);
-        pDataset->GetBrick(key, vUploadMem);
+        bView = pDataset->GetBrickView(key, view);
       }
-      if (brickDebug) {
-        writeBrick(key, vUploadMem);
+      if (!bView) {
+        vKeys.push_back(key);
+        vBatchIDs.push_back(vBrickIDs[i]);
+        continue;
       }
-      if (!pool.UploadBrick(BrickElemInfo(vBrickID, vVoxelSize), &vUploadMem[0]))
-        break;
-      else
-        iPagedBricks++;
 
-      tuvok::Controller::Instance().IncrementPerfCounter(PERF_POOL_UPLOADED_MEM, double(vUploadMem.size() * sizeof(T)));
+      UINTVECTOR3 const vVoxelSize = pDataset->GetBrickVoxelCounts(key);
+      if (!pool.UploadBrick(BrickElemInfo(vBrickIDs[i], vVoxelSize),
+                            view.data.get(), uint32_t(view.rowLength),
+                            uint32_t(view.imageHeight)))
+        return iPagedBricks;
+      iPagedBricks++;
+      tuvok::Controller::Instance().IncrementPerfCounter(PERF_POOL_UPLOADED_MEM, double(vVoxelSize.volume() * sizeof(T)));
     }
+    if (vKeys.empty()) return iPagedBricks;
+
+    // the time spent uploading is not part of getting the bricks
+    Timer tGet, tUpload;
+    double fUploadTime = 0.0;
+    tGet.Start();
+    pDataset->GetBricks(vKeys, std::function<bool(size_t, std::vector<T>&)>(
+      [&](size_t i, std::vector<T>& data) {
+        tUpload.Start();
+        if (brickDebug) {
+          writeBrick(vKeys[i], data);
+        }
+        UINTVECTOR3 const vVoxelSize = pDataset->GetBrickVoxelCounts(vKeys[i]);
+        const bool bUploaded =
+          pool.UploadBrick(BrickElemInfo(vBatchIDs[i], vVoxelSize), &data[0]);
+        if (bUploaded) {
+          iPagedBricks++;
+          tuvok::Controller::Instance().IncrementPerfCounter(PERF_POOL_UPLOADED_MEM, double(vVoxelSize.volume() * sizeof(T)));
+        }
+        fUploadTime += tUpload.Elapsed();
+        return bUploaded;
+      }
+    ));
+    tuvok::Controller::Instance().IncrementPerfCounter(
+      PERF_POOL_GET_BRICK, tGet.Elapsed() - fUploadTime
+    );
     return iPagedBricks;
   }
 
@@ -1396,7 +1448,6 @@ namespace {
     const std::vector<UINTVECTOR4>& vBrickIDs,
     const LinearIndexDataset* pDataset,
     size_t iTimestep,
-    const size_t maxUsedBrickVoxelCount, // we pass it in here to avoid the pDataset->GetMaxUsedBrickSize() loop over all bricks
     bool brickDebug
   ) {
     unsigned int const iBitWidth = pDataset->GetBitWidth();
@@ -1404,22 +1455,22 @@ namespace {
       // brick debugging enabled
       if (!pDataset->GetIsSigned()) {
         switch (iBitWidth) {
-        case 8  : return UploadBricksToBrickPoolT<uint8_t,  true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 16 : return UploadBricksToBrickPoolT<uint16_t, true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 32 : return UploadBricksToBrickPoolT<uint32_t, true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
+        case 8  : return UploadBricksToBrickPoolT<uint8_t,  true>(pool, vBrickIDs, pDataset, iTimestep);
+        case 16 : return UploadBricksToBrickPoolT<uint16_t, true>(pool, vBrickIDs, pDataset, iTimestep);
+        case 32 : return UploadBricksToBrickPoolT<uint32_t, true>(pool, vBrickIDs, pDataset, iTimestep);
         default : throw Exception("Invalid bit width for an unsigned dataset", _func_, __LINE__);
         }
       } else if (pDataset->GetIsFloat()) {
         switch (iBitWidth) {
-        case 32 : return UploadBricksToBrickPoolT<float,    true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 64 : return UploadBricksToBrickPoolT<double,   true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
+        case 32 : return UploadBricksToBrickPoolT<float,    true>(pool, vBrickIDs, pDataset, iTimestep);
+        case 64 : return UploadBricksToBrickPoolT<double,   true>(pool, vBrickIDs, pDataset, iTimestep);
         default : throw Exception("Invalid bit width for a float dataset", _func_, __LINE__);
         }
       } else {
         switch (iBitWidth) {
-        case 8  : return UploadBricksToBrickPoolT<int8_t,   true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 16 : return UploadBricksToBrickPoolT<int16_t,  true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 32 : return UploadBricksToBrickPoolT<int32_t,  true>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
+        case 8  : return UploadBricksToBrickPoolT<int8_t,   true>(pool, vBrickIDs, pDataset, iTimestep);
+        case 16 : return UploadBricksToBrickPoolT<int16_t,  true>(pool, vBrickIDs, pDataset, iTimestep);
+        case 32 : return UploadBricksToBrickPoolT<int32_t,  true>(pool, vBrickIDs, pDataset, iTimestep);
         default : throw Exception("Invalid bit width for a signed dataset", _func_, __LINE__);
         }
       }
@@ -1427,22 +1478,22 @@ namespace {
       // brick debugging disabled
       if (!pDataset->GetIsSigned()) {
         switch (iBitWidth) {
-        case 8  : return UploadBricksToBrickPoolT<uint8_t,  false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 16 : return UploadBricksToBrickPoolT<uint16_t, false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 32 : return UploadBricksToBrickPoolT<uint32_t, false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
+        case 8  : return UploadBricksToBrickPoolT<uint8_t,  false>(pool, vBrickIDs, pDataset, iTimestep);
+        case 16 : return UploadBricksToBrickPoolT<uint16_t, false>(pool, vBrickIDs, pDataset, iTimestep);
+        case 32 : return UploadBricksToBrickPoolT<uint32_t, false>(pool, vBrickIDs, pDataset, iTimestep);
         default : throw Exception("Invalid bit width for an unsigned dataset", _func_, __LINE__);
         }
       } else if (pDataset->GetIsFloat()) {
         switch (iBitWidth) {
-        case 32 : return UploadBricksToBrickPoolT<float,    false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 64 : return UploadBricksToBrickPoolT<double,   false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
+        case 32 : return UploadBricksToBrickPoolT<float,    false>(pool, vBrickIDs, pDataset, iTimestep);
+        case 64 : return UploadBricksToBrickPoolT<double,   false>(pool, vBrickIDs, pDataset, iTimestep);
         default : throw Exception("Invalid bit width for a float dataset", _func_, __LINE__);
         }
       } else {
         switch (iBitWidth) {
-        case 8  : return UploadBricksToBrickPoolT<int8_t,   false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 16 : return UploadBricksToBrickPoolT<int16_t,  false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
-        case 32 : return UploadBricksToBrickPoolT<int32_t,  false>(pool, vBrickIDs, pDataset, iTimestep, maxUsedBrickVoxelCount);
+        case 8  : return UploadBricksToBrickPoolT<int8_t,   false>(pool, vBrickIDs, pDataset, iTimestep);
+        case 16 : return UploadBricksToBrickPoolT<int16_t,  false>(pool, vBrickIDs, pDataset, iTimestep);
+        case 32 : return UploadBricksToBrickPoolT<int32_t,  false>(pool, vBrickIDs, pDataset, iTimestep);
         default : throw Exception("Invalid bit width for a signed dataset", _func_, __LINE__);
         }
       }
@@ -1459,20 +1510,13 @@ namespace {
     std::vector<uint32_t>& vBrickMetadata,
     const std::vector<UINTVECTOR4>& vBrickIDs,
     const std::vector<GLVolumePool::MinMax>& vMinMaxScalar,
-    const std::vector<GLVolumePool::MinMax>& vMinMaxGradient,
-    const size_t maxUsedBrickVoxelCount // we pass it in here to avoid the pDataset->GetMaxUsedBrickSize() loop over all bricks
+    const std::vector<GLVolumePool::MinMax>& vMinMaxGradient
   ) {
-    uint32_t iPagedBricks = 0;
-    std::vector<T> vUploadMem(maxUsedBrickVoxelCount);
-
-    // now iterate over the missing bricks and upload them to the GPU
-    // todo: consider batching this if it turns out to make a difference
-    //       from submitting each brick separately
-    Timer t;
+    // find the missing bricks which are worth uploading, then upload them
+    // in one go
+    std::vector<UINTVECTOR4> vUpload;
     for (auto missingBrick = vBrickIDs.cbegin(); missingBrick < vBrickIDs.cend(); missingBrick++) {
       UINTVECTOR4 const& vBrickID = *missingBrick;
-      BrickKey const key = pDataset->IndexFrom4D(vBrickID, iTimestep);
-      UINTVECTOR3 const vVoxelSize = pDataset->GetBrickVoxelCounts(key);
 
       uint32_t const brickIndex = pool.GetIntegerBrickID(vBrickID);
       // the brick could be flagged as empty by now if the async updater tested the brick after we ran the last render pass
@@ -1480,22 +1524,7 @@ namespace {
         // we might not have tested the brick for visibility yet since the updater's still running and we do not have a BI_UNKNOWN flag for now
         bool const bContainsData = ContainsData<eRenderMode>(visibility, brickIndex, vMinMaxScalar, vMinMaxGradient);
         if (bContainsData) {
-
-          // upload brick core
-          {
-            tuvok::StackTimer poolGetBrick(PERF_POOL_GET_BRICK);
-            pDataset->GetBrick(key, vUploadMem);
-          }
-          if(brickDebug) {
-            writeBrick(key, vUploadMem);
-          }
-          if (!pool.UploadBrick(BrickElemInfo(vBrickID, vVoxelSize), &vUploadMem[0]))
-            return iPagedBricks;
-          else
-            iPagedBricks++;
-
-          tuvok::Controller::Instance().IncrementPerfCounter(PERF_POOL_UPLOADED_MEM, double(vUploadMem.size() * sizeof(T)));
-
+          vUpload.push_back(vBrickID);
         } else {
           vBrickMetadata[brickIndex] = BI_EMPTY;
           pool.UploadMetadataTexel(brickIndex);
@@ -1507,7 +1536,7 @@ namespace {
         assert(false); // should never happen
       }
     }
-    return iPagedBricks;
+    return UploadBricksToBrickPoolT<T, brickDebug>(pool, vUpload, pDataset, iTimestep);
   }
 
   template<AbstrRenderer::ERenderMode eRenderMode>
@@ -1520,7 +1549,6 @@ namespace {
     const std::vector<UINTVECTOR4>& vBrickIDs,
     const std::vector<GLVolumePool::MinMax>& vMinMaxScalar,
     const std::vector<GLVolumePool::MinMax>& vMinMaxGradient,
-    const size_t maxUsedBrickVoxelCount, // we pass it in here to avoid the pDataset->GetMaxUsedBrickSize() loop over all bricks
     bool brickDebug
     ) {
       unsigned int const iBitWidth = pDataset->GetBitWidth();
@@ -1528,22 +1556,22 @@ namespace {
         // brick debugging enabled
         if (!pDataset->GetIsSigned()) {
           switch (iBitWidth) {
-          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint8_t,  true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint16_t, true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint32_t, true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
+          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint8_t,  true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint16_t, true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint32_t, true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
           default : throw Exception("Invalid bit width for an unsigned dataset", _func_, __LINE__);
           }
         } else if (pDataset->GetIsFloat()) {
           switch (iBitWidth) {
-          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, float,    true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 64 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, double,   true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
+          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, float,    true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 64 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, double,   true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
           default : throw Exception("Invalid bit width for a float dataset", _func_, __LINE__);
           }
         } else {
           switch (iBitWidth) {
-          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int8_t,   true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int16_t,  true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int32_t,  true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
+          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int8_t,   true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int16_t,  true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int32_t,  true>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
           default : throw Exception("Invalid bit width for a signed dataset", _func_, __LINE__);
           }
         }
@@ -1551,22 +1579,22 @@ namespace {
         // brick debugging disabled
         if (!pDataset->GetIsSigned()) {
           switch (iBitWidth) {
-          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint8_t,  false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint16_t, false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint32_t, false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
+          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint8_t,  false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint16_t, false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, uint32_t, false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
           default : throw Exception("Invalid bit width for an unsigned dataset", _func_, __LINE__);
           }
         } else if (pDataset->GetIsFloat()) {
           switch (iBitWidth) {
-          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, float,    false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 64 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, double,   false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
+          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, float,    false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 64 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, double,   false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
           default : throw Exception("Invalid bit width for a float dataset", _func_, __LINE__);
           }
         } else {
           switch (iBitWidth) {
-          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int8_t,   false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int16_t,  false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
-          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int32_t,  false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient, maxUsedBrickVoxelCount);
+          case 8  : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int8_t,   false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 16 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int16_t,  false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
+          case 32 : return PotentiallyUploadBricksToBrickPoolT<eRenderMode, int32_t,  false>(visibility, pDataset, iTimestep, pool, vBrickMetadata, vBrickIDs, vMinMaxScalar, vMinMaxGradient);
           default : throw Exception("Invalid bit width for a signed dataset", _func_, __LINE__);
           }
         }
@@ -1599,9 +1627,10 @@ UINTVECTOR4 GLVolumePool::RecomputeVisibility(VisibilityState const& visibility,
     for (uint32_t iBrickID = 0; iBrickID < m_vMinMaxScalar.size(); iBrickID++) {
       UINTVECTOR4 const vBrickID = GetVectorBrickID(iBrickID);
       BrickKey const key = m_pDataset->IndexFrom4D(vBrickID, m_iMinMaxScalarTimestep);
-      MinMaxBlock imme = m_pDataset->MaxMinForKey(key);
-      m_vMinMaxScalar[iBrickID].min = imme.minScalar;
-      m_vMinMaxScalar[iBrickID].max = imme.maxScalar;
+      ValueOccupancy const occupancy = m_pDataset->OccupancyForKey(key);
+      m_vMinMaxScalar[iBrickID].min = occupancy.fMin;
+      m_vMinMaxScalar[iBrickID].max = occupancy.fMax;
+      m_vMinMaxScalar[iBrickID].occupancy = occupancy.iBins;
     }
   }
 
@@ -1736,7 +1765,7 @@ uint32_t GLVolumePool::UploadBricks(const std::vector<UINTVECTOR4>& vBrickIDs,
           PotentiallyUploadBricksToBrickPool<AbstrRenderer::RM_1DTRANS>(
             visibility, m_pDataset, m_iMinMaxScalarTimestep, *this,
             m_vBrickMetadata, vBrickIDs, m_vMinMaxScalar, m_vMinMaxGradient,
-            m_iMaxUsedBrickVoxelCount, brickDebug
+            brickDebug
           );
         break;
       case AbstrRenderer::RM_2DTRANS:
@@ -1744,7 +1773,7 @@ uint32_t GLVolumePool::UploadBricks(const std::vector<UINTVECTOR4>& vBrickIDs,
           PotentiallyUploadBricksToBrickPool<AbstrRenderer::RM_2DTRANS>(
             visibility, m_pDataset, m_iMinMaxScalarTimestep, *this,
             m_vBrickMetadata, vBrickIDs, m_vMinMaxScalar, m_vMinMaxGradient,
-            m_iMaxUsedBrickVoxelCount, brickDebug
+            brickDebug
           );
         break;
       case AbstrRenderer::RM_ISOSURFACE:
@@ -1752,7 +1781,7 @@ uint32_t GLVolumePool::UploadBricks(const std::vector<UINTVECTOR4>& vBrickIDs,
           PotentiallyUploadBricksToBrickPool<AbstrRenderer::RM_ISOSURFACE>(
             visibility, m_pDataset, m_iMinMaxScalarTimestep, *this,
             m_vBrickMetadata, vBrickIDs, m_vMinMaxScalar, m_vMinMaxGradient,
-            m_iMaxUsedBrickVoxelCount, brickDebug
+            brickDebug
           );
         break;
       default:
@@ -1763,7 +1792,7 @@ uint32_t GLVolumePool::UploadBricks(const std::vector<UINTVECTOR4>& vBrickIDs,
       // visibility is updated guaranteeing that requested bricks do contain data
       iPagedBricks = UploadBricksToBrickPool(
         *this, vBrickIDs, m_pDataset, m_iMinMaxScalarTimestep,
-        m_iMaxUsedBrickVoxelCount, brickDebug);
+        brickDebug);
     }
   }
   
@@ -98,7 +98,12 @@ namespace tuvok {
       void UploadFirstBrick(const BrickKey& bkey);
 
       // returns false if we need to render first before we can continue to upload further bricks
-      bool UploadBrick(const BrickElemInfo& metaData, void* pData); // TODO: we could use the 1D-index here too
+      // 'iRowLength' and 'iImageHeight' give the pitch of pData in voxels; see
+      // tuvok::BrickView.  Zero means the brick is tightly packed.
+      bool UploadBrick(const BrickElemInfo& metaData, const void* pData,
+                       uint32_t iRowLength=0, uint32_t iImageHeight=0); // TODO: we could use the 1D-index here too
+      // how many more bricks UploadBrick accepts before we need to render
+      size_t GetFreeUploadSlots() const;
       void UploadFirstBrick(const UINTVECTOR3& m_vVoxelSize, void* pData);
       void UploadMetadataTexture();
       void UploadMetadataTexel(uint32_t iBrickID);
@@ -137,6 +142,7 @@ namespace tuvok {
       struct MinMax {
         double min;
         double max;
+        uint64_t occupancy; ///< scalars only, see ValueOccupancy
       };
 
       uint64_t GetMaxUsedBrickBytes() const { return m_iMaxUsedBrickBytes; }
@@ -196,8 +202,9 @@ namespace tuvok {
 
       void PrepareForPaging();
 
-      void UploadBrick(uint32_t iBrickID, const UINTVECTOR3& vVoxelSize, void* pData, 
-                       size_t iInsertPos, uint64_t iTimeOfCreation);
+      void UploadBrick(uint32_t iBrickID, const UINTVECTOR3& vVoxelSize, const void* pData,
+                       size_t iInsertPos, uint64_t iTimeOfCreation,
+                       uint32_t iRowLength=0, uint32_t iImageHeight=0);
 
       DebugMode const m_eDebugMode;
   };
@@ -5,14 +5,17 @@ using namespace tuvok;
 VisibilityState::VisibilityState() : m_eRenderMode(AbstrRenderer::RM_INVALID)
 {}
 
-bool VisibilityState::NeedsUpdate(double fMin, double fMax)
+bool VisibilityState::NeedsUpdate(double fMin, double fMax,
+                                  ValueRanges const& vRanges)
 {
   bool const bNeedsUpdate = (m_eRenderMode != AbstrRenderer::RM_1DTRANS) ||
     (m_rm1DTrans.fMin != fMin) ||
-    (m_rm1DTrans.fMax != fMax);
+    (m_rm1DTrans.fMax != fMax) ||
+    (m_v1DRanges != vRanges);
   m_eRenderMode = AbstrRenderer::RM_1DTRANS;
   m_rm1DTrans.fMin = fMin;
   m_rm1DTrans.fMax = fMax;
+  m_v1DRanges = vRanges;
   return bNeedsUpdate;
 }
 
@@ -31,7 +31,7 @@ namespace tuvok
 
     VisibilityState();
 
-    bool NeedsUpdate(double fMin, double fMax);
+    bool NeedsUpdate(double fMin, double fMax, ValueRanges const& vRanges);
     bool NeedsUpdate(double fMin, double fMax, double fMinGradient, double fMaxGradient);
     bool NeedsUpdate(double fIsoValue);
 
@@ -39,6 +39,8 @@ namespace tuvok
     RM1DTransfer const& Get1DTransfer() const { return m_rm1DTrans; }
     RM2DTransfer const& Get2DTransfer() const { return m_rm2DTrans; }
     RMIsoSurface const& GetIsoSurface() const { return m_rmIsoSurf; }
+    /// the 1D TF's non-zero ranges, within [fMin, fMax]
+    ValueRanges const& Get1DRanges() const { return m_v1DRanges; }
 
   private:
     AbstrRenderer::ERenderMode m_eRenderMode;
@@ -47,6 +49,7 @@ namespace tuvok
       RM2DTransfer m_rm2DTrans;
       RMIsoSurface m_rmIsoSurf;
     };
+    ValueRanges m_v1DRanges;
   };
 
 } // namespace tuvok
@@ -107,16 +107,19 @@ HEADERS += \
            Basics/Mesh.h \
            Basics/nonstd.h \
            Basics/PerfCounter.h \
+           Basics/PerfRegistry.h \
            Basics/Plane.h \
            Basics/ProgressTimer.h \
            Basics/SysTools.h \
            Basics/Threads.h \
            Basics/Timer.h \
            Basics/TuvokException.h \
+           Basics/ValueOccupancy.h \
            Basics/Vectors.h \
            Controller/Controller.h \
            Controller/MasterController.h \
            DebugOut/AbstrDebugOut.h \
+           DebugOut/AsyncOut.h \
            DebugOut/ConsoleOut.h \
            DebugOut/MultiplexOut.h \
            DebugOut/TextfileOut.h \
@@ -162,9 +165,11 @@ HEADERS += \
            IO/BMinMax.h \
            IO/BOVConverter.h \
            IO/BrickCache.h \
+           IO/BrickView.h \
            IO/BrickedDataset.h \
            IO/const-brick-iterator.h \
            IO/Dataset.h \
+           IO/DecompressingRAWFile.h \
            IO/DICOM/DICOMParser.h \
            IO/DirectoryParser.h \
            IO/DSFactory.h \
@@ -179,6 +184,7 @@ HEADERS += \
            IO/Images/StackExporter.h \
            IO/InveonConverter.h \
            IO/IOManager.h \
+           IO/IsosurfaceExtractor.h \
            IO/KeyValueFileParser.h \
            IO/KitwareConverter.h \
            IO/LinearIndexDataset.h \
@@ -191,11 +197,16 @@ HEADERS += \
            IO/OBJGeoConverter.h \
            IO/PLYGeoConverter.h \
            IO/Quantize.h \
+           IO/QuantizeSIMD.h \
+           IO/QuantizingRAWFile.h \
            IO/QVISConverter.h \
            IO/RAWConverter.h \
            IO/REKConverter.h \
+           IO/SlicePipeline.h \
+           IO/SpatialBrickIndex.h \
            IO/StkConverter.h \
            IO/StLGeoConverter.h \
+           IO/TextSpan.h \
            IO/TiffVolumeConverter.h \
            IO/TransferFunction1D.h \
            IO/TransferFunction2D.h \
@@ -204,6 +215,7 @@ HEADERS += \
            IO/TuvokJPEG.h \
            IO/Tuvok_QtPlugins.h \
            IO/TuvokSizes.h \
+           IO/UVF/BrickHistogram.h \
            IO/UVF/DataBlock.h \
            IO/uvfDataset.h \
            IO/UVF/ExtendedOctree/BzlibCompression.h \
@@ -301,7 +313,8 @@ HEADERS += \
 unix:HEADERS += \
   Basics/LargeFileAIO.h \
   Basics/LargeFileFD.h \
-  Basics/LargeFileMMap.h
+  Basics/LargeFileMMap.h \
+  Basics/LargeFileURing.h
 
 SOURCES += \
            3rdParty/GLEW/GL/glew.c \
@@ -350,6 +363,7 @@ SOURCES += \
            Basics/MathTools.cpp \
            Basics/MC.cpp \
            Basics/Mesh.cpp \
+           Basics/PerfRegistry.cpp \
            Basics/Plane.cpp \
            Basics/ProgressTimer.cpp \
            Basics/SystemInfo.cpp \
@@ -358,6 +372,7 @@ SOURCES += \
            Basics/Timer.cpp \
            Controller/MasterController.cpp \
            DebugOut/AbstrDebugOut.cpp \
+           DebugOut/AsyncOut.cpp \
            DebugOut/ConsoleOut.cpp \
            DebugOut/MultiplexOut.cpp \
            DebugOut/TextfileOut.cpp \
@@ -482,6 +497,7 @@ SOURCES += \
            IO/BrickedDataset.cpp \
            IO/const-brick-iterator.cpp \
            IO/Dataset.cpp \
+           IO/DecompressingRAWFile.cpp \
            IO/DICOM/DICOMParser.cpp \
            IO/DirectoryParser.cpp \
            IO/DSFactory.cpp \
@@ -496,6 +512,7 @@ SOURCES += \
            IO/Images/StackExporter.cpp \
            IO/InveonConverter.cpp \
            IO/IOManager.cpp \
+           IO/IsosurfaceExtractor.cpp \
            IO/KeyValueFileParser.cpp \
            IO/KitwareConverter.cpp \
            IO/LinearIndexDataset.cpp \
@@ -507,11 +524,15 @@ SOURCES += \
            IO/NRRDConverter.cpp \
            IO/OBJGeoConverter.cpp \
            IO/PLYGeoConverter.cpp \
+           IO/QuantizeSIMD.cpp \
            IO/QVISConverter.cpp \
            IO/RAWConverter.cpp \
            IO/REKConverter.cpp \
+           IO/SlicePipeline.cpp \
+           IO/SpatialBrickIndex.cpp \
            IO/StkConverter.cpp \
            IO/StLGeoConverter.cpp \
+           IO/TextSpan.cpp \
            IO/TiffVolumeConverter.cpp \
            IO/TransferFunction1D.cpp \
            IO/TransferFunction2D.cpp \
@@ -598,6 +619,7 @@ unix:SOURCES += \
   Basics/LargeFileAIO.cpp \
   Basics/LargeFileFD.cpp \
   Basics/LargeFileMMap.cpp \
+  Basics/LargeFileURing.cpp \
   IO/3rdParty/tiff/tif_unix.c
 
 win32 {